@@ -0,0 +1,389 @@
+#include "ConfigurationCache.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <xxh3.h>
+#include <LLUtils/Exception.h>
+
+namespace OIV
+{
+    namespace
+    {
+#pragma pack(push,1)
+        struct SnapshotFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t payloadSize;
+            uint64_t payloadHash;
+        };
+
+        struct SnapshotFileStamp
+        {
+            uint64_t fileSize;
+            int64_t lastWriteTime;
+        };
+#pragma pack(pop)
+
+        // 'OIVC' is taken by the decoded image cache.
+        constexpr char SnapshotFileMagic[4] = { 'O', 'I', 'V', 'G' };
+        constexpr uint32_t SnapshotFileVersion = 1;
+
+        class PayloadWriter
+        {
+        public:
+            void Write(const void* data, size_t size)
+            {
+                const size_t offset = fBuffer.size();
+                fBuffer.resize(offset + size);
+                std::memcpy(fBuffer.data() + offset, data, size);
+            }
+
+            void Write(uint32_t value) { Write(&value, sizeof(value)); }
+
+            void Write(const std::string& str)
+            {
+                Write(static_cast<uint32_t>(str.size()));
+                Write(str.data(), str.size());
+            }
+
+            const std::vector<std::byte>& GetBuffer() const { return fBuffer; }
+
+        private:
+            std::vector<std::byte> fBuffer;
+        };
+
+        // Every read is bounds checked, a truncated or corrupted payload fails instead of reading past its end.
+        class PayloadReader
+        {
+        public:
+            PayloadReader(const std::byte* data, size_t size) : fData(data), fSize(size) {}
+
+            bool Read(void* data, size_t size)
+            {
+                if (fSize - fPosition < size)
+                    return false;
+                std::memcpy(data, fData + fPosition, size);
+                fPosition += size;
+                return true;
+            }
+
+            bool Read(uint32_t& value) { return Read(&value, sizeof(value)); }
+
+            bool Read(std::string& str)
+            {
+                uint32_t length;
+                if (Read(length) == false || fSize - fPosition < length)
+                    return false;
+                str.assign(reinterpret_cast<const char*>(fData + fPosition), length);
+                fPosition += length;
+                return true;
+            }
+
+            bool IsAtEnd() const { return fPosition == fSize; }
+
+        private:
+            const std::byte* fData;
+            size_t fSize;
+            size_t fPosition = 0;
+        };
+    }
+
+    const ConfigurationLoader::CommandGroup* ConfigurationCache::Snapshot::FindCommandGroup(const std::string& groupID) const
+    {
+        auto it = fCommandGroupIndex.find(groupID);
+        return it != fCommandGroupIndex.end() ? &commandGroups[it->second] : nullptr;
+    }
+
+    const ConfigurationLoader::KeyBinding* ConfigurationCache::Snapshot::FindKeyBinding(const std::string& keyCombination) const
+    {
+        auto it = fKeyBindingIndex.find(keyCombination);
+        return it != fKeyBindingIndex.end() ? &keyBindings[it->second] : nullptr;
+    }
+
+    void ConfigurationCache::Snapshot::BuildIndices()
+    {
+        fCommandGroupIndex.clear();
+        fCommandGroupIndex.reserve(commandGroups.size());
+        for (size_t i = 0; i < commandGroups.size(); i++)
+            fCommandGroupIndex.emplace(commandGroups[i].commandGroupID, i);
+
+        fKeyBindingIndex.clear();
+        fKeyBindingIndex.reserve(keyBindings.size());
+        for (size_t i = 0; i < keyBindings.size(); i++)
+            fKeyBindingIndex.emplace(keyBindings[i].KeyCombinationName, i);
+    }
+
+    std::wstring ConfigurationCache::GetFilePath(File file)
+    {
+        switch (file)
+        {
+        case File::Commands:
+            return ConfigurationLoader::GetConfigurationFolder() + L"Commands.json";
+        case File::KeyBindings:
+            return ConfigurationLoader::GetConfigurationFolder() + L"KeyBindings.json";
+        case File::Settings:
+            return ConfigurationLoader::GetConfigurationFolder() + L"Settings.json";
+        default:
+            LL_EXCEPTION_UNEXPECTED_VALUE;
+        }
+    }
+
+    void ConfigurationCache::SetSnapshotFolder(const std::wstring& snapshotFolder)
+    {
+        std::lock_guard lock(fMutex);
+        fSnapshotFolder = snapshotFolder;
+    }
+
+    std::wstring ConfigurationCache::GetSnapshotFilePath() const
+    {
+        // Kept out of the configuration folder, which is watched for changes and may be read only.
+        return fSnapshotFolder.empty() ? std::wstring() : fSnapshotFolder + L"Configuration.bin";
+    }
+
+    ConfigurationCache::File ConfigurationCache::FromFileName(const std::wstring& fileName, bool& found)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(File::Count); i++)
+        {
+            const File file = static_cast<File>(i);
+            if (std::filesystem::path(GetFilePath(file)).filename() == fileName)
+            {
+                found = true;
+                return file;
+            }
+        }
+
+        found = false;
+        return File::Count;
+    }
+
+    FileStamp ConfigurationCache::GetStamp(File file)
+    {
+        FileStamp stamp;
+        if (FileStamp::Get(GetFilePath(file), stamp) == false)
+            stamp = FileStamp{};
+        return stamp;
+    }
+
+    void ConfigurationCache::Parse(File file, Snapshot& snapshot)
+    {
+        switch (file)
+        {
+        case File::Commands:
+            snapshot.commandGroups = ConfigurationLoader::LoadCommandGroups();
+            break;
+        case File::KeyBindings:
+            snapshot.keyBindings = ConfigurationLoader::LoadKeyBindings();
+            break;
+        case File::Settings:
+            snapshot.settings = ConfigurationLoader::LoadSettings();
+            break;
+        default:
+            LL_EXCEPTION_UNEXPECTED_VALUE;
+        }
+    }
+
+    bool ConfigurationCache::LoadSnapshot(const std::wstring& filePath, Snapshot& snapshot, FileStamps& stamps)
+    {
+        if (filePath.empty())
+            return false;
+
+        std::ifstream file(std::filesystem::path(filePath), std::ios::binary | std::ios::ate);
+        if (file.is_open() == false)
+            return false;
+
+        const size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < sizeof(SnapshotFileHeader))
+            return false;
+
+        std::vector<std::byte> buffer(fileSize);
+        file.seekg(0);
+        if (file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(fileSize)).good() == false)
+            return false;
+
+        SnapshotFileHeader header;
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        const std::byte* payload = buffer.data() + sizeof(SnapshotFileHeader);
+        if (std::memcmp(header.magic, SnapshotFileMagic, sizeof(SnapshotFileMagic)) != 0
+            || header.version != SnapshotFileVersion
+            || sizeof(SnapshotFileHeader) + header.payloadSize != fileSize
+            || XXH3_64bits(payload, static_cast<size_t>(header.payloadSize)) != header.payloadHash)
+            return false;
+
+        PayloadReader reader(payload, static_cast<size_t>(header.payloadSize));
+        for (FileStamp& stamp : stamps)
+        {
+            SnapshotFileStamp fileStamp;
+            if (reader.Read(&fileStamp, sizeof(fileStamp)) == false)
+                return false;
+            stamp = { fileStamp.fileSize, fileStamp.lastWriteTime };
+        }
+
+        uint32_t count;
+        if (reader.Read(count) == false)
+            return false;
+        snapshot.commandGroups.resize(count);
+        for (ConfigurationLoader::CommandGroup& commandGroup : snapshot.commandGroups)
+        {
+            if ((reader.Read(commandGroup.commandGroupID) && reader.Read(commandGroup.commandDisplayName)
+                && reader.Read(commandGroup.commandName) && reader.Read(commandGroup.arguments)) == false)
+                return false;
+        }
+
+        if (reader.Read(count) == false)
+            return false;
+        snapshot.keyBindings.resize(count);
+        for (ConfigurationLoader::KeyBinding& keyBinding : snapshot.keyBindings)
+        {
+            if ((reader.Read(keyBinding.KeyCombinationName) && reader.Read(keyBinding.GroupID)) == false)
+                return false;
+        }
+
+        if (reader.Read(count) == false)
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            std::string key;
+            std::string value;
+            if ((reader.Read(key) && reader.Read(value)) == false)
+                return false;
+            snapshot.settings.emplace(std::move(key), std::move(value));
+        }
+
+        return reader.IsAtEnd();
+    }
+
+    bool ConfigurationCache::SaveSnapshot(const std::wstring& filePath, const Snapshot& snapshot, const FileStamps& stamps)
+    {
+        using namespace std::filesystem;
+
+        if (filePath.empty())
+            return false;
+
+        PayloadWriter writer;
+        for (const FileStamp& stamp : stamps)
+        {
+            const SnapshotFileStamp fileStamp{ stamp.fileSize, stamp.lastWriteTime };
+            writer.Write(&fileStamp, sizeof(fileStamp));
+        }
+
+        writer.Write(static_cast<uint32_t>(snapshot.commandGroups.size()));
+        for (const ConfigurationLoader::CommandGroup& commandGroup : snapshot.commandGroups)
+        {
+            writer.Write(commandGroup.commandGroupID);
+            writer.Write(commandGroup.commandDisplayName);
+            writer.Write(commandGroup.commandName);
+            writer.Write(commandGroup.arguments);
+        }
+
+        writer.Write(static_cast<uint32_t>(snapshot.keyBindings.size()));
+        for (const ConfigurationLoader::KeyBinding& keyBinding : snapshot.keyBindings)
+        {
+            writer.Write(keyBinding.KeyCombinationName);
+            writer.Write(keyBinding.GroupID);
+        }
+
+        writer.Write(static_cast<uint32_t>(snapshot.settings.size()));
+        for (const auto& [key, value] : snapshot.settings)
+        {
+            writer.Write(key);
+            writer.Write(value);
+        }
+
+        const std::vector<std::byte>& payload = writer.GetBuffer();
+        SnapshotFileHeader header;
+        std::memcpy(header.magic, SnapshotFileMagic, sizeof(SnapshotFileMagic));
+        header.version = SnapshotFileVersion;
+        header.payloadSize = payload.size();
+        header.payloadHash = XXH3_64bits(payload.data(), payload.size());
+
+        std::error_code ec;
+        create_directories(path(filePath).parent_path(), ec);
+
+        // Write to a temporary file first so a concurrent reader never sees a partial snapshot.
+        const path tempPath = path(filePath).concat(L".tmp");
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (file.is_open() == false)
+                return false;
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+            if (file.good() == false)
+                return false;
+        }
+
+        rename(tempPath, filePath, ec);
+        return ec.value() == 0;
+    }
+
+    ConfigurationCache::SnapshotSharedPtr ConfigurationCache::Get()
+    {
+        std::lock_guard lock(fMutex);
+        if (fSnapshot != nullptr)
+            return fSnapshot;
+
+        FileStamps currentStamps;
+        for (size_t i = 0; i < currentStamps.size(); i++)
+            currentStamps[i] = GetStamp(static_cast<File>(i));
+
+        auto snapshot = std::make_shared<Snapshot>();
+        FileStamps snapshotStamps{};
+        const bool snapshotLoaded = LoadSnapshot(GetSnapshotFilePath(), *snapshot, snapshotStamps);
+
+        // Parse only the files which changed since the snapshot was written.
+        bool changed = snapshotLoaded == false;
+        for (size_t i = 0; i < currentStamps.size(); i++)
+        {
+            if (snapshotLoaded == false || snapshotStamps[i] != currentStamps[i] || currentStamps[i] == FileStamp{})
+            {
+                Parse(static_cast<File>(i), *snapshot);
+                changed = true;
+            }
+        }
+
+        snapshot->BuildIndices();
+        fSnapshot = snapshot;
+        fStamps = currentStamps;
+
+        // The snapshot is an optimization, e.g. an unwritable snapshot folder just parses the JSON every time.
+        if (changed)
+            SaveSnapshot(GetSnapshotFilePath(), *fSnapshot, fStamps);
+
+        return fSnapshot;
+    }
+
+    bool ConfigurationCache::Reload(File file)
+    {
+        // Loads everything on first use, nothing is left to reload then.
+        Get();
+
+        std::lock_guard lock(fMutex);
+        const size_t index = static_cast<size_t>(file);
+        const FileStamp stamp = GetStamp(file);
+        if (stamp == fStamps.at(index) && stamp != FileStamp{})
+            return false;
+
+        // Sections of the other files are carried over, the previous snapshot stays valid for its readers.
+        auto snapshot = std::make_shared<Snapshot>(*fSnapshot);
+        Parse(file, *snapshot);
+        snapshot->BuildIndices();
+        fSnapshot = snapshot;
+        fStamps.at(index) = stamp;
+        SaveSnapshot(GetSnapshotFilePath(), *fSnapshot, fStamps);
+        return true;
+    }
+
+    ConfigurationLoader::MapSettings ConfigurationCache::GetChangedSettings(const ConfigurationLoader::MapSettings& previous
+        , const ConfigurationLoader::MapSettings& current)
+    {
+        ConfigurationLoader::MapSettings changed;
+        for (const auto& [key, value] : current)
+        {
+            auto it = previous.find(key);
+            if (it == previous.end() || it->second != value)
+                changed.emplace(key, value);
+        }
+        return changed;
+    }
+}
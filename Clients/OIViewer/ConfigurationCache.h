@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <LLUtils/Singleton.h>
+#include <FileStamp.h>
+#include "ConfigurationLoader.h"
+
+namespace OIV
+{
+    // Parses the JSON configuration once and serves it from memory with hashed lookups.
+    // The parsed configuration is kept in a binary snapshot in the snapshot folder, sections whose JSON file
+    // didn't change since the snapshot was written are read from it instead of parsing the JSON.
+    // Reloading reparses only the files which changed on disk. Thread safe.
+    class ConfigurationCache : public LLUtils::Singleton<ConfigurationCache>
+    {
+    public:
+        enum class File
+        {
+              Commands
+            , KeyBindings
+            , Settings
+            , Count
+        };
+
+        // Immutable once published, readers keep using a snapshot while a newer one is built.
+        struct Snapshot
+        {
+            ConfigurationLoader::CommandGroupList commandGroups;
+            ConfigurationLoader::KeyBindingList keyBindings;
+            ConfigurationLoader::MapSettings settings;
+
+            const ConfigurationLoader::CommandGroup* FindCommandGroup(const std::string& groupID) const;
+            // First binding of a key combination.
+            const ConfigurationLoader::KeyBinding* FindKeyBinding(const std::string& keyCombination) const;
+
+        private:
+            friend class ConfigurationCache;
+            void BuildIndices();
+
+            std::unordered_map<std::string, size_t> fCommandGroupIndex;
+            std::unordered_map<std::string, size_t> fKeyBindingIndex;
+        };
+
+        using SnapshotSharedPtr = std::shared_ptr<const Snapshot>;
+
+        // Set before first use, without a snapshot folder the JSON files are parsed every time.
+        void SetSnapshotFolder(const std::wstring& snapshotFolder);
+        // Loads the configuration on first use.
+        SnapshotSharedPtr Get();
+        // Reparses 'file' if it changed on disk since it was last read, returns whether it did.
+        bool Reload(File file);
+
+        static File FromFileName(const std::wstring& fileName, bool& found);
+        // Settings of 'current' which are new or have a different value than in 'previous'.
+        static ConfigurationLoader::MapSettings GetChangedSettings(const ConfigurationLoader::MapSettings& previous
+            , const ConfigurationLoader::MapSettings& current);
+
+    private:
+        using FileStamps = std::array<FileStamp, static_cast<size_t>(File::Count)>;
+
+        static std::wstring GetFilePath(File file);
+        std::wstring GetSnapshotFilePath() const;
+        static FileStamp GetStamp(File file);
+        static void Parse(File file, Snapshot& snapshot);
+        static bool LoadSnapshot(const std::wstring& filePath, Snapshot& snapshot, FileStamps& stamps);
+        static bool SaveSnapshot(const std::wstring& filePath, const Snapshot& snapshot, const FileStamps& stamps);
+
+        std::mutex fMutex;
+        std::wstring fSnapshotFolder;
+        SnapshotSharedPtr fSnapshot;
+        FileStamps fStamps{};
+    };
+}
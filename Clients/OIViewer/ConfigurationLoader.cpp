@@ -8,12 +8,17 @@
 
 namespace OIV
 {
+	std::wstring ConfigurationLoader::GetConfigurationFolder()
+	{
+		return LLUtils::PlatformUtility::GetExeFolder() + LLUTILS_TEXT("./Resources/Configuration/");
+	}
+
 	ConfigurationLoader::CommandGroupList ConfigurationLoader::LoadCommandGroups()
 	{
 		using namespace nlohmann;
 		using namespace LLUtils;
 
-		std::string jsonText = File::ReadAllText<std::string>(LLUtils::PlatformUtility::GetExeFolder() + LLUTILS_TEXT("./Resources/Configuration/Commands.json"));
+		std::string jsonText = File::ReadAllText<std::string>(GetConfigurationFolder() + LLUTILS_TEXT("Commands.json"));
 		auto jsonObject = json::parse(jsonText);
 		auto commands = jsonObject["commands"];
 
@@ -32,7 +37,7 @@ namespace OIV
 		using namespace nlohmann;
 		using namespace LLUtils;
 
-		std::string jsonText = File::ReadAllText<std::string>(LLUtils::PlatformUtility::GetExeFolder() + LLUTILS_TEXT("./Resources/Configuration/KeyBindings.json"));
+		std::string jsonText = File::ReadAllText<std::string>(GetConfigurationFolder() + LLUTILS_TEXT("KeyBindings.json"));
 		auto jsonObject = json::parse(jsonText);
 		auto keyBindings = jsonObject["KeyBindings"];
 
@@ -59,7 +64,7 @@ namespace OIV
 
 		try
 		{
-			std::string jsonText = File::ReadAllText<std::string>(LLUtils::PlatformUtility::GetExeFolder() + LLUTILS_TEXT("./Resources/Configuration/Settings.json"));
+			std::string jsonText = File::ReadAllText<std::string>(GetConfigurationFolder() + LLUTILS_TEXT("Settings.json"));
 			auto jsonObject = json::parse(jsonText);
 
 			SettingEntryForParsing root;
@@ -53,6 +53,8 @@ namespace OIV
 
 		using CommandGroupList = std::vector<CommandGroup>;
 		using KeyBindingList = std::vector< KeyBinding>;
+		// Folder of the JSON configuration files.
+		static std::wstring GetConfigurationFolder();
 		static CommandGroupList LoadCommandGroups();
 		static KeyBindingList LoadKeyBindings();
 		static MapSettings LoadSettings();
@@ -1,4 +1,6 @@
 #pragma once
+#include <unordered_map>
+#include "FileSystem/MetadataIndex.h"
 namespace OIV
 {
     class FileSorter
@@ -9,6 +11,9 @@ namespace OIV
               Name
             , Date
             , Extension
+            , CaptureDate
+            , PixelCount
+            , FileSize
             , Count
 
         };
@@ -69,6 +74,60 @@ namespace OIV
                     : last_write_time(B) < last_write_time(A);
             }
         }  fFileListDateSorter;
+
+        // Sizes of files which aren't indexed yet, queried once per sort instead of on every comparison.
+        using MapFileSizes = std::unordered_map<std::wstring, uint64_t>;
+
+        // Sorts by a value of the metadata index, files with equal or unknown values are sorted by name.
+        struct FileMetadataSorter
+        {
+            bool operator() (const std::wstring& A, const std::wstring& B, SortDirection direction, SortType sortType, const MetadataIndex* metadataIndex, MapFileSizes& fileSizes) const
+            {
+                const uint64_t a = GetKey(A, sortType, metadataIndex, fileSizes);
+                const uint64_t b = GetKey(B, sortType, metadataIndex, fileSizes);
+                if (a != b)
+                    return direction == SortDirection::Ascending ? a < b : b < a;
+
+                return fNameSorter(A, B, SortDirection::Ascending);
+            }
+
+            // Size of a file, from the index if it's there.
+            static uint64_t GetFileSize(const std::wstring& filePath, const MetadataIndex* metadataIndex, MapFileSizes& fileSizes)
+            {
+                const MetadataIndex::Entry* entry = metadataIndex != nullptr ? metadataIndex->Find(filePath) : nullptr;
+                if (entry != nullptr)
+                    return entry->fileSize;
+
+                auto [it, inserted] = fileSizes.try_emplace(filePath, 0);
+                if (inserted)
+                {
+                    std::error_code ec;
+                    const uintmax_t fileSize = std::filesystem::file_size(filePath, ec);
+                    it->second = ec.value() == 0 ? static_cast<uint64_t>(fileSize) : 0;
+                }
+                return it->second;
+            }
+
+        private:
+            static uint64_t GetKey(const std::wstring& filePath, SortType sortType, const MetadataIndex* metadataIndex, MapFileSizes& fileSizes)
+            {
+                const MetadataIndex::Entry* entry = metadataIndex != nullptr ? metadataIndex->Find(filePath) : nullptr;
+                switch (sortType)
+                {
+                case SortType::CaptureDate:
+                    return entry != nullptr ? static_cast<uint64_t>(entry->captureTime) : 0;
+                case SortType::PixelCount:
+                    return entry != nullptr ? entry->pixelCount : 0;
+                case SortType::FileSize:
+                    return GetFileSize(filePath, metadataIndex, fileSizes);
+                default:
+                    LL_EXCEPTION_UNEXPECTED_VALUE;
+                }
+            }
+
+            FileNameSorter fNameSorter;
+        } fFileListMetadataSorter;
+
     public:
         bool operator() (const std::wstring& A, const std::wstring& B) const
         {
@@ -82,6 +141,10 @@ namespace OIV
                 break;
             case SortType::Extension:
                 return fFileListExtensionSorter(A, B, GetActiveSortDirection());
+            case SortType::CaptureDate:
+            case SortType::PixelCount:
+            case SortType::FileSize:
+                return fFileListMetadataSorter(A, B, GetActiveSortDirection(), fSortType, fMetadataIndex, fFileSizes);
             default:
                 LL_EXCEPTION_UNEXPECTED_VALUE;
                 break;
@@ -97,6 +160,27 @@ namespace OIV
         {
             return fSortType;
         }
+
+        // True if the active sort type relies on the metadata index, the list should be sorted again when the index is updated.
+        bool IsMetadataSort() const
+        {
+            return fSortType == SortType::CaptureDate || fSortType == SortType::PixelCount || fSortType == SortType::FileSize;
+        }
+
+        void SetMetadataIndex(const MetadataIndex* metadataIndex)
+        {
+            fMetadataIndex = metadataIndex;
+        }
+
+        // Called before sorting 'files', computes the sort keys which aren't in the metadata index
+        // so the comparisons don't query the file system. Files inserted later are queried once on first comparison.
+        void PrepareSort(const std::vector<std::wstring>& files)
+        {
+            fFileSizes.clear();
+            if (fSortType == SortType::FileSize)
+                for (const std::wstring& filePath : files)
+                    FileMetadataSorter::GetFileSize(filePath, fMetadataIndex, fFileSizes);
+        }
         
         SortDirection GetActiveSortDirection() const
         {
@@ -115,6 +199,9 @@ namespace OIV
 
     private:
         SortType fSortType = SortType::Name;
-        std::array<SortDirection, static_cast<size_t>(SortType::Count)> fSortDirection{ SortDirection::Ascending , SortDirection::Descending, SortDirection::Ascending };
+        const MetadataIndex* fMetadataIndex = nullptr;
+        mutable MapFileSizes fFileSizes;
+        std::array<SortDirection, static_cast<size_t>(SortType::Count)> fSortDirection{ SortDirection::Ascending , SortDirection::Descending, SortDirection::Ascending
+            , SortDirection::Ascending, SortDirection::Descending, SortDirection::Descending };
     };
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "BackgroundDecoder.h"
+
+namespace OIV
+{
+    BackgroundDecoder::BackgroundDecoder(IMCodec::ImageLoader* imageLoader, DecodeDoneCallback callback)
+        : fImageLoader(imageLoader)
+        , fCallback(callback)
+    {
+        fThread = std::thread(&BackgroundDecoder::DecodeEntryPoint, this);
+    }
+
+    BackgroundDecoder::~BackgroundDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStop = true;
+        }
+        fCondition.notify_one();
+        if (fThread.joinable())
+            fThread.join();
+    }
+
+    BackgroundDecoder::Generation BackgroundDecoder::Decode(std::shared_ptr<OIVFileImage> file, IMCodec::PluginTraverseMode traverseMode
+        , const IMCodec::Parameters& params, std::shared_ptr<DecodedImageCache> decodedImageCache)
+    {
+        Generation generation;
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            generation = ++fGeneration;
+            fPendingRequest = Request{ generation, std::move(file), traverseMode, params, std::move(decodedImageCache) };
+        }
+        fCondition.notify_one();
+        return generation;
+    }
+
+    void BackgroundDecoder::Cancel()
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fPendingRequest.reset();
+        ++fGeneration;
+    }
+
+    void BackgroundDecoder::DecodeEntryPoint()
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        for (;;)
+        {
+            fCondition.wait(lock, [this] { return fStop || fPendingRequest.has_value(); });
+            if (fStop)
+                break;
+
+            Request request = std::move(*fPendingRequest);
+            fPendingRequest.reset();
+            lock.unlock();
+
+            const ResultCode result = request.file->Load(fImageLoader, request.traverseMode, IMCodec::ImageLoadFlags::None, request.params, request.decodedImageCache.get());
+            // Results of superseded requests are not delivered.
+            if (request.generation == fGeneration)
+                fCallback({ request.generation, request.file, result });
+
+            // The cache may have been disabled meanwhile, the last reference is released without holding the lock.
+            request.decodedImageCache.reset();
+
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <cstdint>
+#include <OIVImage/OIVFileImage.h>
+
+namespace OIV
+{
+    // Decodes a single file at a time on a background thread.
+    // Only the latest request is kept, a request which hasn't started yet is replaced by a newer one,
+    // so quickly browsing through files decodes at most the file being decoded and the last one requested.
+    class BackgroundDecoder
+    {
+    public:
+        using Generation = uint32_t;
+        struct Result
+        {
+            Generation generation;
+            std::shared_ptr<OIVFileImage> file;
+            ResultCode result;
+        };
+
+        // Called from the decoding thread.
+        using DecodeDoneCallback = std::function<void(Result&&)>;
+
+        BackgroundDecoder(IMCodec::ImageLoader* imageLoader, DecodeDoneCallback callback);
+        ~BackgroundDecoder();
+        BackgroundDecoder(const BackgroundDecoder&) = delete;
+        BackgroundDecoder& operator=(const BackgroundDecoder&) = delete;
+
+        // Queue decoding of 'file', replacing any pending request, returns the generation of the new request.
+        // The decoded image cache is kept alive until the request completes.
+        Generation Decode(std::shared_ptr<OIVFileImage> file, IMCodec::PluginTraverseMode traverseMode, const IMCodec::Parameters& params
+            , std::shared_ptr<DecodedImageCache> decodedImageCache);
+        // Discard the pending request and the result of the active one.
+        void Cancel();
+        Generation GetGeneration() const { return fGeneration; }
+
+    private:
+        struct Request
+        {
+            Generation generation;
+            std::shared_ptr<OIVFileImage> file;
+            IMCodec::PluginTraverseMode traverseMode;
+            IMCodec::Parameters params;
+            std::shared_ptr<DecodedImageCache> decodedImageCache;
+        };
+
+        void DecodeEntryPoint();
+
+        IMCodec::ImageLoader* fImageLoader;
+        DecodeDoneCallback fCallback;
+        std::optional<Request> fPendingRequest;
+        std::mutex fMutex;
+        std::condition_variable fCondition;
+        bool fStop = false;
+        std::atomic<Generation> fGeneration = 0;
+        std::thread fThread;
+    };
+}
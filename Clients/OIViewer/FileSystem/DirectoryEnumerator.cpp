@@ -0,0 +1,75 @@
+#include "DirectoryEnumerator.h"
+#include <filesystem>
+#include <chrono>
+#include <LLUtils/StringUtility.h>
+
+namespace OIV
+{
+    DirectoryEnumerator::DirectoryEnumerator(BatchReadyCallback callback) : fCallback(callback)
+    {
+
+    }
+
+    DirectoryEnumerator::~DirectoryEnumerator()
+    {
+        Cancel();
+    }
+
+    DirectoryEnumerator::Generation DirectoryEnumerator::Start(const std::wstring& folder, const std::set<std::wstring>& knownExtensions)
+    {
+        Cancel();
+        fCancel = false;
+        const Generation generation = ++fGeneration;
+        fThread = std::thread(&DirectoryEnumerator::Enumerate, this, generation, folder, knownExtensions);
+        return generation;
+    }
+
+    void DirectoryEnumerator::Cancel()
+    {
+        fCancel = true;
+        if (fThread.joinable())
+            fThread.join();
+    }
+
+    void DirectoryEnumerator::Enumerate(Generation generation, std::wstring folder, std::set<std::wstring> knownExtensions)
+    {
+        using namespace std::filesystem;
+        using clock = std::chrono::steady_clock;
+
+        Batch batch{ generation, folder, {}, false };
+        auto lastFlush = clock::now();
+
+        auto flush = [&](bool completed)
+        {
+            batch.completed = completed;
+            fCallback(std::move(batch));
+            batch = Batch{ generation, folder, {}, false };
+            lastFlush = clock::now();
+        };
+
+        std::error_code ec;
+        directory_iterator it(folder, directory_options::skip_permission_denied, ec);
+        const directory_iterator end;
+
+        while (ec.value() == 0 && it != end && fCancel == false)
+        {
+            const directory_entry& entry = *it;
+            std::error_code entryError;
+            if (entry.is_regular_file(entryError))
+            {
+                std::wstring extension = LLUtils::StringUtility::ToLower(entry.path().extension().wstring());
+                if (extension.empty() == false && knownExtensions.contains(extension.substr(1)))
+                    batch.files.push_back(entry.path().wstring());
+            }
+
+            if (batch.files.size() >= MaxBatchSize
+                || (batch.files.empty() == false && clock::now() - lastFlush >= std::chrono::milliseconds(MaxBatchDelayms)))
+                flush(false);
+
+            it.increment(ec);
+        }
+
+        if (fCancel == false)
+            flush(true);
+    }
+}
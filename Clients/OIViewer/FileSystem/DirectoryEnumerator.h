@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace OIV
+{
+    // Enumerates the supported files of a folder on a background thread and delivers them in batches,
+    // so a folder becomes navigable before its enumeration completes.
+    class DirectoryEnumerator
+    {
+    public:
+        using Generation = uint32_t;
+        struct Batch
+        {
+            Generation generation;
+            std::wstring folder;
+            std::vector<std::wstring> files;
+            bool completed;
+        };
+
+        // Called from the enumeration thread.
+        using BatchReadyCallback = std::function<void(Batch&&)>;
+
+        DirectoryEnumerator(BatchReadyCallback callback);
+        ~DirectoryEnumerator();
+        DirectoryEnumerator(const DirectoryEnumerator&) = delete;
+        DirectoryEnumerator& operator=(const DirectoryEnumerator&) = delete;
+
+        // Cancel any active enumeration and start enumerating 'folder', returns the generation of the new enumeration.
+        Generation Start(const std::wstring& folder, const std::set<std::wstring>& knownExtensions);
+        void Cancel();
+        Generation GetGeneration() const { return fGeneration; }
+
+    private:
+        void Enumerate(Generation generation, std::wstring folder, std::set<std::wstring> knownExtensions);
+
+        static constexpr size_t MaxBatchSize = 2048;
+        static constexpr uint32_t MaxBatchDelayms = 50;
+
+        BatchReadyCallback fCallback;
+        std::thread fThread;
+        std::atomic_bool fCancel = false;
+        std::atomic<Generation> fGeneration = 0;
+    };
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace OIV
+{
+    // A sorted list of file paths backed by an order statistic treap.
+    // Insert, remove and rank are O(log n), path lookup is O(1) through a hash map,
+    // so file watcher events and navigation cost the same regardless of the folder size.
+    class IndexedFileList
+    {
+    public:
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using Comparator = std::function<bool(const std::wstring&, const std::wstring&)>;
+        static constexpr difference_type npos = -1;
+
+        IndexedFileList() = default;
+        IndexedFileList(const IndexedFileList&) = delete;
+        IndexedFileList& operator=(const IndexedFileList&) = delete;
+        IndexedFileList(IndexedFileList&&) = default;
+        IndexedFileList& operator=(IndexedFileList&&) = default;
+
+        void SetComparator(Comparator comparator)
+        {
+            fComparator = std::move(comparator);
+        }
+
+        size_type size() const
+        {
+            return fNodes.size();
+        }
+
+        bool empty() const
+        {
+            return fNodes.empty();
+        }
+
+        void clear()
+        {
+            fRoot = nullptr;
+            fNodes.clear();
+        }
+
+        bool Contains(const std::wstring& filePath) const
+        {
+            return fNodes.find(filePath) != fNodes.end();
+        }
+
+        // Replace the content of the list, 'sortedFiles' is expected to be sorted by the active comparator.
+        void Assign(const std::vector<std::wstring>& sortedFiles)
+        {
+            clear();
+            std::vector<Node*> nodes;
+            nodes.reserve(sortedFiles.size());
+            fNodes.reserve(sortedFiles.size());
+            for (const std::wstring& filePath : sortedFiles)
+            {
+                auto [it, inserted] = fNodes.try_emplace(filePath, nullptr);
+                if (inserted)
+                {
+                    it->second = std::make_unique<Node>(&it->first, fRandom());
+                    nodes.push_back(it->second.get());
+                }
+            }
+            Build(nodes);
+        }
+
+        // Re-sort the list after the comparator criteria has changed.
+        void Sort()
+        {
+            std::vector<Node*> nodes;
+            nodes.reserve(fNodes.size());
+            for (auto& [path, node] : fNodes)
+                nodes.push_back(node.get());
+
+            std::sort(nodes.begin(), nodes.end(), [this](const Node* a, const Node* b) { return fComparator(*a->path, *b->path); });
+            Build(nodes);
+        }
+
+        // Insert a file in its sorted position, returns the index of the inserted file or npos if already exists.
+        difference_type Insert(const std::wstring& filePath)
+        {
+            auto [it, inserted] = fNodes.try_emplace(filePath, nullptr);
+            if (inserted == false)
+                return npos;
+
+            it->second = std::make_unique<Node>(&it->first, fRandom());
+            Node* node = it->second.get();
+
+            if (fRoot == nullptr)
+            {
+                fRoot = node;
+                return 0;
+            }
+
+            // Descend to the upper bound position, equal elements keep their insertion order.
+            Node* current = fRoot;
+            for (;;)
+            {
+                current->size++;
+                Node*& child = fComparator(filePath, *current->path) ? current->left : current->right;
+                if (child == nullptr)
+                {
+                    child = node;
+                    node->parent = current;
+                    break;
+                }
+                current = child;
+            }
+
+            while (node->parent != nullptr && node->parent->priority < node->priority)
+                Rotate(node);
+
+            return Rank(node);
+        }
+
+        // Remove a file, returns the index the file had before removal or npos if not found.
+        difference_type Remove(const std::wstring& filePath)
+        {
+            auto it = fNodes.find(filePath);
+            if (it == fNodes.end())
+                return npos;
+
+            Node* node = it->second.get();
+            const difference_type index = Rank(node);
+
+            // Rotate the node down until it has at most one child then splice it out.
+            while (node->left != nullptr && node->right != nullptr)
+                Rotate(node->left->priority > node->right->priority ? node->left : node->right);
+
+            Node* child = node->left != nullptr ? node->left : node->right;
+            if (child != nullptr)
+                child->parent = node->parent;
+
+            ReplaceChild(node->parent, node, child);
+
+            for (Node* ancestor = node->parent; ancestor != nullptr; ancestor = ancestor->parent)
+                ancestor->size--;
+
+            fNodes.erase(it);
+            return index;
+        }
+
+        // Get the index of a file in the sorted list, or npos if not found.
+        difference_type IndexOf(const std::wstring& filePath) const
+        {
+            auto it = fNodes.find(filePath);
+            return it != fNodes.end() ? Rank(it->second.get()) : npos;
+        }
+
+        const std::wstring& at(difference_type index) const
+        {
+            if (index < 0 || static_cast<size_type>(index) >= size())
+                throw std::out_of_range("IndexedFileList index is out of range");
+
+            const Node* current = fRoot;
+            size_type remaining = static_cast<size_type>(index);
+            for (;;)
+            {
+                const size_type leftSize = SizeOf(current->left);
+                if (remaining < leftSize)
+                {
+                    current = current->left;
+                }
+                else if (remaining == leftSize)
+                {
+                    return *current->path;
+                }
+                else
+                {
+                    remaining -= leftSize + 1;
+                    current = current->right;
+                }
+            }
+        }
+
+        const std::wstring& operator[](difference_type index) const
+        {
+            return at(index);
+        }
+
+        std::vector<std::wstring> ToVector() const
+        {
+            std::vector<std::wstring> result;
+            result.reserve(size());
+            std::vector<const Node*> stack;
+            const Node* current = fRoot;
+            while (current != nullptr || stack.empty() == false)
+            {
+                while (current != nullptr)
+                {
+                    stack.push_back(current);
+                    current = current->left;
+                }
+                current = stack.back();
+                stack.pop_back();
+                result.push_back(*current->path);
+                current = current->right;
+            }
+            return result;
+        }
+
+    private:
+        struct Node
+        {
+            Node(const std::wstring* aPath, uint32_t aPriority) : path(aPath), priority(aPriority) {}
+            const std::wstring* path;
+            uint32_t priority;
+            size_type size = 1;
+            Node* parent = nullptr;
+            Node* left = nullptr;
+            Node* right = nullptr;
+        };
+
+        static size_type SizeOf(const Node* node)
+        {
+            return node != nullptr ? node->size : 0;
+        }
+
+        static void UpdateSize(Node* node)
+        {
+            node->size = SizeOf(node->left) + SizeOf(node->right) + 1;
+        }
+
+        difference_type Rank(const Node* node) const
+        {
+            size_type rank = SizeOf(node->left);
+            for (; node->parent != nullptr; node = node->parent)
+            {
+                if (node->parent->right == node)
+                    rank += SizeOf(node->parent->left) + 1;
+            }
+            return static_cast<difference_type>(rank);
+        }
+
+        void ReplaceChild(Node* parent, Node* oldChild, Node* newChild)
+        {
+            if (parent == nullptr)
+                fRoot = newChild;
+            else if (parent->left == oldChild)
+                parent->left = newChild;
+            else
+                parent->right = newChild;
+        }
+
+        // Rotate 'node' above its parent.
+        void Rotate(Node* node)
+        {
+            Node* parent = node->parent;
+            Node* grandParent = parent->parent;
+
+            if (parent->left == node)
+            {
+                parent->left = node->right;
+                if (node->right != nullptr)
+                    node->right->parent = parent;
+                node->right = parent;
+            }
+            else
+            {
+                parent->right = node->left;
+                if (node->left != nullptr)
+                    node->left->parent = parent;
+                node->left = parent;
+            }
+
+            parent->parent = node;
+            node->parent = grandParent;
+            ReplaceChild(grandParent, parent, node);
+
+            UpdateSize(parent);
+            UpdateSize(node);
+        }
+
+        // Build a treap in linear time from nodes in sorted order.
+        void Build(const std::vector<Node*>& sortedNodes)
+        {
+            fRoot = nullptr;
+            std::vector<Node*> rightSpine;
+            for (Node* node : sortedNodes)
+            {
+                node->parent = node->left = node->right = nullptr;
+                Node* lastPopped = nullptr;
+                while (rightSpine.empty() == false && rightSpine.back()->priority < node->priority)
+                {
+                    lastPopped = rightSpine.back();
+                    rightSpine.pop_back();
+                }
+
+                node->left = lastPopped;
+                if (lastPopped != nullptr)
+                    lastPopped->parent = node;
+
+                if (rightSpine.empty() == false)
+                {
+                    rightSpine.back()->right = node;
+                    node->parent = rightSpine.back();
+                }
+                rightSpine.push_back(node);
+            }
+
+            if (sortedNodes.empty() == false)
+                fRoot = rightSpine.front();
+
+            // Update subtree sizes bottom up, children always appear after their parent in a level order traversal.
+            std::vector<Node*> levelOrder;
+            levelOrder.reserve(sortedNodes.size());
+            if (fRoot != nullptr)
+                levelOrder.push_back(fRoot);
+            for (size_t i = 0; i < levelOrder.size(); i++)
+            {
+                if (levelOrder[i]->left != nullptr)
+                    levelOrder.push_back(levelOrder[i]->left);
+                if (levelOrder[i]->right != nullptr)
+                    levelOrder.push_back(levelOrder[i]->right);
+            }
+            for (auto it = levelOrder.rbegin(); it != levelOrder.rend(); ++it)
+                UpdateSize(*it);
+        }
+
+        Comparator fComparator = std::less<std::wstring>();
+        std::unordered_map<std::wstring, std::unique_ptr<Node>> fNodes;
+        Node* fRoot = nullptr;
+        std::minstd_rand fRandom{ std::random_device{}() };
+    };
+}
@@ -0,0 +1,145 @@
+#include "MetadataIndex.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <xxh3.h>
+#include <LLUtils/StringUtility.h>
+
+namespace OIV
+{
+    namespace
+    {
+#pragma pack(push,1)
+        struct IndexFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t numEntries;
+            uint32_t stringTableSize;
+        };
+
+        struct IndexFileRecord
+        {
+            uint64_t fileSize;
+            int64_t lastWriteTime;
+            uint64_t pixelCount;
+            int64_t captureTime;
+            uint32_t nameOffset;
+            uint32_t nameLength;
+        };
+#pragma pack(pop)
+
+        constexpr char IndexFileMagic[4] = { 'O', 'I', 'V', 'M' };
+        constexpr uint32_t IndexFileVersion = 1;
+    }
+
+    int64_t MetadataIndex::ParseExifDateTime(const std::string& dateTime)
+    {
+        // Positions of the digits in "YYYY:MM:DD HH:MM:SS".
+        constexpr size_t digitPositions[] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+        if (dateTime.size() < 19)
+            return 0;
+
+        int64_t result = 0;
+        for (size_t position : digitPositions)
+        {
+            const char c = dateTime[position];
+            if (c < '0' || c > '9')
+                return 0;
+            result = result * 10 + (c - '0');
+        }
+        return result;
+    }
+
+    bool MetadataIndex::Load(const std::wstring& indexFilePath, MapEntries& entries)
+    {
+        std::ifstream file(std::filesystem::path(indexFilePath), std::ios::binary | std::ios::ate);
+        if (file.is_open() == false)
+            return false;
+
+        const size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < sizeof(IndexFileHeader))
+            return false;
+
+        std::vector<std::byte> buffer(fileSize);
+        file.seekg(0);
+        if (file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(fileSize)).good() == false)
+            return false;
+
+        IndexFileHeader header;
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        const size_t recordsSize = static_cast<size_t>(header.numEntries) * sizeof(IndexFileRecord);
+        if (std::memcmp(header.magic, IndexFileMagic, sizeof(IndexFileMagic)) != 0
+            || header.version != IndexFileVersion
+            || sizeof(IndexFileHeader) + recordsSize + header.stringTableSize != fileSize)
+            return false;
+
+        const std::byte* records = buffer.data() + sizeof(IndexFileHeader);
+        const char* stringTable = reinterpret_cast<const char*>(records + recordsSize);
+
+        entries.reserve(header.numEntries);
+        for (uint32_t i = 0; i < header.numEntries; i++)
+        {
+            IndexFileRecord record;
+            std::memcpy(&record, records + i * sizeof(IndexFileRecord), sizeof(record));
+            if (static_cast<uint64_t>(record.nameOffset) + record.nameLength > header.stringTableSize)
+                return false;
+
+            const std::u8string name(reinterpret_cast<const char8_t*>(stringTable + record.nameOffset), record.nameLength);
+            entries.emplace(std::filesystem::path(name).wstring(), Entry{ record.fileSize, record.lastWriteTime, record.pixelCount, record.captureTime });
+        }
+        return true;
+    }
+
+    bool MetadataIndex::Save(const std::wstring& indexFilePath, const MapEntries& entries)
+    {
+        using namespace std::filesystem;
+        std::error_code ec;
+        create_directories(path(indexFilePath).parent_path(), ec);
+
+        std::vector<IndexFileRecord> records;
+        records.reserve(entries.size());
+        std::u8string stringTable;
+        for (const auto& [name, entry] : entries)
+        {
+            const std::u8string utf8Name = path(name).u8string();
+            records.push_back({ entry.fileSize, entry.lastWriteTime, entry.pixelCount, entry.captureTime
+                , static_cast<uint32_t>(stringTable.size()), static_cast<uint32_t>(utf8Name.size()) });
+            stringTable += utf8Name;
+        }
+
+        IndexFileHeader header;
+        std::memcpy(header.magic, IndexFileMagic, sizeof(IndexFileMagic));
+        header.version = IndexFileVersion;
+        header.numEntries = static_cast<uint32_t>(records.size());
+        header.stringTableSize = static_cast<uint32_t>(stringTable.size());
+
+        // Write to a temporary file first so a concurrent reader never sees a partial index.
+        const path tempPath = path(indexFilePath).concat(L".tmp");
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (file.is_open() == false)
+                return false;
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(IndexFileRecord)));
+            file.write(reinterpret_cast<const char*>(stringTable.data()), static_cast<std::streamsize>(stringTable.size()));
+            if (file.good() == false)
+                return false;
+        }
+
+        rename(tempPath, indexFilePath, ec);
+        return ec.value() == 0;
+    }
+
+    std::wstring MetadataIndex::GetIndexFilePath(const std::wstring& indexFolder, const std::wstring& folder)
+    {
+        const std::wstring normalizedFolder = LLUtils::StringUtility::ToLower(std::filesystem::path(folder).lexically_normal().wstring());
+        const uint64_t hash = XXH3_64bits(normalizedFolder.data(), normalizedFolder.size() * sizeof(wchar_t));
+        std::wstringstream ss;
+        ss << indexFolder << std::hex << std::setw(16) << std::setfill(L'0') << hash << L".idx";
+        return ss.str();
+    }
+}
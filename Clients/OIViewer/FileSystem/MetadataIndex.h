@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace OIV
+{
+    // Image properties of the files of a folder, read from their headers and used for sorting.
+    // The index of a folder is persisted to disk so revisiting a folder only probes files that changed.
+    class MetadataIndex
+    {
+    public:
+        struct Entry
+        {
+            // File size and last write time the entry was created with, a mismatch invalidates the entry.
+            uint64_t fileSize = 0;
+            int64_t lastWriteTime = 0;
+            uint64_t pixelCount = 0;
+            // EXIF capture time packed as YYYYMMDDhhmmss so it sorts as an integer, 0 when unknown.
+            int64_t captureTime = 0;
+        };
+
+        // File name (not path) -> entry.
+        using MapEntries = std::unordered_map<std::wstring, Entry>;
+
+        // Parses an EXIF date time "YYYY:MM:DD HH:MM:SS", returns 0 on failure.
+        static int64_t ParseExifDateTime(const std::string& dateTime);
+
+        // Reads and writes the index of a folder as a whole file in a flat layout:
+        // a header, fixed size records and a UTF-8 string table of the file names.
+        static bool Load(const std::wstring& indexFilePath, MapEntries& entries);
+        static bool Save(const std::wstring& indexFilePath, const MapEntries& entries);
+
+        // Path of the index file of 'folder' inside 'indexFolder'.
+        static std::wstring GetIndexFilePath(const std::wstring& indexFolder, const std::wstring& folder);
+
+        void SetFolder(const std::wstring& folder)
+        {
+            if (folder != fFolder)
+            {
+                fFolder = folder;
+                fEntries.clear();
+            }
+        }
+
+        const std::wstring& GetFolder() const { return fFolder; }
+
+        void Set(const std::wstring& filePath, const Entry& entry)
+        {
+            fEntries[filePath] = entry;
+        }
+
+        void Remove(const std::wstring& filePath)
+        {
+            fEntries.erase(filePath);
+        }
+
+        // Keyed by full path.
+        const Entry* Find(const std::wstring& filePath) const
+        {
+            auto it = fEntries.find(filePath);
+            return it != fEntries.end() ? &it->second : nullptr;
+        }
+
+        size_t size() const { return fEntries.size(); }
+
+    private:
+        std::wstring fFolder;
+        std::unordered_map<std::wstring, Entry> fEntries;
+    };
+}
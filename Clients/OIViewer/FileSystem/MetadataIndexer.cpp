@@ -0,0 +1,164 @@
+#include "MetadataIndexer.h"
+#include <filesystem>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <FileSignature/ImageHeaderProbe.h>
+#include <FileStamp.h>
+
+namespace OIV
+{
+    MetadataIndexer::MetadataIndexer(BatchReadyCallback callback) : fCallback(callback)
+    {
+
+    }
+
+    MetadataIndexer::~MetadataIndexer()
+    {
+        Cancel();
+    }
+
+    MetadataIndexer::Generation MetadataIndexer::Start(const std::wstring& folder, std::vector<std::wstring> files)
+    {
+        Cancel();
+        fCancel = false;
+        const Generation generation = ++fGeneration;
+        fThread = std::thread(&MetadataIndexer::Index, this, generation, folder, std::move(files));
+        return generation;
+    }
+
+    void MetadataIndexer::Cancel()
+    {
+        fCancel = true;
+        if (fThread.joinable())
+            fThread.join();
+    }
+
+    MetadataIndex::Entry MetadataIndexer::CreateEntry(const std::wstring& filePath)
+    {
+        MetadataIndex::Entry entry;
+        FileStamp stamp;
+        if (FileStamp::Get(filePath, stamp))
+        {
+            entry.fileSize = stamp.fileSize;
+            entry.lastWriteTime = stamp.lastWriteTime;
+        }
+
+        // Files that can't be probed are indexed as well, with unknown values, so they are not probed again until modified.
+        ImageHeaderInfo info;
+        if (ImageHeaderProbe::Probe(filePath, info) == RC_Success)
+        {
+            entry.pixelCount = static_cast<uint64_t>(info.width) * info.height;
+            entry.captureTime = MetadataIndex::ParseExifDateTime(info.exifDateTime);
+        }
+        return entry;
+    }
+
+    void MetadataIndexer::Index(Generation generation, std::wstring folder, std::vector<std::wstring> files)
+    {
+        using namespace std::filesystem;
+        using clock = std::chrono::steady_clock;
+
+        const std::wstring indexFilePath = MetadataIndex::GetIndexFilePath(fIndexFolder, folder);
+        MetadataIndex::MapEntries persisted;
+        MetadataIndex::Load(indexFilePath, persisted);
+
+        // Deliver the entries which are still valid at once.
+        Batch batch{ generation, folder, {}, false };
+        MetadataIndex::MapEntries updated;
+        std::vector<std::wstring> filesToProbe;
+        for (const std::wstring& filePath : files)
+        {
+            if (fCancel == true)
+                return;
+
+            FileStamp stamp;
+            if (FileStamp::Get(filePath, stamp) == false)
+                continue;
+
+            const std::wstring fileName = path(filePath).filename().wstring();
+            auto it = persisted.find(fileName);
+            if (it != persisted.end() && it->second.fileSize == stamp.fileSize && it->second.lastWriteTime == stamp.lastWriteTime)
+            {
+                batch.entries.emplace_back(filePath, it->second);
+                updated.emplace(fileName, it->second);
+            }
+            else
+            {
+                filesToProbe.push_back(filePath);
+            }
+        }
+
+        const bool indexChanged = filesToProbe.empty() == false || updated.size() != persisted.size();
+        persisted.clear();
+
+        if (batch.entries.empty() == false)
+        {
+            fCallback(std::move(batch));
+            batch = Batch{ generation, folder, {}, false };
+        }
+
+        // Probe the rest of the files in parallel, the indexing thread collects the results and delivers them in batches.
+        std::mutex resultsMutex;
+        std::condition_variable resultsCondition;
+        std::vector<std::pair<std::wstring, MetadataIndex::Entry>> results;
+        std::atomic_size_t nextFile = 0;
+        size_t probedFiles = 0;
+
+        auto probe = [&]()
+        {
+            size_t index;
+            while (fCancel == false && (index = nextFile++) < filesToProbe.size())
+            {
+                MetadataIndex::Entry entry = CreateEntry(filesToProbe[index]);
+                {
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    results.emplace_back(filesToProbe[index], entry);
+                    probedFiles++;
+                }
+                resultsCondition.notify_one();
+            }
+        };
+
+        const size_t numThreads = std::min<size_t>(std::clamp(std::thread::hardware_concurrency(), 1u, MaxProbeThreads), filesToProbe.size());
+        std::vector<std::thread> probeThreads;
+        for (size_t i = 0; i < numThreads; i++)
+            probeThreads.emplace_back(probe);
+
+        bool probingDone = filesToProbe.empty();
+        auto lastFlush = clock::now();
+        while (probingDone == false && fCancel == false)
+        {
+            {
+                std::unique_lock<std::mutex> lock(resultsMutex);
+                resultsCondition.wait_for(lock, std::chrono::milliseconds(MaxBatchDelayms), [&] { return probedFiles == filesToProbe.size() || results.size() >= MaxBatchSize; });
+                probingDone = probedFiles == filesToProbe.size();
+                if (results.empty() == false && (probingDone || results.size() >= MaxBatchSize || clock::now() - lastFlush >= std::chrono::milliseconds(MaxBatchDelayms)))
+                    batch.entries.swap(results);
+            }
+
+            if (batch.entries.empty() == false)
+            {
+                for (const auto& [filePath, entry] : batch.entries)
+                    updated.emplace(path(filePath).filename().wstring(), entry);
+
+                fCallback(std::move(batch));
+                batch = Batch{ generation, folder, {}, false };
+                lastFlush = clock::now();
+            }
+        }
+
+        for (auto& thread : probeThreads)
+            thread.join();
+
+        if (fCancel == false)
+        {
+            if (indexChanged)
+                MetadataIndex::Save(indexFilePath, updated);
+
+            batch.completed = true;
+            fCallback(std::move(batch));
+        }
+    }
+}
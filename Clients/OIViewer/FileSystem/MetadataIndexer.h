@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include "MetadataIndex.h"
+
+namespace OIV
+{
+    // Builds the metadata index of a folder on a background thread.
+    // Entries still valid in the persisted index are delivered first, the remaining files are probed in parallel
+    // using header only reads and delivered in batches. The updated index is persisted once indexing completes.
+    class MetadataIndexer
+    {
+    public:
+        using Generation = uint32_t;
+        struct Batch
+        {
+            Generation generation;
+            std::wstring folder;
+            // Full path -> entry.
+            std::vector<std::pair<std::wstring, MetadataIndex::Entry>> entries;
+            bool completed;
+        };
+
+        // Called from the indexing thread.
+        using BatchReadyCallback = std::function<void(Batch&&)>;
+
+        MetadataIndexer(BatchReadyCallback callback);
+        ~MetadataIndexer();
+        MetadataIndexer(const MetadataIndexer&) = delete;
+        MetadataIndexer& operator=(const MetadataIndexer&) = delete;
+
+        // Folder where the index files of the indexed folders are persisted.
+        void SetIndexFolder(const std::wstring& indexFolder) { fIndexFolder = indexFolder; }
+
+        // Cancel any active indexing and start indexing 'files' of 'folder', returns the generation of the new indexing.
+        Generation Start(const std::wstring& folder, std::vector<std::wstring> files);
+        void Cancel();
+        Generation GetGeneration() const { return fGeneration; }
+
+        // Probe a single file in the calling thread.
+        static MetadataIndex::Entry CreateEntry(const std::wstring& filePath);
+
+    private:
+        void Index(Generation generation, std::wstring folder, std::vector<std::wstring> files);
+
+        static constexpr size_t MaxBatchSize = 2048;
+        static constexpr uint32_t MaxBatchDelayms = 100;
+        static constexpr unsigned MaxProbeThreads = 8;
+
+        BatchReadyCallback fCallback;
+        std::wstring fIndexFolder;
+        std::thread fThread;
+        std::atomic_bool fCancel = false;
+        std::atomic<Generation> fGeneration = 0;
+    };
+}
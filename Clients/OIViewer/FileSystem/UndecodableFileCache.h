@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+
+namespace OIV
+{
+    // Remembers the files of the listed folder that failed to decode, keyed by path and last write time,
+    // so navigation can skip them without attempting to decode them again until they are modified.
+    // Paths are normalized, a file listed and the same file as loaded are the same entry.
+    class UndecodableFileCache
+    {
+    public:
+        void SetFolder(const std::wstring& folder)
+        {
+            if (folder != fFolder)
+            {
+                fFolder = folder;
+                fEntries.clear();
+            }
+        }
+
+        void Add(const std::wstring& filePath)
+        {
+            std::error_code ec;
+            const auto lastWriteTime = std::filesystem::last_write_time(filePath, ec);
+            if (ec.value() == 0)
+                fEntries[Normalize(filePath)] = lastWriteTime;
+        }
+
+        void Remove(const std::wstring& filePath)
+        {
+            fEntries.erase(Normalize(filePath));
+        }
+
+        // Returns true if the file failed to decode and hasn't been modified since.
+        bool Contains(const std::wstring& filePath)
+        {
+            auto it = fEntries.find(Normalize(filePath));
+            if (it == fEntries.end())
+                return false;
+
+            std::error_code ec;
+            const auto lastWriteTime = std::filesystem::last_write_time(filePath, ec);
+            if (ec.value() != 0 || lastWriteTime != it->second)
+            {
+                fEntries.erase(it);
+                return false;
+            }
+            return true;
+        }
+
+        size_t size() const
+        {
+            return fEntries.size();
+        }
+
+    private:
+        static std::wstring Normalize(const std::wstring& filePath)
+        {
+            return std::filesystem::path(filePath).lexically_normal().wstring();
+        }
+
+        std::wstring fFolder;
+        std::unordered_map<std::wstring, std::filesystem::file_time_type> fEntries;
+    };
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <LLUtils/Event.h>
+#include <LLUtils/UniqueIDProvider.h>
+
+// Common surface of the file watcher backends.
+// Changes reported by a backend are coalesced and raised in batches once a burst of changes settles.
+class FileWatcherBase
+{
+public:
+    using UniqueIDProvider = LLUtils::UniqueIdProvider<uint16_t>;
+    using FolderID = UniqueIDProvider::underlying_type;
+    enum class FileChangedOp { None, Add, Remove, Modified, Rename, WatchedFolderRemoved };
+    struct FileChangedEventArgs
+    {
+        FolderID folderID;
+        FileChangedOp fileOp;
+        std::wstring folder;
+        std::wstring fileName;
+        std::wstring fileName2;
+    };
+
+    using ListFileChangedEventArgs = std::vector<FileChangedEventArgs>;
+    using OnFileChangedEventArgsEvent = LLUtils::Event<void(FileChangedEventArgs)>;
+    using OnFilesChangedEventArgsEvent = LLUtils::Event<void(ListFileChangedEventArgs)>;
+
+    // Raised once per coalesced batch of changes.
+    OnFilesChangedEventArgsEvent FilesChangedEvent;
+    // Raised for each change of a coalesced batch.
+    OnFileChangedEventArgsEvent FileChangedEvent;
+
+    FileWatcherBase()
+    {
+        fCoalescingThread = std::thread(&FileWatcherBase::CoalescingEntryPoint, this);
+    }
+
+    virtual ~FileWatcherBase()
+    {
+        StopCoalescing();
+    }
+
+protected:
+    // Called by the backends from their watch thread.
+    void QueueEvents(const ListFileChangedEventArgs& events)
+    {
+        if (events.empty())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(fCoalescingMutex);
+            const auto now = Clock::now();
+            if (fPendingEvents.empty())
+                fFirstPendingEventTime = now;
+
+            fLastPendingEventTime = now;
+
+            for (const auto& eventArgs : events)
+                Coalesce(eventArgs);
+        }
+        fCoalescingCondition.notify_one();
+    }
+
+    // Pending changes are discarded, backends should call this before tearing down their own state.
+    void StopCoalescing()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fCoalescingMutex);
+            fStopCoalescing = true;
+        }
+        fCoalescingCondition.notify_one();
+
+        if (fCoalescingThread.joinable())
+            fCoalescingThread.join();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using PendingKey = std::pair<FolderID, std::wstring>;
+
+    // Time without new changes before a batch is raised.
+    static constexpr std::chrono::milliseconds QuietPeriod{ 100 };
+    // Maximum time a change is held back during a continuous burst.
+    static constexpr std::chrono::milliseconds MaxLatency{ 500 };
+
+    void AppendPending(const FileChangedEventArgs& eventArgs, const std::wstring& currentName)
+    {
+        fPendingEvents.push_back(eventArgs);
+        fPendingIndex[{ eventArgs.folderID, currentName }] = fPendingEvents.size() - 1;
+    }
+
+    // Merge a change with the pending change of the same file, e.g. Add then Remove cancel out,
+    // Remove then Add become Modified and chained renames collapse to a single rename.
+    void Coalesce(const FileChangedEventArgs& eventArgs)
+    {
+        auto it = fPendingIndex.find({ eventArgs.folderID, eventArgs.fileName });
+        FileChangedEventArgs* pending = it != fPendingIndex.end() ? &fPendingEvents.at(it->second) : nullptr;
+
+        switch (eventArgs.fileOp)
+        {
+        case FileChangedOp::Add:
+            if (pending != nullptr && pending->fileOp == FileChangedOp::Remove)
+            {
+                pending->fileOp = FileChangedOp::Modified;
+                return;
+            }
+            if (pending != nullptr && pending->fileOp == FileChangedOp::Add)
+                return;
+            AppendPending(eventArgs, eventArgs.fileName);
+            break;
+
+        case FileChangedOp::Remove:
+            if (pending != nullptr)
+            {
+                switch (pending->fileOp)
+                {
+                case FileChangedOp::Add:
+                    pending->fileOp = FileChangedOp::None;
+                    fPendingIndex.erase(it);
+                    return;
+                case FileChangedOp::Modified:
+                    pending->fileOp = FileChangedOp::Remove;
+                    return;
+                case FileChangedOp::Remove:
+                    return;
+                case FileChangedOp::Rename:
+                {
+                    // A file renamed and then removed, remove the original file.
+                    const std::wstring originalName = pending->fileName;
+                    pending->fileOp = FileChangedOp::Remove;
+                    pending->fileName2.clear();
+                    const size_t index = it->second;
+                    fPendingIndex.erase(it);
+                    fPendingIndex[{ eventArgs.folderID, originalName }] = index;
+                    return;
+                }
+                default:
+                    break;
+                }
+            }
+            AppendPending(eventArgs, eventArgs.fileName);
+            break;
+
+        case FileChangedOp::Modified:
+            if (pending != nullptr && (pending->fileOp == FileChangedOp::Add || pending->fileOp == FileChangedOp::Modified || pending->fileOp == FileChangedOp::Rename))
+                return;
+            AppendPending(eventArgs, eventArgs.fileName);
+            break;
+
+        case FileChangedOp::Rename:
+            if (pending != nullptr)
+            {
+                switch (pending->fileOp)
+                {
+                case FileChangedOp::Add:
+                {
+                    // A file added and then renamed, add the file with its new name.
+                    pending->fileOp = FileChangedOp::None;
+                    fPendingIndex.erase(it);
+                    FileChangedEventArgs added = eventArgs;
+                    added.fileOp = FileChangedOp::Add;
+                    added.fileName = eventArgs.fileName2;
+                    added.fileName2.clear();
+                    Coalesce(added);
+                    return;
+                }
+                case FileChangedOp::Rename:
+                {
+                    const size_t index = it->second;
+                    fPendingIndex.erase(it);
+                    if (pending->fileName == eventArgs.fileName2)
+                    {
+                        // Renamed back to its original name.
+                        pending->fileOp = FileChangedOp::None;
+                    }
+                    else
+                    {
+                        pending->fileName2 = eventArgs.fileName2;
+                        fPendingIndex[{ eventArgs.folderID, eventArgs.fileName2 }] = index;
+                    }
+                    return;
+                }
+                default:
+                    break;
+                }
+            }
+            AppendPending(eventArgs, eventArgs.fileName2);
+            break;
+
+        case FileChangedOp::None:
+        case FileChangedOp::WatchedFolderRemoved:
+            fPendingEvents.push_back(eventArgs);
+            break;
+        }
+    }
+
+    ListFileChangedEventArgs TakePendingEvents()
+    {
+        ListFileChangedEventArgs events;
+        events.reserve(fPendingEvents.size());
+        for (auto& eventArgs : fPendingEvents)
+            if (eventArgs.fileOp != FileChangedOp::None)
+                events.push_back(std::move(eventArgs));
+
+        fPendingEvents.clear();
+        fPendingIndex.clear();
+        return events;
+    }
+
+    void CoalescingEntryPoint()
+    {
+        std::unique_lock<std::mutex> lock(fCoalescingMutex);
+        while (fStopCoalescing == false)
+        {
+            if (fPendingEvents.empty())
+            {
+                fCoalescingCondition.wait(lock, [this] { return fStopCoalescing || fPendingEvents.empty() == false; });
+                continue;
+            }
+
+            const auto deadline = std::min(fLastPendingEventTime + QuietPeriod, fFirstPendingEventTime + MaxLatency);
+            if (Clock::now() < deadline)
+            {
+                fCoalescingCondition.wait_until(lock, deadline);
+                continue;
+            }
+
+            ListFileChangedEventArgs events = TakePendingEvents();
+            lock.unlock();
+
+            // Raise events with the mutex unlocked.
+            if (events.empty() == false)
+            {
+                FilesChangedEvent.Raise(events);
+                for (const auto& eventArgs : events)
+                    FileChangedEvent.Raise(eventArgs);
+            }
+
+            lock.lock();
+        }
+    }
+
+private:
+    ListFileChangedEventArgs fPendingEvents;
+    std::map<PendingKey, size_t> fPendingIndex; // current name of a file -> its pending change
+    Clock::time_point fFirstPendingEventTime;
+    Clock::time_point fLastPendingEventTime;
+    std::mutex fCoalescingMutex;
+    std::condition_variable fCoalescingCondition;
+    bool fStopCoalescing = false;
+    std::thread fCoalescingThread;
+};
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <thread>
+#include <string>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <filesystem>
+#include <cerrno>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <LLUtils/Exception.h>
+#include <LLUtils/StringUtility.h>
+#include "FileWatcherBase.h"
+
+// inotify file watcher backend.
+class FileWatcher : public FileWatcherBase
+{
+public:
+    FileWatcher()
+    {
+        fInotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fInotifyHandle == -1)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Can not initialize inotify");
+
+        fShutdownHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fShutdownHandle == -1)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Can not create shutdown event");
+
+        fFileWatchThread = std::thread(std::bind(&FileWatcher::InotifyEntryPoint, this));
+    }
+
+    ~FileWatcher()
+    {
+        QueueShutdown();
+        if (fFileWatchThread.joinable())
+            fFileWatchThread.join();
+
+        StopCoalescing();
+        RemoveAll();
+        close(fShutdownHandle);
+        close(fInotifyHandle);
+    }
+
+    bool IsFolderRegistered(const std::wstring& folder) const
+    {
+        return fMapFolderID.find(folder) != fMapFolderID.end();
+    }
+
+    FolderID AddFolder(const std::wstring& folder)
+    {
+        std::lock_guard<std::mutex> Lock(fDataMutex);
+
+        if (std::filesystem::is_directory(folder) == false)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "not a directory");
+
+        if (fMapFolderID.find(folder) != fMapFolderID.end())
+        {
+            using namespace std::string_literals;
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::DuplicateItem, "the folder "s + LLUtils::StringUtility::ToAString(folder) + " already exists"s);
+        }
+
+        const int watchDescriptor = inotify_add_watch(fInotifyHandle, std::filesystem::path(folder).string().c_str(), WatchMask);
+        if (watchDescriptor == -1)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Can not watch directory");
+
+        const FolderID folderID = fUniqueIDProvider.Acquire();
+        fMapFolderID.emplace(folder, folderID);
+        fMapIDData.emplace(folderID, FolderData{ folderID, watchDescriptor, folder });
+        fMapWatchDescriptorID.emplace(watchDescriptor, folderID);
+        return folderID;
+    }
+
+    void RemoveAll()
+    {
+        std::lock_guard<std::mutex> Lock(fDataMutex);
+        for (const auto& [folderID, folderData] : fMapIDData)
+            inotify_rm_watch(fInotifyHandle, folderData.watchDescriptor);
+
+        fMapFolderID.clear();
+        fMapIDData.clear();
+        fMapWatchDescriptorID.clear();
+        fUniqueIDProvider.Reset();
+    }
+
+    void RemoveFolder(const std::wstring& folder)
+    {
+        std::lock_guard<std::mutex> Lock(fDataMutex);
+        auto it = fMapFolderID.find(folder);
+        if (it == fMapFolderID.end())
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Folder not found.");
+
+        RemoveFolderLocked(it->second);
+    }
+
+    void QueueShutdown()
+    {
+        const uint64_t value = 1;
+        if (write(fShutdownHandle, &value, sizeof(value)) != sizeof(value))
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Can not signal shutdown");
+    }
+
+    void InotifyEntryPoint()
+    {
+        alignas(inotify_event) char buffer[BufferSize];
+        pollfd pollHandles[] = { { fInotifyHandle, POLLIN, 0 }, { fShutdownHandle, POLLIN, 0 } };
+
+        for (;;)
+        {
+            if (poll(pollHandles, std::size(pollHandles), -1) == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "can not poll inotify events");
+            }
+
+            if ((pollHandles[1].revents & POLLIN) != 0)
+                break;
+
+            ListFileChangedEventArgs events;
+            {
+                std::lock_guard<std::mutex> lock(fDataMutex);
+                std::optional<PendingMove> pendingMove;
+                ssize_t length;
+                // Drain all available events, a burst is forwarded to the coalescer at once.
+                while ((length = read(fInotifyHandle, buffer, sizeof(buffer))) > 0)
+                    ParseEvents(buffer, static_cast<size_t>(length), pendingMove, events);
+
+                // A file moved out of a watched folder.
+                if (pendingMove.has_value())
+                    events.push_back(FileChangedEventArgs{ pendingMove->folderID, FileChangedOp::Remove, pendingMove->folder, pendingMove->fileName, std::wstring() });
+            }
+
+            QueueEvents(events);
+        }
+    }
+
+private:
+    // Called with fDataMutex held.
+    void RemoveFolderLocked(FolderID folderID)
+    {
+        auto itData = fMapIDData.find(folderID);
+        if (itData == fMapIDData.end())
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Incoherent data structures.");
+
+        // The watch is already gone if the folder itself has been removed.
+        if (inotify_rm_watch(fInotifyHandle, itData->second.watchDescriptor) == -1 && errno != EINVAL)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Could not remove watch.");
+
+        fUniqueIDProvider.Release(itData->second.uniqueID);
+
+        fMapWatchDescriptorID.erase(itData->second.watchDescriptor);
+        fMapFolderID.erase(itData->second.folderPath);
+        fMapIDData.erase(itData);
+    }
+
+    struct PendingMove
+    {
+        uint32_t cookie;
+        FolderID folderID;
+        std::wstring folder;
+        std::wstring fileName;
+    };
+
+    void ParseEvents(const char* buffer, size_t length, std::optional<PendingMove>& pendingMove, ListFileChangedEventArgs& events)
+    {
+        for (size_t offset = 0; offset < length;)
+        {
+            const inotify_event* currentEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + currentEvent->len;
+
+            // IN_MOVED_FROM followed by a matching IN_MOVED_TO is a rename, otherwise the file left the folder.
+            if (pendingMove.has_value() && ((currentEvent->mask & IN_MOVED_TO) == 0 || currentEvent->cookie != pendingMove->cookie))
+            {
+                events.push_back(FileChangedEventArgs{ pendingMove->folderID, FileChangedOp::Remove, pendingMove->folder, pendingMove->fileName, std::wstring() });
+                pendingMove.reset();
+            }
+
+            auto itID = fMapWatchDescriptorID.find(currentEvent->wd);
+            if (itID == fMapWatchDescriptorID.end() || (currentEvent->mask & IN_ISDIR) != 0)
+                continue;
+
+            const FolderData& folderData = fMapIDData.at(itID->second);
+            const std::wstring fileName = currentEvent->len > 0 ? std::filesystem::path(currentEvent->name).wstring() : std::wstring();
+
+            if ((currentEvent->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+            {
+                events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::WatchedFolderRemoved, folderData.folderPath, std::wstring(), std::wstring() });
+                RemoveFolderLocked(folderData.uniqueID);
+            }
+            else if ((currentEvent->mask & IN_MOVED_FROM) != 0)
+            {
+                pendingMove = PendingMove{ currentEvent->cookie, folderData.uniqueID, folderData.folderPath, fileName };
+            }
+            else if ((currentEvent->mask & IN_MOVED_TO) != 0)
+            {
+                if (pendingMove.has_value() && pendingMove->folderID == folderData.uniqueID)
+                {
+                    events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::Rename, folderData.folderPath, pendingMove->fileName, fileName });
+                }
+                else
+                {
+                    // Moved between two watched folders.
+                    if (pendingMove.has_value())
+                        events.push_back(FileChangedEventArgs{ pendingMove->folderID, FileChangedOp::Remove, pendingMove->folder, pendingMove->fileName, std::wstring() });
+                    events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::Add, folderData.folderPath, fileName, std::wstring() });
+                }
+                pendingMove.reset();
+            }
+            else if ((currentEvent->mask & IN_CREATE) != 0)
+            {
+                events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::Add, folderData.folderPath, fileName, std::wstring() });
+            }
+            else if ((currentEvent->mask & IN_DELETE) != 0)
+            {
+                events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::Remove, folderData.folderPath, fileName, std::wstring() });
+            }
+            else if ((currentEvent->mask & IN_CLOSE_WRITE) != 0)
+            {
+                events.push_back(FileChangedEventArgs{ folderData.uniqueID, FileChangedOp::Modified, folderData.folderPath, fileName, std::wstring() });
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t BufferSize = 65536;
+    static constexpr uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+    struct FolderData
+    {
+        UniqueIDProvider::underlying_type uniqueID;
+        int watchDescriptor = -1;
+        std::wstring folderPath;
+    };
+
+    using MapFolderID = std::map <std::wstring, FolderID>;
+    using MapIDData = std::map <FolderID, FolderData>;
+    using MapWatchDescriptorID = std::map <int, FolderID>;
+    MapFolderID fMapFolderID;
+    MapIDData fMapIDData;
+    MapWatchDescriptorID fMapWatchDescriptorID;
+    int fInotifyHandle = -1;
+    int fShutdownHandle = -1;
+    std::mutex fDataMutex;
+    std::thread fFileWatchThread;
+    UniqueIDProvider fUniqueIDProvider{ 1 };
+};
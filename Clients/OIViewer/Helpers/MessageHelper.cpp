@@ -2,7 +2,8 @@
 #include "MessageFormatter.h"
 #include "PixelHelper.h"
 #include  <OIVImage/OIVFileImage.h>
-#include "../ConfigurationLoader.h"
+#include <Memory/ImageItemPool.h>
+#include "../ConfigurationCache.h"
 #include "UnitsHelper.h"
 #include <ImageCodec.h>
 namespace OIV
@@ -41,18 +42,13 @@ namespace OIV
         MessageFormatter::MessagesValues& messageValues = args.messageValues;
 
 
-        auto keybindingsList = ConfigurationLoader::LoadKeyBindings();
-        auto commands = ConfigurationLoader::LoadCommandGroups();
+        ConfigurationCache::SnapshotSharedPtr configuration = ConfigurationCache::GetSingleton().Get();
 
-        for (const auto& binding : keybindingsList)
+        for (const auto& binding : configuration->keyBindings)
         {
-            auto it = std::find_if(commands.begin(), commands.end(), [&](auto& element)->bool
-                {
-                    return element.commandGroupID == binding.GroupID;
-                });
-
-            if (it != commands.end())
-                messageValues.emplace_back(binding.KeyCombinationName, MessageFormatter::ValueObjectList{ {it->commandDisplayName} });
+            const ConfigurationLoader::CommandGroup* commandGroup = configuration->FindCommandGroup(binding.GroupID);
+            if (commandGroup != nullptr)
+                messageValues.emplace_back(binding.KeyCombinationName, MessageFormatter::ValueObjectList{ {commandGroup->commandDisplayName} });
         }
 
         return MessageFormatter::FormatMetaText(args);
@@ -96,7 +92,7 @@ namespace OIV
         return ss.str();
     }
 
-    std::wstring MessageHelper::CreateImageInfoMessage(const OIVBaseImageSharedPtr& oivImage, const OIVBaseImageSharedPtr& rasterized, IMCodec::ImageCodec& imageCodec)
+    std::wstring MessageHelper::CreateImageInfoMessage(const OIVBaseImageSharedPtr& oivImage, const OIVBaseImageSharedPtr& rasterized, IMCodec::ImageCodec& imageCodec, const ImageState::MemoryStats* memoryStats)
     {
 
         using namespace std;
@@ -164,6 +160,20 @@ namespace OIV
 
         messageValues.emplace_back("Codec used", MessageFormatter::ValueObjectList{ {       pluginDescription   } });
 
+        const ImageItemPool::Stats poolStats = ImageItemPool::GetSingleton().GetStats();
+        messageValues.emplace_back("Buffer pool hit rate", MessageFormatter::ValueObjectList{ {static_cast<long double>(poolStats.GetHitRate() * 100.0)} , {"%"} });
+        messageValues.emplace_back("Buffer pool resident", MessageFormatter::ValueObjectList{ {static_cast<long double>(poolStats.residentBytes / (1024.0 * 1024.0))} , {"MB"} });
+
+        if (memoryStats != nullptr)
+        {
+            messageValues.emplace_back("Image chain memory", MessageFormatter::ValueObjectList{ {static_cast<long double>(memoryStats->totalBytes / (1024.0 * 1024.0))} , {"MB"} });
+            if (memoryStats->evictions > 0)
+            {
+                messageValues.emplace_back("Stage evictions", MessageFormatter::ValueObjectList{ { memoryStats->evictions } });
+                messageValues.emplace_back("Stage recompute time", MessageFormatter::ValueObjectList{ {static_cast<long double>(memoryStats->recomputeTimems)} , {"ms"} });
+            }
+        }
+
 
         auto uniqueValues = rasterized->GetNumUniqueColors();
         if (uniqueValues > -1)
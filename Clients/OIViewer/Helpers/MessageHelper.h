@@ -1,4 +1,5 @@
 #include <OIVImage/OIVBaseImage.h>
+#include "../ImageState.h"
 
 namespace IMCodec
 {
@@ -10,7 +11,7 @@ namespace OIV
 	class MessageHelper
 	{
 	public:
-		static std::wstring CreateImageInfoMessage(const OIVBaseImageSharedPtr& oivImage, const OIVBaseImageSharedPtr& rasterized,  IMCodec::ImageCodec& imageCodec);
+		static std::wstring CreateImageInfoMessage(const OIVBaseImageSharedPtr& oivImage, const OIVBaseImageSharedPtr& rasterized,  IMCodec::ImageCodec& imageCodec, const ImageState::MemoryStats* memoryStats = nullptr);
 		static std::wstring CreateKeyBindingsMessage();
 		static std::wstring ParseImageSource(const OIVBaseImageSharedPtr& image);
 		static std::wstring GetFileTime(const std::wstring& filePath);
@@ -17,9 +17,9 @@ namespace OIV
 
         static OIVBaseImageSharedPtr GetRendererCompatibleImage(OIVBaseImageSharedPtr image, bool useRainbow);
      
-        static OIVBaseImageSharedPtr ResampleImage(OIVBaseImageSharedPtr image, LLUtils::PointI32 scale)
+        static OIVBaseImageSharedPtr ResampleImage(OIVBaseImageSharedPtr image, LLUtils::PointI32 scale, ResampleFilter filter = ResampleFilter::Box)
         {
-            auto resampled = ApiGlobal::sPictureRenderer->Resample(image->GetImage(), scale);
+            auto resampled = ApiGlobal::sPictureRenderer->Resample(image->GetImage(), scale, filter);
             if (resampled != nullptr)
             {
                 return std::make_shared<OIVBaseImage>(ImageSource::GeneratedByLib, resampled);
@@ -29,5 +29,13 @@ namespace OIV
                 return nullptr;
             }
         }
+
+        // Resample 'image' as seen through 'transform' without creating the transformed and converted images, returns nullptr
+        // if the texel format of 'image' isn't supported.
+        static OIVBaseImageSharedPtr ResampleImage(OIVBaseImageSharedPtr image, const IMUtil::AxisAlignedTransform& transform, LLUtils::PointI32 scale, ResampleFilter filter = ResampleFilter::Box)
+        {
+            auto resampled = ApiGlobal::sPictureRenderer->ResampleTransformed(image->GetImage(), transform, scale, filter);
+            return resampled != nullptr ? std::make_shared<OIVBaseImage>(ImageSource::GeneratedByLib, resampled) : nullptr;
+        }
     };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "OIVCommands.h"
 #include "Helpers/OIVImageHelper.h"
 #include <ImageUtil/ImageUtil.h>
+#include <Transform/AxisAlignedTransformer.h>
+#include <LLUtils/StopWatch.h>
 
 namespace OIV
 {
@@ -24,6 +26,11 @@ namespace OIV
 
 
     //Image state
+
+    ImageState::~ImageState()
+    {
+        CancelRefinement();
+    }
     
     void ImageState::Refresh()
     {
@@ -46,15 +53,27 @@ namespace OIV
             }
 
             ImageChainStage maxImageStage = std::min(requiredImageStage, fFinalProcessingStage);
+            const bool fuseResample = CanFuseResample(currentStage, maxImageStage);
 
             while (currentStage <= maxImageStage)
             {
                 ImageChainStage previousStage = static_cast<ImageChainStage>(std::max((int)currentStage - 1, 0));
                 ImageChainStage nextStage = static_cast<ImageChainStage>(static_cast<int>(currentStage) + 1);
-                fCurrentImageChain.Get(currentStage) = ProcessStage(currentStage, fCurrentImageChain.Get(previousStage));
+                OIVBaseImageSharedPtr fused;
+                if (fuseResample && currentStage != ImageChainStage::Resampled)
+                    DeferStage(currentStage);
+                else if (fuseResample && (fused = ResampleFused()) != nullptr)
+                    fCurrentImageChain.Get(currentStage) = fused;
+                else
+                {
+                    Rematerialize(previousStage);
+                    fCurrentImageChain.Get(currentStage) = ProcessStage(currentStage, fCurrentImageChain.Get(previousStage));
+                    fEvictedStages[static_cast<size_t>(currentStage)] = false;
+                }
                 currentStage = nextStage;
             }
             fDirtyStage = static_cast<ImageChainStage>( std::min<int>(static_cast<int>(maxImageStage) + static_cast<int>(1), static_cast<int>(ImageChainStage::Count)));
+            EnforceMemoryBudget();
 
         }
     }
@@ -79,6 +98,8 @@ namespace OIV
 
     void ImageState::ClearAll()
     {
+        CancelRefinement();
+        fEvictedStages.fill(false);
         fCurrentImageChain.Reset();
         fOpenedImage.reset();
     }
@@ -158,6 +179,8 @@ namespace OIV
 
                 if (fFinalProcessingStage == ImageChainStage::Rasterized)
                 {
+                    CancelRefinement();
+                    Rematerialize(ImageChainStage::Rasterized);
                     auto rasterized = fCurrentImageChain.Get(ImageChainStage::Rasterized);
                     if (rasterized != nullptr)
                         UpdateImageParameters(rasterized, true);
@@ -249,6 +272,10 @@ namespace OIV
         {
             souceImageSlot->SetVisible(false);
         }
+        CancelRefinement();
+        fSkipPreviewResample = false;
+        fEvictedStages.fill(false);
+
         //Assign the new source image        
         souceImageSlot = image;
         SetDirtyStage(ImageChainStage::SourceImage);
@@ -257,9 +284,146 @@ namespace OIV
     OIVBaseImageSharedPtr& ImageState::GetImage(ImageChainStage imageStage)
     {
         Refresh(imageStage);
+        Rematerialize(imageStage);
         return fCurrentImageChain.Get(imageStage);
     }
 
+    bool ImageState::IsAxesSwapped() const
+    {
+        return fTransform.rotation == IMUtil::AxisAlignedRotation::Rotate90CW || fTransform.rotation == IMUtil::AxisAlignedRotation::Rotate90CCW;
+    }
+
+    LLUtils::PointF64 ImageState::GetTransformedSize() const
+    {
+        const auto& source = fCurrentImageChain.Get(ImageChainStage::SourceImage);
+        if (source == nullptr)
+            return LLUtils::PointF64::Zero;
+
+        const LLUtils::PointF64 size = static_cast<LLUtils::PointF64>(source->GetImage()->GetDimensions());
+        return IsAxesSwapped() ? LLUtils::PointF64(size.y, size.x) : size;
+    }
+
+    std::wstring ImageState::GetTransformedDescription() const
+    {
+        const auto& deformed = fCurrentImageChain.Get(ImageChainStage::Deformed);
+        if (deformed != nullptr)
+            return deformed->GetDescription();
+
+        const auto& source = fCurrentImageChain.Get(ImageChainStage::SourceImage);
+        return source != nullptr ? source->GetDescription(IsAxesSwapped()) : std::wstring();
+    }
+
+    OIVBaseImageSharedPtr ImageState::GetTransformedTexelSource(LLUtils::PointI32& position)
+    {
+        Refresh(ImageChainStage::Deformed);
+        const auto& deformed = fCurrentImageChain.Get(ImageChainStage::Deformed);
+        if (deformed != nullptr)
+            return deformed;
+
+        // The transformed image has been evicted, map the position back to the source image:
+        // undo the flip, which is applied after rotation, then the rotation.
+        const auto& source = fCurrentImageChain.Get(ImageChainStage::SourceImage);
+        const int32_t width = static_cast<int32_t>(source->GetImage()->GetWidth());
+        const int32_t height = static_cast<int32_t>(source->GetImage()->GetHeight());
+        const int32_t transformedWidth = IsAxesSwapped() ? height : width;
+        const int32_t transformedHeight = IsAxesSwapped() ? width : height;
+
+        LLUtils::PointI32 unflipped = position;
+        if ((fTransform.flip & IMUtil::AxisAlignedFlip::Horizontal) == IMUtil::AxisAlignedFlip::Horizontal)
+            unflipped.x = transformedWidth - 1 - unflipped.x;
+        if ((fTransform.flip & IMUtil::AxisAlignedFlip::Vertical) == IMUtil::AxisAlignedFlip::Vertical)
+            unflipped.y = transformedHeight - 1 - unflipped.y;
+
+        switch (fTransform.rotation)
+        {
+        case IMUtil::AxisAlignedRotation::Rotate90CW:
+            position = { unflipped.y, height - 1 - unflipped.x };
+            break;
+        case IMUtil::AxisAlignedRotation::Rotate90CCW:
+            position = { width - 1 - unflipped.y, unflipped.x };
+            break;
+        case IMUtil::AxisAlignedRotation::Rotate180:
+            position = { width - 1 - unflipped.x, height - 1 - unflipped.y };
+            break;
+        default:
+            position = unflipped;
+            break;
+        }
+        return source;
+    }
+
+    void ImageState::SetMemoryBudget(uint64_t budget)
+    {
+        fMemoryStats.budget = budget;
+        EnforceMemoryBudget();
+    }
+
+    uint64_t ImageState::GetStageBytes(ImageChainStage stage) const
+    {
+        const auto& image = fCurrentImageChain.Get(stage);
+        if (image == nullptr || image->GetImage() == nullptr)
+            return 0;
+
+        // Stages which pass their input through share its memory.
+        for (int i = 0; i < static_cast<int>(stage); i++)
+        {
+            const auto& previous = fCurrentImageChain.Get(static_cast<ImageChainStage>(i));
+            if (previous != nullptr && previous->GetImage() == image->GetImage())
+                return 0;
+        }
+        return image->GetImage()->GetTotalSizeOfImageTexels();
+    }
+
+    void ImageState::UpdateMemoryStats()
+    {
+        fMemoryStats.totalBytes = 0;
+        for (int i = 0; i < static_cast<int>(ImageChainStage::Count); i++)
+        {
+            fMemoryStats.stageBytes[i] = GetStageBytes(static_cast<ImageChainStage>(i));
+            fMemoryStats.totalBytes += fMemoryStats.stageBytes[i];
+        }
+    }
+
+    void ImageState::EnforceMemoryBudget()
+    {
+        UpdateMemoryStats();
+        if (fMemoryStats.budget == 0 || fMemoryStats.totalBytes <= fMemoryStats.budget)
+            return;
+
+        // Deformed is only the input of Rasterized, and can be recomputed from the source image with a single transform.
+        // Source is the decoded file, Rasterized is the input of every resample and Resampled may be on display, so these are kept.
+        const uint64_t deformedBytes = fMemoryStats.stageBytes[static_cast<size_t>(ImageChainStage::Deformed)];
+        const auto& rasterized = fCurrentImageChain.Get(ImageChainStage::Rasterized);
+        if (deformedBytes > 0 && rasterized != nullptr && fMemoryStats.stageBytes[static_cast<size_t>(ImageChainStage::Rasterized)] > 0)
+        {
+            fCurrentImageChain.Get(ImageChainStage::Deformed).reset();
+            fEvictedStages[static_cast<size_t>(ImageChainStage::Deformed)] = true;
+            fMemoryStats.evictions++;
+            fMemoryStats.evictedBytes += deformedBytes;
+            UpdateMemoryStats();
+        }
+    }
+
+    void ImageState::Rematerialize(ImageChainStage stage)
+    {
+        auto& slot = fCurrentImageChain.Get(stage);
+        if (slot != nullptr || fEvictedStages[static_cast<size_t>(stage)] == false)
+            return;
+
+        LLUtils::StopWatch stopWatch(true);
+        const ImageChainStage previousStage = static_cast<ImageChainStage>(static_cast<int>(stage) - 1);
+        Rematerialize(previousStage);
+        slot = ProcessStage(stage, fCurrentImageChain.Get(previousStage));
+        fEvictedStages[static_cast<size_t>(stage)] = false;
+        // Processing the rasterized stage displays it, keep displaying the resampled image.
+        if (slot != GetVisibleImage())
+            slot->SetVisible(false);
+
+        fMemoryStats.recomputations++;
+        fMemoryStats.recomputeTimems += stopWatch.GetElapsedTimeReal(LLUtils::StopWatch::TimeUnit::Milliseconds);
+        UpdateMemoryStats();
+    }
+
     ImageChain& ImageState::GetWorkingImageChain()
     {
         return fCurrentImageChain;
@@ -271,6 +435,202 @@ namespace OIV
     }
 
 
+    OIVBaseImageSharedPtr ImageState::Resample(OIVBaseImageSharedPtr rasterized)
+    {
+        OIVBaseImageSharedPtr resampled;
+        if (GetScale().x <= ResampleScaleThreshold && GetScale().y <= ResampleScaleThreshold)
+        {
+            LLUtils::PointF64 originalImageSize = static_cast<LLUtils::PointF64>(rasterized->GetImage()->GetDimensions());
+            const LLUtils::PointI32 targetSize = static_cast<LLUtils::PointI32>((originalImageSize * GetScale()).Round());
+
+            if (fProgressiveResampling == false)
+            {
+                resampled = OIVImageHelper::ResampleImage(rasterized, targetSize);
+            }
+            else
+            {
+                // Display a nearest neighbour resample right away, and replace it with a filtered one once ready.
+                StartRefinement(rasterized, targetSize, false);
+                if (fSkipPreviewResample == false)
+                {
+                    LLUtils::StopWatch stopWatch(true);
+                    resampled = OIVImageHelper::ResampleImage(rasterized, targetSize, ResampleFilter::Nearest);
+                    fSkipPreviewResample = stopWatch.GetElapsedTimeReal(LLUtils::StopWatch::TimeUnit::Milliseconds) > PreviewResampleBudgetms;
+                }
+            }
+        }
+        else
+        {
+            CancelRefinement();
+        }
+
+        if (resampled != nullptr)
+        {
+            //Resampled image is pixel perfect in relation to the client window, so no scale.
+            resampled->SetScale(LLUtils::PointF64::One);
+            rasterized->SetVisible(false);
+            UpdateImageParameters(resampled, true);
+        }
+        else
+        {
+            // Fall back to the unfiltered rasterized image scaled by the renderer.
+            rasterized->SetScale(fScale);
+            UpdateImageParameters(rasterized, true);
+        }
+        return resampled;
+    }
+
+    void ImageState::SetProgressiveResampling(bool progressive)
+    {
+        if (fProgressiveResampling != progressive)
+        {
+            fProgressiveResampling = progressive;
+            CancelRefinement();
+            if (GetResample())
+                SetDirtyStage(ImageChainStage::Resampled);
+        }
+    }
+
+    OIVBaseImageSharedPtr ImageState::ResampleFused()
+    {
+        auto source = fCurrentImageChain.Get(ImageChainStage::SourceImage);
+        const LLUtils::PointI32 targetSize = static_cast<LLUtils::PointI32>((GetTransformedSize() * GetScale()).Round());
+
+        OIVBaseImageSharedPtr resampled;
+        if (fProgressiveResampling == false)
+        {
+            resampled = OIVImageHelper::ResampleImage(source, fTransform, targetSize);
+        }
+        else
+        {
+            // A fused nearest neighbour resample reads a single source texel per target texel,
+            // so unlike the regular preview its cost doesn't depend on the source size.
+            StartRefinement(source, targetSize, true);
+            resampled = OIVImageHelper::ResampleImage(source, fTransform, targetSize, ResampleFilter::Nearest);
+        }
+
+        if (resampled == nullptr)
+        {
+            CancelRefinement();
+            return nullptr;
+        }
+
+        resampled->SetScale(LLUtils::PointF64::One);
+        source->SetVisible(false);
+        UpdateImageParameters(resampled, true);
+        return resampled;
+    }
+
+    bool ImageState::CanFuseResample(ImageChainStage firstStage, ImageChainStage maxImageStage) const
+    {
+        const auto& source = fCurrentImageChain.Get(ImageChainStage::SourceImage);
+        if (fFusedResampling == false
+            || maxImageStage != ImageChainStage::Resampled
+            || fUseRainbowNormalization == true
+            || source == nullptr
+            || GetScale().x > ResampleScaleThreshold || GetScale().y > ResampleScaleThreshold)
+            return false;
+
+        // Resample from the rasterized image when it's already resident.
+        if (firstStage > ImageChainStage::Rasterized && fCurrentImageChain.Get(ImageChainStage::Rasterized) != nullptr)
+            return false;
+
+        // Nothing is saved when the source is displayed as is.
+        if (source->GetImage()->GetTexelFormat() == IMCodec::TexelFormat::I_R8_G8_B8_A8
+            && fTransform.rotation == IMUtil::AxisAlignedRotation::None && fTransform.flip == IMUtil::AxisAlignedFlip::None)
+            return false;
+
+        ResamplerSource resamplerSource;
+        return Resampler::GetResamplerSource(*source->GetImage(), resamplerSource);
+    }
+
+    void ImageState::DeferStage(ImageChainStage stage)
+    {
+        // The stage is computed on demand through Rematerialize.
+        auto& slot = fCurrentImageChain.Get(stage);
+        if (slot != nullptr)
+        {
+            slot->SetVisible(false);
+            slot.reset();
+        }
+        fEvictedStages[static_cast<size_t>(stage)] = true;
+    }
+
+    void ImageState::SetFusedResampling(bool fused)
+    {
+        if (fFusedResampling != fused)
+        {
+            fFusedResampling = fused;
+            if (GetResample())
+                SetDirtyStage(ImageChainStage::Deformed);
+        }
+    }
+
+    void ImageState::StartRefinement(OIVBaseImageSharedPtr image, LLUtils::PointI32 targetSize, bool fused)
+    {
+        // A newer scale supersedes any refinement in flight.
+        CancelRefinement();
+        fCancelRefinement = false;
+        const uint32_t generation = fRefinementGeneration;
+        const IMUtil::AxisAlignedTransform transform = fTransform;
+        fRefinementThread = std::thread([this, generation, targetSize, fused, transform](IMCodec::ImageSharedPtr source)
+            {
+                IMCodec::ImageSharedPtr refined = fused
+                    ? ApiGlobal::sPictureRenderer->ResampleTransformed(source, transform, targetSize, ResampleFilter::Box, &fCancelRefinement)
+                    : ApiGlobal::sPictureRenderer->Resample(source, targetSize, ResampleFilter::Box, &fCancelRefinement);
+                if (refined == nullptr)
+                    return;
+
+                {
+                    std::lock_guard<std::mutex> lock(fRefinedMutex);
+                    fRefinedImage = refined;
+                    fRefinedGeneration = generation;
+                }
+
+                if (fRefinementReadyCallback != nullptr)
+                    fRefinementReadyCallback();
+            }, image->GetImage());
+    }
+
+    void ImageState::CancelRefinement()
+    {
+        fCancelRefinement = true;
+        if (fRefinementThread.joinable())
+            fRefinementThread.join();
+
+        fRefinementGeneration++;
+        std::lock_guard<std::mutex> lock(fRefinedMutex);
+        fRefinedImage.reset();
+    }
+
+    bool ImageState::CommitRefinedResample()
+    {
+        IMCodec::ImageSharedPtr refinedImage;
+        {
+            std::lock_guard<std::mutex> lock(fRefinedMutex);
+            if (fRefinedGeneration != fRefinementGeneration)
+                return false;
+            refinedImage = std::move(fRefinedImage);
+        }
+
+        // The view has changed since, a newer refinement will follow.
+        auto rasterized = fCurrentImageChain.Get(ImageChainStage::Rasterized);
+        if (refinedImage == nullptr || fCurrentImageChain.Get(ImageChainStage::SourceImage) == nullptr || fDirtyStage <= ImageChainStage::Resampled || GetResample() == false)
+            return false;
+
+        auto refined = std::make_shared<OIVBaseImage>(ImageSource::GeneratedByLib, refinedImage);
+        refined->SetScale(LLUtils::PointF64::One);
+        UpdateImageParameters(refined, true);
+
+        auto& resampledSlot = fCurrentImageChain.Get(ImageChainStage::Resampled);
+        if (resampledSlot != nullptr)
+            resampledSlot->SetVisible(false);
+        if (rasterized != nullptr)
+            rasterized->SetVisible(false);
+        resampledSlot = refined;
+        return true;
+    }
+
     OIVBaseImageSharedPtr ImageState::ProcessStage(ImageChainStage stage, OIVBaseImageSharedPtr inputImage)
     {
         switch (stage)
@@ -283,7 +643,7 @@ namespace OIV
         case ImageChainStage::Deformed:
             if (fTransform.rotation != IMUtil::AxisAlignedRotation::None || fTransform.flip != IMUtil::AxisAlignedFlip::None)
             {
-                auto deformed = IMUtil::ImageUtil::Transform(fTransform, inputImage->GetImage());
+                auto deformed = AxisAlignedTransformer::Transform(fTransform, inputImage->GetImage());
 
                 inputImage->SetVisible(false);
 
@@ -310,25 +670,7 @@ namespace OIV
 
 
         case ImageChainStage::Resampled:
-        {
-            if (GetScale().x > ResampleScaleThreshold || GetScale().y > ResampleScaleThreshold)
-            {
-                return nullptr;
-            }
-            else
-            {
-                auto rasterized = fCurrentImageChain.Get(ImageChainStage::Rasterized);
-                LLUtils::PointF64 originalImageSize = static_cast<LLUtils::PointF64>(rasterized->GetImage()->GetDimensions());
-                auto resampled = OIVImageHelper::ResampleImage(rasterized, static_cast<LLUtils::PointI32>((originalImageSize * GetScale()).Round()));
-                //Resampled image is pixel perfect in relation to the client window, so no scale.
-
-                resampled->SetScale(LLUtils::PointF64::One);
-                inputImage->SetVisible(false);
-
-                UpdateImageParameters(resampled, true);
-                return resampled;
-            }
-        }
+            return Resample(inputImage);
             break;
         default:
             LL_EXCEPTION_UNEXPECTED_VALUE;
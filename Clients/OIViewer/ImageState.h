@@ -1,5 +1,9 @@
 #pragma once
 #include <array>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include "OIVImage/OIVBaseImage.h"
 #include "OIVImage/OIVFileImage.h"
 #include <ImageUtil/AxisAlignedTransform.h>
@@ -8,6 +12,8 @@ namespace OIV
 {
     //TODO: adjust resampling conditions
     constexpr double ResampleScaleThreshold = 0.8;
+    // Zoom steps which can't produce a preview resample within this time display the unfiltered image until refined.
+    constexpr double PreviewResampleBudgetms = 8.0;
     enum class ImageChainStage
     {
           SourceImage = 0
@@ -32,6 +38,24 @@ namespace OIV
 
     class ImageState
     {
+    public:
+        // Called from the refinement thread once a high quality resample is ready to be committed.
+        using RefinementReadyCallback = std::function<void()>;
+
+        struct MemoryStats
+        {
+            // Bytes held by each stage, a stage sharing the image of the previous stage holds none.
+            std::array<uint64_t, static_cast<size_t>(ImageChainStage::Count)> stageBytes{};
+            uint64_t totalBytes = 0;
+            uint64_t budget = 0;
+            uint32_t evictions = 0;
+            uint64_t evictedBytes = 0;
+            uint32_t recomputations = 0;
+            double recomputeTimems = 0.0;
+        };
+
+        ~ImageState();
+
     public:// const methods:
 
         OIVBaseImageSharedPtr GetOpenedImage() const { return fOpenedImage; }
@@ -46,10 +70,20 @@ namespace OIV
 
         LLUtils::PointF64 GetVisibleSize();
         OIVBaseImageSharedPtr GetVisibleImage() const;
+        const MemoryStats& GetMemoryStats() const { return fMemoryStats; }
+
+        // Size and description of the transformed (Deformed) image, available without keeping its pixels resident.
+        LLUtils::PointF64 GetTransformedSize() const;
+        std::wstring GetTransformedDescription() const;
 
     public:// mutating methods:
         void SetImageChainRoot(OIVBaseImageSharedPtr image);
         OIVBaseImageSharedPtr& GetImage(ImageChainStage imageStage);
+        // Image to read the texel at 'position' of the transformed image from, 'position' is mapped
+        // to the source image when the transformed image has been evicted.
+        OIVBaseImageSharedPtr GetTransformedTexelSource(LLUtils::PointI32& position);
+        // Intermediate stages that can be recomputed are dropped while the chain holds more than 'budget' bytes, 0 - no limit.
+        void SetMemoryBudget(uint64_t budget);
         void SetScale(LLUtils::PointF64 scale);
         void SetOffset(LLUtils::PointF64 offset);
         void SetUseRainbowNormalization(bool val);
@@ -59,6 +93,15 @@ namespace OIV
         void ResetUserState();
         void SetResample(bool resample);
         void Refresh();
+        // When enabled, every scale change produces an immediate low cost resample which is then refined in the background.
+        void SetProgressiveResampling(bool progressive);
+        bool GetProgressiveResampling() const { return fProgressiveResampling; }
+        // When enabled, zooming out reads the source image through the transform, converting and resampling in a single pass.
+        // The transformed and rasterized images are then created only when requested.
+        void SetFusedResampling(bool fused);
+        void SetRefinementReadyCallback(RefinementReadyCallback callback) { fRefinementReadyCallback = callback; }
+        // Swap in the refined resample, returns false if it's been superseded. Call from the main thread.
+        bool CommitRefinedResample();
 
     private: //methods 
 
@@ -67,6 +110,17 @@ namespace OIV
         void Refresh(ImageChainStage requiredImageStage);
         void UpdateImageParameters(OIVBaseImageSharedPtr visibleImage, bool visible);
 
+        OIVBaseImageSharedPtr Resample(OIVBaseImageSharedPtr rasterized);
+        OIVBaseImageSharedPtr ResampleFused();
+        bool CanFuseResample(ImageChainStage firstStage, ImageChainStage maxImageStage) const;
+        void DeferStage(ImageChainStage stage);
+        void StartRefinement(OIVBaseImageSharedPtr image, LLUtils::PointI32 targetSize, bool fused);
+        void CancelRefinement();
+        bool IsAxesSwapped() const;
+        uint64_t GetStageBytes(ImageChainStage stage) const;
+        void UpdateMemoryStats();
+        void EnforceMemoryBudget();
+        void Rematerialize(ImageChainStage stage);
         bool IsActuallyResampled() const;
         ImageChain& GetWorkingImageChain();
         const ImageChain& GetWorkingImageChain() const;
@@ -80,5 +134,21 @@ namespace OIV
         ImageChainStage fFinalProcessingStage = ImageChainStage::Rasterized;
         LLUtils::PointF64 fScale = LLUtils::PointF64::One;
         LLUtils::PointF64 fOffset = LLUtils::PointF64::Zero;
+
+        // Memory policy
+        MemoryStats fMemoryStats;
+        std::array<bool, static_cast<size_t>(ImageChainStage::Count)> fEvictedStages{};
+
+        // Progressive resampling
+        bool fProgressiveResampling = true;
+        bool fSkipPreviewResample = false;
+        bool fFusedResampling = true;
+        RefinementReadyCallback fRefinementReadyCallback;
+        std::thread fRefinementThread;
+        std::atomic_bool fCancelRefinement = false;
+        uint32_t fRefinementGeneration = 0;
+        std::mutex fRefinedMutex;
+        IMCodec::ImageSharedPtr fRefinedImage;
+        uint32_t fRefinedGeneration = 0;
     };
 }
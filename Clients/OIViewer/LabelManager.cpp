@@ -6,7 +6,7 @@ namespace OIV
 {
 
     
-    LabelManager::LabelManager(FreeType::FreeTypeConnector* freeType)
+    LabelManager::LabelManager(FreeType::FreeTypeConnector* freeType) : fGlyphAtlas(freeType)
     {
         EventManager::GetSingleton().MonitorChange.Add(std::bind(&LabelManager::OnMonitorChange, this,std::placeholders::_1));
         fFreeType = freeType;
@@ -16,10 +16,26 @@ namespace OIV
     {
         std::get<0>(fDPI) = params.monitorDesc.DPIx;
         std::get<1>(fDPI) = params.monitorDesc.DPIy;
+        // Glyphs of the previous DPI are no longer used.
+        fGlyphAtlas.Clear();
         for (auto& [name, text] : fTextLabels)
             text->SetDPI(std::get<0>(fDPI), std::get<1>(fDPI));
     }
 
+    void LabelManager::PreloadFont()
+    {
+        FreeType::TextCreateParams createParams{};
+        createParams.fontPath = sFontPath;
+        createParams.fontSize = 12;
+        createParams.DPIx = std::get<0>(fDPI);
+        createParams.DPIy = std::get<1>(fDPI);
+        createParams.renderMode = FreeType::RenderMode::Antialiased;
+        createParams.text = L"0";
+
+        FreeType::TextMetrics metrics;
+        fFreeType->MeasureText(createParams, metrics);
+    }
+
     void LabelManager::RemoveAll()
     {
         fTextLabels.clear();
@@ -60,6 +76,7 @@ namespace OIV
         text->SetVisible(true);
         text->SetOpacity(1.0);
 
+        text->SetGlyphAtlas(&fGlyphAtlas);
         text->SetDPI(std::get<0>(fDPI), std::get<1>(fDPI));
         text->SetFontPath(sFontPath);
         text->SetFontSize(12);
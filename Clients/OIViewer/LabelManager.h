@@ -2,6 +2,7 @@
 #include <defs.h>
 #include <map>
 #include <OIVImage/OIVTextImage.h>
+#include <Text/GlyphAtlasCache.h>
 #include "EventManager.h"
 namespace FreeType
 {
@@ -22,6 +23,8 @@ namespace OIV
         void Remove(const std::string& labelName);
         OIVTextImage* GetTextLabel(const std::string& labelName);
         OIVTextImage* GetOrCreateTextLabel(const std::string& labelName);
+        // Opens the label font ahead of the first label, safe to call from any thread before labels are created.
+        void PreloadFont();
 
     private:
         void OnMonitorChange(const EventManager::MonitorChangeEventParams& params);
@@ -30,6 +33,8 @@ namespace OIV
 
     private:
         std::tuple<uint16_t, uint16_t> fDPI{ 96,96 };
+        // Shared by all labels, declared before them as labels reference it.
+        GlyphAtlasCache fGlyphAtlas;
         TextLabels fTextLabels;
         FreeType::FreeTypeConnector* fFreeType;
     };
@@ -125,11 +125,13 @@ namespace OIV
             OIV_CMD_SetSelectionRect_Request request = { -1,-1,-1,-1 };
             ExecuteCommand(CommandExecute::OIV_CMD_SetSelectionRect, &request, &NullCommand);
         }
-        static void Init(HANDLE hwnd)
+        static void Init(HANDLE hwnd, const std::wstring& spillFolder, uint64_t imageMemoryBudget)
         {
             // Init OIV renderer
             CmdDataInit init;
             init.parentHandle = reinterpret_cast<std::size_t>(hwnd);
+            init.spillFolder = spillFolder.c_str();
+            init.imageMemoryBudget = imageMemoryBudget;
             if (ExecuteCommand(CommandExecute::CE_Init, &init, &NullCommand) != RC_Success)
                 LL_EXCEPTION(LLUtils::Exception::ErrorCode::RuntimeError, "Unable initialize OIV library");
             
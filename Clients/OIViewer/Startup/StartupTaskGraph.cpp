@@ -0,0 +1,143 @@
+#include "StartupTaskGraph.h"
+#include "StartupTrace.h"
+#include <thread>
+#include <algorithm>
+#include <LLUtils/Exception.h>
+
+namespace OIV
+{
+    StartupTaskGraph::StartupTaskGraph(StartupTrace* trace) : fTrace(trace)
+    {
+
+    }
+
+    StartupTaskGraph::TaskID StartupTaskGraph::Add(std::string name, Affinity affinity, Task task, std::vector<TaskID> dependencies)
+    {
+        const TaskID id = fNodes.size();
+        Node node;
+        node.name = std::move(name);
+        node.affinity = affinity;
+        node.task = std::move(task);
+        node.pendingDependencies = dependencies.size();
+
+        for (TaskID dependency : dependencies)
+        {
+            // Dependencies are added first, the graph can't have cycles.
+            if (dependency >= id)
+                LL_EXCEPTION(LLUtils::Exception::ErrorCode::BadParameters, "Unknown startup task dependency");
+            fNodes.at(dependency).dependents.push_back(id);
+        }
+
+        fNodes.push_back(std::move(node));
+        return id;
+    }
+
+    void StartupTaskGraph::Enqueue(TaskID id)
+    {
+        if (fNodes.at(id).affinity == Affinity::MainThread)
+            fReadyMainThreadTasks.push_back(id);
+        else
+            fReadyWorkerTasks.push_back(id);
+    }
+
+    void StartupTaskGraph::Complete(TaskID id, bool failed)
+    {
+        fRemainingTasks--;
+        for (TaskID dependentID : fNodes.at(id).dependents)
+        {
+            Node& dependent = fNodes.at(dependentID);
+            dependent.failed |= failed;
+            if (--dependent.pendingDependencies == 0)
+            {
+                if (dependent.failed)
+                    Complete(dependentID, true);
+                else
+                    Enqueue(dependentID);
+            }
+        }
+    }
+
+    void StartupTaskGraph::Execute(TaskID id, uint32_t thread)
+    {
+        Node& node = fNodes.at(id);
+        const StartupTrace::Clock::time_point start = StartupTrace::Clock::now();
+        bool failed = false;
+        try
+        {
+            node.task();
+        }
+        catch (...)
+        {
+            failed = true;
+            std::lock_guard lock(fMutex);
+            if (fException == nullptr)
+                fException = std::current_exception();
+        }
+
+        if (fTrace != nullptr)
+            fTrace->AddSpan({ node.name, thread, start, StartupTrace::Clock::now() });
+
+        {
+            std::lock_guard lock(fMutex);
+            Complete(id, failed);
+        }
+        fCondition.notify_all();
+    }
+
+    void StartupTaskGraph::WorkerLoop(uint32_t thread)
+    {
+        std::unique_lock lock(fMutex);
+        for (;;)
+        {
+            fCondition.wait(lock, [this] { return fReadyWorkerTasks.empty() == false || fRemainingTasks == 0; });
+            if (fReadyWorkerTasks.empty())
+                return;
+
+            const TaskID id = fReadyWorkerTasks.front();
+            fReadyWorkerTasks.pop_front();
+            lock.unlock();
+            Execute(id, thread);
+            lock.lock();
+        }
+    }
+
+    void StartupTaskGraph::Run(uint32_t numWorkers)
+    {
+        const size_t numWorkerTasks = std::count_if(fNodes.begin(), fNodes.end(), [](const Node& node) { return node.affinity == Affinity::Worker; });
+        numWorkers = static_cast<uint32_t>(std::min<size_t>(std::max(numWorkers, 1u), numWorkerTasks));
+
+        {
+            std::lock_guard lock(fMutex);
+            fRemainingTasks = fNodes.size();
+            for (TaskID id = 0; id < fNodes.size(); id++)
+                if (fNodes[id].pendingDependencies == 0)
+                    Enqueue(id);
+        }
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < numWorkers; i++)
+            workers.emplace_back(&StartupTaskGraph::WorkerLoop, this, i + 1);
+
+        {
+            std::unique_lock lock(fMutex);
+            for (;;)
+            {
+                fCondition.wait(lock, [this] { return fReadyMainThreadTasks.empty() == false || fRemainingTasks == 0; });
+                if (fReadyMainThreadTasks.empty())
+                    break;
+
+                const TaskID id = fReadyMainThreadTasks.front();
+                fReadyMainThreadTasks.pop_front();
+                lock.unlock();
+                Execute(id, 0);
+                lock.lock();
+            }
+        }
+
+        for (std::thread& worker : workers)
+            worker.join();
+
+        if (fException != nullptr)
+            std::rethrow_exception(fException);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+
+namespace OIV
+{
+    class StartupTrace;
+
+    // Runs the startup of the application as a graph of tasks, each starting once all of its dependencies completed.
+    // Worker tasks run on a pool of threads, main thread tasks, e.g. window and renderer creation, run on the thread calling Run.
+    class StartupTaskGraph
+    {
+    public:
+        using TaskID = size_t;
+        using Task = std::function<void()>;
+
+        enum class Affinity
+        {
+              Worker
+            , MainThread
+        };
+
+        StartupTaskGraph(StartupTrace* trace);
+        TaskID Add(std::string name, Affinity affinity, Task task, std::vector<TaskID> dependencies = {});
+
+        // Returns once all tasks completed. Tasks depending on a task that threw are skipped, and the first exception is rethrown.
+        void Run(uint32_t numWorkers);
+
+    private:
+        struct Node
+        {
+            std::string name;
+            Affinity affinity;
+            Task task;
+            std::vector<TaskID> dependents;
+            size_t pendingDependencies = 0;
+            bool failed = false;
+        };
+
+        // Thread 0 is the main thread, workers are numbered from 1.
+        void Execute(TaskID id, uint32_t thread);
+        void WorkerLoop(uint32_t thread);
+        // Called with fMutex locked.
+        void Complete(TaskID id, bool failed);
+        void Enqueue(TaskID id);
+
+        StartupTrace* fTrace;
+        std::vector<Node> fNodes;
+        std::deque<TaskID> fReadyWorkerTasks;
+        std::deque<TaskID> fReadyMainThreadTasks;
+        size_t fRemainingTasks = 0;
+        std::exception_ptr fException;
+        std::mutex fMutex;
+        std::condition_variable fCondition;
+    };
+}
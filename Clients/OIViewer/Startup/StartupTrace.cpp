@@ -0,0 +1,127 @@
+#include "StartupTrace.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+
+namespace OIV
+{
+    namespace
+    {
+        // Initialized with the rest of the statics of the executable, before main.
+        const StartupTrace::Clock::time_point sProcessStart = StartupTrace::Clock::now();
+    }
+
+    void StartupTrace::Mark(Milestone milestone)
+    {
+        std::lock_guard lock(fMutex);
+        Clock::time_point& timePoint = fMilestones.at(static_cast<size_t>(milestone));
+        if (timePoint == Clock::time_point{})
+            timePoint = Clock::now();
+    }
+
+    void StartupTrace::AddSpan(Span span)
+    {
+        std::lock_guard lock(fMutex);
+        fSpans.push_back(std::move(span));
+    }
+
+    double StartupTrace::ToMilliseconds(Clock::time_point timePoint)
+    {
+        return std::chrono::duration<double, std::milli>(timePoint - sProcessStart).count();
+    }
+
+    const char* StartupTrace::GetMilestoneName(Milestone milestone)
+    {
+        switch (milestone)
+        {
+        case Milestone::Window:
+            return "Time to window";
+        case Milestone::FirstFrame:
+            return "Time to first frame";
+        case Milestone::FirstImage:
+            return "Time to first image";
+        default:
+            return "Unknown";
+        }
+    }
+
+    double StartupTrace::GetMilestoneMilliseconds(Milestone milestone) const
+    {
+        std::lock_guard lock(fMutex);
+        const Clock::time_point timePoint = fMilestones.at(static_cast<size_t>(milestone));
+        return timePoint == Clock::time_point{} ? -1.0 : ToMilliseconds(timePoint);
+    }
+
+    std::wstring StartupTrace::ToString() const
+    {
+        std::wstringstream ss;
+        ss << std::fixed << std::setprecision(1);
+
+        for (size_t i = 0; i < static_cast<size_t>(Milestone::Count); i++)
+        {
+            const Milestone milestone = static_cast<Milestone>(i);
+            const double milliseconds = GetMilestoneMilliseconds(milestone);
+            ss << GetMilestoneName(milestone) << L": ";
+            if (milliseconds < 0)
+                ss << L"N/A";
+            else
+                ss << milliseconds << L" ms";
+            ss << L'\n';
+        }
+
+        std::lock_guard lock(fMutex);
+        for (const Span& span : fSpans)
+        {
+            ss << span.name.c_str() << L" [thread " << span.thread << L"]: " << ToMilliseconds(span.start) << L" - "
+                << ToMilliseconds(span.end) << L" ms\n";
+        }
+
+        return ss.str();
+    }
+
+    bool StartupTrace::Export(const std::wstring& filePath) const
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), ec);
+
+        std::ofstream file(std::filesystem::path(filePath), std::ios::trunc);
+        if (file.is_open() == false)
+            return false;
+
+        // Task and milestone names are plain identifiers, no escaping needed.
+        auto toMicroseconds = [](double milliseconds) { return static_cast<int64_t>(milliseconds * 1000.0); };
+        std::vector<std::string> events;
+
+        for (size_t i = 0; i < static_cast<size_t>(Milestone::Count); i++)
+        {
+            const Milestone milestone = static_cast<Milestone>(i);
+            const double milliseconds = GetMilestoneMilliseconds(milestone);
+            if (milliseconds >= 0)
+            {
+                std::stringstream ss;
+                ss << R"({"name":")" << GetMilestoneName(milestone) << R"(","ph":"i","s":"g","pid":1,"tid":0,"ts":)" << toMicroseconds(milliseconds) << "}";
+                events.push_back(ss.str());
+            }
+        }
+
+        {
+            std::lock_guard lock(fMutex);
+            for (const Span& span : fSpans)
+            {
+                std::stringstream ss;
+                ss << R"({"name":")" << span.name << R"(","ph":"X","pid":1,"tid":)" << span.thread
+                    << R"(,"ts":)" << toMicroseconds(ToMilliseconds(span.start))
+                    << R"(,"dur":)" << toMicroseconds(ToMilliseconds(span.end)) - toMicroseconds(ToMilliseconds(span.start)) << "}";
+                events.push_back(ss.str());
+            }
+        }
+
+        file << R"({"traceEvents":[)" << '\n';
+        for (size_t i = 0; i < events.size(); i++)
+            file << events[i] << (i + 1 < events.size() ? ",\n" : "\n");
+        file << "]}\n";
+
+        return file.good();
+    }
+}
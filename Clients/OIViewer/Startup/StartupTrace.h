@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace OIV
+{
+    // Records the startup of the application: the span of each startup task and the time of user visible milestones.
+    // Times are relative to the process start. The trace can be formatted for display or exported in the
+    // chrome://tracing (Trace Event) format. Thread safe.
+    class StartupTrace
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Milestone
+        {
+              Window        // The main window was created.
+            , FirstFrame    // The window was first shown.
+            , FirstImage    // The first image was displayed.
+            , Count
+        };
+
+        struct Span
+        {
+            std::string name;
+            uint32_t thread;
+            Clock::time_point start;
+            Clock::time_point end;
+        };
+
+        // Only the first time each milestone is reached is recorded.
+        void Mark(Milestone milestone);
+        void AddSpan(Span span);
+
+        // Returns a negative value if the milestone wasn't reached.
+        double GetMilestoneMilliseconds(Milestone milestone) const;
+        std::wstring ToString() const;
+        bool Export(const std::wstring& filePath) const;
+
+    private:
+        static double ToMilliseconds(Clock::time_point timePoint);
+        static const char* GetMilestoneName(Milestone milestone);
+
+        mutable std::mutex fMutex;
+        std::array<Clock::time_point, static_cast<size_t>(Milestone::Count)> fMilestones{};
+        std::vector<Span> fSpans;
+    };
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <future>
 #include <cassert>
+#include <algorithm>
 
 #include "TestApp.h"
 
@@ -43,16 +44,19 @@
 
 #include "OIVImage/OIVFileImage.h"
 #include "OIVImage/OIVRawImage.h"
+#include "Transform/AxisAlignedTransformer.h"
 #include "Helpers/OIVImageHelper.h"
 #include "VirtualStatusBar.h"
 #include "MonitorProvider.h"
 
 #include "ContextMenu.h"
 #include "globals.h"
-#include "ConfigurationLoader.h"
+#include "ConfigurationCache.h"
 #include "Helpers/PixelHelper.h"
 #include "ExceptionHandler.h"
+#include "Startup/StartupTaskGraph.h"
 #include <ImageUtil/ImageUtil.h>
+#include <FileSignature/ImageHeaderProbe.h>
 
 #include "resource.h"
 
@@ -214,6 +218,15 @@ namespace OIV
             fVirtualStatusBar.SetVisible(!fVirtualStatusBar.GetVisible());
             fRefreshOperation.Queue();
         }
+        else if (type == "startupTrace")
+        {
+            result.resValue = L"Startup trace\n" + fStartupTrace.ToString();
+        }
+        else if (type == "exportStartupTrace")
+        {
+            const std::wstring filePath = GetAppDataFolder() + L"StartupTrace.json";
+            result.resValue = fStartupTrace.Export(filePath) ? L"Startup trace exported to: " + filePath : L"Can not export startup trace to: " + filePath;
+        }
 
 
         if (fullscreenModeChanged == true)
@@ -653,6 +666,30 @@ namespace OIV
                 fFileSorter.SetSortType(FileSorter::SortType::Extension);
         }
 
+        else if (sort_type == "capturedate")
+        {
+            if (fFileSorter.GetSortType() == FileSorter::SortType::CaptureDate)
+                reverseDirection = true;
+            else
+                fFileSorter.SetSortType(FileSorter::SortType::CaptureDate);
+        }
+
+        else if (sort_type == "pixelcount")
+        {
+            if (fFileSorter.GetSortType() == FileSorter::SortType::PixelCount)
+                reverseDirection = true;
+            else
+                fFileSorter.SetSortType(FileSorter::SortType::PixelCount);
+        }
+
+        else if (sort_type == "filesize")
+        {
+            if (fFileSorter.GetSortType() == FileSorter::SortType::FileSize)
+                reverseDirection = true;
+            else
+                fFileSorter.SetSortType(FileSorter::SortType::FileSize);
+        }
+
         if (reverseDirection)
         {
             fFileSorter.SetActiveSortDirection(fFileSorter.GetActiveSortDirection() == FileSorter::SortDirection::Ascending ?
@@ -1080,20 +1117,32 @@ namespace OIV
         : fRefreshTimer(std::bind(&TestApp::OnRefreshTimer, this))
         , fRefreshOperation(std::bind(&TestApp::OnRefresh, this))
         , fPreserveImageSpaceSelection(std::bind(&TestApp::OnPreserveSelectionRect, this))
+        , fFileListIndexUpdate([this]() { UpdateOpenedFileIndex(); UpdateTitle(); })
         , fSelectionRect(std::bind(&TestApp::OnSelectionRectChanged, this,std::placeholders::_1, std::placeholders::_2))
         , fVirtualStatusBar(&fLabelManager, std::bind(&TestApp::OnLabelRefreshRequest, this))
         , fFreeType(std::make_unique<FreeType::FreeTypeConnector>())
         , fLabelManager(fFreeType.get())
+        , fDirectoryEnumerator(std::bind(&TestApp::OnFolderEnumerationBatch, this, std::placeholders::_1))
+        , fMetadataIndexer(std::bind(&TestApp::OnMetadataIndexBatch, this, std::placeholders::_1))
+        , fBackgroundDecoder(&fImageLoader, std::bind(&TestApp::OnBackgroundDecodeDone, this, std::placeholders::_1))
         //, fFileCache(&fImageLoader, std::bind(&TestApp::OnImageReady, this, std::placeholders::_1))
          
        
     {
+        fListFiles.SetComparator(std::ref(fFileSorter));
+        fFileSorter.SetMetadataIndex(&fMetadataIndex);
+        fMetadataIndexer.SetIndexFolder(GetAppDataFolder() + L"MetadataIndex/");
+        ConfigurationCache::GetSingleton().SetSnapshotFolder(GetAppDataFolder() + L"Configuration/");
+        fImageState.SetRefinementReadyCallback([this]()
+            {
+                PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_RESAMPLE_REFINED, 0, 0);
+            });
        // LLUtils::Exception::SetThrowErrorsInDebug(false);
         EventManager::GetSingleton().MonitorChange.Add(std::bind(&TestApp::OnMonitorChanged, this, std::placeholders::_1));
 
         RegisterExceptionhandler();
 
-        OIV_CMD_RegisterCallbacks_Request request;
+        OIV_CMD_RegisterCallbacks_Request request = {};
 
         
 
@@ -1120,12 +1169,8 @@ namespace OIV
         );
     }
 
-    void TestApp::AddCommandsAndKeyBindings()
+    void TestApp::AddCommandsAndKeyBindings(const ConfigurationLoader::CommandGroupList& commandGroups, const ConfigurationLoader::KeyBindingList& keyBindings)
     {
-
-        auto commandGroups = ConfigurationLoader::LoadCommandGroups();
-        auto keyBindings = ConfigurationLoader::LoadKeyBindings();
-
         for (const auto& commandGroup : commandGroups)
         {
             fCommandManager.AddCommandGroup(
@@ -1209,7 +1254,7 @@ namespace OIV
             {
                 fRefreshTimer.Enable(false);
                 //Refresh immediately
-                OIVCommands::Refresh();
+                RenderFrame();
                 fLastRefreshTime = now;
                 //Clear last image chain if exists, this operation is deffered to this moment to display the new image faster.
             }
@@ -1225,10 +1270,17 @@ namespace OIV
         }
         else
         {
-            OIVCommands::Refresh();
+            RenderFrame();
         }
     }
 
+    void TestApp::RenderFrame()
+    {
+        // Status bar changes since the last frame are applied at once.
+        fVirtualStatusBar.Update();
+        OIVCommands::Refresh();
+    }
+
     void TestApp::OnSelectionRectChanged(const LLUtils::RectI32& selectionRect, bool isVisible)
     {
         if (isVisible)
@@ -1249,7 +1301,7 @@ namespace OIV
     void TestApp::OnRefreshTimer()
     {
         using namespace std::chrono;
-        OIVCommands::Refresh();
+        RenderFrame();
         fLastRefreshTime = high_resolution_clock::now();
     }
     
@@ -1330,6 +1382,8 @@ namespace OIV
    
     void TestApp::UnloadOpenedImaged()
     {
+        // A virtualized text paste is displayed in place of the opened image, it's closed along with it.
+        fVirtualText.reset();
         fImageState.ClearAll();
         fRefreshOperation.Queue();
         UpdateOpenImageUI();
@@ -1368,7 +1422,7 @@ namespace OIV
         }
         else
         {
-            ProcessRemovalOfOpenedFile(fileNameToRemove);
+            ProcessRemovalOfOpenedFile(fileNameToRemove, fCurrentFileIndex);
         }
     }
 
@@ -1411,7 +1465,7 @@ namespace OIV
         auto bgraImage = IMUtil::ImageUtil::ConvertImageWithNormalization(image , IMCodec::TexelFormat::I_B8_G8_R8_A8, false);  
         
         // Flip vertically.
-        bgraImage = IMUtil::ImageUtil::Transform({ IMUtil::AxisAlignedRotation::None,IMUtil::AxisAlignedFlip::Vertical }, bgraImage);
+        AxisAlignedTransformer::TransformInPlace({ IMUtil::AxisAlignedRotation::None,IMUtil::AxisAlignedFlip::Vertical }, bgraImage);
 
         // Create 32 bit BGRA color image
         
@@ -1569,12 +1623,118 @@ namespace OIV
         std::wstring normalizedPath = std::filesystem::path(filePath).lexically_normal().wstring();
       //  fFileCache.Add(normalizedPath);
 
+        if (LoadEmbeddedPreview(normalizedPath, loaderFlags, GetFileLoadParameters()))
+            return true;
+
         std::shared_ptr<OIVFileImage> file = std::make_shared<OIVFileImage>(normalizedPath);
         
-        IMCodec::Parameters params = { {L"canvasWidth", (int)fWindow.GetClientSize().cx}, {L"canvasHeight", (int)fWindow.GetClientSize().cy} };
+        ResultCode result = file->Load(&fImageLoader, loaderFlags, IMCodec::ImageLoadFlags::None, GetFileLoadParameters(), fDecodedImageCache.get());
 
-        ResultCode result = file->Load(&fImageLoader, loaderFlags, IMCodec::ImageLoadFlags::None, params);
+        const auto& codecSelection = file->GetCodecSelection();
+        if (codecSelection.traversalSkipped)
+        {
+            std::wstringstream ss;
+            ss << L"File signature: " << normalizedPath << L", detected format: " << codecSelection.detectedFormat
+                << L", plugin traversal skipped";
 
+            IMCodec::PluginProperties properties;
+            if (result == RC_Success && fImageLoader.GetImageCodec().GetPluginInfo(file->GetImage()->GetProcessData().pluginUsed, properties) == IMCodec::ImageResult::Success)
+                ss << L", plugin used: " << properties.pluginDescription;
+
+            mLogFile.Log(ss.str());
+        }
+
+        return ProcessFileLoadResult(file, result);
+    }
+
+    bool TestApp::LoadEmbeddedPreview(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode, const IMCodec::Parameters& params)
+    {
+        // A preview is displayed fitted to the window, replacing it with the full image keeps the same on screen size.
+        if (fEmbeddedPreviewEnabled == false || fResetTransformationMode != ResetTransformationMode::ResetAll)
+            return false;
+
+        auto preview = std::make_shared<OIVFileImage>(filePath);
+        if (preview->LoadEmbeddedPreview(&fImageLoader) != RC_Success)
+            return false;
+
+        // Not worth it when the full image is about as small as the preview, or when the full image can't be displayed anyway.
+        const LLUtils::PointI32 fullImageSize = preview->GetFullImageSize();
+        const uint64_t fullImagePixels = static_cast<uint64_t>(fullImageSize.x) * fullImageSize.y;
+        const uint64_t previewPixels = static_cast<uint64_t>(preview->GetImage()->GetWidth()) * preview->GetImage()->GetHeight();
+        if (fullImagePixels < previewPixels * MinPreviewReductionFactor || fullImageSize.x > MaxImageDimension || fullImageSize.y > MaxImageDimension)
+            return false;
+
+        LoadOivImage(preview);
+        fBackgroundDecoder.Decode(std::make_shared<OIVFileImage>(filePath), traverseMode, params, fDecodedImageCache);
+        return true;
+    }
+
+    void TestApp::OnBackgroundDecodeDone(BackgroundDecoder::Result&& result)
+    {
+        // The main thread takes ownership of the result.
+        auto pendingResult = new BackgroundDecoder::Result(std::move(result));
+        if (PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_BACKGROUND_DECODE, reinterpret_cast<WPARAM>(pendingResult), 0) == FALSE)
+            delete pendingResult;
+    }
+
+    void TestApp::ProcessBackgroundDecodeResult(BackgroundDecoder::Result* resultPtr)
+    {
+        std::unique_ptr<BackgroundDecoder::Result> result(resultPtr);
+
+        // Discard the result if another image has been opened since the preview was displayed.
+        auto preview = std::dynamic_pointer_cast<OIVFileImage>(fImageState.GetOpenedImage());
+        if (result->generation != fBackgroundDecoder.GetGeneration() || preview == nullptr || preview->IsPreview() == false
+            || preview->GetFileName() != result->file->GetFileName())
+            return;
+
+        if (result->result != RC_Success)
+        {
+            fUndecodableFiles.Add(result->file->GetFileName());
+            ProcessFileLoadResult(result->file, result->result);
+            return;
+        }
+
+        // Keep the view the user may have set on the preview, in the coordinates of the full image.
+        const bool isFitToScreen = fIsLockFitToScreen;
+        const double previewToFullScale = static_cast<double>(preview->GetImage()->GetWidth()) / preview->GetFullImageSize().x;
+        const double scale = GetScale() * previewToFullScale;
+        const LLUtils::PointF64 offset = GetOffset();
+
+        fRefreshOperation.Begin();
+        ProcessFileLoadResult(result->file, result->result);
+        if (isFitToScreen == false)
+        {
+            SetZoomInternal(scale, -1, -1);
+            SetOffset(offset);
+        }
+        fRefreshOperation.End();
+    }
+
+    void TestApp::UpdateDecodedImageCache()
+    {
+        if (fDecodedImageCacheEnabled == false)
+        {
+            fDecodedImageCache.reset();
+        }
+        else if (fDecodedImageCache == nullptr)
+        {
+            fDecodedImageCache = std::make_shared<DecodedImageCache>(GetAppDataFolder() + L"DecodedImageCache/"
+                , fDecodedImageCacheBudget, fDecodedImageCacheMinDecodeTime);
+        }
+        else
+        {
+            fDecodedImageCache->SetBudget(fDecodedImageCacheBudget);
+            fDecodedImageCache->SetMinDecodeTime(fDecodedImageCacheMinDecodeTime);
+        }
+    }
+
+    IMCodec::Parameters TestApp::GetFileLoadParameters() const
+    {
+        return { {L"canvasWidth", (int)fWindow.GetClientSize().cx}, {L"canvasHeight", (int)fWindow.GetClientSize().cy} };
+    }
+
+    bool TestApp::ProcessFileLoadResult(std::shared_ptr<OIVFileImage> file, ResultCode result)
+    {
         auto formattedFilePath = MessageFormatter::FormatFilePath(file->GetFileName()) + L"<textcolor=#ff8930>";
 
         using namespace std::string_literals;
@@ -1582,7 +1742,7 @@ namespace OIV
         {
         case ResultCode::RC_Success:
         {
-            if (file->GetImage()->GetWidth() <= 16384 && file->GetImage()->GetHeight() <= 16384)
+            if (file->GetImage()->GetWidth() <= MaxImageDimension && file->GetImage()->GetHeight() <= MaxImageDimension)
             {
                 LoadOivImage(file);
             }
@@ -1590,7 +1750,7 @@ namespace OIV
             {
                 using namespace std::string_literals;
                 SetUserMessage(L"Can not load the file: "s + formattedFilePath + \
-                    L", image dimensions are more than 16384: ", static_cast<GroupID>(UserMessageGroups::FailedFileLoad), MessageFlags::Persistent);
+                    L", image dimensions are more than "s + std::to_wstring(MaxImageDimension) + L": ", static_cast<GroupID>(UserMessageGroups::FailedFileLoad), MessageFlags::Persistent);
             }
         }
 
@@ -1612,6 +1772,8 @@ namespace OIV
 
         if (oivImage->GetImage() == nullptr)
             LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Expected a valid image");
+
+        fVirtualText.reset();
         
         fFileDisplayTimer.Start();
 
@@ -1644,6 +1806,7 @@ namespace OIV
 
         fRefreshOperation.End();
         fFileDisplayTimer.Stop();
+        fStartupTrace.Mark(StartupTrace::Milestone::FirstImage);
 
         LoadSubImages();
 
@@ -1682,7 +1845,7 @@ namespace OIV
         if (IsImageOpen())
         {
             UpdateTitle();
-            fVirtualStatusBar.SetText("imageDescription", fImageState.GetImage(ImageChainStage::Deformed)->GetDescription());
+            fVirtualStatusBar.SetText("imageDescription", fImageState.GetTransformedDescription());
         }
     }
 
@@ -1707,10 +1870,10 @@ namespace OIV
     {
         if (IsOpenedImageIsAFile())
         {
-            LLUtils::ListWStringIterator it = std::find(fListFiles.begin(), fListFiles.end(), GetOpenedFileName());
+            const FileIndexType index = fListFiles.IndexOf(GetOpenedFileName());
 
-            if (it != fListFiles.end())
-                fCurrentFileIndex = std::distance(fListFiles.begin(), it);
+            if (index != IndexedFileList::npos)
+                fCurrentFileIndex = index;
         }
     }
 
@@ -1718,7 +1881,8 @@ namespace OIV
 
     void TestApp::SortFileList()
     {
-        std::sort(fListFiles.begin(), fListFiles.end(), fFileSorter);
+        fFileSorter.PrepareSort(fListFiles.ToVector());
+        fListFiles.Sort();
     }
 
     void TestApp::LoadFileInFolder(std::wstring absoluteFilePath)
@@ -1729,17 +1893,182 @@ namespace OIV
 
         if (absoluteFolderPath != fListedFolder)
         {
-            auto fileList = GetSupportedFileListInFolder(absoluteFolderPath);
-
             //File is loaded from a different folder then the active one.
-            std::swap(fListFiles, fileList);
-            fCurrentFileIndex = FileIndexStart;
-            fListedFolder = absoluteFolderPath;
+            //Keep the opened file navigable while the rest of the folder is enumerated in the background.
+            EnumerateFolder(absoluteFolderPath);
+            if (IsKnownFileType(absoluteFilePath))
+                fListFiles.Insert(absoluteFilePath);
         }
         
         UpdateOpenedFileIndex();
     }
 
+    void TestApp::EnumerateFolder(const std::wstring& folderPath)
+    {
+        // Supersedes a folder being opened.
+        fOpenedFolder.reset();
+        fUndecodableFiles.SetFolder(folderPath);
+        fListFiles.clear();
+        fCurrentFileIndex = FileIndexStart;
+        fListedFolder = folderPath;
+        fIsFolderEnumerationPending = true;
+        fDirectoryEnumerator.Start(folderPath, fKnownFileTypesSet);
+    }
+
+    void TestApp::OnFolderEnumerationBatch(DirectoryEnumerator::Batch&& batch)
+    {
+        // The main thread takes ownership of the batch.
+        auto pendingBatch = new DirectoryEnumerator::Batch(std::move(batch));
+        if (PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_FOLDER_ENUMERATION, reinterpret_cast<WPARAM>(pendingBatch), 0) == FALSE)
+            delete pendingBatch;
+    }
+
+    void TestApp::MergeFolderEnumerationBatch(DirectoryEnumerator::Batch* batchPtr)
+    {
+        std::unique_ptr<DirectoryEnumerator::Batch> batch(batchPtr);
+
+        // Discard batches of a superseded enumeration.
+        if (batch->generation != fDirectoryEnumerator.GetGeneration())
+            return;
+
+        if (fOpenedFolder.has_value() && batch->folder == fOpenedFolder->folder)
+        {
+            MergeOpenedFolderBatch(*batch);
+            return;
+        }
+
+        if (batch->folder != fListedFolder)
+            return;
+
+        // Files already in the list, e.g. the opened file or files reported by the file watcher, are ignored.
+        for (const std::wstring& filePath : batch->files)
+            fListFiles.Insert(filePath);
+
+        if (batch->completed)
+        {
+            fIsFolderEnumerationPending = false;
+            StartMetadataIndexing();
+        }
+
+        UpdateOpenedFileIndex();
+        UpdateTitle();
+    }
+
+    void TestApp::OpenFolder(const std::wstring& folderPath, bool activateWindow)
+    {
+        fOpenedFolder.emplace();
+        fOpenedFolder->folder = folderPath;
+        fOpenedFolder->files.SetComparator(std::ref(fFileSorter));
+        fOpenedFolder->undecodableFiles.SetFolder(folderPath);
+        fOpenedFolder->activateWindow = activateWindow;
+        fDirectoryEnumerator.Start(folderPath, fKnownFileTypesSet);
+    }
+
+    void TestApp::MergeOpenedFolderBatch(DirectoryEnumerator::Batch& batch)
+    {
+        const bool isFirstBatch = fOpenedFolder->files.empty();
+        for (const std::wstring& filePath : batch.files)
+            fOpenedFolder->files.Insert(filePath);
+
+        // Display the first file of the first batch, if none could be loaded retry once the whole folder is listed.
+        if (((isFirstBatch && fOpenedFolder->files.empty() == false) || batch.completed) && TryLoadOpenedFolder(batch.completed))
+            return;
+
+        if (batch.completed)
+        {
+            using namespace std::string_literals;
+            SetUserMessage(L"Can not open the folder: "s + MessageFormatter::FormatFilePath(fOpenedFolder->folder) + L"<textcolor=#ff8930>, no image could be loaded"s
+                , static_cast<GroupID>(UserMessageGroups::FailedFileLoad), MessageFlags::Persistent);
+            fOpenedFolder.reset();
+
+            // Opening the folder superseded the enumeration of the listed folder, the files already listed are kept.
+            if (fIsFolderEnumerationPending)
+                fDirectoryEnumerator.Start(fListedFolder, fKnownFileTypesSet);
+        }
+    }
+
+    bool TestApp::TryLoadOpenedFolder(bool isEnumerationCompleted)
+    {
+        // Navigate the opened folder as if it was listed, the listed folder is restored if none of its files loads.
+        const FileIndexType previousFileIndex = fCurrentFileIndex;
+        std::swap(fListFiles, fOpenedFolder->files);
+        std::swap(fListedFolder, fOpenedFolder->folder);
+        std::swap(fUndecodableFiles, fOpenedFolder->undecodableFiles);
+        fCurrentFileIndex = FileIndexStart;
+
+        if (JumpFiles(FileIndexStart) == false)
+        {
+            std::swap(fListFiles, fOpenedFolder->files);
+            std::swap(fListedFolder, fOpenedFolder->folder);
+            std::swap(fUndecodableFiles, fOpenedFolder->undecodableFiles);
+            fCurrentFileIndex = previousFileIndex;
+            return false;
+        }
+
+        const bool activateWindow = fOpenedFolder->activateWindow;
+        fOpenedFolder.reset();
+        fIsFolderEnumerationPending = isEnumerationCompleted == false;
+        if (isEnumerationCompleted)
+            StartMetadataIndexing();
+
+        if (activateWindow)
+            fWindow.SetForground();
+
+        UpdateOpenedFileIndex();
+        UpdateTitle();
+        return true;
+    }
+
+    void TestApp::StartMetadataIndexing()
+    {
+        fMetadataIndex.SetFolder(fListedFolder);
+        fMetadataIndexer.Start(fListedFolder, fListFiles.ToVector());
+    }
+
+    void TestApp::OnMetadataIndexBatch(MetadataIndexer::Batch&& batch)
+    {
+        // The main thread takes ownership of the batch.
+        auto pendingBatch = new MetadataIndexer::Batch(std::move(batch));
+        if (PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_METADATA_INDEX, reinterpret_cast<WPARAM>(pendingBatch), 0) == FALSE)
+            delete pendingBatch;
+    }
+
+    void TestApp::MergeMetadataIndexBatch(MetadataIndexer::Batch* batchPtr)
+    {
+        std::unique_ptr<MetadataIndexer::Batch> batch(batchPtr);
+
+        // Discard batches of a superseded indexing.
+        if (batch->generation != fMetadataIndexer.GetGeneration() || batch->folder != fMetadataIndex.GetFolder())
+            return;
+
+        for (const auto& [filePath, entry] : batch->entries)
+            fMetadataIndex.Set(filePath, entry);
+
+        // Order of the list depends on the index.
+        if (fFileSorter.IsMetadataSort() && batch->entries.empty() == false)
+        {
+            SortFileList();
+            UpdateOpenedFileIndex();
+            UpdateTitle();
+        }
+    }
+
+    void TestApp::IndexFileMetadata(const std::wstring& filePath)
+    {
+        if (fMetadataIndex.GetFolder() == fListedFolder)
+            fMetadataIndex.Set(filePath, MetadataIndexer::CreateEntry(filePath));
+    }
+
+    bool TestApp::IsKnownFileType(const std::wstring& filePath) const
+    {
+        std::wstring extension = LLUtils::StringUtility::ToLower(std::filesystem::path(filePath).extension().wstring());
+        std::wstring_view sv(extension);
+        if (sv.empty() == false)
+            sv = sv.substr(1);
+
+        return fKnownFileTypesSet.contains(sv.data());
+    }
+
     void TestApp::OnScroll(const LLUtils::PointF64& panAmount)
     {
         Pan(panAmount);
@@ -1769,38 +2098,10 @@ namespace OIV
         fRefreshOperation.Queue();
     }
 
-    void TestApp::Init(std::wstring relativeFilePath)
+    void TestApp::CreateMainWindow()
     {
-        using namespace std;
-        using namespace placeholders;
-        
-        wstring filePath = LLUtils::FileSystemHelper::ResolveFullPath(relativeFilePath);
-        filePath = std::filesystem::path(filePath).lexically_normal();
-    
-        const bool isDirectory = std::filesystem::is_directory(filePath);
-
-        const bool isInitialFileProvided = filePath.empty() == false && isDirectory == false;
-        const bool isInitialFileExists = isInitialFileProvided && filesystem::exists(filePath);
+        using namespace std::placeholders;
 
-        if (isDirectory)
-            fPendingFolderLoad = filePath;
-        
-        
-        future <bool> asyncResult;
-        
-        if (isInitialFileExists == true)
-        {
-            fIsTryToLoadInitialFile = true;
-                 
-            // if initial file is provided, load asynchronously.
-            asyncResult = async(launch::async, [&]() ->bool
-                {
-                    fInitialFile = std::make_shared<OIVFileImage>(filePath);
-                    return fInitialFile->Load(&fImageLoader, IMCodec::PluginTraverseMode::NoTraverse) == RC_Success;
-                }
-            );
-        }
-        
         // initialize the windowing system of the window
         fWindow.Create();
         fWindow.SetMenuChar(false);
@@ -1872,25 +2173,76 @@ namespace OIV
                  RefreshImage();
              });
 
+        fStartupTrace.Mark(StartupTrace::Milestone::Window);
+    }
 
-         fMessageManager = std::make_unique<MessageManager>(fWindow.GetHandle(), &fLabelManager, 5, [&]()->void
-         {
-                 fRefreshOperation.Queue();
-         });
+    void TestApp::Init(std::wstring relativeFilePath)
+    {
+        using namespace std;
+        using namespace placeholders;
         
-        OIVCommands::Init(fWindow.GetCanvasHandle());
+        wstring filePath = LLUtils::FileSystemHelper::ResolveFullPath(relativeFilePath);
+        filePath = std::filesystem::path(filePath).lexically_normal();
+    
+        const bool isDirectory = std::filesystem::is_directory(filePath);
 
-        // Update oiv lib client size
-        UpdateWindowSize();
+        const bool isInitialFileProvided = filePath.empty() == false && isDirectory == false;
+        const bool isInitialFileExists = isInitialFileProvided && filesystem::exists(filePath);
 
-        // Wait for initial file to finish loading
+        if (isDirectory)
+            fPendingFolderLoad = filePath;
+        
+        // Startup runs as a task graph, configuration parsing, font loading and codecs enumeration run on workers
+        // concurrently with the creation of the window and the renderer on the main thread.
+        using Affinity = StartupTaskGraph::Affinity;
+        StartupTaskGraph startup(&fStartupTrace);
         bool isInitialFileLoadedSuccesfuly = false;
-        if (asyncResult.valid())
+        
+        if (isInitialFileExists == true)
+        {
+            fIsTryToLoadInitialFile = true;
+                 
+            // if initial file is provided, load asynchronously.
+            startup.Add("Initial file", Affinity::Worker, [&]()
+                {
+                    fInitialFile = std::make_shared<OIVFileImage>(filePath);
+                    isInitialFileLoadedSuccesfuly = fInitialFile->Load(&fImageLoader, IMCodec::PluginTraverseMode::NoTraverse) == RC_Success;
+                }
+            );
+        }
+
+        startup.Add("Configuration", Affinity::Worker, [this]()
+            {
+                fStartupConfiguration = ConfigurationCache::GetSingleton().Get();
+            });
+
+        const auto fontTask = startup.Add("Font", Affinity::Worker, [this]() { fLabelManager.PreloadFont(); });
+        const auto codecsTask = startup.Add("Codecs", Affinity::Worker, [this]() { BuildFileDialogFilters(); });
+        const auto windowTask = startup.Add("Window", Affinity::MainThread, [this]() { CreateMainWindow(); });
+        const auto rendererTask = startup.Add("Renderer", Affinity::MainThread, [this]() { OIVCommands::Init(fWindow.GetCanvasHandle(), GetAppDataFolder() + L"Spill/", ImageMemoryBudget); }, { windowTask });
+
+        // Enumerate the folder of the initial file while the file is being decoded.
+        if (isInitialFileExists == true)
         {
-            asyncResult.wait();
-            isInitialFileLoadedSuccesfuly = asyncResult.get();
+            startup.Add("Folder", Affinity::MainThread, [this, filePath]()
+                {
+                    EnumerateFolder(std::filesystem::path(filePath).parent_path());
+                }, { windowTask, codecsTask });
         }
 
+        startup.Add("Layout", Affinity::MainThread, [this]()
+            {
+                fMessageManager = std::make_unique<MessageManager>(fWindow.GetHandle(), &fLabelManager, 5, [&]()->void
+                {
+                        fRefreshOperation.Queue();
+                });
+
+                // Update oiv lib client size
+                UpdateWindowSize();
+            }, { rendererTask, fontTask });
+
+        startup.Run(std::thread::hardware_concurrency());
+
         // If there is no initial file or the file has failed to load, show the window now, otherwise show the window after 
         // the image has rendered completely at the method FinalizeImageLoad.
         fWindow.SetVisible(!isInitialFileLoadedSuccesfuly);
@@ -1952,10 +2304,12 @@ namespace OIV
         }
     }
 
-    void TestApp::ProcessRemovalOfOpenedFile(const std::wstring& fileName)
+    void TestApp::ProcessRemovalOfOpenedFile(const std::wstring& fileName, FileIndexType removedFileIndex)
     {
         if (fileName == GetOpenedFileName())
         {
+            // The index might be stale while a batch of file changes is processed.
+            fCurrentFileIndex = removedFileIndex;
             const bool internally = fRequestedFileForRemoval == GetOpenedFileName();
 
             bool shouldRemoveFile = (internally == true &&  (fDeletedFileRemovalMode & DeletedFileRemovalMode::DeletedInternally) == DeletedFileRemovalMode::DeletedInternally)
@@ -1999,14 +2353,13 @@ namespace OIV
             }
 
             fRequestedFileForRemoval = {};
+            UpdateTitle();
         }
         else
         {
-            // File has been added to the current folder, indices have changed - update current file index
-            auto itCurrentFile = std::lower_bound(fListFiles.begin(), fListFiles.end(), GetOpenedFileName(), fFileSorter);
-            fCurrentFileIndex = std::distance(fListFiles.begin(), itCurrentFile);
+            // File has been removed from the current folder, indices have changed - update current file index
+            fFileListIndexUpdate.Queue();
         }
-        UpdateTitle();
     }
 
     void TestApp::UpdateFileList(FileWatcher::FileChangedOp fileOp, const std::wstring& filePath, const std::wstring& filePath2)
@@ -2016,50 +2369,36 @@ namespace OIV
         case FileWatcher::FileChangedOp::Add:
         {
             //Add file to list only if it's a known file type
-            std::wstring extension = LLUtils::StringUtility::ToLower(std::filesystem::path(filePath).extension().wstring());
-            std::wstring_view sv(extension);
-            if (sv.empty() == false)
-                sv = sv.substr(1);
-
-            if (fKnownFileTypesSet.contains(sv.data()))
+            if (IsKnownFileType(filePath))
             {
-                //TODO: add file sorted 
-                auto itAddedFile = std::lower_bound(fListFiles.begin(), fListFiles.end(), filePath, fFileSorter);
+                // Index the file before inserting it, its position may depend on its metadata.
+                IndexFileMetadata(filePath);
 
-                if (itAddedFile != fListFiles.end() && *itAddedFile == filePath)
+                // While the folder is enumerated the file might have been already listed.
+                if (fListFiles.Insert(filePath) == IndexedFileList::npos && fIsFolderEnumerationPending == false)
                         LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Trying to add an existing file");
 
-                fListFiles.insert(itAddedFile, filePath);
-                
                 // File has been added to the current folder, indices have changed - update current file index
-                auto itCurrentFile = std::lower_bound(fListFiles.begin(), fListFiles.end(), GetOpenedFileName(), fFileSorter);
-   	            fCurrentFileIndex = std::distance(fListFiles.begin(), itCurrentFile);
- 
-                UpdateTitle();
+                fFileListIndexUpdate.Queue();
             }
         }
         break;
 
         case FileWatcher::FileChangedOp::Remove:
         {
-            auto it = std::find(fListFiles.begin(), fListFiles.end(), filePath);
-            if (it != fListFiles.end())
-            {
-                auto fileNameToRemove = *it;
-                fListFiles.erase(it);
-                ProcessRemovalOfOpenedFile(fileNameToRemove);
-            }
+            const FileIndexType removedFileIndex = fListFiles.Remove(filePath);
+            fMetadataIndex.Remove(filePath);
+            if (removedFileIndex != IndexedFileList::npos)
+                ProcessRemovalOfOpenedFile(filePath, removedFileIndex);
         }
         break;
         case FileWatcher::FileChangedOp::Rename:
         {
-            auto it = std::find(fListFiles.begin(), fListFiles.end(), filePath);
-            if (it != fListFiles.end())
+            if (fListFiles.Remove(filePath) != IndexedFileList::npos)
             {
-                auto fileNameToRemove = *it;
-                fListFiles.erase(it);
-                auto itRenamedFile = std::lower_bound(fListFiles.begin(), fListFiles.end(), filePath2, fFileSorter);
-                fListFiles.insert(itRenamedFile, filePath2);
+                fMetadataIndex.Remove(filePath);
+                IndexFileMetadata(filePath2);
+                fListFiles.Insert(filePath2);
 
                 if (filePath == GetOpenedFileName())
                 {
@@ -2068,10 +2407,8 @@ namespace OIV
                 }
                 else
                 {
-                    // File has been added to the current folder, indices have changed - update current file index
-                    auto itCurrentFile = std::lower_bound(fListFiles.begin(), fListFiles.end(), GetOpenedFileName(), fFileSorter);
-                    fCurrentFileIndex = std::distance(fListFiles.begin(), itCurrentFile);
-                    UpdateTitle();
+                    // File has been renamed in the current folder, indices have changed - update current file index
+                    fFileListIndexUpdate.Queue();
                 }
 
             }
@@ -2085,16 +2422,34 @@ namespace OIV
           break;
 
         case FileWatcher::FileChangedOp::Modified:
+            // Metadata of the file might have changed, and with it its position in the list.
+            if (fListFiles.Contains(filePath))
+            {
+                fListFiles.Remove(filePath);
+                IndexFileMetadata(filePath);
+                fListFiles.Insert(filePath);
+                fFileListIndexUpdate.Queue();
+            }
+            break;
         case FileWatcher::FileChangedOp::None:
         case FileWatcher::FileChangedOp::WatchedFolderRemoved:
             break;
         }
     }
 
-    void TestApp::OnFileChangedImpl(FileWatcher::FileChangedEventArgs* fileChangedEventArgsPtr)
+    void TestApp::OnFileChangedImpl(FileWatcher::ListFileChangedEventArgs* filesChangedEventArgsPtr)
+    {
+        std::unique_ptr<FileWatcher::ListFileChangedEventArgs> filesChangedEventArgs(filesChangedEventArgsPtr);
+
+        // Apply the whole batch in one pass, the opened file index and the title are updated once at the end.
+        fFileListIndexUpdate.Begin();
+        for (const auto& fileChangedEventArgs : *filesChangedEventArgs)
+            ProcessFileChanged(fileChangedEventArgs);
+        fFileListIndexUpdate.End();
+    }
+
+    void TestApp::ProcessFileChanged(const FileWatcher::FileChangedEventArgs& fileChangedEventArgs)
     {
-        auto fileChangedEventArgs = *fileChangedEventArgsPtr;
-		
         if (fileChangedEventArgs.folderID == fOpenedFileFolderID)
         {
             std::wstring absoluteFilePath = std::filesystem::path(GetOpenedFileName());
@@ -2113,6 +2468,7 @@ namespace OIV
                 UpdateFileList(fileChangedEventArgs.fileOp, changedFileName, std::wstring());
                 break;
             case FileWatcher::FileChangedOp::Modified:
+                UpdateFileList(fileChangedEventArgs.fileOp, changedFileName, std::wstring());
                 if (absoluteFilePath == changedFileName)
                     ProcessCurrentFileChanged();
                 break;
@@ -2129,9 +2485,15 @@ namespace OIV
         }
         else if (fileChangedEventArgs.folderID == fCOnfigurationFolderID)
         {
-            if (fileChangedEventArgs.fileName == L"Settings.json")
+            bool found;
+            const ConfigurationCache::File file = ConfigurationCache::FromFileName(fileChangedEventArgs.fileName, found);
+            if (found)
             {
-                LoadSettings();
+                // Commands and key bindings are bound once at startup, a reload refreshes what's displayed from them.
+                if (file == ConfigurationCache::File::Settings)
+                    LoadSettings();
+                else
+                    ConfigurationCache::GetSingleton().Reload(file);
             }
         }
         else
@@ -2140,9 +2502,13 @@ namespace OIV
         }
     }
 
-    void TestApp::OnFileChanged(FileWatcher::FileChangedEventArgs fileChangedEventArgs)
+    void TestApp::OnFileChanged(FileWatcher::ListFileChangedEventArgs filesChangedEventArgs)
     {
-        SendMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_NOTIFY_FILE_CHANGED, reinterpret_cast<WPARAM>(&fileChangedEventArgs),0);
+        // Posted, the main thread may be blocked joining the coalescing thread when the watcher is destroyed.
+        // The main thread takes ownership of the batch.
+        auto pendingChanges = new FileWatcher::ListFileChangedEventArgs(std::move(filesChangedEventArgs));
+        if (PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WM_NOTIFY_FILE_CHANGED, reinterpret_cast<WPARAM>(pendingChanges), 0) == FALSE)
+            delete pendingChanges;
     }
 
     void TestApp::OnMouseEvent(const LInput::ButtonStdExtension<MouseButtonType>::ButtonEvent& btnEvent)
@@ -2458,40 +2824,8 @@ namespace OIV
             WatchCurrentFolder();
         }
     }
-    void TestApp::PostInitOperations()
+    void TestApp::BuildFileDialogFilters()
     {
-        LLUtils::Logger::GetSingleton().AddLogTarget(&mLogFile);
-
-
-
-        fTimerTopMostRetention.SetTargetWindow(fWindow.GetHandle());
-        fTimerTopMostRetention.SetCallback([this]()
-            {
-                ProcessTopMost();
-            }
-        );
-
-
-        fTimerSlideShow.SetTargetWindow(fWindow.GetHandle());
-        fTimerSlideShow.SetCallback([this]()
-            {
-                SetSlideShowEnabled(false);
-
-                bool foundFile = JumpFiles(1) ||
-                    ((fCurrentFileIndex == std::distance(fListFiles.begin(), fListFiles.end()) - 1) && JumpFiles(FileIndexStart));
-
-                SetSlideShowEnabled(foundFile);
-            });
-
-        fDoubleTap.callback = [this]()
-        {
-            fWindow.SetAlwaysOnTop(true);
-            fTopMostCounter = 3;
-            SetTopMostUserMesage();
-            fTimerTopMostRetention.SetInterval(1000);
-        };
-
-
         auto codecsInfo = fImageLoader.GetImageCodec().GetPluginsInfo();
 
         //Build known image extension set and open/save dialog filters
@@ -2569,27 +2903,49 @@ namespace OIV
 
         fOpenComDlgFilters = { readFilters };
         fSaveComDlgFilters = { writeFilters };
+    }
 
-        std::wstringstream ss;
+    void TestApp::PostInitOperations()
+    {
+        LLUtils::Logger::GetSingleton().AddLogTarget(&mLogFile);
 
-        for (const auto& knownExtension : fKnownFileTypesSet)
-            ss << knownExtension << L';';
-        
-        if (ss.rdbuf()->in_avail() > 0)
+
+
+        fTimerTopMostRetention.SetTargetWindow(fWindow.GetHandle());
+        fTimerTopMostRetention.SetCallback([this]()
+            {
+                ProcessTopMost();
+            }
+        );
+
+
+        fTimerSlideShow.SetTargetWindow(fWindow.GetHandle());
+        fTimerSlideShow.SetCallback([this]()
+            {
+                SetSlideShowEnabled(false);
+
+                bool foundFile = JumpFiles(1) ||
+                    ((fCurrentFileIndex == static_cast<FileIndexType>(fListFiles.size()) - 1) && JumpFiles(FileIndexStart));
+
+                SetSlideShowEnabled(foundFile);
+            });
+
+        fDoubleTap.callback = [this]()
         {
-            ss.seekp(-1, std::ios_base::end);
-            ss << L'\0';
-        }
-        
-        fKnownFileTypes = ss.str();
+            fWindow.SetAlwaysOnTop(true);
+            fTopMostCounter = 3;
+            SetTopMostUserMesage();
+            fTimerTopMostRetention.SetInterval(1000);
+        };
+
 
-        fFileWatcher.FileChangedEvent.Add(std::bind(&TestApp::OnFileChanged, this, std::placeholders::_1));
+        fFileWatcher.FilesChangedEvent.Add(std::bind(&TestApp::OnFileChanged, this, std::placeholders::_1));
 
         //If a file has been succesfuly loaded, index all the file in the folder
         ProcessLoadedDirectory();
         UpdateTitle();
 
-        AddCommandsAndKeyBindings();
+        AddCommandsAndKeyBindings(fStartupConfiguration->commandGroups, fStartupConfiguration->keyBindings);
 
         fWindow.GetImageControl().GetImageList().ImageSelectionChanged.Add(std::bind(&TestApp::OnImageSelectionChanged, this, std::placeholders::_1));
 		
@@ -2627,10 +2983,11 @@ namespace OIV
 
         fMouseClickEventHandler.OnMouseClickEvent.Add(std::bind(&TestApp::OnMouseMultiClick, this, std::placeholders::_1));
 
-        LoadSettings();
+        ApplySettings(fStartupConfiguration->settings);
+        fStartupConfiguration.reset();
 
         if (fReloadSettingsFileIfChanged)
-            fCOnfigurationFolderID = fFileWatcher.AddFolder(LLUtils::PlatformUtility::GetExeFolder() + LLUTILS_TEXT("./Resources/Configuration/."));
+            fCOnfigurationFolderID = fFileWatcher.AddFolder(ConfigurationLoader::GetConfigurationFolder() + LLUTILS_TEXT("."));
 
 
         if (fPendingFolderLoad.empty() == false)
@@ -2652,6 +3009,8 @@ namespace OIV
         fRTFFormatID = fClipboardHelper.RegisterFormat(L"Rich Text Format");*/
         fClipboardHelper.RegisterFormat(CF_UNICODETEXT);
         fClipboardHelper.RegisterFormat(CF_TEXT);
+
+        LLUtils::Logger::GetSingleton().Log(L"Startup trace\n" + fStartupTrace.ToString());
     }
 
     template <typename value_type>
@@ -2692,6 +3051,20 @@ namespace OIV
             fSlideShowIntervalms = static_cast<uint32_t>(ParseValue<Integral>(value));
         else if (key == L"viewsettings/quickbrowsedelay")
             fQuickBrowseDelay = static_cast<uint16_t>(ParseValue<Integral>(value));
+        else if (key == L"viewsettings/progressiveresampling")
+        {
+            fImageState.SetProgressiveResampling(ParseValue<Bool>(value));
+            QueueResampling();
+        }
+        else if (key == L"viewsettings/fusedresampling")
+        {
+            fImageState.SetFusedResampling(ParseValue<Bool>(value));
+            QueueResampling();
+        }
+        else if (key == L"viewsettings/imagememorybudgetmb")
+            fImageState.SetMemoryBudget(static_cast<uint64_t>(ParseValue<Integral>(value)) * 1024 * 1024);
+        else if (key == L"viewsettings/embeddedpreview")
+            fEmbeddedPreviewEnabled = ParseValue<Bool>(value);
 
         //Auto scroll
 
@@ -2706,6 +3079,24 @@ namespace OIV
         else if (key == L"autoscroll/maxspeed")
             fAutoScroll->SetMaxSpeed(static_cast<int32_t>(ParseValue<Integral>(value)));
 
+        //Decoded image cache
+
+        else if (key == L"decodedimagecache/enabled")
+        {
+            fDecodedImageCacheEnabled = ParseValue<Bool>(value);
+            UpdateDecodedImageCache();
+        }
+        else if (key == L"decodedimagecache/budgetmb")
+        {
+            fDecodedImageCacheBudget = static_cast<uint64_t>(ParseValue<Integral>(value)) * 1024 * 1024;
+            UpdateDecodedImageCache();
+        }
+        else if (key == L"decodedimagecache/mindecodetime")
+        {
+            fDecodedImageCacheMinDecodeTime = ParseValue<Float>(value);
+            UpdateDecodedImageCache();
+        }
+
         //deleted file removal mode
 
         else if (key == L"filesystem/deletedfileremovalmode")
@@ -2734,6 +3125,8 @@ namespace OIV
             else if (modifiedFileReloadModeStr == L"autobackground")
                 fMofifiedFileReloadMode = MofifiedFileReloadMode::AutoBackground;
         }
+        else if (key == L"system/bufferpoolidlemb")
+            ImageItemPool::GetSingleton().SetMaxIdleBytes(static_cast<uint64_t>(ParseValue<Integral>(value)) * 1024 * 1024);
         else if (key == L"system/reloadsettingsfileifchanged")
         {
             fReloadSettingsFileIfChanged = ParseValue<Bool>(value);
@@ -2746,6 +3139,12 @@ namespace OIV
                 fFileSorter.SetSortType(FileSorter::SortType::Date);
             else if (value == L"extension")
                 fFileSorter.SetSortType(FileSorter::SortType::Extension);
+            else if (value == L"capturedate")
+                fFileSorter.SetSortType(FileSorter::SortType::CaptureDate);
+            else if (value == L"pixelcount")
+                fFileSorter.SetSortType(FileSorter::SortType::PixelCount);
+            else if (value == L"filesize")
+                fFileSorter.SetSortType(FileSorter::SortType::FileSize);
         }
         else if (key == L"files/sortbynamedirection")
             fFileSorter.SetSortDirection(FileSorter::SortType::Name, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
@@ -2753,6 +3152,12 @@ namespace OIV
             fFileSorter.SetSortDirection(FileSorter::SortType::Date, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
         else if (key == L"files/sortbyextensiondirection")
             fFileSorter.SetSortDirection(FileSorter::SortType::Extension, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
+        else if (key == L"files/sortbycapturedatedirection")
+            fFileSorter.SetSortDirection(FileSorter::SortType::CaptureDate, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
+        else if (key == L"files/sortbypixelcountdirection")
+            fFileSorter.SetSortDirection(FileSorter::SortType::PixelCount, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
+        else if (key == L"files/sortbyfilesizedirection")
+            fFileSorter.SetSortDirection(FileSorter::SortType::FileSize, value == L"ascending" ? FileSorter::SortDirection::Ascending : FileSorter::SortDirection::Descending);
         
 
         else if (key == L"displaysettings/backgroundcolor1")
@@ -2778,7 +3183,15 @@ namespace OIV
 
     void TestApp::LoadSettings()
     {
-        auto settings = ConfigurationLoader::LoadSettings();
+        // Apply only the settings which changed since the file was last read.
+        ConfigurationCache& cache = ConfigurationCache::GetSingleton();
+        const ConfigurationCache::SnapshotSharedPtr previous = cache.Get();
+        if (cache.Reload(ConfigurationCache::File::Settings))
+            ApplySettings(ConfigurationCache::GetChangedSettings(previous->settings, cache.Get()->settings));
+    }
+
+    void TestApp::ApplySettings(const ConfigurationLoader::MapSettings& settings)
+    {
         for (const auto& pair : settings)
             OnSettingChange(LLUtils::StringUtility::ToWString(pair.first), LLUtils::StringUtility::ToWString(pair.second));
     }
@@ -2888,7 +3301,7 @@ namespace OIV
         if (step == FileIndexEnd)
         {
             // Last
-            fileIndex = static_cast<int32_t>(fListFiles.size());
+            fileIndex = static_cast<FileIndexType>(fListFiles.size());
             sign = -1;
         }
         else if (step == FileIndexStart)
@@ -2903,20 +3316,30 @@ namespace OIV
         }
 
         bool isLoaded = false;
-        LLUtils::ListWStringIterator it;
 
         do
         {
-            fileIndex += sign;
-            
-            if (fileIndex < 0 || fileIndex >= static_cast<FileIndexType>(totalFiles) || fileIndex == fCurrentFileIndex)
+            // Gather the next candidates, skip files which are known to be undecodable.
+            std::vector<FileIndexType> candidates;
+            FileIndexType candidateIndex = fileIndex;
+            while (candidates.size() < CandidateBatchSize)
+            {
+                candidateIndex += sign;
+
+                if (candidateIndex < 0 || candidateIndex >= static_cast<FileIndexType>(totalFiles) || candidateIndex == fCurrentFileIndex)
+                    break;
+
+                if (fUndecodableFiles.Contains(fListFiles.at(candidateIndex)) == false)
+                    candidates.push_back(candidateIndex);
+            }
+
+            if (candidates.empty())
                 break;
-            
-            it = fListFiles.begin();
-            std::advance(it, fileIndex);
-        }
-        
-        while ((isLoaded = LoadFile(*it, IMCodec::PluginTraverseMode::AnyPlugin | IMCodec::PluginTraverseMode::OnlyKnownFileType)) == false);
+
+            const FileIndexType decodedIndex = DecodeCandidateFiles(candidates, isLoaded);
+            fileIndex = decodedIndex != IndexedFileList::npos ? decodedIndex : candidates.back();
+
+        } while (isLoaded == false);
 
 
         if (isLoaded)
@@ -2927,6 +3350,46 @@ namespace OIV
         return isLoaded;
     }
     
+    TestApp::FileIndexType TestApp::DecodeCandidateFiles(const std::vector<FileIndexType>& candidates, bool& isLoaded)
+    {
+        const auto traverseMode = IMCodec::PluginTraverseMode::AnyPlugin | IMCodec::PluginTraverseMode::OnlyKnownFileType;
+        // Decodes may outlive a settings change disabling the cache.
+        std::shared_ptr<DecodedImageCache> decodedImageCache = fDecodedImageCache;
+
+        // Decode the nearest candidate, the next ones only if it fails.
+        for (FileIndexType candidate : candidates)
+        {
+            const std::wstring filePath = std::filesystem::path(fListFiles.at(candidate)).lexically_normal().wstring();
+
+            // A header probe costs a few kilobytes of I/O, it skips a file removed since the folder was listed.
+            // Any other probe result tells nothing about whether a plugin can decode the file.
+            ImageHeaderInfo info;
+            if (ImageHeaderProbe::Probe(filePath, info) == RC_FileNotFound)
+                continue;
+
+            // Display the embedded preview at once, the full image is decoded in the background.
+            if (LoadEmbeddedPreview(filePath, traverseMode, GetFileLoadParameters()))
+            {
+                isLoaded = true;
+                return candidate;
+            }
+
+            auto file = std::make_shared<OIVFileImage>(filePath);
+            const ResultCode result = file->Load(&fImageLoader, traverseMode, IMCodec::ImageLoadFlags::None, GetFileLoadParameters(), decodedImageCache.get());
+            // Only a failed decode proves the file undecodable.
+            if (result != RC_Success)
+                fUndecodableFiles.Add(filePath);
+
+            if (ProcessFileLoadResult(file, result))
+            {
+                isLoaded = true;
+                return candidate;
+            }
+        }
+
+        return IndexedFileList::npos;
+    }
+
     void TestApp::ToggleFullScreen(bool multiFullScreen)
     {
         fRefreshOperation.Begin();
@@ -3023,12 +3486,34 @@ namespace OIV
 
     void TestApp::Pan(const LLUtils::PointF64& panAmount )
     {
+        if (fVirtualText != nullptr)
+        {
+            fVirtualText->SetViewportOffset(fVirtualText->GetViewportOffset() - panAmount * fDPIadjustmentFactor / fVirtualText->GetViewportScale());
+            fRefreshOperation.Queue();
+            return;
+        }
+
         if (fImageState.GetOpenedImage() != nullptr)
             SetOffset(panAmount * fDPIadjustmentFactor + fImageState.GetOffset());
     }
 
     void TestApp::Zoom(double amount, int zoomX , int zoomY )
     {
+        if (fVirtualText != nullptr)
+        {
+            // Keep the document point under the zoom center in place.
+            using namespace LLUtils;
+            const PointF64 clientSize = static_cast<PointF64>(fWindow.GetCanvasSize());
+            const PointF64 zoomPoint = zoomX < 0 || zoomY < 0 ? clientSize / 2 : PointF64(zoomX, zoomY);
+            const double scale = fVirtualText->GetViewportScale();
+            const double newScale = std::clamp(amount > 0 ? scale * (1 + amount) : scale / (1 - amount), 0.01, 16.0);
+            const PointF64 documentPoint = fVirtualText->GetViewportOffset() + zoomPoint / scale;
+            fVirtualText->SetViewportScale(newScale);
+            fVirtualText->SetViewportOffset(documentPoint - zoomPoint / newScale);
+            fRefreshOperation.Queue();
+            return;
+        }
+
         if (IsImageOpen())
         {
             CommandManager::CommandRequest request;
@@ -3073,7 +3558,7 @@ namespace OIV
         case ImageSizeType::Original:
             return  fImageState.GetImage(ImageChainStage::SourceImage) != nullptr ? PointF64(fImageState.GetImage(ImageChainStage::SourceImage)->GetImage()->GetDimensions()) : PointF64(0, 0);
         case ImageSizeType::Transformed:
-            return static_cast<PointF64>(fImageState.GetImage(ImageChainStage::Deformed)->GetImage()->GetDimensions());
+            return fImageState.GetTransformedSize();
         case ImageSizeType::Visible:
             return fImageState.GetVisibleSize();
 
@@ -3205,6 +3690,16 @@ namespace OIV
     {
         if (GetResamplingEnabled() && IsImageOpen() && fDownScalingTechnique == DownscalingTechnique::Software)
         {
+            if (fImageState.GetProgressiveResampling())
+            {
+                // Every scale change is resampled at once and refined in the background, no need to wait for zooming to settle.
+                fTimerNoActiveZoom.SetInterval(0);
+                fImageState.SetResample(true);
+                fImageState.Refresh();
+                fRefreshOperation.Queue();
+                return;
+            }
+
             fImageState.SetResample(false);
             fTimerNoActiveZoom.SetInterval(0);
             fTimerNoActiveZoom.SetInterval(fQueueResamplingDelay);
@@ -3349,7 +3844,7 @@ namespace OIV
     {
         if (fVirtualStatusBar.GetVisible() == true)
         {
-            if (fImageState.GetImage(ImageChainStage::Deformed) != nullptr)
+            if (fImageState.GetImage(ImageChainStage::SourceImage) != nullptr)
             {
                 using namespace LLUtils;
                 PointF64 storageImageSpace = ClientToImage(fWindow.GetMousePosition());
@@ -3372,7 +3867,9 @@ namespace OIV
                     || storageImageSpace.y >= storageImageSize.y
                     ))
                 {
-                    std::wstring message = StringUtility::ConvertString<OIVString>(OIVHelper::ParseTexelValue(fImageState.GetImage(ImageChainStage::Deformed)->GetImage(),static_cast<LLUtils::PointI32>(storageImageSpace)));
+                    LLUtils::PointI32 texelPos = static_cast<LLUtils::PointI32>(storageImageSpace);
+                    OIVBaseImageSharedPtr texelSource = fImageState.GetTransformedTexelSource(texelPos);
+                    std::wstring message = StringUtility::ConvertString<OIVString>(OIVHelper::ParseTexelValue(texelSource->GetImage(), texelPos));
                     OIVString txt = LLUtils::StringUtility::ConvertString<OIVString>(message);
                     fVirtualStatusBar.SetText("texelValue", txt);
                     fVirtualStatusBar.SetOpacity("texelValue", 1.0);
@@ -3411,6 +3908,8 @@ namespace OIV
             AutoPlaceImage();
             auto point = static_cast<LLUtils::PointI32>(fWindow.GetCanvasSize());
             fVirtualStatusBar.ClientSizeChanged(point);
+            if (fVirtualText != nullptr)
+                fVirtualText->SetViewportSize(point);
 
             EventManager::GetSingleton().SizeChange.Raise(EventManager::SizeChangeEventParams{ static_cast<int32_t>(size.cx) , static_cast<int32_t>(size.cy)} );
         }
@@ -3571,7 +4070,7 @@ namespace OIV
             if (info->biCompression == BI_BITFIELDS) // no support for alpha channel, convert to BGR
                 image = IMUtil::ImageUtil::Convert(image,  IMCodec::TexelFormat::I_B8_G8_R8);
 
-            image = IMUtil::ImageUtil::Transform({ IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Vertical }, image);
+            AxisAlignedTransformer::TransformInPlace({ IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Vertical }, image);
 
             std::shared_ptr<OIVBaseImage> rawImage = std::make_shared<OIVBaseImage>(ImageSource::Clipboard, image);
 
@@ -3593,7 +4092,12 @@ namespace OIV
                 text = LLUtils::StringUtility::ToWString((const char*)buffer.data());
 
 
-            if (text.empty() == false)
+            if (static_cast<size_t>(std::count(text.begin(), text.end(), L'\n')) + 1 >= MinVirtualTextLines)
+            {
+                ShowVirtualText(std::move(text));
+                clipboardType = ClipboardDataType::Text;
+            }
+            else if (text.empty() == false)
             {
                 OIVTextImageSharedPtr textImage = std::make_shared<OIVTextImage>(ImageSource::ClipboardText, fFreeType.get());
                 textImage->SetText(text);
@@ -3623,6 +4127,29 @@ namespace OIV
         return clipboardType;
     }
 
+    void TestApp::ShowVirtualText(std::wstring text)
+    {
+        // Lines are laid out once and only the visible ones are rasterized, the text replaces the opened image.
+        UnloadOpenedImaged();
+        UnloadWelcomeMessage();
+
+        fVirtualText = std::make_shared<OIVVirtualTextImage>(ImageSource::ClipboardText, fFreeType.get());
+        fVirtualText->SetText(std::move(text));
+        fVirtualText->SetPosition(LLUtils::PointF64::Zero);
+        fVirtualText->SetScale(LLUtils::PointF64::One);
+        fVirtualText->SetFilterType(OIV_Filter_type::FT_None);
+        fVirtualText->SetImageRenderMode(OIV_Image_Render_mode::IRM_MainImage);
+        fVirtualText->SetVisible(true);
+        fVirtualText->SetOpacity(1.0);
+        fVirtualText->SetDPI(fCurrentMonitorProperties.DPIx, fCurrentMonitorProperties.DPIy);
+        fVirtualText->SetFontPath(LabelManager::sFontPath);
+        fVirtualText->SetFontSize(10);
+        fVirtualText->SetTextColor({ 48, 48, 48, 255 });
+        fVirtualText->SetBackgroundColor(LLUtils::Color(255, 255, 255, 255));
+        fVirtualText->SetViewportSize(static_cast<LLUtils::PointI32>(fWindow.GetCanvasSize()));
+        fRefreshOperation.Queue();
+    }
+
     bool TestApp::SetClipboardImage(IMCodec::ImageSharedPtr image)
     {
         auto clipboardCompatibleImage = IMUtil::ImageUtil::ConvertImageWithNormalization(image, IMCodec::TexelFormat::I_B8_G8_R8_A8, false);
@@ -3663,7 +4190,8 @@ namespace OIV
                 if (cropped != nullptr)
                 {
                     //2. Flip the image vertically and convert it to BGRA for the clipboard.
-                    auto flipped = IMUtil::ImageUtil::Transform({ IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Vertical }, cropped);
+                    auto flipped = cropped;
+                    AxisAlignedTransformer::TransformInPlace({ IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Vertical }, flipped);
                     if (flipped != nullptr && SetClipboardImage(flipped))
                         result = OperationResult::Success;
                 }
@@ -3892,6 +4420,7 @@ namespace OIV
             {
 				PostMessage(fWindow.GetHandle(), Win32::UserMessage::PRIVATE_WN_FIRST_FRAME_DISPLAYED, 0, 0);
 				fIsFirstFrameDisplayed = true;
+				fStartupTrace.Mark(StartupTrace::Milestone::FirstFrame);
             }
             break;
         case Win32::UserMessage::PRIVATE_WN_FIRST_FRAME_DISPLAYED:
@@ -3902,7 +4431,20 @@ namespace OIV
             fAutoScroll->PerformAutoScroll();
             break;
         case Win32::UserMessage::PRIVATE_WM_NOTIFY_FILE_CHANGED:
-            OnFileChangedImpl(reinterpret_cast<FileWatcher::FileChangedEventArgs*>(uMsg.wParam));
+            OnFileChangedImpl(reinterpret_cast<FileWatcher::ListFileChangedEventArgs*>(uMsg.wParam));
+            break;
+        case Win32::UserMessage::PRIVATE_WM_FOLDER_ENUMERATION:
+            MergeFolderEnumerationBatch(reinterpret_cast<DirectoryEnumerator::Batch*>(uMsg.wParam));
+            break;
+        case Win32::UserMessage::PRIVATE_WM_METADATA_INDEX:
+            MergeMetadataIndexBatch(reinterpret_cast<MetadataIndexer::Batch*>(uMsg.wParam));
+            break;
+        case Win32::UserMessage::PRIVATE_WM_BACKGROUND_DECODE:
+            ProcessBackgroundDecodeResult(reinterpret_cast<BackgroundDecoder::Result*>(uMsg.wParam));
+            break;
+        case Win32::UserMessage::PRIVATE_WM_RESAMPLE_REFINED:
+            if (fImageState.CommitRefinedResample())
+                fRefreshOperation.Queue();
             break;
         case Win32::UserMessage::PRIVATE_WM_COUNT_COLORS:
         {
@@ -4013,57 +4555,18 @@ namespace OIV
             LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Mutex cannot be closed.");
     }
 
-    LLUtils::ListWString TestApp::GetSupportedFileListInFolder(const std::wstring& folderPath)
-    {
-        LLUtils::ListWString fileList;
-        if (std::filesystem::is_directory(folderPath))
-        {
-            LLUtils::FileSystemHelper::FindFiles(fileList, folderPath, fKnownFileTypes, false, false);
-            std::sort(fileList.begin(), fileList.end(), fFileSorter);
-        }
-        else
-        {
-            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Not a folder");
-        }
-       
-        return fileList;
-    }
-
-
-
-    bool TestApp::LoadFileOrFolder(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode)
+    bool TestApp::LoadFileOrFolder(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode, bool activateWindow)
     {
 
         bool success = false;
         if (std::filesystem::is_directory(filePath))
         {
-         
-            auto fileList = GetSupportedFileListInFolder(filePath);
-            size_t i;
-            std::shared_ptr<OIVFileImage> file;
-            ResultCode result = ResultCode::RC_NotInitialized;
-
-            if (fileList.empty() == false)
-            {
-                // Traverse file list untill a file has been successfully loaded
-                for (i = 0; i < fileList.size(); i++)
-                {
-                    file = std::make_shared<OIVFileImage>(fileList.at(i));
-                    result = file->Load(&fImageLoader, IMCodec::PluginTraverseMode::NoTraverse);
-                    if (result == RC_Success)
-                        break;
-
-                }
-            }
+            std::filesystem::path folderPath = std::filesystem::path(filePath).lexically_normal();
+            if (folderPath.has_filename() == false)
+                folderPath = folderPath.parent_path();
 
-            if (result == RC_Success)
-            {
-                std::swap(fListFiles, fileList);
-                fCurrentFileIndex = i;
-                fListedFolder = filePath;
-                LoadOivImage(file);
-                success = true;
-            }
+            // Enumerate the folder in the background, the first supported file is loaded as soon as it's listed.
+            OpenFolder(folderPath.wstring(), activateWindow);
         }
 
         else
@@ -4072,8 +4575,6 @@ namespace OIV
                 success = true;
         }
 
-     
-
         return success;
     }
 	
@@ -4081,7 +4582,8 @@ namespace OIV
     {
 
         std::wstring normalizedPath = std::filesystem::path(event_ddrag_drop_file->fileName).lexically_normal().wstring();
-        if (LoadFileOrFolder(normalizedPath, IMCodec::PluginTraverseMode::AnyPlugin | IMCodec::PluginTraverseMode::AnyFileType))
+        // A dropped folder activates the window once one of its files loads.
+        if (LoadFileOrFolder(normalizedPath, IMCodec::PluginTraverseMode::AnyPlugin | IMCodec::PluginTraverseMode::AnyFileType, true))
         {
             fWindow.SetForground();
             return true;
@@ -4189,7 +4691,8 @@ namespace OIV
             std::wstring imageInfoString = MessageHelper::CreateImageInfoMessage(
                 fImageState.GetOpenedImage(), 
                 fImageState.GetImage(ImageChainStage::SourceImage)
-            , fImageLoader.GetImageCodec() );
+            , fImageLoader.GetImageCodec()
+            , &fImageState.GetMemoryStats());
             OIVTextImage* imageInfoText = fLabelManager.GetOrCreateTextLabel("imageInfo");
 
             imageInfoText->SetText(imageInfoString);
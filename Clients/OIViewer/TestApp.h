@@ -31,8 +31,16 @@
 
 #include "SelectionRect.h"
 #include "OIVImage/OIVBaseImage.h"
+#include <OIVImage/OIVVirtualTextImage.h>
 #include "LabelManager.h"
 #include "FileSystem/FileCache.h"
+#include "FileSystem/IndexedFileList.h"
+#include "FileSystem/DirectoryEnumerator.h"
+#include "FileSystem/UndecodableFileCache.h"
+#include "FileSystem/MetadataIndexer.h"
+#include "FileSystem/BackgroundDecoder.h"
+#include <ImageCache/DecodedImageCache.h>
+#include <Memory/ImageItemPool.h>
 #include "VirtualStatusBar.h"
 #include "MonitorProvider.h"
 #include "Helpers/OIVImageHelper.h"
@@ -40,6 +48,8 @@
 
 #include "ContextMenu.h"
 #include "FileWatcher.h"
+#include "ConfigurationCache.h"
+#include "Startup/StartupTrace.h"
 
 #include "MouseMultiClickHandler.h"
 #include "UI/MessageManager.h"
@@ -146,8 +156,8 @@ namespace OIV
         static HWND FindTrayBarWindow();
 
     private:// types
-        using FileIndexType = LLUtils::ListWString::difference_type;
-        using FileCountType = LLUtils::ListWString::size_type;
+        using FileIndexType = IndexedFileList::difference_type;
+        using FileCountType = IndexedFileList::size_type;
         struct CommandRequestIntenal
         {
             std::string commandName;
@@ -174,15 +184,18 @@ namespace OIV
         double GetMinimumPixelSize();
         
 #pragma endregion Win32 event handling
-        void AddCommandsAndKeyBindings();
+        void AddCommandsAndKeyBindings(const ConfigurationLoader::CommandGroupList& commandGroups, const ConfigurationLoader::KeyBindingList& keyBindings);
+        void BuildFileDialogFilters();
         void OnMonitorChanged(const EventManager::MonitorChangeEventParams& params);
         void ProbeForMonitorChange();
         void PerformRefresh();
+        void RenderFrame();
         void SetUserMessage(const std::wstring& message, GroupID groupID = 0, MessageFlags groupFlags = MessageFlags::Interchangeable);
         bool ExecuteCommandInternal(const CommandRequestIntenal& request);
         bool ExecuteCommand(const CommandManager::CommandRequest& request);
         bool ExecutePredefinedCommand(std::string command);
         void PostInitOperations();
+        void CreateMainWindow();
 #pragma region Commands
         void CMD_Zoom(const CommandManager::CommandRequest&, CommandManager::CommandResult&);
         void CMD_ViewState(const CommandManager::CommandRequest&, CommandManager::CommandResult&);
@@ -213,6 +226,7 @@ namespace OIV
         void UpdateTitle();
         //bool JumpTo(FileIndexType fileIndex);
         bool JumpFiles(FileIndexType step);
+        FileIndexType DecodeCandidateFiles(const std::vector<FileIndexType>& candidates, bool& isLoaded);
 		void ToggleFullScreen(bool multiFullScreen);
         void ToggleBorders();
         void SetSlideShowEnabled(bool enabled);
@@ -248,9 +262,26 @@ namespace OIV
         void OnScroll(const LLUtils::PointF64& panAmount);
         void OnImageSelectionChanged(const ImageList::ImageSelectionChangeArgs& ImageSelectionChangeArgs);
         bool LoadFile(std::wstring filePath, IMCodec::PluginTraverseMode loaderFlags);
-        bool LoadFileOrFolder(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode);
-
-        LLUtils::ListWString GetSupportedFileListInFolder(const std::wstring& folderPath);
+        bool ProcessFileLoadResult(std::shared_ptr<OIVFileImage> file, ResultCode result);
+        bool LoadEmbeddedPreview(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode, const IMCodec::Parameters& params);
+        void OnBackgroundDecodeDone(BackgroundDecoder::Result&& result); // callback from the background decoder
+        void ProcessBackgroundDecodeResult(BackgroundDecoder::Result* result); // runs in the main thread.
+        IMCodec::Parameters GetFileLoadParameters() const;
+        void UpdateDecodedImageCache();
+        // A folder is opened in the background, false is returned for folders.
+        bool LoadFileOrFolder(const std::wstring& filePath, IMCodec::PluginTraverseMode traverseMode, bool activateWindow = false);
+
+        void EnumerateFolder(const std::wstring& folderPath);
+        void OpenFolder(const std::wstring& folderPath, bool activateWindow);
+        void MergeOpenedFolderBatch(DirectoryEnumerator::Batch& batch);
+        bool TryLoadOpenedFolder(bool isEnumerationCompleted);
+        void OnFolderEnumerationBatch(DirectoryEnumerator::Batch&& batch); // callback from the directory enumerator
+        void MergeFolderEnumerationBatch(DirectoryEnumerator::Batch* batch); // runs in the main thread.
+        bool IsKnownFileType(const std::wstring& filePath) const;
+        void StartMetadataIndexing();
+        void OnMetadataIndexBatch(MetadataIndexer::Batch&& batch); // callback from the metadata indexer
+        void MergeMetadataIndexBatch(MetadataIndexer::Batch* batch); // runs in the main thread.
+        void IndexFileMetadata(const std::wstring& filePath);
         void LoadOivImage(OIVBaseImageSharedPtr oivImage);
         void UpdateOpenImageUI();
         void UnloadWelcomeMessage();
@@ -263,6 +294,7 @@ namespace OIV
         void TransformImage(IMUtil::AxisAlignedRotation transform, IMUtil::AxisAlignedFlip flip);
         void LoadRaw(const std::byte* buffer, uint32_t width, uint32_t height,uint32_t rowPitch, IMCodec::TexelFormat texelFormat);
         ClipboardDataType PasteFromClipBoard();
+        void ShowVirtualText(std::wstring text);
         bool SetClipboardImage(IMCodec::ImageSharedPtr image);
         OperationResult CropVisibleImage();
         OperationResult CopyVisibleToClipBoard();
@@ -281,10 +313,11 @@ namespace OIV
         void OnContextMenuTimer();
         void SetDownScalingTechnique(DownscalingTechnique technique);
         bool IsMainThread() const { return fMainThreadID == GetCurrentThreadId(); }
-        void OnFileChangedImpl(FileWatcher::FileChangedEventArgs* fileChangedEventArgs);// file change handler, runs in the main thread.
-        void OnFileChanged(FileWatcher::FileChangedEventArgs fileChangedEventArgs); // callback from file watcher
+        void OnFileChangedImpl(FileWatcher::ListFileChangedEventArgs* filesChangedEventArgs);// file change handler, runs in the main thread.
+        void OnFileChanged(FileWatcher::ListFileChangedEventArgs filesChangedEventArgs); // callback from file watcher
+        void ProcessFileChanged(const FileWatcher::FileChangedEventArgs& fileChangedEventArgs);
         void ProcessCurrentFileChanged();
-        void ProcessRemovalOfOpenedFile(const std::wstring& fileName);
+        void ProcessRemovalOfOpenedFile(const std::wstring& fileName, FileIndexType removedFileIndex);
         void UpdateFileList(FileWatcher::FileChangedOp fileOp, const std::wstring& fileName, const std::wstring& filePath2);
         void WatchCurrentFolder();
         void OnNotificationIcon(::Win32::NotificationIconGroup::NotificationIconEventArgs args);
@@ -331,6 +364,7 @@ namespace OIV
         AutoScrollUniquePtr fAutoScroll;
         RecrusiveDelayedOp fRefreshOperation;
         RecrusiveDelayedOp fPreserveImageSpaceSelection;
+        RecrusiveDelayedOp fFileListIndexUpdate;
         double fMaxPixelSize = 30.0;
         double fMinImageSize = 150.0;
         uint32_t fSlideShowIntervalms = 3000;
@@ -379,12 +413,21 @@ namespace OIV
         bool fIsResamplingEnabled = false;
         bool fQueueImageInfoLoad = false;
         uint16_t fQuickBrowseDelay = 100;
+        // The full image must have at least this many times the pixels of its embedded preview for the preview to be displayed.
+        static constexpr uint64_t MinPreviewReductionFactor = 4;
+        // Images wider or taller than this are not displayed.
+        static constexpr int32_t MaxImageDimension = 16384;
+        // Pixel data of the library's images beyond this size is spilled to disk.
+        static constexpr uint64_t ImageMemoryBudget = 2048ull * 1024 * 1024;
         bool fDisplayBiggestSubImageOnLoad = true;
 
         static constexpr FileIndexType FileIndexEnd = std::numeric_limits<FileIndexType>::max();
         static constexpr FileIndexType FileIndexStart = std::numeric_limits<FileIndexType>::min();
         FileIndexType  fCurrentFileIndex = FileIndexStart;
-        LLUtils::ListWString fListFiles;
+        IndexedFileList fListFiles;
+        UndecodableFileCache fUndecodableFiles;
+        // Navigation gathers this many candidate files at a time, they are tried nearest first.
+        static constexpr size_t CandidateBatchSize = 4;
         LLUtils::PointI32 fDragStart { -1,-1 };
         bool fIsTryToLoadInitialFile = false; // determines whether the current loaded file is the initial file being loaded at startup
         bool fIsFirstFrameDisplayed = false;
@@ -434,6 +477,9 @@ namespace OIV
         OIV_CMD_ColorExposure_Request fColorExposure = DefaultColorCorrection;
         OIV_CMD_ColorExposure_Request fLastColorExposure = fColorExposure;
         VirtualStatusBar fVirtualStatusBar;
+        // Pasted text of at least this many lines is displayed virtualized, panning and zooming apply to it instead of the image.
+        static constexpr size_t MinVirtualTextLines = 2000;
+        OIVVirtualTextImageSharedPtr fVirtualText;
 
         AdaptiveMotion fAdaptiveZoom = AdaptiveMotion(1.0, 0.6, 1.0);
         AdaptiveMotion fAdaptivePanLeftRight = AdaptiveMotion(1.6, 1.0, 5.2);
@@ -450,7 +496,28 @@ namespace OIV
         std::wstring fCurrentFolderWatched;
         std::wstring fPendingReloadFileName;
         std::set<std::wstring> fKnownFileTypesSet;
-        std::wstring fKnownFileTypes;
+        DirectoryEnumerator fDirectoryEnumerator;
+        bool fIsFolderEnumerationPending = false; // batches of the listed folder are still being merged
+        // A folder opened directly is listed aside, it replaces the listed folder only once one of its files loads.
+        struct OpenedFolder
+        {
+            std::wstring folder;
+            IndexedFileList files;
+            UndecodableFileCache undecodableFiles;
+            bool activateWindow = false;
+        };
+        std::optional<OpenedFolder> fOpenedFolder;
+        MetadataIndex fMetadataIndex;
+        MetadataIndexer fMetadataIndexer;
+        // Decodes the full image of a file while its embedded preview is displayed.
+        BackgroundDecoder fBackgroundDecoder;
+        bool fEmbeddedPreviewEnabled = true;
+        // Opt-in disk cache of decoded images for formats which are slow to decode.
+        // Shared with background decodes, which may still run when the cache is disabled.
+        std::shared_ptr<DecodedImageCache> fDecodedImageCache;
+        bool fDecodedImageCacheEnabled = false;
+        uint64_t fDecodedImageCacheBudget = 2048ull * 1024 * 1024;
+        double fDecodedImageCacheMinDecodeTime = 150.0;
         ::Win32::FileDialogFilterBuilder fOpenComDlgFilters;
         ::Win32::FileDialogFilterBuilder fSaveComDlgFilters;
         std::wstring fDefaultSaveFileExtension = L"png";
@@ -462,6 +529,7 @@ namespace OIV
         std::unique_ptr<MessageManager> fMessageManager;
         void OnSettingChange(const std::wstring& key, const std::wstring& value);
         void LoadSettings();
+        void ApplySettings(const ConfigurationLoader::MapSettings& settings);
         void SetResamplingEnabled(bool enable);
         bool GetResamplingEnabled() const; 
         void QueueResampling();
@@ -469,6 +537,9 @@ namespace OIV
 
         std::unique_ptr<ContextMenu<int>> fNotificationContextMenu;
         std::shared_ptr<OIVFileImage> fInitialFile;
+        StartupTrace fStartupTrace;
+        // Parsed concurrently with the startup, applied once the first frame is displayed.
+        ConfigurationCache::SnapshotSharedPtr fStartupConfiguration;
 
 		LLUtils::LogFile mLogFile{ GetLogFilePath(), true };
 
@@ -30,6 +30,7 @@ namespace OIV
                 texelValue->SetFontSize(11);
                 texelValue->SetTextColor({ 170,170,170,255 });
                 texelValue->SetOutlineWidth(0);
+                texelValue->SetIncrementalCells(true);
 				label = fMapLabels.emplace(labelName, texelValue).first;
 			}
 
@@ -37,6 +38,17 @@ namespace OIV
 		}
 
 
+        // Labels are updated and laid out once per displayed frame, call right before the frame is rendered.
+        void Update()
+        {
+            fRefreshRequested = false;
+            if (fLayoutDirty)
+            {
+                fLayoutDirty = false;
+                RepositionLabels();
+            }
+        }
+
         void RepositionLabels()
         {
             const LLUtils::PointF64 sizef = static_cast<LLUtils::PointF64>(fClientSize);
@@ -45,8 +57,7 @@ namespace OIV
             {
                 // labels placement logic, currently hard coded.
                 //TOOD: make it dynamic
-                if (text->GetImage() == nullptr)
-                    text->Create();
+                text->Create();
 
                 if (text->GetImage() != nullptr &&  text->GetOpacity() > 0.0 && text->GetVisible() ) // if visible
                 {
@@ -59,15 +70,13 @@ namespace OIV
 
                 }
             }
-
-            fRefreshCallback();
         }
 
         void ClientSizeChanged(LLUtils::PointI32& size)
         {
             fClientSize = size;
             if (GetVisible())
-                RepositionLabels();
+                InvalidateLayout();
         }
 
         void SetText(std::string elementName, const OIVString& text)
@@ -76,9 +85,7 @@ namespace OIV
             texelValue->SetText(text);
 
             if (GetVisible())
-            {
-                RepositionLabels(); // size of text is most likely changed - reposition.
-            }
+                InvalidateLayout(); // size of text may have changed - reposition.
         }
 
         bool GetVisible() const
@@ -96,7 +103,7 @@ namespace OIV
                     text->SetVisible(fVisible);
                 }
 
-                RepositionLabels();
+                InvalidateLayout();
             }
         }
         /// <summary>
@@ -118,12 +125,24 @@ namespace OIV
         }
 
     private:
+        // Any number of changes between two frames result in a single refresh request.
+        void InvalidateLayout()
+        {
+            fLayoutDirty = true;
+            if (fRefreshRequested == false)
+            {
+                fRefreshRequested = true;
+                fRefreshCallback();
+            }
+        }
 
         LLUtils::PointI32 fClientSize = LLUtils::PointI32::Zero;
         std::map<std::string, OIVTextImage*> fMapLabels;
         LabelManager* fLabelManager;
         RefreshCallback fRefreshCallback;
         bool fVisible = false;
+        bool fLayoutDirty = false;
+        bool fRefreshRequested = false;
 
     };
 }
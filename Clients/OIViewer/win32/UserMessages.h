@@ -12,6 +12,10 @@ namespace OIV
             static constexpr UINT PRIVATE_WM_NOTIFY_FILE_CHANGED    = WM_USER + 3;
             static constexpr UINT PRIVATE_WM_LOAD_FILE_EXTERNALLY   = WM_USER + 4;
             static constexpr UINT PRIVATE_WM_COUNT_COLORS           = WM_USER + 5;
+            static constexpr UINT PRIVATE_WM_FOLDER_ENUMERATION     = WM_USER + 6;
+            static constexpr UINT PRIVATE_WM_METADATA_INDEX         = WM_USER + 7;
+            static constexpr UINT PRIVATE_WM_BACKGROUND_DECODE      = WM_USER + 8;
+            static constexpr UINT PRIVATE_WM_RESAMPLE_REFINED       = WM_USER + 9;
         };
     }
 }
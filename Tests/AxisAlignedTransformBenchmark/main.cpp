@@ -0,0 +1,134 @@
+// Benchmark of AxisAlignedTransformer against IMUtil::ImageUtil::Transform for every axis aligned transform,
+// on texel sizes of 24, 32, 64 and 96 bits. No texel format is 128 bits wide, the transformer's 128 bit path can't be reached.
+// Results of both are compared byte for byte, the median time of each is reported.
+// usage: AxisAlignedTransformBenchmark [width] [height] [runs]
+
+#include <Transform/AxisAlignedTransformer.h>
+#include <Memory/ImageItemPool.h>
+#include <ImageUtil/ImageUtil.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace OIV;
+using namespace IMCodec;
+
+namespace
+{
+    constexpr uint32_t DefaultWidth = 4000;
+    constexpr uint32_t DefaultHeight = 3000;
+    constexpr int DefaultRuns = 7;
+
+    struct Format
+    {
+        const char* name;
+        TexelFormat format;
+        uint32_t bitsPerTexel;
+    };
+
+    const Format Formats[] =
+    {
+          { "24 bit R8G8B8", TexelFormat::I_R8_G8_B8, 24 }
+        , { "32 bit R8G8B8A8", TexelFormat::I_R8_G8_B8_A8, 32 }
+        , { "64 bit R16G16B16A16", TexelFormat::I_R16_G16_B16_A16, 64 }
+        , { "96 bit R32G32B32 float", TexelFormat::F_R32_G32_B32, 96 }
+    };
+
+    struct NamedTransform
+    {
+        const char* name;
+        IMUtil::AxisAlignedTransform transform;
+    };
+
+    const NamedTransform Transforms[] =
+    {
+          { "rotate 90 CW", { IMUtil::AxisAlignedRotation::Rotate90CW, IMUtil::AxisAlignedFlip::None } }
+        , { "rotate 90 CCW", { IMUtil::AxisAlignedRotation::Rotate90CCW, IMUtil::AxisAlignedFlip::None } }
+        , { "rotate 180", { IMUtil::AxisAlignedRotation::Rotate180, IMUtil::AxisAlignedFlip::None } }
+        , { "flip horizontal", { IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Horizontal } }
+        , { "flip vertical", { IMUtil::AxisAlignedRotation::None, IMUtil::AxisAlignedFlip::Vertical } }
+    };
+
+    ImageSharedPtr CreateImage(const Format& format, uint32_t width, uint32_t height)
+    {
+        const uint32_t rowPitch = width * format.bitsPerTexel / 8;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(static_cast<size_t>(rowPitch) * height);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = width;
+        desc.height = height;
+        desc.rowPitchInBytes = rowPitch;
+        desc.texelFormatDecompressed = format.format;
+        desc.texelFormatStorage = format.format;
+        imageItem->itemType = ImageItemType::Image;
+
+        // Every byte differs from its neighbours, a texel read from the wrong position is caught by the comparison.
+        std::byte* buffer = reinterpret_cast<std::byte*>(imageItem->data.data());
+        for (size_t i = 0; i < static_cast<size_t>(rowPitch) * height; i++)
+            buffer[i] = static_cast<std::byte>((i * 2654435761u) >> 13);
+
+        return std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+    }
+
+    bool IsEqual(const ImageSharedPtr& a, const ImageSharedPtr& b)
+    {
+        if (a->GetWidth() != b->GetWidth() || a->GetHeight() != b->GetHeight())
+            return false;
+
+        const size_t rowBytes = static_cast<size_t>(a->GetWidth()) * a->GetBitsPerTexel() / 8;
+        for (uint32_t y = 0; y < a->GetHeight(); y++)
+            if (std::memcmp(a->GetBuffer() + static_cast<size_t>(y) * a->GetRowPitchInBytes(), b->GetBuffer() + static_cast<size_t>(y) * b->GetRowPitchInBytes(), rowBytes) != 0)
+                return false;
+        return true;
+    }
+
+    template <typename Func>
+    double MeasureMedian(int runs, Func func)
+    {
+        std::vector<double> times;
+        for (int i = 0; i < runs; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t width = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : DefaultWidth;
+    const uint32_t height = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : DefaultHeight;
+    const int runs = argc > 3 ? std::stoi(argv[3]) : DefaultRuns;
+
+    std::cout << width << "x" << height << ", median of " << runs << " runs" << std::endl;
+    std::cout << std::left << std::setw(24) << "format" << std::setw(18) << "transform"
+        << std::right << std::setw(14) << "ImageUtil ms" << std::setw(16) << "transformer ms" << std::setw(10) << "speedup" << std::endl;
+
+    int mismatches = 0;
+    for (const Format& format : Formats)
+    {
+        const ImageSharedPtr image = CreateImage(format, width, height);
+        for (const NamedTransform& transform : Transforms)
+        {
+            if (IsEqual(IMUtil::ImageUtil::Transform(transform.transform, image), AxisAlignedTransformer::Transform(transform.transform, image)) == false)
+            {
+                std::cerr << "error: " << format.name << ", " << transform.name << " differs from ImageUtil" << std::endl;
+                mismatches++;
+            }
+
+            const double reference = MeasureMedian(runs, [&] { IMUtil::ImageUtil::Transform(transform.transform, image); });
+            const double transformer = MeasureMedian(runs, [&] { AxisAlignedTransformer::Transform(transform.transform, image); });
+            std::cout << std::left << std::setw(24) << format.name << std::setw(18) << transform.name << std::right << std::fixed << std::setprecision(2)
+                << std::setw(14) << reference << std::setw(16) << transformer << std::setw(9) << reference / transformer << "x" << std::endl;
+        }
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
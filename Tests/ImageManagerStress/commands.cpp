@@ -0,0 +1,397 @@
+// Stress test for the command interface: threads issue the same mix of commands synchronously through OIV_Execute
+// and queued through OIV_ExecuteAsync, on images shared by all threads, which load, crop, rotate and unload them concurrently.
+// Every texel is stamped with its image and its position in the loaded image, a command resolving a stale or recycled handle is detected.
+// The library is destroyed with commands still queued, each of them must complete exactly once.
+// usage: CommandStress [iterations per thread]
+
+#include <functions.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr int NumThreads = 8;
+    constexpr int DefaultIterations = 5000;
+    constexpr int32_t MaxImageSize = 64;
+    constexpr uint32_t NumReadPoints = 4;
+    constexpr int NumCommandsQueuedOnDestroy = 2000;
+
+    std::atomic<uint64_t> gErrors = 0;
+
+    void Fail(const char* what)
+    {
+        if (gErrors++ < 20)
+            std::cerr << "error: " << what << std::endl;
+    }
+
+    uint32_t TexelValue(uint32_t stamp, int32_t x, int32_t y)
+    {
+        return stamp ^ (static_cast<uint32_t>(y) << 16) ^ static_cast<uint32_t>(x);
+    }
+
+    // A texel (x, y) of the image holds TexelValue(stamp, originX + stepX * x, originY + stepY * y),
+    // crops move the origin and rotations reverse the steps.
+    struct TrackedImage
+    {
+        ImageHandle handle;
+        uint32_t stamp;
+        int32_t width;
+        int32_t height;
+        int32_t originX;
+        int32_t originY;
+        int32_t stepX;
+        int32_t stepY;
+
+        uint32_t GetTexel(int32_t x, int32_t y) const { return TexelValue(stamp, originX + stepX * x, originY + stepY * y); }
+    };
+
+    // Images any thread may use or unload.
+    std::mutex gImagesMutex;
+    std::vector<TrackedImage> gImages;
+    std::vector<ImageHandle> gUnloaded;
+
+    void AddImage(const TrackedImage& image)
+    {
+        std::lock_guard lock(gImagesMutex);
+        gImages.push_back(image);
+    }
+
+    bool PickImage(std::mt19937& random, TrackedImage& image)
+    {
+        std::lock_guard lock(gImagesMutex);
+        if (gImages.empty())
+            return false;
+        image = gImages[random() % gImages.size()];
+        return true;
+    }
+
+    bool TakeImage(std::mt19937& random, TrackedImage& image)
+    {
+        std::lock_guard lock(gImagesMutex);
+        if (gImages.empty())
+            return false;
+        const size_t index = random() % gImages.size();
+        image = gImages[index];
+        gImages.erase(gImages.begin() + index);
+        return true;
+    }
+
+    // An image may be unloaded by another thread at any time, a command on it then fails to find it.
+    bool IsImageGone(ResultCode result)
+    {
+        return result == RC_ImageNotFound || result == RC_InvalidImageHandle;
+    }
+
+    // Data the request points to is captured by 'onCompleted', it stays alive until the command completes.
+    struct Command
+    {
+        CommandExecute command;
+        std::vector<std::byte> request;
+        std::size_t responseSize;
+        std::function<void(ResultCode, const void*)> onCompleted;
+    };
+
+    template <class T>
+    std::vector<std::byte> ToBytes(const T& request)
+    {
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(&request);
+        return std::vector<std::byte>(bytes, bytes + sizeof(T));
+    }
+
+    // Commands queued and not completed yet, a ticket is added before its completion can be looked up.
+    std::mutex gPendingMutex;
+    std::condition_variable gPendingCondition;
+    std::unordered_map<OIV_AsyncTicket, std::function<void(ResultCode, const void*)>> gPending;
+    std::atomic<uint64_t> gNumCancelled = 0;
+
+    void OnAsyncCommandCompleted(OIV_AsyncCommandCompleted_Args args, [[maybe_unused]] void* userPointer)
+    {
+        std::function<void(ResultCode, const void*)> onCompleted;
+        {
+            std::lock_guard lock(gPendingMutex);
+            auto it = gPending.find(args.ticket);
+            if (it == gPending.end())
+            {
+                Fail("a command completed twice or wasn't queued");
+                return;
+            }
+            onCompleted = std::move(it->second);
+            gPending.erase(it);
+        }
+
+        if (args.result == RC_Cancelled)
+            gNumCancelled++;
+        else
+            onCompleted(args.result, args.responseData);
+
+        gPendingCondition.notify_all();
+    }
+
+    void Issue(Command&& command, bool async)
+    {
+        if (async == false)
+        {
+            std::vector<std::byte> response(command.responseSize);
+            const ResultCode result = OIV_Execute(command.command, command.request.size(), command.request.data(), response.size(), response.data());
+            command.onCompleted(result, response.data());
+            return;
+        }
+
+        std::lock_guard lock(gPendingMutex);
+        OIV_AsyncTicket ticket;
+        if (OIV_ExecuteAsync(command.command, command.request.size(), command.request.data(), command.responseSize, &ticket) != RC_Success)
+            Fail("a command couldn't be queued");
+        else
+            gPending.emplace(ticket, std::move(command.onCompleted));
+    }
+
+    Command LoadRaw(std::mt19937& random, uint32_t stamp)
+    {
+        const int32_t width = 1 + random() % MaxImageSize;
+        const int32_t height = 1 + random() % MaxImageSize;
+        auto texels = std::make_shared<std::vector<uint32_t>>(static_cast<size_t>(width) * height);
+        for (int32_t y = 0; y < height; y++)
+            for (int32_t x = 0; x < width; x++)
+                (*texels)[static_cast<size_t>(y) * width + x] = TexelValue(stamp, x, y);
+
+        OIV_CMD_LoadRaw_Request request{};
+        request.width = width;
+        request.height = height;
+        request.rowPitch = width * 4;
+        request.texelFormat = TF_I_R8_G8_B8_A8;
+        request.buffer = reinterpret_cast<std::byte*>(texels->data());
+        request.transformation = AAF_None;
+
+        return { OIV_CMD_LoadRaw, ToBytes(request), sizeof(OIV_CMD_LoadRaw_Response), [texels, stamp, width, height](ResultCode result, const void* response)
+        {
+            if (result != RC_Success)
+                return Fail("LoadRaw failed");
+            AddImage({ static_cast<const OIV_CMD_LoadRaw_Response*>(response)->handle, stamp, width, height, 0, 0, 1, 1 });
+        } };
+    }
+
+    Command ReadTexels(std::mt19937& random, const TrackedImage& image)
+    {
+        // Points outside the image read as zero.
+        auto points = std::make_shared<std::vector<OIV_POINT_I>>(NumReadPoints);
+        for (OIV_POINT_I& point : *points)
+            point = { static_cast<int32_t>(random() % (image.width + 2)) - 1, static_cast<int32_t>(random() % (image.height + 2)) - 1 };
+        auto texels = std::make_shared<std::vector<uint32_t>>(NumReadPoints);
+
+        OIV_CMD_ReadTexels_Request request{};
+        request.handle = image.handle;
+        request.format = TF_UNKNOWN;
+        request.points = points->data();
+        request.numPoints = NumReadPoints;
+        request.buffer = texels->data();
+        request.bufferSize = texels->size() * sizeof(uint32_t);
+
+        return { OIV_CMD_ReadTexels, ToBytes(request), sizeof(OIV_CMD_ReadTexels_Response), [points, texels, image](ResultCode result, const void*)
+        {
+            if (IsImageGone(result))
+                return;
+            if (result != RC_Success)
+                return Fail("ReadTexels failed");
+
+            for (uint32_t i = 0; i < NumReadPoints; i++)
+            {
+                const OIV_POINT_I& point = (*points)[i];
+                const bool inside = point.x >= 0 && point.x < image.width && point.y >= 0 && point.y < image.height;
+                if ((*texels)[i] != (inside ? image.GetTexel(point.x, point.y) : 0))
+                    return Fail("ReadTexels read the wrong texels");
+            }
+        } };
+    }
+
+    Command QueryImageInfo(const TrackedImage& image)
+    {
+        const OIV_CMD_QueryImageInfo_Request request{ image.handle };
+        return { OIV_CMD_QueryImageInfo, ToBytes(request), sizeof(OIV_CMD_QueryImageInfo_Response), [image](ResultCode result, const void* response)
+        {
+            if (IsImageGone(result))
+                return;
+
+            const auto* info = static_cast<const OIV_CMD_QueryImageInfo_Response*>(response);
+            if (result != RC_Success || info->width != static_cast<uint32_t>(image.width) || info->height != static_cast<uint32_t>(image.height))
+                Fail("QueryImageInfo returned the wrong image");
+        } };
+    }
+
+    Command CropImage(std::mt19937& random, const TrackedImage& image)
+    {
+        const int32_t x0 = random() % image.width;
+        const int32_t y0 = random() % image.height;
+        const int32_t x1 = x0 + 1 + random() % (image.width - x0);
+        const int32_t y1 = y0 + 1 + random() % (image.height - y0);
+
+        OIV_CMD_CropImage_Request request{};
+        request.rect = { x0, y0, x1, y1 };
+        request.imageHandle = image.handle;
+
+        TrackedImage cropped = image;
+        cropped.width = x1 - x0;
+        cropped.height = y1 - y0;
+        cropped.originX = image.originX + image.stepX * x0;
+        cropped.originY = image.originY + image.stepY * y0;
+
+        return { OIV_CMD_CropImage, ToBytes(request), sizeof(OIV_CMD_CropImage_Response), [cropped](ResultCode result, const void* response) mutable
+        {
+            if (IsImageGone(result))
+                return;
+            if (result != RC_Success)
+                return Fail("CropImage failed");
+
+            cropped.handle = static_cast<const OIV_CMD_CropImage_Response*>(response)->imageHandle;
+            AddImage(cropped);
+        } };
+    }
+
+    Command Rotate180(const TrackedImage& image)
+    {
+        OIV_CMD_AxisAlignedTransform_Request request{};
+        request.transform = { AAT_Rotate180, AAF_None };
+        request.handle = image.handle;
+
+        TrackedImage rotated = image;
+        rotated.originX = image.originX + image.stepX * (image.width - 1);
+        rotated.originY = image.originY + image.stepY * (image.height - 1);
+        rotated.stepX = -image.stepX;
+        rotated.stepY = -image.stepY;
+
+        return { OIV_CMD_AxisAlignedTransform, ToBytes(request), sizeof(OIV_CMD_AxisAlignedTransform_Response), [rotated](ResultCode result, const void* response) mutable
+        {
+            // The transform doesn't tell a missing image apart.
+            if (result == RC_UknownError)
+                return;
+            if (result != RC_Success)
+                return Fail("AxisAlignedTransform failed");
+
+            rotated.handle = static_cast<const OIV_CMD_AxisAlignedTransform_Response*>(response)->handle;
+            AddImage(rotated);
+        } };
+    }
+
+    Command UnloadFile(const TrackedImage& image)
+    {
+        const OIV_CMD_UnloadFile_Request request{ image.handle };
+        return { OIV_CMD_UnloadFile, ToBytes(request), sizeof(CmdNull), [handle = image.handle](ResultCode result, const void*)
+        {
+            // Taken out of the shared images first, no other thread unloads it.
+            if (result != RC_Success)
+                return Fail("UnloadFile failed for a live image");
+
+            std::lock_guard lock(gImagesMutex);
+            gUnloaded.push_back(handle);
+        } };
+    }
+
+    void CheckStaleHandle(std::mt19937& random)
+    {
+        ImageHandle handle;
+        {
+            std::lock_guard lock(gImagesMutex);
+            if (gUnloaded.empty())
+                return;
+            handle = gUnloaded[random() % gUnloaded.size()];
+        }
+
+        OIV_CMD_QueryImageInfo_Request request{ handle };
+        OIV_CMD_QueryImageInfo_Response response{};
+        if (OIV_Execute(OIV_CMD_QueryImageInfo, sizeof(request), &request, sizeof(response), &response) == RC_Success)
+            Fail("a stale handle resolved");
+    }
+
+    void Run(int threadIndex, int iterations)
+    {
+        std::mt19937 random(threadIndex);
+        uint32_t nextStamp = static_cast<uint32_t>(threadIndex) << 24;
+
+        for (int i = 0; i < iterations; i++)
+        {
+            const bool async = random() % 2 == 0;
+            const uint32_t operation = random() % 8;
+            TrackedImage image;
+
+            if (operation < 2 || PickImage(random, image) == false)
+                Issue(LoadRaw(random, ++nextStamp), async);
+            else if (operation == 2 || operation == 3)
+                Issue(ReadTexels(random, image), async);
+            else if (operation == 4)
+                Issue(QueryImageInfo(image), async);
+            else if (operation == 5)
+                Issue(CropImage(random, image), async);
+            else if (operation == 6)
+                Issue(Rotate180(image), async);
+            else if (TakeImage(random, image))
+                Issue(UnloadFile(image), async);
+
+            if (i % 32 == 0)
+                CheckStaleHandle(random);
+        }
+    }
+
+    void WaitForPendingCommands()
+    {
+        std::unique_lock lock(gPendingMutex);
+        gPendingCondition.wait(lock, [] { return gPending.empty(); });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : DefaultIterations;
+
+    OIV_CMD_RegisterCallbacks_Request callbacks{};
+    callbacks.OnAsyncCommandCompleted = &OnAsyncCommandCompleted;
+    CmdNull nullResponse;
+    if (OIV_Execute(OIV_CMD_RegisterCallbacks, sizeof(callbacks), &callbacks, sizeof(nullResponse), &nullResponse) != RC_Success)
+        Fail("callbacks couldn't be registered");
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NumThreads; i++)
+        threads.emplace_back(Run, i, iterations);
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    WaitForPendingCommands();
+    if (gNumCancelled != 0)
+        Fail("a command was cancelled before the library was destroyed");
+
+    // Destroy while commands are queued, queued commands complete as cancelled and running ones normally.
+    std::mt19937 random(NumThreads);
+    TrackedImage image;
+    for (int i = 0; i < NumCommandsQueuedOnDestroy; i++)
+    {
+        if (PickImage(random, image))
+            Issue(ReadTexels(random, image), true);
+        else
+            Issue(LoadRaw(random, 0), true);
+    }
+
+    if (OIV_Execute(OIV_CMD_Destroy, sizeof(nullResponse), &nullResponse, sizeof(nullResponse), &nullResponse) != RC_Success)
+        Fail("Destroy failed");
+
+    {
+        std::lock_guard lock(gPendingMutex);
+        if (gPending.empty() == false)
+            Fail("queued commands didn't complete on destroy");
+    }
+
+    OIV_CMD_QueryImageInfo_Request request{ ImageHandleNull };
+    OIV_AsyncTicket ticket;
+    if (OIV_ExecuteAsync(OIV_CMD_QueryImageInfo, sizeof(request), &request, sizeof(OIV_CMD_QueryImageInfo_Response), &ticket) != RC_NotInitialized)
+        Fail("a command was queued after destroy");
+
+    std::cout << (gErrors == 0 ? "passed" : "failed") << ", " << gErrors << " errors, " << gNumCancelled << " commands cancelled on destroy" << std::endl;
+    return gErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+// Stress test for ImageManager: threads add, acquire, read, replace and remove images concurrently
+// under a memory budget small enough to keep spilling images to disk.
+// Every image's pixels and process data are stamped with a value of its own, so an image resolved through a stale or recycled handle is detected.
+// usage: ImageManagerStress [spill folder] [iterations per thread]
+
+#include <ImageManager.h>
+#include <Memory/ImageItemPool.h>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OIV;
+using namespace IMCodec;
+
+namespace
+{
+    constexpr int NumThreads = 8;
+    constexpr int DefaultIterations = 20000;
+    constexpr uint64_t MemoryBudget = 512 * 1024;
+
+    std::atomic<uint64_t> gErrors = 0;
+
+    void Fail(const char* what)
+    {
+        if (gErrors++ < 20)
+            std::cerr << "error: " << what << std::endl;
+    }
+
+    ImageSharedPtr CreateImage(uint32_t width, uint32_t height, uint32_t stamp)
+    {
+        const uint32_t rowPitch = width * 4;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(static_cast<size_t>(rowPitch) * height);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = width;
+        desc.height = height;
+        desc.rowPitchInBytes = rowPitch;
+        desc.texelFormatDecompressed = TexelFormat::I_R8_G8_B8_A8;
+        desc.texelFormatStorage = TexelFormat::I_R8_G8_B8_A8;
+        imageItem->itemType = ImageItemType::Image;
+        // Restored along with the pixels of a spilled image.
+        imageItem->processData.processTime = stamp;
+
+        // Half of the rows carry the stamp and half the stamp mixed with the texel index.
+        std::byte* buffer = reinterpret_cast<std::byte*>(imageItem->data.data());
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            const uint32_t value = (i / width) % 2 == 0 ? stamp : stamp ^ i;
+            std::memcpy(buffer + i * 4, &value, 4);
+        }
+        return std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+    }
+
+    bool HasStamp(const ImageSharedPtr& image, uint32_t stamp)
+    {
+        if (image == nullptr || image->GetBuffer() == nullptr || image->GetProcessData().processTime != stamp)
+            return false;
+
+        const uint32_t width = image->GetWidth();
+        for (uint32_t i = 0; i < width * image->GetHeight(); i++)
+        {
+            const uint32_t expected = (i / width) % 2 == 0 ? stamp : stamp ^ i;
+            uint32_t value;
+            std::memcpy(&value, image->GetBuffer() + i * 4, 4);
+            if (value != expected)
+                return false;
+        }
+        return true;
+    }
+
+    struct OwnedImage
+    {
+        ImageHandle handle;
+        uint32_t stamp;
+    };
+
+    void Run(ImageManager& imageManager, int threadIndex, int iterations)
+    {
+        std::mt19937 random(threadIndex);
+        std::vector<OwnedImage> owned;
+        std::vector<ImageHandle> removed;
+        uint32_t nextStamp = static_cast<uint32_t>(threadIndex) << 24;
+
+        auto pickOwned = [&]() -> size_t { return random() % owned.size(); };
+
+        for (int i = 0; i < iterations; i++)
+        {
+            const uint32_t operation = random() % 8;
+            if (owned.empty() || operation < 2)
+            {
+                const uint32_t stamp = ++nextStamp;
+                const ImageHandle handle = imageManager.AddImage(CreateImage(1 + random() % 64, 1 + random() % 64, stamp));
+                if (handle == ImageHandleNull)
+                    Fail("AddImage returned a null handle");
+                else
+                    owned.push_back({ handle, stamp });
+            }
+            else if (operation == 2)
+            {
+                const OwnedImage& image = owned[pickOwned()];
+                if (HasStamp(imageManager.GetImage(image.handle), image.stamp) == false)
+                    Fail("GetImage resolved to the wrong image");
+            }
+            else if (operation == 3)
+            {
+                const OwnedImage& image = owned[pickOwned()];
+                ImageManager::Reference reference = imageManager.Acquire(image.handle);
+                if (!reference || HasStamp(reference.GetImage(), image.stamp) == false)
+                    Fail("Acquire resolved to the wrong image");
+            }
+            else if (operation == 4)
+            {
+                OwnedImage& image = owned[pickOwned()];
+                image.stamp = ++nextStamp;
+                imageManager.ReplaceImage(image.handle, CreateImage(1 + random() % 64, 1 + random() % 64, image.stamp));
+            }
+            else if (operation == 5)
+            {
+                // A child is removed along with its parent.
+                const OwnedImage& parent = owned[pickOwned()];
+                const uint32_t stamp = ++nextStamp;
+                const ImageHandle child = imageManager.AddChildImage(CreateImage(8, 8, stamp), parent.handle);
+                if (HasStamp(imageManager.GetImage(child), stamp) == false)
+                    Fail("AddChildImage resolved to the wrong image");
+            }
+            else
+            {
+                // Remove while referenced, the reference keeps the image and the handle stops resolving at once.
+                const size_t index = pickOwned();
+                const OwnedImage image = owned[index];
+                owned.erase(owned.begin() + index);
+
+                ImageManager::Reference reference = imageManager.Acquire(image.handle);
+                for (const ImageHandle child : imageManager.GetChildrenOf(image.handle))
+                    removed.push_back(child);
+
+                if (imageManager.RemoveImage(image.handle) == false)
+                    Fail("RemoveImage failed for a live image");
+                if (imageManager.GetImage(image.handle) != nullptr)
+                    Fail("a removed image still resolves");
+                if (!reference || HasStamp(reference.GetImage(), image.stamp) == false)
+                    Fail("a reference lost its image on removal");
+                removed.push_back(image.handle);
+            }
+
+            // Handles of removed images must never resolve, whichever image took over their entry.
+            if (removed.empty() == false && i % 16 == 0)
+            {
+                const ImageHandle handle = removed[random() % removed.size()];
+                if (imageManager.GetImage(handle) != nullptr || imageManager.Acquire(handle))
+                    Fail("a stale handle resolved");
+                if (imageManager.RemoveImage(handle))
+                    Fail("a stale handle was removed");
+            }
+        }
+
+        for (const OwnedImage& image : owned)
+            if (imageManager.RemoveImage(image.handle) == false)
+                Fail("RemoveImage failed for a live image");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::filesystem::path spillFolder = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path() / "OIVImageManagerStress";
+    const int iterations = argc > 2 ? std::stoi(argv[2]) : DefaultIterations;
+
+    {
+        ImageManager imageManager;
+        imageManager.SetSpillFolder(spillFolder);
+        imageManager.SetMemoryBudget(MemoryBudget);
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < NumThreads; i++)
+            threads.emplace_back(Run, std::ref(imageManager), i, iterations);
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        if (imageManager.GetNumLoadedImages() != 0)
+            Fail("images are left after all were removed");
+        if (imageManager.GetResidentBytes() != 0 || imageManager.GetSpilledBytes() != 0)
+            Fail("bytes are accounted after all images were removed");
+    }
+
+    std::error_code ec;
+    if (std::filesystem::exists(spillFolder, ec) && std::filesystem::is_empty(spillFolder, ec) == false)
+        Fail("spill files are left after the manager was destroyed");
+
+    std::cout << (gErrors == 0 ? "passed" : "failed") << ", " << gErrors << " errors" << std::endl;
+    return gErrors == 0 ? 0 : 1;
+}
@@ -29,6 +29,8 @@ namespace OivTestDotNet
         {
 
             public IntPtr /*std::size_t*/ parentHandle;
+            public IntPtr spillFolder;
+            public ulong imageMemoryBudget;
         };
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         struct CmdDataClientMetrics
@@ -115,6 +117,8 @@ namespace OivTestDotNet
             const int CE_Init = 1;
             CmdDataInit init;
             init.parentHandle = panel1.Handle;
+            init.spillFolder = IntPtr.Zero;
+            init.imageMemoryBudget = 0;
             CmdDataInit? initNullable = new CmdDataInit?(init);
             ExecuteCommand(CE_Init, ref initNullable, ref nullStruct);
         }
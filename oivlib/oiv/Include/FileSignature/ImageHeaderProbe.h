@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <filesystem>
+#include <defs.h>
+
+namespace OIV
+{
+    struct ImageHeaderInfo
+    {
+        // Canonical extension of the detected format, see SignatureRegistry.
+        std::wstring format;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t bitsPerPixel = 0;
+        // Number of pages or frames, 0 when counting them requires more than reading headers (e.g. GIF).
+        uint32_t numSubImages = 0;
+        OIV_TexelFormat texelFormat = TF_UNKNOWN;
+        // EXIF orientation, 0 when absent.
+        uint16_t exifOrientation = 0;
+        // EXIF DateTimeOriginal or DateTime as "YYYY:MM:DD HH:MM:SS", empty when absent.
+        std::string exifDateTime;
+        // Location of the embedded EXIF JPEG thumbnail in the file, exifThumbnailLength is 0 when absent.
+        uint64_t exifThumbnailOffset = 0;
+        uint32_t exifThumbnailLength = 0;
+    };
+
+    // Reads image properties from file headers and EXIF segments without decoding any pixels.
+    // Reads are bounded so probing a file costs a few kilobytes of I/O regardless of its size.
+    class ImageHeaderProbe
+    {
+    public:
+        // Size of the first read of a file, enough for the headers of most formats.
+        static constexpr size_t HeadReadSize = 4096;
+        // Maximum number of bytes read from a single file.
+        static constexpr size_t MaxReadSize = 256 * 1024;
+
+        // RC_FileNotSupported if the header matches no single known format, RC_UnsupportedFormat if the format is known
+        // but its properties couldn't be probed. Neither means the file can't be decoded.
+        static ResultCode Probe(const std::filesystem::path& filePath, ImageHeaderInfo& info);
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+
+namespace OIV
+{
+    // Magic byte signatures of image file formats.
+    // Signatures are kept in a prefix trie so a file header is matched against all the formats in a single pass.
+    class SignatureRegistry
+    {
+    public:
+        // A signature byte, AnyByte matches any value, e.g. the size field of a RIFF header.
+        using SignatureByte = int16_t;
+        static constexpr SignatureByte AnyByte = -1;
+        using ListSignatureBytes = std::vector<SignatureByte>;
+        using ListFormats = std::vector<std::wstring>;
+
+        struct MatchResult
+        {
+            // Formats of the longest matching signature, more than one format means the header is ambiguous.
+            ListFormats formats;
+            bool IsUnique() const { return formats.size() == 1; }
+            bool IsEmpty() const { return formats.empty(); }
+        };
+
+        // Registry populated with the built in signatures.
+        static const SignatureRegistry& GetBuiltIn();
+
+        // 'format' is the canonical lower case extension of the format, 'extensions' are its aliases.
+        void Register(const std::wstring& format, const ListFormats& extensions, const ListSignatureBytes& signature);
+
+        MatchResult Match(const std::byte* header, size_t size) const;
+
+        // Reads the first GetMaxSignatureLength() bytes of the file and matches them.
+        MatchResult MatchFile(const std::filesystem::path& filePath) const;
+
+        // Returns the format of a file extension (without a dot), or an empty string if no signature is registered for it.
+        std::wstring GetFormatByExtension(const std::wstring& extension) const;
+
+        size_t GetMaxSignatureLength() const { return fMaxSignatureLength; }
+
+    private:
+        using NodeIndex = uint32_t;
+        static constexpr NodeIndex NoNode = 0; // The root is never a child.
+
+        struct Node
+        {
+            std::map<uint8_t, NodeIndex> children;
+            NodeIndex anyChild = NoNode;
+            std::vector<uint16_t> formats;
+        };
+
+        NodeIndex GetOrCreateChild(NodeIndex parent, SignatureByte value);
+
+    private:
+        std::vector<Node> fNodes{ 1 };
+        ListFormats fFormats;
+        std::map<std::wstring, uint16_t> fExtensionToFormat;
+        size_t fMaxSignatureLength = 0;
+    };
+}
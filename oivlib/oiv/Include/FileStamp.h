@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+namespace OIV
+{
+    // Size and last write time of a file, a different stamp means the file was modified.
+    struct FileStamp
+    {
+        uint64_t fileSize = 0;
+        int64_t lastWriteTime = 0;
+
+        bool operator==(const FileStamp& rhs) const = default;
+
+        // Returns false if the file can't be queried.
+        static bool Get(const std::wstring& filePath, FileStamp& stamp)
+        {
+            std::error_code ec;
+            stamp.fileSize = static_cast<uint64_t>(std::filesystem::file_size(filePath, ec));
+            if (ec.value() != 0)
+                return false;
+
+            const auto writeTime = std::filesystem::last_write_time(filePath, ec);
+            if (ec.value() != 0)
+                return false;
+
+            stamp.lastWriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+            return true;
+        }
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <filesystem>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <Image.h>
+#include <FileStamp.h>
+
+namespace OIV
+{
+    // Disk cache of decoded images, for formats which are slow to decode.
+    // Entries are keyed by source file path, size and last write time, and hold the decoded image descriptor
+    // followed by the raw pixel buffer at a page aligned offset. The cache is bounded by a byte budget
+    // and evicts least recently used entries, usage order survives restarts through the entries' write time.
+    class DecodedImageCache
+    {
+    public:
+        DecodedImageCache(const std::filesystem::path& cacheFolder, uint64_t budgetBytes, double minDecodeTimems);
+        ~DecodedImageCache();
+        DecodedImageCache(const DecodedImageCache&) = delete;
+        DecodedImageCache& operator=(const DecodedImageCache&) = delete;
+
+        void SetBudget(uint64_t budgetBytes);
+        // Only images that took at least this long to decode are cached.
+        void SetMinDecodeTime(double minDecodeTimems);
+
+        // Returns the cached decoded image of a file, or nullptr if the file isn't cached or has changed since.
+        IMCodec::ImageSharedPtr Find(const std::wstring& filePath);
+
+        // Queues a decoded image to be written to the cache in the background.
+        // Images with sub images or that decoded faster than the minimum decode time are ignored.
+        void Add(const std::wstring& filePath, IMCodec::ImageSharedPtr image);
+
+        uint64_t GetSize() const;
+
+    private:
+        using Key = uint64_t;
+
+        struct Entry
+        {
+            uint64_t size;
+            std::list<Key>::iterator lruPosition;
+        };
+
+        struct PendingWrite
+        {
+            Key key;
+            std::wstring filePath;
+            FileStamp stamp;
+            IMCodec::ImageSharedPtr image;
+        };
+
+        static Key GetKey(const std::wstring& filePath, const FileStamp& stamp);
+        std::filesystem::path GetCacheFilePath(Key key) const;
+
+        void LoadIndex();
+        bool Write(const PendingWrite& pendingWrite);
+        void Touch(Key key);
+        void Remove(Key key);
+        void Evict();
+        void WriterEntryPoint();
+
+        static constexpr uint64_t DataAlignment = 4096;
+        static constexpr size_t MaxPendingWrites = 4;
+
+        std::filesystem::path fCacheFolder;
+        uint64_t fBudget;
+        double fMinDecodeTime;
+        uint64_t fSize = 0;
+        std::list<Key> fLRU; // most recently used first
+        std::unordered_map<Key, Entry> fEntries;
+        mutable std::mutex fMutex;
+
+        std::deque<PendingWrite> fPendingWrites;
+        std::condition_variable fWriterCondition;
+        bool fStopWriter = false;
+        std::thread fWriterThread;
+    };
+}
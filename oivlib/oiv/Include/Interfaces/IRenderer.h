@@ -3,6 +3,7 @@
 #include <Image.h>
 #include <Interfaces/IRendererDefs.h>
 #include <Interfaces/IRenderable.h>
+#include <Render/OverlayCompositor.h>
 
 namespace OIV
 {
@@ -19,6 +20,8 @@ namespace OIV
 
         virtual int AddRenderable(IRenderable* renderable) = 0;
         virtual int RemoveRenderable(IRenderable* renderable) = 0;
+        // Statistics of the overlay atlas, including the overlay bytes uploaded by the last redraw.
+        virtual int GetOverlayStats(OverlayCompositor::Stats& stats) const = 0;
 
         virtual ~IRenderer() {}
     };
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <Image.h>
+
+namespace OIV
+{
+    // Recycles the pixel buffers of images produced by oivlib (resamples, crops, raw images).
+    // Buffers are rounded up to size classes at most 25% apart, and a buffer released by an image is kept idle
+    // for the next image of the same size class instead of being freed, so repeated operations of similar size
+    // like zoom steps don't page fault in fresh memory every time.
+    // Idle buffers are trimmed oldest first once they exceed the idle budget, or after being unused for IdleTimeout.
+    class ImageItemPool
+    {
+    public:
+        struct Stats
+        {
+            uint64_t requests = 0;
+            uint64_t hits = 0;
+            // Bytes of pooled buffers, both in use and idle.
+            uint64_t residentBytes = 0;
+            uint64_t idleBytes = 0;
+
+            double GetHitRate() const { return requests > 0 ? static_cast<double>(hits) / requests : 0.0; }
+        };
+
+        static constexpr size_t MinPooledSize = 256 * 1024;
+        static constexpr uint64_t DefaultMaxIdleBytes = 256ull * 1024 * 1024;
+        static constexpr std::chrono::seconds IdleTimeout = std::chrono::seconds(30);
+
+        static ImageItemPool& GetSingleton();
+
+        // Returns an image item with a data buffer of at least 'size' bytes.
+        // The buffer returns to the pool once the last reference to the item is released.
+        IMCodec::ImageItemSharedPtr Acquire(size_t size);
+
+        void SetMaxIdleBytes(uint64_t maxIdleBytes);
+        // Free idle buffers, oldest first, until no more than 'maxIdleBytes' are idle.
+        void Trim(uint64_t maxIdleBytes);
+        Stats GetStats() const;
+
+        static size_t GetClassSize(size_t size);
+
+    private:
+        using Buffer = decltype(IMCodec::ImageItem::data);
+        using Clock = std::chrono::steady_clock;
+
+        struct IdleBuffer
+        {
+            size_t classSize;
+            Clock::time_point releaseTime;
+            Buffer buffer;
+        };
+
+        void Release(size_t classSize, Buffer&& buffer);
+        void TrimExpired();
+        void TrimLocked(uint64_t maxIdleBytes);
+
+        std::list<IdleBuffer> fIdleBuffers; // most recently released first
+        uint64_t fMaxIdleBytes = DefaultMaxIdleBytes;
+        Stats fStats;
+        mutable std::mutex fMutex;
+        // Released items of outstanding images find the pool through this, and free their buffer once it's gone.
+        std::shared_ptr<ImageItemPool*> fSelf = std::make_shared<ImageItemPool*>(this);
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <Image.h>
+
+namespace OIV
+{
+    // Files holding the pixels of images evicted from memory, one file per image.
+    // Texels are stored as they are, a spilled image is read back at the speed of the disk.
+    // The image's process data is kept in memory while its pixels are on disk, and restored with them.
+    // Every store writes to a folder of its own, removed when the store is destroyed.
+    // A folder is locked by its store through a lock file beside it, folders left by a store which didn't
+    // exit cleanly are unlocked and removed when the next store is created.
+    // Safe to use from several threads as long as each key is used by one thread at a time.
+    class ImageSpillStore
+    {
+    public:
+        ImageSpillStore(const std::filesystem::path& parentFolder);
+        ~ImageSpillStore();
+        ImageSpillStore(const ImageSpillStore&) = delete;
+        ImageSpillStore& operator=(const ImageSpillStore&) = delete;
+
+        // Images with sub images can't be written.
+        static bool CanWrite(const IMCodec::Image& image);
+        bool Write(uint64_t key, const IMCodec::Image& image);
+        // Returns nullptr if the file is missing or corrupted.
+        IMCodec::ImageSharedPtr Read(uint64_t key) const;
+        void Remove(uint64_t key);
+
+    private:
+        class FolderLock;
+        using ProcessData = decltype(IMCodec::ImageItem::processData);
+
+        std::filesystem::path GetFilePath(uint64_t key) const;
+        static std::filesystem::path GetLockPath(const std::filesystem::path& folder);
+        static void RemoveStaleFolders(const std::filesystem::path& parentFolder);
+
+        // Empty if no folder could be locked and created, nothing is written then.
+        std::filesystem::path fFolder;
+        std::unique_ptr<FolderLock> fLock;
+        mutable std::mutex fProcessDataMutex;
+        std::unordered_map<uint64_t, ProcessData> fProcessData;
+    };
+}
@@ -32,10 +32,11 @@ namespace OIV
         OIVBaseImage(ImageSource source, IMCodec::ImageSharedPtr image);
         ImageSource GetImageSource() const { return fSource; }
         
-        std::wstring GetDescription() const
+        // 'swapAxes' describes the image as rotated by 90 degrees.
+        std::wstring GetDescription(bool swapAxes = false) const
         {
             std::wstringstream ss;
-            ss << fImage->GetWidth() << L" X " << fImage->GetHeight() << L" X "
+            ss << (swapAxes ? fImage->GetHeight() : fImage->GetWidth()) << L" X " << (swapAxes ? fImage->GetWidth() : fImage->GetHeight()) << L" X "
                 << fImage->GetBitsPerTexel() << L" BPP | loaded in " << std::fixed << std::setprecision(1)
                 << fImage->GetImageItem()->processData.processTime << L" ms"
                 //<< L"/" << fDescriptor.DisplayTime + fDescriptor.LoadTime << L" ms"
@@ -5,15 +5,41 @@
 
 namespace OIV
 {
+    class DecodedImageCache;
 
     class OIVFileImage : public OIVBaseImage
     {
     public:
+        // How the decoder of the file was selected.
+        struct CodecSelection
+        {
+            // Format detected from the file header, empty when unknown or ambiguous.
+            std::wstring detectedFormat;
+            // True if only the plugin of the detected format was tried, without trial decoding by other plugins.
+            bool traversalSkipped = false;
+        };
+
         const LLUtils::native_string_type& GetFileName() const;
         OIVFileImage(const LLUtils::native_string_type& fileName);
-        ResultCode Load(IMCodec::ImageLoader* imageCodec, IMCodec::PluginTraverseMode loaderFlags, IMCodec::ImageLoadFlags imageLoadFlags, const IMCodec::Parameters& params);
+        // When a decoded image cache is given, a cached decode of the file is used instead of decoding,
+        // and a fresh decode is offered to the cache.
+        ResultCode Load(IMCodec::ImageLoader* imageCodec, IMCodec::PluginTraverseMode loaderFlags, IMCodec::ImageLoadFlags imageLoadFlags, const IMCodec::Parameters& params
+            , DecodedImageCache* decodedImageCache = nullptr);
         ResultCode Load(IMCodec::ImageLoader* imageCodec, IMCodec::PluginTraverseMode loaderFlags);
+        const CodecSelection& GetCodecSelection() const { return fCodecSelection; }
+
+        // Load the JPEG preview embedded in the EXIF data of the file instead of the full image, orientation is applied.
+        ResultCode LoadEmbeddedPreview(IMCodec::ImageLoader* imageCodec);
+        bool IsPreview() const { return fIsPreview; }
+        // Size of the full image after orientation, valid when IsPreview() is true.
+        LLUtils::PointI32 GetFullImageSize() const { return fFullImageSize; }
+    private:
+        // Returns true and sets the detected format if the file header identifies a single format.
+        bool SelectPluginBySignature(IMCodec::PluginTraverseMode loaderFlags);
     private:
         const LLUtils::native_string_type fFileName;
+        CodecSelection fCodecSelection;
+        bool fIsPreview = false;
+        LLUtils::PointI32 fFullImageSize = LLUtils::PointI32::Zero;
     };
 }
\ No newline at end of file
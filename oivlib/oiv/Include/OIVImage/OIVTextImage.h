@@ -3,6 +3,7 @@
 #include <LLUtils/BitFlags.h>
 #include <LLUtils/Templates.h>
 #include <FreeTypeWrapper/FreeTypeConnector.h>
+#include <Text/GlyphAtlasCache.h>
 
 namespace FreeType
 {
@@ -159,6 +160,23 @@ namespace OIV
         }
 
 
+        // Single line labels are composed from the atlas' glyph cells when possible, the atlas must outlive the text image.
+        void SetGlyphAtlas(GlyphAtlasCache* glyphAtlas)
+        {
+            if (fGlyphAtlas != glyphAtlas)
+            {
+                fGlyphAtlas = glyphAtlas;
+                fDirtyFlags.set(DirtyFlags::Bitmap);
+            }
+        }
+
+        // Fixed width labels whose text changes often, e.g. numeric readouts, update only the glyph cells that
+        // changed in the existing bitmap when the number of glyphs stays the same.
+        void SetIncrementalCells(bool incrementalCells)
+        {
+            fIncrementalCells = incrementalCells;
+        }
+
         TextMetrics GetMetrics();
         void UpdateTextMetrics();
         void Create()
@@ -174,9 +192,9 @@ namespace OIV
         
     protected:
 
+        // Metrics are measured lazily, a composed text doesn't need them and a rasterized text gets them along with the bitmap.
         void UpdateBitmap()
         {
-            UpdateTextMetrics();
             if (fDirtyFlags.test(DirtyFlags::Bitmap))
             {
                 auto textImage = CreateText();
@@ -207,6 +225,11 @@ namespace OIV
        LLUtils::BitFlags<DirtyFlags> fDirtyFlags{};
        FreeType::TextMetrics fCachedTextMetrics;
        FreeType::FreeTypeConnector* fFreeType{};
+       GlyphAtlasCache* fGlyphAtlas{};
+       bool fIncrementalCells = false;
+       // Parameters of the current bitmap when it was composed from glyph cells.
+       bool fIsComposed = false;
+       FreeType::TextCreateParams fComposedParams{};
         
     };
 
@@ -0,0 +1,97 @@
+#pragma once
+#include "OIVBaseImage.h"
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <LLUtils/Color.h>
+#include <FreeTypeWrapper/FreeTypeConnector.h>
+
+namespace OIV
+{
+    // Displays text too large to rasterize as a whole, e.g. a multi-megabyte paste.
+    // Lines are split once, and only the lines intersecting the viewport are rasterized at the current scale.
+    // Rasterized lines are kept as strips in a byte bounded cache, so scrolling back and forth doesn't rasterize them again.
+    // The image is an overlay the size of the viewport, recomposed from the strips before rendering when the view changes.
+    class OIVVirtualTextImage : public OIVBaseImage
+    {
+    public:
+        OIVVirtualTextImage(ImageSource imageSource, FreeType::FreeTypeConnector* freeType);
+
+        void SetText(std::wstring text);
+        void SetFontPath(const std::wstring& fontPath);
+        void SetFontSize(uint16_t fontSize);
+        void SetDPI(uint16_t dpix, uint16_t dpiy);
+        void SetTextColor(LLUtils::Color color);
+        void SetBackgroundColor(LLUtils::Color color);
+
+        // Size of the viewport in client pixels.
+        void SetViewportSize(LLUtils::PointI32 size);
+        // Top left corner of the viewport in document space, i.e. text pixels at scale 1.
+        void SetViewportOffset(LLUtils::PointF64 offset);
+        void SetViewportScale(double scale);
+        LLUtils::PointF64 GetViewportOffset() const { return fViewportOffset; }
+        double GetViewportScale() const { return fViewportScale; }
+
+        // The width is of the widest line rasterized so far, or estimated from its length.
+        LLUtils::PointF64 GetDocumentSize();
+        size_t GetNumLines() const { return fLineStarts.size(); }
+
+    protected:
+        void PerformPreRender() override;
+        bool PerformIsDirty() const override;
+
+    private:
+        struct Strip
+        {
+            uint64_t key;
+            IMCodec::ImageSharedPtr image;
+        };
+
+        using StripList = std::list<Strip>;
+
+        static uint64_t GetStripKey(size_t line, uint16_t fontSize) { return (static_cast<uint64_t>(line) << 16) | fontSize; }
+
+        void InvalidateStrips();
+        void UpdateFontMetrics();
+        void ClampViewportOffset();
+        std::wstring_view GetLine(size_t line) const;
+        IMCodec::ImageSharedPtr GetStrip(size_t line, uint16_t fontSize);
+        void Compose();
+
+        static constexpr size_t MaxStripCacheBytes = 64 * 1024 * 1024;
+        // Longer lines are truncated, a single strip can't exceed texture limits.
+        static constexpr size_t MaxLineLength = 2048;
+        // Below this row pitch in client pixels lines are drawn as bars instead of text.
+        static constexpr double MinRowPitch = 6.0;
+        static constexpr uint16_t MaxFontSize = 256;
+
+        FreeType::FreeTypeConnector* fFreeType;
+        std::wstring fText;
+        std::vector<size_t> fLineStarts;
+        // Width of each line in document space, 0 until rasterized.
+        std::vector<uint32_t> fLineWidths;
+        double fDocumentWidth = 0;
+
+        std::wstring fFontPath;
+        uint16_t fFontSize = 10;
+        uint16_t fDPIx = 96;
+        uint16_t fDPIy = 96;
+        LLUtils::Color fTextColor{ 0, 0, 0, 255 };
+        LLUtils::Color fBackgroundColor{ 255, 255, 255, 255 };
+        // Measured once per font configuration.
+        bool fFontMetricsValid = false;
+        uint32_t fRowHeight = 0;
+        double fCharAdvance = 0;
+
+        LLUtils::PointI32 fViewportSize = LLUtils::PointI32::Zero;
+        LLUtils::PointF64 fViewportOffset = LLUtils::PointF64::Zero;
+        double fViewportScale = 1.0;
+        bool fViewDirty = true;
+
+        StripList fStrips; // most recently used first
+        std::unordered_map<uint64_t, StripList::iterator> fStripsMap;
+        size_t fStripsBytes = 0;
+    };
+
+    using OIVVirtualTextImageSharedPtr = std::shared_ptr<OIVVirtualTextImage>;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <defs.h>
+#include <Image.h>
+
+namespace OIV
+{
+    // Copies texels of an image into a caller's buffer, converting them on the way.
+    // Conversions between 8 and 16 bit unsigned RGB, RGBA and alpha layouts are done directly per row,
+    // with an SSE2 path for swapping the red and blue channels of 32 bit texels. Large regions are split over threads.
+    // Texels are copied as they are when the formats match. Conversions between other texel formats aren't handled,
+    // callers convert those with IMUtil::ImageUtil first.
+    class TexelReadback
+    {
+    public:
+        static bool IsSupported(OIV_TexelFormat sourceFormat, OIV_TexelFormat targetFormat);
+        // 0 for texel formats smaller than a byte.
+        static uint32_t GetBytesPerTexel(OIV_TexelFormat format);
+
+        // Copies the region at (x, y) of the given size, which must lie inside 'image'.
+        static void CopyRegion(const IMCodec::Image& image, uint32_t x, uint32_t y, uint32_t width, uint32_t height
+            , OIV_TexelFormat targetFormat, std::byte* target, std::size_t targetRowPitch);
+
+        // Writes the texels at 'points' one after another, texels of points outside the image are zeroed.
+        static void CopyPoints(const IMCodec::Image& image, const OIV_POINT_I* points, std::size_t numPoints
+            , OIV_TexelFormat targetFormat, std::byte* target);
+    };
+}
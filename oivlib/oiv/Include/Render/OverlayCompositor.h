@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <LLUtils/Point.h>
+#include <Image.h>
+#include <Interfaces/IRenderable.h>
+
+namespace OIV
+{
+    // Packs the images of all overlay renderables into a single atlas image, so a renderer uploads one texture
+    // and draws all overlays at once. Images are packed into shelves, an overlay whose image changed is copied over
+    // its place in the atlas and only the changed rectangle is uploaded. The atlas is repacked, and uploaded as a whole,
+    // only when a changed image no longer fits its place and no free space is left.
+    class OverlayCompositor
+    {
+    public:
+        struct Rect
+        {
+            uint32_t x;
+            uint32_t y;
+            uint32_t width;
+            uint32_t height;
+        };
+
+        struct Instance
+        {
+            IRenderable* renderable;
+            // The overlay's image within the atlas.
+            Rect atlasRect;
+            LLUtils::PointF64 position;
+            LLUtils::PointF64 scale;
+            double opacity;
+        };
+
+        struct Stats
+        {
+            uint32_t packedOverlays = 0;
+            uint32_t unpackedOverlays = 0;
+            uint32_t atlasWidth = 0;
+            uint32_t atlasHeight = 0;
+            uint64_t frames = 0;
+            uint64_t repacks = 0;
+            uint64_t frameUploadedBytes = 0;
+            uint64_t totalUploadedBytes = 0;
+        };
+
+        static constexpr uint32_t InitialAtlasSize = 512;
+        static constexpr uint32_t MaxAtlasSize = 4096;
+
+        // 'overlays' are in draw order. Visible overlays are prepared for rendering and their changed images copied to the atlas.
+        // Overlays that can't be packed, being too large or not 8 bit RGBA/BGRA, are returned in 'unpacked' to be drawn on their own.
+        void Update(const std::vector<IRenderable*>& overlays, std::vector<IRenderable*>& unpacked);
+        void Remove(IRenderable* renderable);
+
+        const IMCodec::ImageSharedPtr& GetAtlas() const { return fAtlas; }
+        // Visible packed overlays, in draw order.
+        const std::vector<Instance>& GetInstances() const { return fInstances; }
+        // The atlas was recreated since the last upload and has to be uploaded as a whole.
+        bool IsAtlasRecreated() const { return fAtlasRecreated; }
+        // Rectangles of the atlas changed since the last upload.
+        const std::vector<Rect>& GetDirtyRects() const { return fDirtyRects; }
+
+        // Called by the renderer once the atlas changes were uploaded.
+        void OnUploaded();
+        // Called by the renderer for textures of unpacked overlays.
+        void AddUploadedBytes(uint64_t bytes);
+        const Stats& GetStats() const { return fStats; }
+
+    private:
+        struct Entry
+        {
+            IMCodec::ImageSharedPtr image;
+            // Allocated place, at least the size of the image.
+            Rect slot{};
+            bool packed = false;
+            // Didn't fit an atlas of the maximum size, drawn unpacked and not retried until the set of overlays changes.
+            bool overflowed = false;
+        };
+
+        struct Shelf
+        {
+            uint32_t y;
+            uint32_t height;
+            uint32_t usedWidth;
+        };
+
+        static bool IsPackable(const IMCodec::Image& image);
+        // Size an image takes in the atlas, rounded up and padded.
+        static void GetSlotSize(uint32_t width, uint32_t height, uint32_t& slotWidth, uint32_t& slotHeight);
+        bool Allocate(uint32_t width, uint32_t height, Rect& slot);
+        void CreateAtlas();
+        void Repack();
+        void Copy(const Entry& entry);
+
+        // Slots are rounded up so images which change size slightly, like labels, keep their place.
+        static constexpr uint32_t SlotWidthGranularity = 16;
+        static constexpr uint32_t SlotHeightGranularity = 4;
+        // Free texels between slots, sampling at the edge of an image never reads its neighbour.
+        static constexpr uint32_t SlotPadding = 1;
+
+        IMCodec::ImageSharedPtr fAtlas;
+        std::byte* fAtlasData = nullptr;
+        uint32_t fAtlasWidth = InitialAtlasSize;
+        uint32_t fAtlasHeight = InitialAtlasSize;
+        std::vector<Shelf> fShelves;
+        uint32_t fShelvesBottom = 0;
+        std::unordered_map<IRenderable*, Entry> fEntries;
+        std::vector<Instance> fInstances;
+        std::vector<Rect> fDirtyRects;
+        bool fAtlasRecreated = false;
+        // Overlays were added or removed since overflowed entries were last retried.
+        bool fOverlaySetChanged = false;
+        Stats fStats;
+    };
+}
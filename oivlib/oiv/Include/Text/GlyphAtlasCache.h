@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <Image.h>
+#include <FreeTypeWrapper/FreeTypeConnector.h>
+
+namespace OIV
+{
+    // Glyphs rasterized once per font configuration (font, size, DPI, render mode, outline and colors) and shared by all text labels.
+    // Single line text in a fixed width font is composed by blitting cached glyph cells, so labels which change often,
+    // like the texel position in the status bar, don't lay out and rasterize their whole text on every change.
+    // Each configuration is calibrated once against a fully rasterized string, configurations that can't be composed
+    // exactly (e.g. proportional fonts) are left to full rasterization.
+    class GlyphAtlasCache
+    {
+    public:
+        GlyphAtlasCache(FreeType::FreeTypeConnector* freeType);
+
+        // Returns nullptr if the text can't be composed from glyph cells, the caller then rasterizes the text as a whole.
+        IMCodec::ImageSharedPtr Compose(const FreeType::TextCreateParams& createParams);
+        // Update in place an image composed from 'previousParams' to 'createParams', blitting only the glyph cells that changed.
+        // Returns false if the configuration or the number of glyphs differ, the caller then composes the text anew.
+        bool Update(const FreeType::TextCreateParams& createParams, const FreeType::TextCreateParams& previousParams, IMCodec::Image& image);
+        void Clear();
+
+    private:
+        enum class CompositionOrder
+        {
+              Unknown
+            , Disabled
+            , Forward  // glyph cells overflow their advance to the left, later glyphs are blitted over earlier ones
+            , Backward // glyph cells overflow their advance to the right
+        };
+
+        struct Atlas
+        {
+            FreeType::TextCreateParams params;
+            CompositionOrder order = CompositionOrder::Unknown;
+            uint32_t advance = 0;
+            uint32_t cellWidth = 0;
+            uint32_t cellHeight = 0;
+            // R8G8B8A8 cells, one after the other.
+            std::vector<std::byte> cells;
+            // Rasterized text (a glyph and its meta text color tag) -> cell index, -1 if it doesn't fit a cell.
+            std::unordered_map<std::wstring, int32_t> glyphs;
+        };
+
+        static bool IsSameConfiguration(const FreeType::TextCreateParams& a, const FreeType::TextCreateParams& b);
+        // Split text to the strings rasterized for each glyph, returns false if the text isn't a single line of composable glyphs.
+        static bool SplitGlyphs(const std::wstring& text, bool useMetaText, std::vector<std::wstring>& glyphs);
+
+        Atlas& GetAtlas(const FreeType::TextCreateParams& createParams);
+        void Calibrate(Atlas& atlas);
+        int32_t GetGlyph(Atlas& atlas, const std::wstring& glyphText);
+        bool GetGlyphs(Atlas& atlas, const std::vector<std::wstring>& glyphTexts, std::vector<int32_t>& cells);
+        IMCodec::ImageSharedPtr Compose(const Atlas& atlas, const std::vector<int32_t>& cells, CompositionOrder order) const;
+        // Blit columns [firstColumn, endColumn) of a cell to its position in the text.
+        static void BlitCell(const Atlas& atlas, int32_t cell, size_t position, uint32_t firstColumn, uint32_t endColumn, std::byte* target, size_t rowPitch);
+        static void BlitCells(const Atlas& atlas, const std::vector<int32_t>& cells, CompositionOrder order, std::byte* target, size_t rowPitch);
+
+        static constexpr size_t MaxAtlases = 16;
+        static constexpr size_t MaxGlyphsPerAtlas = 1024;
+        static constexpr wchar_t CalibrationText[] = L"0:9 X";
+
+        FreeType::FreeTypeConnector* fFreeType;
+        // Most recently used last.
+        std::list<Atlas> fAtlases;
+    };
+}
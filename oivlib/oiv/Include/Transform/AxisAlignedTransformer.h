@@ -0,0 +1,20 @@
+#pragma once
+#include <Image.h>
+#include <ImageUtil/AxisAlignedTransform.h>
+
+namespace OIV
+{
+    // Axis aligned rotations and flips of images.
+    // 90 degrees rotations are done in square tiles so both the source rows and the target rows of a tile stay in cache,
+    // with SSE2 block transposes for 32 and 64 bit texels, and tiles are spread over threads for large images.
+    // Texel sizes other than 8, 16, 24, 32, 64 and 128 bits and images with sub images are handed to IMUtil::ImageUtil::Transform.
+    class AxisAlignedTransformer
+    {
+    public:
+        static IMCodec::ImageSharedPtr Transform(const IMUtil::AxisAlignedTransform& transform, IMCodec::ImageSharedPtr image);
+
+        // Transforms 'image' in place when the transform keeps its dimensions (180 degrees rotation and flips)
+        // and 'image' is the only reference to it, otherwise 'image' is replaced with a transformed copy.
+        static void TransformInPlace(const IMUtil::AxisAlignedTransform& transform, IMCodec::ImageSharedPtr& image);
+    };
+}
@@ -20,9 +20,14 @@ typedef wchar_t OIVCHAR;
 
 
 
-    typedef int16_t ImageHandle;
+    // Image handles are tagged with a generation, a handle of an unloaded image is never reused for another image.
+    typedef int32_t ImageHandle;
     const ImageHandle ImageHandleNull = 0;
 
+    // Identifies a command queued by OIV_ExecuteAsync.
+    typedef uint64_t OIV_AsyncTicket;
+    const OIV_AsyncTicket OIV_AsyncTicketNull = 0;
+
 
     enum CommandExecute
     {
@@ -50,6 +55,9 @@ typedef wchar_t OIVCHAR;
         , OIV_CMD_RegisterCallbacks
         , OIV_CMD_GetSubImages
         , OIV_CMD_ResampleImage
+        , OIV_CMD_ProbeFile
+        , OIV_CMD_ReadTexels
+        , OIV_CMD_SetImageMemoryBudget
     };
 
     
@@ -74,6 +82,7 @@ typedef wchar_t OIVCHAR;
         , RC_BadConversion
         , RC_ImageNotFound
         , RC_NotImplemented
+        , RC_Cancelled
         , RC_UknownError = 0xFF
         , RC_InternalError = 0xFF + 1,
 
@@ -151,6 +160,12 @@ typedef wchar_t OIVCHAR;
         int32_t y1;
     };
 
+    struct OIV_POINT_I
+    {
+        int32_t x;
+        int32_t y;
+    };
+
     struct OIV_RECT_F
     {
         double x0;
@@ -187,10 +202,22 @@ typedef wchar_t OIVCHAR;
         const LLUtils::native_char_type* functionName;
     };
 
+    struct OIV_AsyncCommandCompleted_Args
+    {
+        OIV_AsyncTicket ticket;
+        int command;
+        ResultCode result;
+        // The command's response, valid only during the callback.
+        const void* responseData;
+        std::size_t responseSize;
+    };
+
     struct OIV_CMD_RegisterCallbacks_Request
     {
         void(*OnException) (OIV_Exception_Args, void*);
 		void* userPointer;
+        // Called from a worker thread when a command queued by OIV_ExecuteAsync completes or is cancelled.
+        void(*OnAsyncCommandCompleted) (OIV_AsyncCommandCompleted_Args, void*);
     };
 
 
@@ -512,6 +539,11 @@ typedef wchar_t OIVCHAR;
     struct CmdDataInit
     {
         std::size_t parentHandle;
+        // Pixel data of images beyond 'imageMemoryBudget' is spilled to a folder of this instance under 'spillFolder',
+        // nullptr keeps all images in memory.
+        const OIVCHAR* spillFolder;
+        // 0 for no limit, may be changed later by OIV_CMD_SetImageMemoryBudget.
+        uint64_t imageMemoryBudget;
     };
 
     struct OIV_CMD_QueryImageInfo_Request
@@ -530,6 +562,78 @@ typedef wchar_t OIVCHAR;
         OIV_TexelFormat texelFormat;
     };
 
+    constexpr uint8_t OIV_CMD_ProbeFile_Format_Size = 16;
+    constexpr uint8_t OIV_CMD_ProbeFile_DateTime_Size = 20;
+
+    // Reads image properties from the file headers without decoding the image.
+    struct OIV_CMD_ProbeFile_Request
+    {
+        const OIVCHAR* filePath;
+    };
+
+    struct OIV_CMD_ProbeFile_Response
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t bitsPerPixel;
+        // 0 when unknown.
+        uint32_t NumSubImages;
+        OIV_TexelFormat texelFormat;
+        // 0 when absent.
+        uint16_t exifOrientation;
+        // "YYYY:MM:DD HH:MM:SS", empty when absent.
+        char exifDateTime[OIV_CMD_ProbeFile_DateTime_Size];
+        // File offset of the embedded EXIF thumbnail, exifThumbnailLength is 0 when absent.
+        uint64_t exifThumbnailOffset;
+        uint32_t exifThumbnailLength;
+        // Canonical file extension of the detected format.
+        OIVCHAR format[OIV_CMD_ProbeFile_Format_Size];
+    };
+
+    // Copies texels of an image into a caller provided buffer, converted to 'format'.
+    struct OIV_CMD_ReadTexels_Request
+    {
+        ImageHandle handle;
+        // TF_UNKNOWN keeps the texel format of the image.
+        OIV_TexelFormat format;
+        // Region to copy when 'points' is null, clipped to the image. x1 and y1 are exclusive.
+        OIV_RECT_I rect;
+        // Otherwise the texels at 'points' are written one after another, texels of points outside the image are zeroed.
+        const OIV_POINT_I* points;
+        uint32_t numPoints;
+        // When null only the response is filled, e.g. to query the buffer size.
+        void* buffer;
+        std::size_t bufferSize;
+        // Bytes between the rows of the region in 'buffer', 0 for consecutive rows.
+        uint32_t rowPitch;
+    };
+
+    struct OIV_CMD_ReadTexels_Response
+    {
+        // Size of the copied region after clipping, a single row of 'numPoints' texels for points.
+        uint32_t width;
+        uint32_t height;
+        uint32_t rowPitch;
+        uint32_t bitsPerTexel;
+        OIV_TexelFormat format;
+        // Bytes required in 'buffer'.
+        std::size_t requiredSize;
+    };
+
+    // Pixel data of loaded images beyond the budget is spilled to disk, least recently used first,
+    // and read back when the image is next used.
+    struct OIV_CMD_SetImageMemoryBudget_Request
+    {
+        // 0 for no limit.
+        uint64_t budgetBytes;
+    };
+
+    struct OIV_CMD_SetImageMemoryBudget_Response
+    {
+        uint64_t residentBytes;
+        uint64_t spilledBytes;
+    };
+
 #pragma pack(pop) 
 
 #ifdef __cplusplus
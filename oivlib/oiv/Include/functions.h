@@ -11,5 +11,10 @@
 extern "C"
 {
     OIV_EXPORT ResultCode OIV_Execute(int command, std::size_t requestSize, void* requestData, std::size_t responseSize, void* responseData);
+    // Queues a command and returns at once, the response is delivered to the OnAsyncCommandCompleted callback.
+    // Only the request structure is copied, data it points to, like the buffer of LoadRaw or the path of ProbeFile,
+    // must stay valid until the completion callback is called for the command, cancelled or not.
+    OIV_EXPORT ResultCode OIV_ExecuteAsync(int command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket* ticket);
+    OIV_EXPORT ResultCode OIV_CancelAsync(OIV_AsyncTicket ticket);
     OIV_EXPORT ResultCode OIV_Util_GetBPPFromTexelFormat(OIV_TexelFormat in_texelFormat, uint8_t* out_bpp);
 }
@@ -0,0 +1,27 @@
+uniform Texture2D    tex1;
+uniform SamplerState samplerState;
+
+#if defined(HLSL) || defined(D3D11)
+////////////////////////
+///DIRECT3D HLSL FRAGMENT SHADER
+///////////////////////
+struct ShaderIn
+{
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD;
+    float opacity : OPACITY;
+};
+
+struct ShaderOut
+{
+    float4 texelOut : SV_Target;
+};
+
+// Samples the overlay's image from the atlas, the quad covers the overlay only.
+void main(in ShaderIn input, out ShaderOut output)
+{
+    float4 texel = tex1.Sample(samplerState, input.uv);
+    texel.a *= input.opacity;
+    output.texelOut = texel;
+}
+#endif
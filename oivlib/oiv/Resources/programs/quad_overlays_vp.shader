@@ -0,0 +1,46 @@
+#define MAX_OVERLAYS 256
+
+struct OverlayInstance
+{
+	float4 screenRect; // x, y, width, height in client pixels
+	float4 atlasRect;  // u, v, width, height in atlas texture space
+	float4 opacity;
+};
+
+cbuffer OverlaysData : register(b0)
+{
+	float4 uViewportSize;
+	OverlayInstance uOverlays[MAX_OVERLAYS];
+};
+
+#if defined(HLSL) || defined(D3D11)
+////////////////////////
+///DIRECT3D HLSL VERTEX SHADER
+///////////////////////
+struct ShaderIn
+{
+	float2 pos : POSITION;
+	uint instanceID : SV_InstanceID;
+};
+
+struct ShaderOut
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD;
+	float opacity : OPACITY;
+};
+
+// Each instance is the unit quad placed over its overlay's screen rectangle.
+void main(in ShaderIn input, out ShaderOut output)
+{
+	OverlayInstance instance = uOverlays[input.instanceID];
+	float2 local = float2(input.pos * 0.5 + 0.5);
+	local.y = 1.0 - local.y;
+
+	float2 pixel = instance.screenRect.xy + local * instance.screenRect.zw;
+	float2 clip = pixel / uViewportSize.xy * 2.0 - 1.0;
+	output.pos = float4(clip.x, -clip.y, 0, 1);
+	output.uv = instance.atlasRect.xy + local * instance.atlasRect.zw;
+	output.opacity = instance.opacity.x;
+}
+#endif
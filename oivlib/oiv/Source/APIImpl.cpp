@@ -7,9 +7,27 @@ namespace OIV
 
     ResultCode Execute_impl(int command, std::size_t requestSize, void* requestData, std::size_t responseSize, void* responseData)
     {
+        // Running asynchronous commands hold the command lock shared, they are waited for, and queued ones cancelled,
+        // before destroy takes the lock exclusively and the picture renderer is gone.
+        if (command == OIV_CMD_Destroy)
+            ApiGlobal::sAsyncCommandProcessor.Shutdown();
+
         return ApiGlobal::sCommandProcessor.ProcessCommand(static_cast<CommandExecute>(command), requestSize, requestData, responseSize, responseData);
     }
 
+    ResultCode ExecuteAsync_impl(int command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket* ticket)
+    {
+        if (requestData == nullptr || ticket == nullptr)
+            return RC_InvalidParameters;
+
+        return ApiGlobal::sAsyncCommandProcessor.Submit(static_cast<CommandExecute>(command), requestSize, requestData, responseSize, *ticket);
+    }
+
+    ResultCode CancelAsync_impl(OIV_AsyncTicket ticket)
+    {
+        return ApiGlobal::sAsyncCommandProcessor.Cancel(ticket);
+    }
+
     namespace Util
     {
         
@@ -3,6 +3,8 @@
 namespace OIV
 {
     ResultCode Execute_impl(int command, std::size_t requestSize, void* requestData, std::size_t responseSize, void* responseData);
+    ResultCode ExecuteAsync_impl(int command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket* ticket);
+    ResultCode CancelAsync_impl(OIV_AsyncTicket ticket);
     namespace Util
     {
         ResultCode GetBPPFromTexelFormat_impl(OIV_TexelFormat in_texelFormat, uint8_t* out_bpp);
@@ -5,4 +5,5 @@ namespace OIV
 {
     std::unique_ptr<IPictureRenderer> ApiGlobal::sPictureRenderer = std::make_unique<OIV>();
     CommandProcessor ApiGlobal::sCommandProcessor;
+    AsyncCommandProcessor ApiGlobal::sAsyncCommandProcessor(ApiGlobal::sCommandProcessor);
 }
\ No newline at end of file
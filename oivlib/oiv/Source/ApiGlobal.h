@@ -1,5 +1,6 @@
 #pragma once
 #include "Commands/CommandProcessor.h"
+#include "Commands/AsyncCommandProcessor.h"
 
 namespace OIV
 {
@@ -9,6 +10,7 @@ namespace OIV
     public:
         static std::unique_ptr<IPictureRenderer> sPictureRenderer;
         static CommandProcessor sCommandProcessor;
+        static AsyncCommandProcessor sAsyncCommandProcessor;
     };
 }
 
@@ -0,0 +1,188 @@
+#include "AsyncCommandProcessor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace OIV
+{
+    AsyncCommandProcessor::AsyncCommandProcessor(CommandProcessor& commandProcessor) : fState(std::make_shared<State>(commandProcessor))
+    {
+
+    }
+
+    AsyncCommandProcessor::~AsyncCommandProcessor()
+    {
+        {
+            std::lock_guard lock(fState->mutex);
+            fState->stop = true;
+        }
+
+        fState->condition.notify_all();
+        for (std::thread& worker : fWorkers)
+            worker.detach();
+    }
+
+    void AsyncCommandProcessor::StartWorkers()
+    {
+        const unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < numWorkers; i++)
+            fWorkers.emplace_back(&AsyncCommandProcessor::WorkerEntryPoint, fState);
+    }
+
+    ResultCode AsyncCommandProcessor::Submit(CommandExecute command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket& ticket)
+    {
+        ticket = OIV_AsyncTicketNull;
+        CommandHandler* handler = fState->commandProcessor.GetHandler(command);
+        if (handler == nullptr)
+            return RC_UnknownCommand;
+
+        if (handler->IsConcurrent() == false)
+            return RC_NotImplemented;
+
+        const ResultCode result = handler->Validate(requestSize, responseSize);
+        if (result != RC_Success)
+            return result;
+
+        Task task;
+        task.command = command;
+        task.request.resize(requestSize);
+        std::memcpy(task.request.data(), requestData, requestSize);
+        task.responseSize = responseSize;
+        task.imageHandle = handler->GetImageHandle(requestData);
+
+        {
+            std::lock_guard lock(fState->mutex);
+            if (fState->stop)
+                return RC_NotInitialized;
+
+            // Workers are started on first use, applications which don't queue commands pay nothing.
+            if (fWorkers.empty())
+                StartWorkers();
+
+            ticket = fState->nextTicket++;
+            if (task.imageHandle == ImageHandleNull)
+            {
+                fState->ready.push_back(ticket);
+            }
+            else
+            {
+                auto [it, idle] = fState->imageQueues.try_emplace(task.imageHandle);
+                if (idle)
+                    fState->ready.push_back(ticket);
+                else
+                    it->second.push_back(ticket);
+            }
+
+            fState->tasks.emplace(ticket, std::move(task));
+        }
+
+        fState->condition.notify_one();
+        return RC_Success;
+    }
+
+    ResultCode AsyncCommandProcessor::Cancel(OIV_AsyncTicket ticket)
+    {
+        std::lock_guard lock(fState->mutex);
+        auto it = fState->tasks.find(ticket);
+        if (it == fState->tasks.end())
+            return RC_InvalidHandle;
+
+        it->second.cancelled = true;
+        return RC_Success;
+    }
+
+    void AsyncCommandProcessor::Shutdown()
+    {
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard lock(fState->mutex);
+            fState->stop = true;
+            workers.swap(fWorkers);
+        }
+
+        // Running commands complete normally.
+        fState->condition.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+
+        std::vector<std::pair<OIV_AsyncTicket, Task>> dropped;
+        void(*callback)(OIV_AsyncCommandCompleted_Args, void*);
+        void* userPointer;
+        {
+            std::lock_guard lock(fState->mutex);
+            dropped.assign(std::make_move_iterator(fState->tasks.begin()), std::make_move_iterator(fState->tasks.end()));
+            fState->tasks.clear();
+            fState->ready.clear();
+            fState->imageQueues.clear();
+            callback = fState->completionCallback;
+            userPointer = fState->completionUserPointer;
+        }
+
+        if (callback == nullptr)
+            return;
+
+        // Tickets are increasing, queued commands complete in submission order.
+        std::sort(dropped.begin(), dropped.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        for (auto& [ticket, task] : dropped)
+        {
+            std::vector<std::byte> response(task.responseSize);
+            callback(OIV_AsyncCommandCompleted_Args{ ticket, task.command, RC_Cancelled, response.data(), response.size() }, userPointer);
+        }
+    }
+
+    void AsyncCommandProcessor::SetCompletionCallback(void(*callback)(OIV_AsyncCommandCompleted_Args, void*), void* userPointer)
+    {
+        std::lock_guard lock(fState->mutex);
+        fState->completionCallback = callback;
+        fState->completionUserPointer = userPointer;
+    }
+
+    void AsyncCommandProcessor::WorkerEntryPoint(std::shared_ptr<State> state)
+    {
+        for (;;)
+        {
+            OIV_AsyncTicket ticket;
+            Task task;
+            void(*callback)(OIV_AsyncCommandCompleted_Args, void*);
+            void* userPointer;
+            {
+                std::unique_lock lock(state->mutex);
+                state->condition.wait(lock, [&state] { return state->stop || state->ready.empty() == false; });
+                if (state->stop)
+                    return;
+
+                ticket = state->ready.front();
+                state->ready.pop_front();
+                auto it = state->tasks.find(ticket);
+                task = std::move(it->second);
+                state->tasks.erase(it);
+                callback = state->completionCallback;
+                userPointer = state->completionUserPointer;
+            }
+
+            std::vector<std::byte> response(task.responseSize);
+            const ResultCode result = task.cancelled ? RC_Cancelled
+                : state->commandProcessor.ProcessCommand(task.command, task.request.size(), task.request.data(), response.size(), response.data());
+
+            // The next task on the same image is released only after the callback returns, completions on an image stay ordered.
+            if (callback != nullptr)
+                callback(OIV_AsyncCommandCompleted_Args{ ticket, task.command, result, response.data(), response.size() }, userPointer);
+
+            if (task.imageHandle != ImageHandleNull)
+            {
+                {
+                    std::lock_guard lock(state->mutex);
+                    auto it = state->imageQueues.find(task.imageHandle);
+                    if (it->second.empty())
+                    {
+                        state->imageQueues.erase(it);
+                        continue;
+                    }
+
+                    state->ready.push_back(it->second.front());
+                    it->second.pop_front();
+                }
+                state->condition.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <defs.h>
+#include "CommandProcessor.h"
+
+namespace OIV
+{
+    // Executes commands on worker threads and reports their completion through a callback.
+    // Only concurrent commands are accepted, they run alongside synchronous commands under the command processor's lock.
+    // Commands on the same image run one at a time and complete in submission order, other commands run in parallel.
+    class AsyncCommandProcessor
+    {
+    public:
+        AsyncCommandProcessor(CommandProcessor& commandProcessor);
+        // Doesn't wait for the workers, it may run during static destruction under the loader lock.
+        // Workers which weren't shut down are detached and exit on their own.
+        ~AsyncCommandProcessor();
+
+        // The request is copied shallowly, data it points to is read by a worker and must stay valid until the completion callback is called.
+        // The response is passed to the completion callback.
+        ResultCode Submit(CommandExecute command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket& ticket);
+        // A command which didn't start yet completes with RC_Cancelled, a running command can't be cancelled.
+        ResultCode Cancel(OIV_AsyncTicket ticket);
+        // Waits for running commands and completes queued ones with RC_Cancelled, commands submitted later are rejected.
+        // Must be called without the command processor's lock held and not from a completion callback.
+        void Shutdown();
+        void SetCompletionCallback(void(*callback)(OIV_AsyncCommandCompleted_Args, void*), void* userPointer);
+
+    private:
+        struct Task
+        {
+            CommandExecute command;
+            std::vector<std::byte> request;
+            std::size_t responseSize;
+            ImageHandle imageHandle;
+            bool cancelled = false;
+        };
+
+        // Shared with the workers, which outlive the processor when it's destroyed without a shutdown.
+        struct State
+        {
+            State(CommandProcessor& processor) : commandProcessor(processor) {}
+
+            CommandProcessor& commandProcessor;
+            std::mutex mutex;
+            std::condition_variable condition;
+            OIV_AsyncTicket nextTicket = 1;
+            // Tasks which didn't start yet.
+            std::unordered_map<OIV_AsyncTicket, Task> tasks;
+            // Tasks free to run, in submission order.
+            std::deque<OIV_AsyncTicket> ready;
+            // An image with a queued or running task, and the tasks waiting for it to complete.
+            std::unordered_map<ImageHandle, std::deque<OIV_AsyncTicket>> imageQueues;
+            void(*completionCallback)(OIV_AsyncCommandCompleted_Args, void*) = nullptr;
+            void* completionUserPointer = nullptr;
+            bool stop = false;
+        };
+
+        static void WorkerEntryPoint(std::shared_ptr<State> state);
+        // Called with the state locked.
+        void StartWorkers();
+
+        std::shared_ptr<State> fState;
+        // Guarded by the state's mutex.
+        std::vector<std::thread> fWorkers;
+    };
+}
@@ -33,6 +33,12 @@ namespace OIV
         }
     public:
         virtual ~CommandHandler() {}
+        // Concurrent commands only access images through their handles and may run in parallel with each other,
+        // other commands run exclusively.
+        virtual bool IsConcurrent() const { return false; }
+        // The image a command reads, queued commands on the same image run and complete in submission order.
+        virtual ImageHandle GetImageHandle([[maybe_unused]] const void* request) const { return ImageHandleNull; }
+        ResultCode Validate(std::size_t requestSize, std::size_t responseSize) { return Verify(requestSize, responseSize); }
     protected:
         virtual ResultCode Verify([[maybe_unused]] std::size_t requestSize, [[maybe_unused]] std::size_t responseSize) { return RC_Success; }
 
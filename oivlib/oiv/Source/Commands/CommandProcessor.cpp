@@ -24,6 +24,9 @@ LLUTILS_DISABLE_WARNING_UNUSED_PARAMETER
 #include "Handlers/CommandHandlerRegisterCallbacks.h"
 #include "Handlers/CommandHandlerGetSubImages.h"
 #include "Handlers/CommandHandlerResampleImage.h"
+#include "Handlers/CommandHandlerProbeFile.h"
+#include "Handlers/CommandHandlerReadTexels.h"
+#include "Handlers/CommandHandlerSetImageMemoryBudget.h"
 LLUTILS_DISABLE_WARNING_POP
 
 namespace OIV
@@ -52,6 +55,15 @@ namespace OIV
         fCommandHandlers.emplace(OIV_CMD_RegisterCallbacks, std::make_unique<CommandHandlerRegisterCallbacks>());
         fCommandHandlers.emplace(OIV_CMD_GetSubImages, std::make_unique<CommandHandlerGetSubImages>());
         fCommandHandlers.emplace(OIV_CMD_ResampleImage, std::make_unique<CommandHandlerResampleImage>());
+        fCommandHandlers.emplace(OIV_CMD_ProbeFile, std::make_unique<CommandHandlerProbeFile>());
+        fCommandHandlers.emplace(OIV_CMD_ReadTexels, std::make_unique<CommandHandlerReadTexels>());
+        fCommandHandlers.emplace(OIV_CMD_SetImageMemoryBudget, std::make_unique<CommandHandlerSetImageMemoryBudget>());
+    }
+
+    CommandHandler* CommandProcessor::GetHandler(CommandExecute command) const
+    {
+        auto it = fCommandHandlers.find(command);
+        return it != fCommandHandlers.end() ? it->second.get() : nullptr;
     }
 
     ResultCode CommandProcessor::ProcessCommand(CommandExecute command, const std::size_t requestSize, const void* requestData, const std::size_t responseSize, void* responseData)
@@ -61,7 +73,16 @@ namespace OIV
         {
             try
             {
-                return pair->second->Execute(requestData, requestSize, responseData, responseSize);
+                if (pair->second->IsConcurrent())
+                {
+                    std::shared_lock lock(fMutex);
+                    return pair->second->Execute(requestData, requestSize, responseData, responseSize);
+                }
+                else
+                {
+                    std::unique_lock lock(fMutex);
+                    return pair->second->Execute(requestData, requestSize, responseData, responseSize);
+                }
             }
 
             catch (...)
@@ -1,5 +1,6 @@
 #pragma once
 #include <unordered_map>
+#include <shared_mutex>
 
 #include <defs.h>
 #include "../IPictureRenderer.h"
@@ -15,11 +16,15 @@ namespace OIV
     public: // methods
         CommandProcessor();
         ResultCode ProcessCommand(CommandExecute command, const std::size_t requestSize, const void* requestData, const std::size_t responseSize, void* responseData);
+        // Returns nullptr for an unknown command.
+        CommandHandler* GetHandler(CommandExecute command) const;
     private: // methods
         //bool IsInitialized() const;
 
     private: // member fields
         MapCommanderHandler fCommandHandlers;
+        // Concurrent commands share the lock, commands on different images proceed in parallel.
+        std::shared_mutex fMutex;
 
     };
 }
@@ -10,6 +10,7 @@ namespace OIV
     protected:
         ResultCode ExecuteImpl(const void* request, const std::size_t requestSize, void* response, const std::size_t responseSize) override
         {
+            // Asynchronous commands were shut down by Execute_impl before the command lock was taken.
             ApiGlobal::sPictureRenderer.reset();
             return RC_Success;
         }
@@ -18,6 +18,7 @@ namespace OIV
 
             const CmdDataInit* dataInit = reinterpret_cast<const CmdDataInit*>(request);
             ApiGlobal::sPictureRenderer->SetParent(static_cast<std::size_t>(dataInit->parentHandle));
+            ApiGlobal::sPictureRenderer->SetImageSpilling(dataInit->spillFolder, dataInit->imageMemoryBudget);
             ApiGlobal::sPictureRenderer->Init();
             result = RC_Success;
 
@@ -0,0 +1,29 @@
+#pragma once
+#include "../CommandHandler.h"
+#include <defs.h>
+#include "../CommandProcessor.h"
+#include "../../ApiGlobal.h"
+
+namespace OIV
+{
+
+    class CommandHandlerReadTexels : public CommandHandler
+    {
+    public:
+        bool IsConcurrent() const override { return true; }
+        ImageHandle GetImageHandle(const void* request) const override { return reinterpret_cast<const OIV_CMD_ReadTexels_Request*>(request)->handle; }
+
+    protected:
+        ResultCode Verify(std::size_t requestSize, std::size_t responseSize) override
+        {
+            return VERIFY(OIV_CMD_ReadTexels_Request, requestSize, OIV_CMD_ReadTexels_Response, responseSize);
+        }
+
+        ResultCode ExecuteImpl(const void* request, const std::size_t requestSize, void* response, const std::size_t responseSize) override
+        {
+            const OIV_CMD_ReadTexels_Request* requestT = reinterpret_cast<const OIV_CMD_ReadTexels_Request*>(request);
+            OIV_CMD_ReadTexels_Response* responseT = reinterpret_cast<OIV_CMD_ReadTexels_Response*>(response);
+            return ApiGlobal::sPictureRenderer->ReadTexels(*requestT, *responseT);
+        }
+    };
+}
@@ -19,6 +19,7 @@ namespace OIV
             ResultCode result = RC_Success;
             const OIV_CMD_RegisterCallbacks_Request* callbacks = reinterpret_cast<const OIV_CMD_RegisterCallbacks_Request*>(request);
             result = ApiGlobal::sPictureRenderer->RegisterCallbacks(*callbacks);
+            ApiGlobal::sAsyncCommandProcessor.SetCompletionCallback(callbacks->OnAsyncCommandCompleted, callbacks->userPointer);
 
             return result;
         }
@@ -0,0 +1,32 @@
+#pragma once
+#include "../CommandHandler.h"
+#include <defs.h>
+#include "../CommandProcessor.h"
+#include "../../ApiGlobal.h"
+
+namespace OIV
+{
+
+    class CommandHandlerSetImageMemoryBudget : public CommandHandler
+    {
+    public:
+        bool IsConcurrent() const override { return true; }
+
+    protected:
+        ResultCode Verify(std::size_t requestSize, std::size_t responseSize) override
+        {
+            return VERIFY_OPTIONAL_RESPONSE(OIV_CMD_SetImageMemoryBudget_Request, requestSize, OIV_CMD_SetImageMemoryBudget_Response, responseSize);
+        }
+
+        ResultCode ExecuteImpl(const void* request, const std::size_t requestSize, void* response, const std::size_t responseSize) override
+        {
+            const OIV_CMD_SetImageMemoryBudget_Request* requestT = reinterpret_cast<const OIV_CMD_SetImageMemoryBudget_Request*>(request);
+            OIV_CMD_SetImageMemoryBudget_Response responseT = {};
+            const ResultCode result = ApiGlobal::sPictureRenderer->SetImageMemoryBudget(*requestT, responseT);
+            if (responseSize == sizeof(OIV_CMD_SetImageMemoryBudget_Response))
+                *reinterpret_cast<OIV_CMD_SetImageMemoryBudget_Response*>(response) = responseT;
+
+            return result;
+        }
+    };
+}
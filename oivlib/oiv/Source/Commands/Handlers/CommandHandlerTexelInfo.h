@@ -8,6 +8,10 @@ namespace OIV
 {
     class CommandHandlerTexelInfo : public CommandHandler
     {
+    public:
+        bool IsConcurrent() const override { return true; }
+        ImageHandle GetImageHandle(const void* request) const override { return reinterpret_cast<const OIV_CMD_TexelInfo_Request*>(request)->handle; }
+
     protected:
         ResultCode Verify(std::size_t requestSize, std::size_t responseSize) override
         {
@@ -0,0 +1,709 @@
+#include <FileSignature/ImageHeaderProbe.h>
+#include <FileSignature/SignatureRegistry.h>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+
+namespace OIV
+{
+    namespace
+    {
+        uint16_t ReadU16(const std::byte* data, bool littleEndian)
+        {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+            return littleEndian ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : static_cast<uint16_t>((p[0] << 8) | p[1]);
+        }
+
+        uint32_t ReadU24LE(const std::byte* data)
+        {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+            return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16;
+        }
+
+        uint32_t ReadU32(const std::byte* data, bool littleEndian)
+        {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+            return littleEndian
+                ? static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24
+                : static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+        }
+
+        uint64_t ReadU64(const std::byte* data, bool littleEndian)
+        {
+            const uint64_t first = ReadU32(data, littleEndian);
+            const uint64_t second = ReadU32(data + 4, littleEndian);
+            return littleEndian ? first | second << 32 : first << 32 | second;
+        }
+
+        uint8_t ReadU8(const std::byte* data)
+        {
+            return static_cast<uint8_t>(*data);
+        }
+
+        // Serves reads from the head of the file, reads past the head go to the file and are bounded by MaxReadSize.
+        class ProbeReader
+        {
+        public:
+            ProbeReader(std::ifstream& file) : fFile(file)
+            {
+                fHead.resize(ImageHeaderProbe::HeadReadSize);
+                fFile.read(reinterpret_cast<char*>(fHead.data()), static_cast<std::streamsize>(fHead.size()));
+                fHead.resize(static_cast<size_t>(fFile.gcount()));
+                fBytesRead = fHead.size();
+            }
+
+            const std::byte* Head() const { return fHead.data(); }
+            size_t HeadSize() const { return fHead.size(); }
+
+            bool Read(uint64_t offset, size_t size, std::byte* destination)
+            {
+                if (offset + size <= fHead.size())
+                {
+                    std::memcpy(destination, fHead.data() + offset, size);
+                    return true;
+                }
+
+                if (fBytesRead + size > ImageHeaderProbe::MaxReadSize)
+                    return false;
+
+                fBytesRead += size;
+                fFile.clear();
+                fFile.seekg(static_cast<std::streamoff>(offset));
+                fFile.read(reinterpret_cast<char*>(destination), static_cast<std::streamsize>(size));
+                return static_cast<size_t>(fFile.gcount()) == size;
+            }
+
+        private:
+            std::ifstream& fFile;
+            std::vector<std::byte> fHead;
+            size_t fBytesRead = 0;
+        };
+
+        // Minimal TIFF directory reader, shared by TIFF files and EXIF segments.
+        // BigTIFF files use the same directories with 64 bit counts and offsets.
+        class TiffReader
+        {
+        public:
+            enum Tag : uint16_t
+            {
+                  ImageWidth = 256
+                , ImageLength = 257
+                , BitsPerSample = 258
+                , Orientation = 274
+                , SamplesPerPixel = 277
+                , DateTime = 306
+                , JPEGInterchangeFormat = 513
+                , JPEGInterchangeFormatLength = 514
+                , ExifIFD = 34665
+                , DateTimeOriginal = 36867
+            };
+
+            enum Type : uint16_t
+            {
+                  Byte = 1
+                , Ascii = 2
+                , Short = 3
+                , Long = 4
+                , IFD = 13
+                , Long8 = 16
+                , IFD8 = 18
+            };
+
+            struct Entry
+            {
+                uint16_t tag;
+                uint16_t type;
+                uint64_t count;
+                // The value if it fits, otherwise its offset.
+                std::byte value[8];
+            };
+
+            using ListEntries = std::vector<Entry>;
+
+            // 'base' is the file offset of the TIFF header, directory offsets are relative to it.
+            TiffReader(ProbeReader& reader, uint64_t base) : fReader(reader), fBase(base) {}
+
+            bool Open()
+            {
+                std::byte header[16];
+                if (fReader.Read(fBase, 8, header) == false)
+                    return false;
+
+                const uint8_t byteOrder = ReadU8(header);
+                if (byteOrder != ReadU8(header + 1) || (byteOrder != 'I' && byteOrder != 'M'))
+                    return false;
+
+                fLittleEndian = byteOrder == 'I';
+                const uint16_t version = ReadU16(header + 2, fLittleEndian);
+                if (version == ClassicVersion)
+                {
+                    fFirstIFD = ReadU32(header + 4, fLittleEndian);
+                    return true;
+                }
+
+                // BigTIFF: offset size, always 8, a reserved word and a 64 bit offset of the first directory.
+                if (version != BigTiffVersion || fReader.Read(fBase + 8, 8, header + 8) == false || ReadU16(header + 4, fLittleEndian) != 8)
+                    return false;
+
+                fBigTiff = true;
+                fFirstIFD = ReadU64(header + 8, fLittleEndian);
+                return true;
+            }
+
+            uint64_t GetBase() const { return fBase; }
+            uint64_t GetFirstIFD() const { return fFirstIFD; }
+
+            bool ReadIFD(uint64_t ifdOffset, ListEntries& entries, uint64_t& nextIFD)
+            {
+                entries.clear();
+                nextIFD = 0;
+                uint64_t declaredCount;
+                if (ReadEntryCount(ifdOffset, declaredCount) == false)
+                    return false;
+
+                const uint64_t count = std::min<uint64_t>(declaredCount, MaxEntries);
+                const size_t entrySize = GetEntrySize();
+                std::vector<std::byte> data(count * entrySize + GetOffsetSize());
+                if (fReader.Read(fBase + ifdOffset + GetCountSize(), data.size(), data.data()) == false)
+                    return false;
+
+                entries.resize(count);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const std::byte* entryData = data.data() + i * entrySize;
+                    Entry& entry = entries[i];
+                    entry.tag = ReadU16(entryData, fLittleEndian);
+                    entry.type = ReadU16(entryData + 2, fLittleEndian);
+                    entry.count = fBigTiff ? ReadU64(entryData + 4, fLittleEndian) : ReadU32(entryData + 4, fLittleEndian);
+                    std::memset(entry.value, 0, sizeof(entry.value));
+                    std::memcpy(entry.value, entryData + (fBigTiff ? 12 : 8), GetOffsetSize());
+                }
+
+                // The next directory offset follows all the declared entries.
+                nextIFD = count == declaredCount ? ReadOffset(data.data() + count * entrySize) : 0;
+                return true;
+            }
+
+            // Next directory offset without reading the entries, used for counting pages.
+            bool SkipIFD(uint64_t ifdOffset, uint64_t& nextIFD)
+            {
+                nextIFD = 0;
+                uint64_t count;
+                if (ReadEntryCount(ifdOffset, count) == false || count > MaxSkippedEntries)
+                    return false;
+
+                std::byte nextBytes[8];
+                if (fReader.Read(fBase + ifdOffset + GetCountSize() + count * GetEntrySize(), GetOffsetSize(), nextBytes) == false)
+                    return false;
+
+                nextIFD = ReadOffset(nextBytes);
+                return true;
+            }
+
+            // First value of a BYTE, SHORT, LONG or LONG8 entry.
+            uint64_t GetUInt(const Entry& entry)
+            {
+                const size_t typeSize = TypeSize(entry.type);
+                std::byte value[8];
+                if (entry.count * typeSize <= GetOffsetSize())
+                    std::memcpy(value, entry.value, sizeof(value));
+                else if (fReader.Read(fBase + ReadOffset(entry.value), typeSize, value) == false)
+                    return 0;
+
+                switch (entry.type)
+                {
+                case Byte:
+                    return ReadU8(value);
+                case Short:
+                    return ReadU16(value, fLittleEndian);
+                case Long:
+                case IFD:
+                    return ReadU32(value, fLittleEndian);
+                case Long8:
+                case IFD8:
+                    return ReadU64(value, fLittleEndian);
+                default:
+                    return 0;
+                }
+            }
+
+            std::string GetString(const Entry& entry)
+            {
+                if (entry.type != Ascii || entry.count == 0 || entry.count > MaxStringLength)
+                    return {};
+
+                std::vector<std::byte> data(entry.count);
+                if (entry.count <= GetOffsetSize())
+                    std::memcpy(data.data(), entry.value, entry.count);
+                else if (fReader.Read(fBase + ReadOffset(entry.value), entry.count, data.data()) == false)
+                    return {};
+
+                std::string result(reinterpret_cast<const char*>(data.data()), data.size());
+                result.erase(std::find(result.begin(), result.end(), '\0'), result.end());
+                return result;
+            }
+
+        private:
+            static constexpr uint16_t ClassicVersion = 42;
+            static constexpr uint16_t BigTiffVersion = 43;
+            static constexpr uint16_t MaxEntries = 512;
+            static constexpr uint64_t MaxSkippedEntries = 0xFFFF;
+            static constexpr uint32_t MaxStringLength = 256;
+
+            static size_t TypeSize(uint16_t type)
+            {
+                switch (type)
+                {
+                case Short:
+                    return 2;
+                case Long:
+                case IFD:
+                    return 4;
+                case Long8:
+                case IFD8:
+                    return 8;
+                default:
+                    return 1;
+                }
+            }
+
+            size_t GetCountSize() const { return fBigTiff ? 8 : 2; }
+            size_t GetEntrySize() const { return fBigTiff ? 20 : 12; }
+            size_t GetOffsetSize() const { return fBigTiff ? 8 : 4; }
+            uint64_t ReadOffset(const std::byte* data) const { return fBigTiff ? ReadU64(data, fLittleEndian) : ReadU32(data, fLittleEndian); }
+
+            bool ReadEntryCount(uint64_t ifdOffset, uint64_t& count)
+            {
+                std::byte countBytes[8];
+                if (ifdOffset == 0 || fReader.Read(fBase + ifdOffset, GetCountSize(), countBytes) == false)
+                    return false;
+
+                count = fBigTiff ? ReadU64(countBytes, fLittleEndian) : ReadU16(countBytes, fLittleEndian);
+                return true;
+            }
+
+            ProbeReader& fReader;
+            uint64_t fBase;
+            uint64_t fFirstIFD = 0;
+            bool fLittleEndian = true;
+            bool fBigTiff = false;
+        };
+
+        OIV_TexelFormat GetTexelFormat(uint32_t channels, uint32_t bitsPerChannel)
+        {
+            switch (channels * 100 + bitsPerChannel)
+            {
+            case 101:
+                return TF_I_X1;
+            case 104:
+                return TF_I_X4;
+            case 108:
+                return TF_I_X8;
+            case 116:
+                return TF_I_X16;
+            case 308:
+                return TF_I_R8_G8_B8;
+            case 316:
+                return TF_I_R16_G16_B16;
+            case 408:
+                return TF_I_R8_G8_B8_A8;
+            case 416:
+                return TF_I_R16_G16_B16_A16;
+            default:
+                return TF_UNKNOWN;
+            }
+        }
+
+        // Reads the directories of a TIFF file or of an EXIF segment.
+        void ProbeTiffDirectories(TiffReader& tiff, ImageHeaderInfo& info, bool isTiffFile)
+        {
+            TiffReader::ListEntries entries;
+            uint64_t nextIFD = 0;
+            if (tiff.ReadIFD(tiff.GetFirstIFD(), entries, nextIFD) == false)
+                return;
+
+            uint64_t exifIFD = 0;
+            uint32_t bitsPerSample = 1;
+            uint32_t samplesPerPixel = 1;
+            for (const auto& entry : entries)
+            {
+                switch (entry.tag)
+                {
+                case TiffReader::ImageWidth:
+                    if (isTiffFile)
+                        info.width = static_cast<uint32_t>(tiff.GetUInt(entry));
+                    break;
+                case TiffReader::ImageLength:
+                    if (isTiffFile)
+                        info.height = static_cast<uint32_t>(tiff.GetUInt(entry));
+                    break;
+                case TiffReader::BitsPerSample:
+                    bitsPerSample = static_cast<uint32_t>(tiff.GetUInt(entry));
+                    break;
+                case TiffReader::SamplesPerPixel:
+                    samplesPerPixel = static_cast<uint32_t>(tiff.GetUInt(entry));
+                    break;
+                case TiffReader::Orientation:
+                    info.exifOrientation = static_cast<uint16_t>(tiff.GetUInt(entry));
+                    break;
+                case TiffReader::DateTime:
+                    if (info.exifDateTime.empty())
+                        info.exifDateTime = tiff.GetString(entry);
+                    break;
+                case TiffReader::ExifIFD:
+                    exifIFD = tiff.GetUInt(entry);
+                    break;
+                }
+            }
+
+            TiffReader::ListEntries exifEntries;
+            uint64_t unused;
+            if (exifIFD != 0 && tiff.ReadIFD(exifIFD, exifEntries, unused))
+            {
+                for (const auto& entry : exifEntries)
+                {
+                    if (entry.tag == TiffReader::DateTimeOriginal)
+                    {
+                        std::string dateTimeOriginal = tiff.GetString(entry);
+                        if (dateTimeOriginal.empty() == false)
+                            info.exifDateTime = std::move(dateTimeOriginal);
+                    }
+                }
+            }
+
+            if (isTiffFile)
+            {
+                info.bitsPerPixel = bitsPerSample * samplesPerPixel;
+                info.texelFormat = GetTexelFormat(samplesPerPixel, bitsPerSample);
+
+                // Each page is a directory, follow the chain within the read budget.
+                constexpr uint32_t MaxPages = 4096;
+                info.numSubImages = 1;
+                uint64_t pageIFD = nextIFD;
+                while (pageIFD != 0)
+                {
+                    // The chain was cut short by the read budget or is broken, the page count is unknown.
+                    if (info.numSubImages == MaxPages || tiff.SkipIFD(pageIFD, pageIFD) == false)
+                    {
+                        info.numSubImages = 0;
+                        break;
+                    }
+                    info.numSubImages++;
+                }
+            }
+            else
+            {
+                // IFD1 of an EXIF segment describes the thumbnail.
+                uint64_t thumbnailOffset = 0;
+                uint32_t thumbnailLength = 0;
+                if (tiff.ReadIFD(nextIFD, entries, unused))
+                {
+                    for (const auto& entry : entries)
+                    {
+                        if (entry.tag == TiffReader::JPEGInterchangeFormat)
+                            thumbnailOffset = tiff.GetUInt(entry);
+                        else if (entry.tag == TiffReader::JPEGInterchangeFormatLength)
+                            thumbnailLength = static_cast<uint32_t>(tiff.GetUInt(entry));
+                    }
+                }
+
+                if (thumbnailOffset != 0 && thumbnailLength != 0)
+                {
+                    info.exifThumbnailOffset = tiff.GetBase() + thumbnailOffset;
+                    info.exifThumbnailLength = thumbnailLength;
+                }
+            }
+        }
+
+        bool ProbeJpeg(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            // Bounds the fill bytes skipped before a single marker.
+            constexpr uint32_t MaxFillBytes = 4096;
+            bool exifParsed = false;
+            uint64_t offset = 2;
+            std::byte marker[2];
+            while (reader.Read(offset, sizeof(marker), marker) && ReadU8(marker) == 0xFF)
+            {
+                // Any number of 0xFF fill bytes may precede the marker type.
+                uint8_t markerType = ReadU8(marker + 1);
+                offset += sizeof(marker);
+                for (uint32_t fillBytes = 0; markerType == 0xFF; fillBytes++)
+                {
+                    std::byte next;
+                    if (fillBytes == MaxFillBytes || reader.Read(offset, 1, &next) == false)
+                        return false;
+
+                    markerType = ReadU8(&next);
+                    offset++;
+                }
+
+                // Markers without a payload.
+                if (markerType == 0x01 || (markerType >= 0xD0 && markerType <= 0xD8))
+                    continue;
+
+                // Entropy coded data follows SOS, the frame header must have been found by now.
+                if (markerType == 0xDA || markerType == 0xD9)
+                    break;
+
+                std::byte lengthBytes[2];
+                if (reader.Read(offset, sizeof(lengthBytes), lengthBytes) == false)
+                    break;
+
+                const uint16_t length = ReadU16(lengthBytes, false);
+                if (length < 2)
+                    break;
+
+                const uint64_t payload = offset + sizeof(lengthBytes);
+                if (markerType == 0xE1 && exifParsed == false)
+                {
+                    std::byte exifHeader[6];
+                    if (reader.Read(payload, sizeof(exifHeader), exifHeader) && std::memcmp(exifHeader, "Exif\0\0", sizeof(exifHeader)) == 0)
+                    {
+                        TiffReader tiff(reader, payload + sizeof(exifHeader));
+                        if (tiff.Open())
+                            ProbeTiffDirectories(tiff, info, false);
+                        exifParsed = true;
+                    }
+                }
+                else if (markerType >= 0xC0 && markerType <= 0xCF && markerType != 0xC4 && markerType != 0xC8 && markerType != 0xCC)
+                {
+                    // Start of frame.
+                    std::byte frameHeader[6];
+                    if (reader.Read(payload, sizeof(frameHeader), frameHeader) == false)
+                        return false;
+
+                    const uint8_t precision = ReadU8(frameHeader);
+                    const uint8_t components = ReadU8(frameHeader + 5);
+                    info.height = ReadU16(frameHeader + 1, false);
+                    info.width = ReadU16(frameHeader + 3, false);
+                    info.bitsPerPixel = precision * components;
+                    info.texelFormat = GetTexelFormat(components, precision);
+                    info.numSubImages = 1;
+                    return true;
+                }
+
+                offset += length;
+            }
+            return false;
+        }
+
+        bool ProbePng(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[33];
+            if (reader.Read(0, sizeof(header), header) == false || std::memcmp(header + 12, "IHDR", 4) != 0)
+                return false;
+
+            info.width = ReadU32(header + 16, false);
+            info.height = ReadU32(header + 20, false);
+            const uint8_t bitDepth = ReadU8(header + 24);
+            const uint8_t colorType = ReadU8(header + 25);
+            static const std::map<uint8_t, uint32_t> channelsByColorType = { {0, 1}, {2, 3}, {3, 1}, {4, 2}, {6, 4} };
+            auto it = channelsByColorType.find(colorType);
+            const uint32_t channels = it != channelsByColorType.end() ? it->second : 0;
+            info.bitsPerPixel = bitDepth * channels;
+            info.texelFormat = colorType == 3 ? TF_UNKNOWN : GetTexelFormat(channels, bitDepth);
+            info.numSubImages = 1;
+
+            // An animation control chunk, if any, precedes the image data.
+            uint64_t offset = 8;
+            std::byte chunkHeader[12];
+            while (reader.Read(offset, sizeof(chunkHeader), chunkHeader) && std::memcmp(chunkHeader + 4, "IDAT", 4) != 0)
+            {
+                if (std::memcmp(chunkHeader + 4, "acTL", 4) == 0)
+                {
+                    info.numSubImages = ReadU32(chunkHeader + 8, false);
+                    break;
+                }
+                // length + type + data + crc
+                offset += 12ull + ReadU32(chunkHeader, false);
+            }
+            return true;
+        }
+
+        bool ProbeGif(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[10];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            info.width = ReadU16(header + 6, true);
+            info.height = ReadU16(header + 8, true);
+            info.bitsPerPixel = 8;
+            // Counting frames requires walking all the image data.
+            info.numSubImages = 0;
+            return true;
+        }
+
+        bool ProbeBmp(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[30];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            const uint32_t dibHeaderSize = ReadU32(header + 14, true);
+            if (dibHeaderSize == 12)
+            {
+                info.width = ReadU16(header + 18, true);
+                info.height = ReadU16(header + 20, true);
+                info.bitsPerPixel = ReadU16(header + 24, true);
+            }
+            else
+            {
+                info.width = static_cast<uint32_t>(std::abs(static_cast<int32_t>(ReadU32(header + 18, true))));
+                // Negative height for top down bitmaps.
+                info.height = static_cast<uint32_t>(std::abs(static_cast<int32_t>(ReadU32(header + 22, true))));
+                info.bitsPerPixel = ReadU16(header + 28, true);
+            }
+
+            info.texelFormat = info.bitsPerPixel == 24 ? TF_I_B8_G8_R8 : info.bitsPerPixel == 32 ? TF_I_B8_G8_R8_A8 : TF_UNKNOWN;
+            info.numSubImages = 1;
+            return true;
+        }
+
+        bool ProbeTiff(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            TiffReader tiff(reader, 0);
+            if (tiff.Open() == false)
+                return false;
+
+            ProbeTiffDirectories(tiff, info, true);
+            return info.width != 0 && info.height != 0;
+        }
+
+        bool ProbeWebP(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[30];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            bool hasAlpha = false;
+            info.numSubImages = 1;
+            if (std::memcmp(header + 12, "VP8 ", 4) == 0)
+            {
+                info.width = ReadU16(header + 26, true) & 0x3FFF;
+                info.height = ReadU16(header + 28, true) & 0x3FFF;
+            }
+            else if (std::memcmp(header + 12, "VP8L", 4) == 0)
+            {
+                const uint32_t bits = ReadU32(header + 21, true);
+                info.width = (bits & 0x3FFF) + 1;
+                info.height = ((bits >> 14) & 0x3FFF) + 1;
+                hasAlpha = ((bits >> 28) & 1) != 0;
+            }
+            else if (std::memcmp(header + 12, "VP8X", 4) == 0)
+            {
+                const uint8_t flags = ReadU8(header + 20);
+                hasAlpha = (flags & 0x10) != 0;
+                if ((flags & 0x02) != 0)
+                    info.numSubImages = 0; // Animated, frames are not counted.
+                info.width = ReadU24LE(header + 24) + 1;
+                info.height = ReadU24LE(header + 27) + 1;
+            }
+            else
+            {
+                return false;
+            }
+
+            info.bitsPerPixel = hasAlpha ? 32 : 24;
+            info.texelFormat = hasAlpha ? TF_I_R8_G8_B8_A8 : TF_I_R8_G8_B8;
+            return true;
+        }
+
+        bool ProbePsd(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[24];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            const uint16_t channels = ReadU16(header + 12, false);
+            const uint16_t depth = ReadU16(header + 22, false);
+            info.height = ReadU32(header + 14, false);
+            info.width = ReadU32(header + 18, false);
+            info.bitsPerPixel = channels * depth;
+            info.texelFormat = GetTexelFormat(channels, depth);
+            info.numSubImages = 1;
+            return true;
+        }
+
+        bool ProbeDds(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[20];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            info.height = ReadU32(header + 12, true);
+            info.width = ReadU32(header + 16, true);
+            info.numSubImages = 1;
+            return true;
+        }
+
+        bool ProbeQoi(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[13];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            const uint8_t channels = ReadU8(header + 12);
+            info.width = ReadU32(header + 4, false);
+            info.height = ReadU32(header + 8, false);
+            info.bitsPerPixel = channels * 8;
+            info.texelFormat = GetTexelFormat(channels, 8);
+            info.numSubImages = 1;
+            return true;
+        }
+
+        bool ProbeIco(ProbeReader& reader, ImageHeaderInfo& info)
+        {
+            std::byte header[14];
+            if (reader.Read(0, sizeof(header), header) == false)
+                return false;
+
+            // Properties of the first icon in the directory, 0 stands for 256 pixels.
+            info.numSubImages = ReadU16(header + 4, true);
+            info.width = ReadU8(header + 6) == 0 ? 256 : ReadU8(header + 6);
+            info.height = ReadU8(header + 7) == 0 ? 256 : ReadU8(header + 7);
+            info.bitsPerPixel = ReadU16(header + 12, true);
+            return info.numSubImages > 0;
+        }
+
+        using ProbeFunction = bool(*)(ProbeReader&, ImageHeaderInfo&);
+        const std::map<std::wstring, ProbeFunction> sProbeFunctions =
+        {
+              { L"jpg", &ProbeJpeg }
+            , { L"png", &ProbePng }
+            , { L"gif", &ProbeGif }
+            , { L"bmp", &ProbeBmp }
+            , { L"tif", &ProbeTiff }
+            , { L"webp", &ProbeWebP }
+            , { L"psd", &ProbePsd }
+            , { L"dds", &ProbeDds }
+            , { L"qoi", &ProbeQoi }
+            , { L"ico", &ProbeIco }
+        };
+    }
+
+    ResultCode ImageHeaderProbe::Probe(const std::filesystem::path& filePath, ImageHeaderInfo& info)
+    {
+        info = {};
+        std::ifstream file(filePath, std::ios::binary);
+        if (file.is_open() == false)
+            return RC_FileNotFound;
+
+        ProbeReader reader(file);
+        const SignatureRegistry::MatchResult match = SignatureRegistry::GetBuiltIn().Match(reader.Head(), reader.HeadSize());
+        if (match.IsUnique() == false)
+            return RC_FileNotSupported;
+
+        info.format = match.formats.front();
+        auto it = sProbeFunctions.find(info.format);
+        if (it == sProbeFunctions.end())
+            return RC_UnsupportedFormat;
+
+        // The format is known but its header couldn't be read within the read budget, or is a variant the probe doesn't parse.
+        // This says nothing about whether a decoder can read the file.
+        return it->second(reader, info) ? RC_Success : RC_UnsupportedFormat;
+    }
+}
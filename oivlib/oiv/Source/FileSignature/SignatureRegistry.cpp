@@ -0,0 +1,163 @@
+#include <FileSignature/SignatureRegistry.h>
+#include <fstream>
+#include <algorithm>
+#include <LLUtils/StringUtility.h>
+
+namespace OIV
+{
+    namespace
+    {
+        SignatureRegistry::ListSignatureBytes FromString(const char* prefix, size_t anyBytesBefore = 0)
+        {
+            SignatureRegistry::ListSignatureBytes signature(anyBytesBefore, SignatureRegistry::AnyByte);
+            for (const char* c = prefix; *c != '\0'; c++)
+                signature.push_back(static_cast<uint8_t>(*c));
+            return signature;
+        }
+
+        SignatureRegistry CreateBuiltIn()
+        {
+            constexpr SignatureRegistry::SignatureByte X = SignatureRegistry::AnyByte;
+            SignatureRegistry registry;
+            registry.Register(L"png", {}, { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A });
+            registry.Register(L"jpg", { L"jpeg", L"jpe", L"jfif" }, { 0xFF, 0xD8, 0xFF });
+            registry.Register(L"gif", {}, FromString("GIF87a"));
+            registry.Register(L"gif", {}, FromString("GIF89a"));
+            registry.Register(L"bmp", { L"dib" }, FromString("BM"));
+            registry.Register(L"tif", { L"tiff" }, { 'I', 'I', 0x2A, 0x00 });
+            registry.Register(L"tif", { L"tiff" }, { 'M', 'M', 0x00, 0x2A });
+            registry.Register(L"tif", { L"tiff" }, { 'I', 'I', 0x2B, 0x00 });
+            registry.Register(L"tif", { L"tiff" }, { 'M', 'M', 0x00, 0x2B });
+            registry.Register(L"webp", {}, { 'R', 'I', 'F', 'F', X, X, X, X, 'W', 'E', 'B', 'P' });
+            registry.Register(L"psd", {}, FromString("8BPS"));
+            registry.Register(L"ico", {}, { 0x00, 0x00, 0x01, 0x00 });
+            registry.Register(L"dds", {}, FromString("DDS "));
+            registry.Register(L"exr", {}, { 0x76, 0x2F, 0x31, 0x01 });
+            registry.Register(L"hdr", {}, FromString("#?RADIANCE"));
+            registry.Register(L"hdr", {}, FromString("#?RGBE"));
+            registry.Register(L"qoi", {}, FromString("qoif"));
+            registry.Register(L"jxl", {}, { 0xFF, 0x0A });
+            registry.Register(L"jxl", {}, { 0x00, 0x00, 0x00, 0x0C, 'J', 'X', 'L', ' ', 0x0D, 0x0A, 0x87, 0x0A });
+            registry.Register(L"jp2", { L"j2k", L"jpf" }, { 0x00, 0x00, 0x00, 0x0C, 'j', 'P', ' ', ' ', 0x0D, 0x0A, 0x87, 0x0A });
+            registry.Register(L"avif", {}, FromString("ftypavif", 4));
+            registry.Register(L"avif", {}, FromString("ftypavis", 4));
+            registry.Register(L"heic", { L"heif" }, FromString("ftypheic", 4));
+            registry.Register(L"heic", { L"heif" }, FromString("ftypheix", 4));
+            // Generic HEIF brands, used by both AVIF and HEIC files.
+            registry.Register(L"heic", { L"heif" }, FromString("ftypmif1", 4));
+            registry.Register(L"avif", {}, FromString("ftypmif1", 4));
+            return registry;
+        }
+    }
+
+    const SignatureRegistry& SignatureRegistry::GetBuiltIn()
+    {
+        static const SignatureRegistry builtIn = CreateBuiltIn();
+        return builtIn;
+    }
+
+    SignatureRegistry::NodeIndex SignatureRegistry::GetOrCreateChild(NodeIndex parent, SignatureByte value)
+    {
+        NodeIndex child = value == AnyByte ? fNodes.at(parent).anyChild : NoNode;
+        if (value != AnyByte)
+        {
+            auto it = fNodes.at(parent).children.find(static_cast<uint8_t>(value));
+            if (it != fNodes.at(parent).children.end())
+                child = it->second;
+        }
+
+        if (child == NoNode)
+        {
+            child = static_cast<NodeIndex>(fNodes.size());
+            // Take the parent by index, emplace_back may reallocate.
+            fNodes.emplace_back();
+            if (value == AnyByte)
+                fNodes.at(parent).anyChild = child;
+            else
+                fNodes.at(parent).children.emplace(static_cast<uint8_t>(value), child);
+        }
+        return child;
+    }
+
+    void SignatureRegistry::Register(const std::wstring& format, const ListFormats& extensions, const ListSignatureBytes& signature)
+    {
+        if (signature.empty())
+            return;
+
+        auto itFormat = std::find(fFormats.begin(), fFormats.end(), format);
+        const uint16_t formatIndex = static_cast<uint16_t>(std::distance(fFormats.begin(), itFormat));
+        if (itFormat == fFormats.end())
+            fFormats.push_back(format);
+
+        fExtensionToFormat[format] = formatIndex;
+        for (const auto& extension : extensions)
+            fExtensionToFormat[extension] = formatIndex;
+
+        NodeIndex current = 0;
+        for (SignatureByte value : signature)
+            current = GetOrCreateChild(current, value);
+
+        auto& formats = fNodes.at(current).formats;
+        if (std::find(formats.begin(), formats.end(), formatIndex) == formats.end())
+            formats.push_back(formatIndex);
+
+        fMaxSignatureLength = std::max(fMaxSignatureLength, signature.size());
+    }
+
+    SignatureRegistry::MatchResult SignatureRegistry::Match(const std::byte* header, size_t size) const
+    {
+        // Walk the trie breadth first, wildcard bytes may keep more than one node alive at the same depth.
+        std::vector<NodeIndex> frontier{ 0 };
+        std::vector<NodeIndex> next;
+        std::vector<uint16_t> matched;
+
+        for (size_t i = 0; i < size && frontier.empty() == false; i++)
+        {
+            next.clear();
+            const uint8_t value = static_cast<uint8_t>(header[i]);
+            for (NodeIndex nodeIndex : frontier)
+            {
+                const Node& node = fNodes[nodeIndex];
+                auto it = node.children.find(value);
+                if (it != node.children.end())
+                    next.push_back(it->second);
+                if (node.anyChild != NoNode)
+                    next.push_back(node.anyChild);
+            }
+
+            std::vector<uint16_t> matchedAtDepth;
+            for (NodeIndex nodeIndex : next)
+                for (uint16_t formatIndex : fNodes[nodeIndex].formats)
+                    if (std::find(matchedAtDepth.begin(), matchedAtDepth.end(), formatIndex) == matchedAtDepth.end())
+                        matchedAtDepth.push_back(formatIndex);
+
+            // A longer signature is more specific.
+            if (matchedAtDepth.empty() == false)
+                matched = std::move(matchedAtDepth);
+
+            frontier.swap(next);
+        }
+
+        MatchResult result;
+        for (uint16_t formatIndex : matched)
+            result.formats.push_back(fFormats[formatIndex]);
+        return result;
+    }
+
+    SignatureRegistry::MatchResult SignatureRegistry::MatchFile(const std::filesystem::path& filePath) const
+    {
+        std::vector<std::byte> header(fMaxSignatureLength);
+        std::ifstream file(filePath, std::ios::binary);
+        if (file.is_open() == false)
+            return {};
+
+        file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        return Match(header.data(), static_cast<size_t>(file.gcount()));
+    }
+
+    std::wstring SignatureRegistry::GetFormatByExtension(const std::wstring& extension) const
+    {
+        auto it = fExtensionToFormat.find(LLUtils::StringUtility::ToLower(extension));
+        return it != fExtensionToFormat.end() ? fFormats.at(it->second) : std::wstring();
+    }
+}
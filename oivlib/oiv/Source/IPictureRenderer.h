@@ -2,6 +2,7 @@
 #include <defs.h>
 #include <Image.h>
 #include <Interfaces/IRenderer.h>
+#include "Resampler.h"
 
 
 namespace OIV
@@ -10,10 +11,16 @@ namespace OIV
     {
     public:
         virtual IRenderer* GetRenderer() = 0;
-        virtual IMCodec::ImageSharedPtr Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize) = 0;
+        // Returns nullptr if resampling has been cancelled through 'cancelled'.
+        virtual IMCodec::ImageSharedPtr Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize
+            , ResampleFilter filter = ResampleFilter::Box, const std::atomic_bool* cancelled = nullptr) = 0;
+        // Resamples 'sourceImage' as seen through 'transform' into an R8G8B8A8 image in a single pass.
+        // Returns nullptr if cancelled or if the texel format of the source can't be read directly, see Resampler::GetResamplerSource.
+        virtual IMCodec::ImageSharedPtr ResampleTransformed(IMCodec::ImageSharedPtr sourceImage, const IMUtil::AxisAlignedTransform& transform
+            , LLUtils::PointI32 targetSize, ResampleFilter filter = ResampleFilter::Box, const std::atomic_bool* cancelled = nullptr) = 0;
     
         virtual ResultCode LoadFile(void* buffer, std::size_t size, char* extension, OIV_CMD_LoadFile_Flags flags, ImageHandle& handle) = 0;
-        virtual ResultCode LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, int16_t& handle) = 0;
+        virtual ResultCode LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, ImageHandle& handle) = 0;
         virtual ResultCode UnloadFile(const ImageHandle handle) = 0;
         //virtual ResultCode DisplayFile(const OIV_CMD_DisplayImage_Request& display_request) = 0;
         virtual ResultCode CreateText(const OIV_CMD_CreateText_Request&, OIV_CMD_CreateText_Response&) = 0;
@@ -22,6 +29,7 @@ namespace OIV
 
         virtual int Init() = 0;
         virtual int SetParent(std::size_t handle) = 0;
+        virtual int SetImageSpilling(const OIVCHAR* spillFolder, uint64_t budgetBytes) = 0;
         virtual int Refresh() = 0;
 
         virtual ResultCode GetFileInformation(ImageHandle handle, OIV_CMD_QueryImageInfo_Response& information) = 0;
@@ -42,6 +50,9 @@ namespace OIV
 
         virtual ResultCode RegisterCallbacks(const OIV_CMD_RegisterCallbacks_Request& callbacks) = 0;
         virtual ResultCode ResampleImage(const OIV_CMD_Resample_Request&, ImageHandle&) = 0;
+        virtual ResultCode ProbeFile(const OIV_CMD_ProbeFile_Request&, OIV_CMD_ProbeFile_Response&) = 0;
+        virtual ResultCode ReadTexels(const OIV_CMD_ReadTexels_Request&, OIV_CMD_ReadTexels_Response&) = 0;
+        virtual ResultCode SetImageMemoryBudget(const OIV_CMD_SetImageMemoryBudget_Request&, OIV_CMD_SetImageMemoryBudget_Response&) = 0;
         virtual ResultCode SetBackgroundColor(int index, LLUtils::Color backgroundColor) = 0;
     };
 }
@@ -0,0 +1,327 @@
+#include <ImageCache/DecodedImageCache.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <LLUtils/StopWatch.h>
+#include <Memory/ImageItemPool.h>
+
+namespace OIV
+{
+    namespace
+    {
+#pragma pack(push,1)
+        struct CacheFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t sourceFileSize;
+            int64_t sourceLastWriteTime;
+            uint32_t width;
+            uint32_t height;
+            uint32_t rowPitchInBytes;
+            uint16_t texelFormatStorage;
+            uint16_t texelFormatDecompressed;
+            uint64_t dataOffset;
+            uint64_t dataSize;
+            uint32_t pathSize; // UTF-8 source path follows the header
+        };
+#pragma pack(pop)
+
+        constexpr char CacheFileMagic[4] = { 'O', 'I', 'V', 'C' };
+        constexpr uint32_t CacheFileVersion = 1;
+        constexpr wchar_t CacheFileExtension[] = L".oivc";
+    }
+
+    DecodedImageCache::DecodedImageCache(const std::filesystem::path& cacheFolder, uint64_t budgetBytes, double minDecodeTimems)
+        : fCacheFolder(cacheFolder)
+        , fBudget(budgetBytes)
+        , fMinDecodeTime(minDecodeTimems)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(fCacheFolder, ec);
+        LoadIndex();
+        fWriterThread = std::thread(&DecodedImageCache::WriterEntryPoint, this);
+    }
+
+    DecodedImageCache::~DecodedImageCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStopWriter = true;
+        }
+        fWriterCondition.notify_one();
+        if (fWriterThread.joinable())
+            fWriterThread.join();
+    }
+
+    void DecodedImageCache::SetBudget(uint64_t budgetBytes)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fBudget = budgetBytes;
+        Evict();
+    }
+
+    void DecodedImageCache::SetMinDecodeTime(double minDecodeTimems)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fMinDecodeTime = minDecodeTimems;
+    }
+
+    uint64_t DecodedImageCache::GetSize() const
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        return fSize;
+    }
+
+    DecodedImageCache::Key DecodedImageCache::GetKey(const std::wstring& filePath, const FileStamp& stamp)
+    {
+        std::wstringstream ss;
+        ss << std::filesystem::path(filePath).lexically_normal().wstring() << L'|' << stamp.fileSize << L'|' << stamp.lastWriteTime;
+        return static_cast<Key>(std::hash<std::wstring>()(ss.str()));
+    }
+
+    std::filesystem::path DecodedImageCache::GetCacheFilePath(Key key) const
+    {
+        std::wstringstream ss;
+        ss << std::hex << std::setw(16) << std::setfill(L'0') << key << CacheFileExtension;
+        return fCacheFolder / ss.str();
+    }
+
+    void DecodedImageCache::LoadIndex()
+    {
+        using namespace std::filesystem;
+        struct CacheFile
+        {
+            Key key;
+            uint64_t size;
+            file_time_type lastUsed;
+        };
+
+        std::vector<CacheFile> cacheFiles;
+        std::error_code ec;
+        for (directory_iterator it(fCacheFolder, ec), end; ec.value() == 0 && it != end; it.increment(ec))
+        {
+            const path& filePath = it->path();
+            if (filePath.extension() != CacheFileExtension)
+                continue;
+
+            std::error_code entryError;
+            const uint64_t size = it->file_size(entryError);
+            const file_time_type lastUsed = it->last_write_time(entryError);
+            if (entryError.value() != 0)
+                continue;
+
+            std::wstringstream ss(filePath.stem().wstring());
+            Key key = 0;
+            if (ss >> std::hex >> key)
+                cacheFiles.push_back({ key, size, lastUsed });
+        }
+
+        // Entries are touched on use, the most recently written is the most recently used.
+        std::sort(cacheFiles.begin(), cacheFiles.end(), [](const CacheFile& a, const CacheFile& b) { return a.lastUsed > b.lastUsed; });
+
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (const CacheFile& cacheFile : cacheFiles)
+        {
+            fLRU.push_back(cacheFile.key);
+            fEntries.emplace(cacheFile.key, Entry{ cacheFile.size, std::prev(fLRU.end()) });
+            fSize += cacheFile.size;
+        }
+        Evict();
+    }
+
+    IMCodec::ImageSharedPtr DecodedImageCache::Find(const std::wstring& filePath)
+    {
+        using namespace IMCodec;
+        FileStamp stamp;
+        if (FileStamp::Get(filePath, stamp) == false)
+            return nullptr;
+
+        const Key key = GetKey(filePath, stamp);
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            if (fEntries.find(key) == fEntries.end())
+                return nullptr;
+        }
+
+        LLUtils::StopWatch stopWatch(true);
+        std::ifstream file(GetCacheFilePath(key), std::ios::binary);
+        CacheFileHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)).good() == false
+            || std::memcmp(header.magic, CacheFileMagic, sizeof(CacheFileMagic)) != 0
+            || header.version != CacheFileVersion
+            || header.sourceFileSize != stamp.fileSize
+            || header.sourceLastWriteTime != stamp.lastWriteTime
+            || header.dataSize != static_cast<uint64_t>(header.rowPitchInBytes) * header.height)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            Remove(key);
+            return nullptr;
+        }
+
+        // Guard against hash collisions.
+        std::u8string sourcePath(header.pathSize, u8'\0');
+        file.read(reinterpret_cast<char*>(sourcePath.data()), header.pathSize);
+        if (file.good() == false || sourcePath != std::filesystem::path(filePath).lexically_normal().u8string())
+            return nullptr;
+
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(header.dataSize);
+        imageItem->itemType = ImageItemType::Image;
+        ImageDescriptor& props = imageItem->descriptor;
+        props.width = header.width;
+        props.height = header.height;
+        props.rowPitchInBytes = header.rowPitchInBytes;
+        props.texelFormatStorage = static_cast<TexelFormat>(header.texelFormatStorage);
+        props.texelFormatDecompressed = static_cast<TexelFormat>(header.texelFormatDecompressed);
+
+        ImageSharedPtr image = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+
+        // Pixel data is read straight into the image buffer.
+        file.seekg(static_cast<std::streamoff>(header.dataOffset));
+        file.read(reinterpret_cast<char*>(const_cast<std::byte*>(image->GetBuffer())), static_cast<std::streamsize>(header.dataSize));
+        if (file.good() == false)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            Remove(key);
+            return nullptr;
+        }
+
+        imageItem->processData.processTime = stopWatch.GetElapsedTimeReal(LLUtils::StopWatch::TimeUnit::Milliseconds);
+
+        std::lock_guard<std::mutex> lock(fMutex);
+        Touch(key);
+        return image;
+    }
+
+    void DecodedImageCache::Add(const std::wstring& filePath, IMCodec::ImageSharedPtr image)
+    {
+        if (image == nullptr || image->GetNumSubImages() > 0)
+            return;
+
+        FileStamp stamp;
+        if (FileStamp::Get(filePath, stamp) == false)
+            return;
+
+        const Key key = GetKey(filePath, stamp);
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            const uint64_t imageSize = static_cast<uint64_t>(image->GetRowPitchInBytes()) * image->GetHeight();
+            if (image->GetProcessData().processTime < fMinDecodeTime
+                || imageSize > fBudget
+                || fEntries.find(key) != fEntries.end()
+                || fPendingWrites.size() >= MaxPendingWrites)
+                return;
+
+            fPendingWrites.push_back({ key, filePath, stamp, image });
+        }
+        fWriterCondition.notify_one();
+    }
+
+    bool DecodedImageCache::Write(const PendingWrite& pendingWrite)
+    {
+        const IMCodec::ImageSharedPtr& image = pendingWrite.image;
+        const std::u8string sourcePath = std::filesystem::path(pendingWrite.filePath).lexically_normal().u8string();
+
+        CacheFileHeader header{};
+        std::memcpy(header.magic, CacheFileMagic, sizeof(CacheFileMagic));
+        header.version = CacheFileVersion;
+        header.sourceFileSize = pendingWrite.stamp.fileSize;
+        header.sourceLastWriteTime = pendingWrite.stamp.lastWriteTime;
+        header.width = image->GetWidth();
+        header.height = image->GetHeight();
+        header.rowPitchInBytes = image->GetRowPitchInBytes();
+        header.texelFormatStorage = static_cast<uint16_t>(image->GetOriginalTexelFormat());
+        header.texelFormatDecompressed = static_cast<uint16_t>(image->GetTexelFormat());
+        header.pathSize = static_cast<uint32_t>(sourcePath.size());
+        // Page aligned pixel data, so the file can be mapped and used in place.
+        header.dataOffset = (sizeof(header) + sourcePath.size() + DataAlignment - 1) / DataAlignment * DataAlignment;
+        header.dataSize = static_cast<uint64_t>(header.rowPitchInBytes) * header.height;
+
+        const std::filesystem::path cacheFilePath = GetCacheFilePath(pendingWrite.key);
+        const std::filesystem::path tempPath = std::filesystem::path(cacheFilePath).concat(L".tmp");
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (file.is_open() == false)
+                return false;
+
+            const std::vector<char> padding(header.dataOffset - sizeof(header) - sourcePath.size(), 0);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(sourcePath.data()), static_cast<std::streamsize>(sourcePath.size()));
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            file.write(reinterpret_cast<const char*>(image->GetBuffer()), static_cast<std::streamsize>(header.dataSize));
+            if (file.good() == false)
+            {
+                file.close();
+                std::error_code ec;
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, cacheFilePath, ec);
+        if (ec.value() != 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(fMutex);
+        if (fEntries.find(pendingWrite.key) == fEntries.end())
+        {
+            fLRU.push_front(pendingWrite.key);
+            fEntries.emplace(pendingWrite.key, Entry{ header.dataOffset + header.dataSize, fLRU.begin() });
+            fSize += header.dataOffset + header.dataSize;
+            Evict();
+        }
+        return true;
+    }
+
+    void DecodedImageCache::Touch(Key key)
+    {
+        auto it = fEntries.find(key);
+        if (it == fEntries.end())
+            return;
+
+        fLRU.splice(fLRU.begin(), fLRU, it->second.lruPosition);
+        std::error_code ec;
+        std::filesystem::last_write_time(GetCacheFilePath(key), std::filesystem::file_time_type::clock::now(), ec);
+    }
+
+    void DecodedImageCache::Remove(Key key)
+    {
+        auto it = fEntries.find(key);
+        if (it == fEntries.end())
+            return;
+
+        std::error_code ec;
+        std::filesystem::remove(GetCacheFilePath(key), ec);
+        fSize -= it->second.size;
+        fLRU.erase(it->second.lruPosition);
+        fEntries.erase(it);
+    }
+
+    void DecodedImageCache::Evict()
+    {
+        while (fSize > fBudget && fLRU.empty() == false)
+            Remove(fLRU.back());
+    }
+
+    void DecodedImageCache::WriterEntryPoint()
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        for (;;)
+        {
+            fWriterCondition.wait(lock, [this] { return fStopWriter || fPendingWrites.empty() == false; });
+            // Pending writes are dropped on shutdown, the cache is only an optimization.
+            if (fStopWriter)
+                break;
+
+            PendingWrite pendingWrite = std::move(fPendingWrites.front());
+            fPendingWrites.pop_front();
+            lock.unlock();
+            Write(pendingWrite);
+            lock.lock();
+        }
+    }
+}
@@ -3,120 +3,481 @@
 
 namespace OIV
 {
-    ImageManager::ImageManager()
+    ImageManager::Reference::Reference(ImageManager* manager, Entry* entry, uint32_t index, IMCodec::ImageSharedPtr image)
+        : fManager(manager), fEntry(entry), fIndex(index), fImage(std::move(image))
     {
-        for (int16_t i = MAX_IMAGES + 1; i >= 1; i--)
-            fListFreeHandles.push_back(static_cast<ImageHandle>(i));
+
+    }
+
+    ImageManager::Reference::Reference(Reference&& rhs) noexcept
+        : fManager(rhs.fManager), fEntry(rhs.fEntry), fIndex(rhs.fIndex), fImage(std::move(rhs.fImage))
+    {
+        rhs.fEntry = nullptr;
+    }
+
+    ImageManager::Reference& ImageManager::Reference::operator=(Reference&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            Release();
+            fManager = rhs.fManager;
+            fEntry = rhs.fEntry;
+            fIndex = rhs.fIndex;
+            fImage = std::move(rhs.fImage);
+            rhs.fEntry = nullptr;
+        }
+        return *this;
+    }
+
+    ImageManager::Reference::~Reference()
+    {
+        Release();
+    }
+
+    void ImageManager::Reference::Release()
+    {
+        if (fEntry != nullptr)
+        {
+            std::lock_guard lock(fEntry->mutex);
+            if (--fEntry->references == 0 && fEntry->alive == false)
+                fManager->RecycleEntry(*fEntry, fIndex);
+
+            fEntry = nullptr;
+            fImage.reset();
+        }
     }
 
+    ImageManager::ImageManager() = default;
+    ImageManager::~ImageManager() = default;
+
     std::size_t ImageManager::GetNumLoadedImages() const
     {
-        return MAX_IMAGES - GetNumImagesVacancy();
+        return fNumLoadedImages.load(std::memory_order_relaxed);
     }
 
     std::size_t ImageManager::GetNumImagesVacancy() const
     {
-        return fListFreeHandles.size();
+        return MaxImages - GetNumLoadedImages();
     }
 
-    ImageHandle ImageManager::AllocateImageHandle()
+    ImageHandle ImageManager::MakeHandle(uint32_t index, uint16_t generation)
     {
-        ImageHandle handle = fListFreeHandles.back();
-        fListFreeHandles.pop_back();
-        return handle;
+        return static_cast<ImageHandle>(((generation & GenerationMask) << IndexBits) | (index + 1));
+    }
+
+    bool ImageManager::ParseHandle(ImageHandle handle, uint32_t& index, uint16_t& generation)
+    {
+        if (handle <= ImageHandleNull)
+            return false;
+
+        const uint32_t value = static_cast<uint32_t>(handle);
+        const uint32_t biasedIndex = value & ((1u << IndexBits) - 1);
+        if (biasedIndex == 0)
+            return false;
+
+        index = biasedIndex - 1;
+        generation = static_cast<uint16_t>((value >> IndexBits) & GenerationMask);
+        return true;
     }
 
-    void ImageManager::DeallocateHandle(ImageHandle handle)
+    ImageManager::Entry* ImageManager::GetEntry(uint32_t index) const
     {
-        fListFreeHandles.push_back(handle);
+        const uint32_t slab = index / SlabSize;
+        if (slab >= fNumSlabs.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &(*fSlabs[slab])[index % SlabSize];
+    }
+
+    ImageManager::Entry* ImageManager::Resolve(ImageHandle handle, std::unique_lock<std::mutex>& lock, uint32_t& index) const
+    {
+        uint16_t generation;
+        if (ParseHandle(handle, index, generation) == false)
+            return nullptr;
+
+        Entry* entry = GetEntry(index);
+        if (entry == nullptr)
+            return nullptr;
+
+        lock = std::unique_lock(entry->mutex);
+        if (entry->alive == false || entry->generation != generation)
+        {
+            lock.unlock();
+            return nullptr;
+        }
+
+        return entry;
+    }
+
+    uint32_t ImageManager::AllocateEntry()
+    {
+        std::lock_guard lock(fFreeListMutex);
+        if (fFirstFree == NoEntry)
+        {
+            const uint32_t numSlabs = fNumSlabs.load(std::memory_order_relaxed);
+            if (numSlabs == MaxSlabs)
+                return NoEntry;
+
+            // Link the new slab's entries in order, the lower indices are handed out first.
+            fSlabs[numSlabs] = std::make_unique<Slab>();
+            Slab& slab = *fSlabs[numSlabs];
+            const uint32_t first = numSlabs * SlabSize;
+            for (uint32_t i = 0; i < SlabSize - 1; i++)
+                slab[i].nextFree = first + i + 1;
+
+            fFirstFree = first;
+            fNumSlabs.store(numSlabs + 1, std::memory_order_release);
+        }
+
+        const uint32_t index = fFirstFree;
+        Entry& entry = (*fSlabs[index / SlabSize])[index % SlabSize];
+        fFirstFree = entry.nextFree;
+        entry.nextFree = NoEntry;
+        return index;
+    }
+
+    void ImageManager::RecycleEntry(Entry& entry, uint32_t index)
+    {
+        entry.generation = (entry.generation + 1) & GenerationMask;
+        entry.image.reset();
+        entry.children.clear();
+
+        std::lock_guard lock(fFreeListMutex);
+        entry.nextFree = fFirstFree;
+        fFirstFree = index;
     }
 
     ImageHandle ImageManager::AddImage(const IMCodec::ImageSharedPtr& image)
     {
-        if (GetNumImagesVacancy() > 0)
+        const uint32_t index = AllocateEntry();
+        if (index == NoEntry)
+            return ImageHandleNull;
+
+        ImageHandle handle;
         {
-            auto pair = fMapHandleToImage.insert(std::make_pair(AllocateImageHandle(), image));
-            if (pair.second == false)
+            Entry& entry = *GetEntry(index);
+            std::lock_guard lock(entry.mutex);
+            if (entry.alive)
                 LL_EXCEPTION(LLUtils::Exception::ErrorCode::DuplicateItem, "Image manager, duplicate image found");
 
-            return pair.first->first;
+            entry.alive = true;
+            entry.image = image;
+            Account(entry, index);
+            fNumLoadedImages.fetch_add(1, std::memory_order_relaxed);
+            handle = MakeHandle(index, entry.generation);
         }
 
-        return ImageHandleNull;
+        Evict();
+        return handle;
     }
 
     ImageHandle ImageManager::AddChildImage(const IMCodec::ImageSharedPtr& image,ImageHandle parent)
     {
-        IMCodec::ImageSharedPtr parentImage = GetImage(parent);
-        if (parentImage == nullptr)
+        Reference parentReference = Acquire(parent);
+        if (!parentReference)
             LL_EXCEPTION(LLUtils::Exception::ErrorCode::DuplicateItem, "Image manager, parent image not found");
 
         ImageHandle childHandle = AddImage(image);
-        fMapHandleToChildren[parent].push_back(childHandle);
+        if (childHandle != ImageHandleNull)
+        {
+            std::unique_lock lock(parentReference.fEntry->mutex);
+            if (parentReference.fEntry->alive)
+            {
+                parentReference.fEntry->children.push_back(childHandle);
+            }
+            else
+            {
+                // The parent was removed meanwhile, so are its children.
+                lock.unlock();
+                RemoveImage(childHandle);
+                childHandle = ImageHandleNull;
+            }
+        }
         return childHandle;
     }
 
 
     bool ImageManager::RemoveImage(ImageHandle handle)
     {
-        auto it = fMapHandleToImage.find(handle);
-        if (it != fMapHandleToImage.end())
+        VecImageHandles children;
         {
-            RemoveChildren(handle);
-            DeallocateHandle(handle);
-            fMapHandleToImage.erase(it);
-            return true;
+            std::unique_lock<std::mutex> lock;
+            uint32_t index;
+            Entry* entry = Resolve(handle, lock, index);
+            if (entry == nullptr)
+                return false;
+
+            entry->alive = false;
+            children = std::move(entry->children);
+            Forget(*entry, index);
+            fNumLoadedImages.fetch_sub(1, std::memory_order_relaxed);
+            if (entry->references == 0)
+                RecycleEntry(*entry, index);
         }
-        return false;
+
+        RemoveChildren(std::move(children));
+        return true;
     }
 
 
-    bool ImageManager::RemoveChildren(ImageHandle handle)
+    void ImageManager::RemoveChildren(VecImageHandles children)
     {
-        auto it = fMapHandleToChildren.find(handle);
+        for (ImageHandle child : children)
+            RemoveImage(child);
+    }
 
-        if (it != fMapHandleToChildren.end())
+    IMCodec::ImageSharedPtr ImageManager::GetImage(ImageHandle handle) const
+    {
+        IMCodec::ImageSharedPtr image;
         {
-            auto& children = it->second;
-            for (ImageHandle handle : children)
-                RemoveImage(handle);
+            std::unique_lock<std::mutex> lock;
+            uint32_t index;
+            Entry* entry = Resolve(handle, lock, index);
+            if (entry == nullptr)
+                return nullptr;
 
-            fMapHandleToChildren.erase(it);
-        }
-        else
-        {
-            return false;
+            image = Restore(*entry, index);
         }
 
-        return true;
+        // The returned image is held by the caller, it isn't spilled again meanwhile.
+        Evict();
+        return image;
     }
 
-    IMCodec::ImageSharedPtr ImageManager::GetImage(ImageHandle handle) const
+    ImageManager::Reference ImageManager::Acquire(ImageHandle handle)
     {
-        IMCodec::ImageSharedPtr image = nullptr;
-        if (handle != ImageHandleNull)
+        Reference reference;
         {
-            auto it = fMapHandleToImage.find(handle);
-            if (it != fMapHandleToImage.end())
-                image = it->second;
+            std::unique_lock<std::mutex> lock;
+            uint32_t index;
+            Entry* entry = Resolve(handle, lock, index);
+            if (entry == nullptr)
+                return Reference();
+
+            IMCodec::ImageSharedPtr image = Restore(*entry, index);
+            entry->references++;
+            reference = Reference(this, entry, index, std::move(image));
         }
 
-        return image;
+        Evict();
+        return reference;
     }
 
     void ImageManager::ReplaceImage(ImageHandle handle, IMCodec::ImageSharedPtr image)
     {
-        RemoveChildren(handle);
-        fMapHandleToImage[handle] = image;
+        VecImageHandles children;
+        {
+            std::unique_lock<std::mutex> lock;
+            uint32_t index;
+            Entry* entry = Resolve(handle, lock, index);
+            if (entry == nullptr)
+                LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Image manager, image not found");
+
+            children = std::move(entry->children);
+            Forget(*entry, index);
+            entry->image = std::move(image);
+            Account(*entry, index);
+        }
+
+        RemoveChildren(std::move(children));
+        Evict();
     }
 
     ImageManager::VecImageHandles ImageManager::GetChildrenOf(ImageHandle handle)
     {
-        auto it = fMapHandleToChildren.find(handle);
+        std::unique_lock<std::mutex> lock;
+        uint32_t index;
+        const Entry* entry = Resolve(handle, lock, index);
+        return entry != nullptr ? entry->children : VecImageHandles();
+    }
+
+    void ImageManager::SetMemoryBudget(uint64_t budgetBytes)
+    {
+        fMemoryBudget.store(budgetBytes, std::memory_order_relaxed);
+        Evict();
+    }
+
+    uint64_t ImageManager::GetMemoryBudget() const
+    {
+        return fMemoryBudget.load(std::memory_order_relaxed);
+    }
+
+    void ImageManager::SetSpillFolder(const std::filesystem::path& folder)
+    {
+        {
+            std::lock_guard lock(fLRUMutex);
+            // Evictions use the store without holding the lock, it lives as long as the manager.
+            if (fSpillStore != nullptr)
+                return;
+
+            fSpillStore = std::make_unique<ImageSpillStore>(folder);
+        }
+        Evict();
+    }
+
+    uint64_t ImageManager::GetResidentBytes() const
+    {
+        return fResidentBytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t ImageManager::GetSpilledBytes() const
+    {
+        return fSpilledBytes.load(std::memory_order_relaxed);
+    }
+
+    ImageSpillStore* ImageManager::GetSpillStore() const
+    {
+        std::lock_guard lock(fLRUMutex);
+        return fSpillStore.get();
+    }
+
+    void ImageManager::LinkFront(Entry& entry, uint32_t index) const
+    {
+        entry.lruPrev = NoEntry;
+        entry.lruNext = fLRUHead;
+        if (fLRUHead != NoEntry)
+            GetEntry(fLRUHead)->lruPrev = index;
+        else
+            fLRUTail = index;
+
+        fLRUHead = index;
+        entry.inLRU = true;
+    }
+
+    void ImageManager::Unlink(Entry& entry) const
+    {
+        if (entry.inLRU == false)
+            return;
+
+        if (entry.lruPrev != NoEntry)
+            GetEntry(entry.lruPrev)->lruNext = entry.lruNext;
+        else
+            fLRUHead = entry.lruNext;
 
-        if (it != fMapHandleToChildren.end())
-            return it->second;
+        if (entry.lruNext != NoEntry)
+            GetEntry(entry.lruNext)->lruPrev = entry.lruPrev;
         else
-            return VecImageHandles();
+            fLRUTail = entry.lruPrev;
+
+        entry.lruPrev = NoEntry;
+        entry.lruNext = NoEntry;
+        entry.inLRU = false;
+    }
+
+    void ImageManager::Touch(Entry& entry, uint32_t index) const
+    {
+        std::lock_guard lock(fLRUMutex);
+        if (entry.inLRU && fLRUHead != index)
+        {
+            Unlink(entry);
+            LinkFront(entry, index);
+        }
+    }
+
+    void ImageManager::Account(Entry& entry, uint32_t index) const
+    {
+        const IMCodec::ImageSharedPtr& image = entry.image;
+        entry.bytes = image != nullptr ? static_cast<uint64_t>(image->GetRowPitchInBytes()) * image->GetHeight() : 0;
+        entry.spilled = false;
+        fResidentBytes.fetch_add(entry.bytes, std::memory_order_relaxed);
+
+        std::lock_guard lock(fLRUMutex);
+        LinkFront(entry, index);
+    }
+
+    void ImageManager::Forget(Entry& entry, uint32_t index) const
+    {
+        if (entry.spilled)
+        {
+            GetSpillStore()->Remove(index);
+            fSpilledBytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+            entry.spilled = false;
+        }
+        else
+        {
+            fResidentBytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+        }
+
+        entry.bytes = 0;
+        std::lock_guard lock(fLRUMutex);
+        Unlink(entry);
+    }
+
+    const IMCodec::ImageSharedPtr& ImageManager::Restore(Entry& entry, uint32_t index) const
+    {
+        if (entry.spilled == false)
+        {
+            Touch(entry, index);
+            return entry.image;
+        }
+
+        // Spill files are keyed by entry index, an entry holds a single image at a time.
+        ImageSpillStore* spillStore = GetSpillStore();
+        IMCodec::ImageSharedPtr image = spillStore->Read(index);
+        if (image == nullptr)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::RuntimeError, "Image manager, could not read back a spilled image");
+
+        spillStore->Remove(index);
+        fSpilledBytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+        fResidentBytes.fetch_add(entry.bytes, std::memory_order_relaxed);
+        entry.image = std::move(image);
+        entry.spilled = false;
+
+        std::lock_guard lock(fLRUMutex);
+        LinkFront(entry, index);
+        return entry.image;
+    }
+
+    void ImageManager::Evict() const
+    {
+        const uint64_t budget = fMemoryBudget.load(std::memory_order_relaxed);
+        if (budget == 0 || fResidentBytes.load(std::memory_order_relaxed) <= budget)
+            return;
+
+        ImageSpillStore* spillStore = GetSpillStore();
+        if (spillStore == nullptr)
+            return;
+
+        // Images in use are moved to the front as they're passed over, the number of batches bounds the work
+        // when most resident images are held elsewhere.
+        for (uint32_t batch = 0; batch < MaxEvictionBatches && fResidentBytes.load(std::memory_order_relaxed) > budget; batch++)
+        {
+            std::array<uint32_t, EvictionBatchSize> candidates;
+            uint32_t numCandidates = 0;
+            {
+                std::lock_guard lock(fLRUMutex);
+                for (uint32_t index = fLRUTail; index != NoEntry && numCandidates < EvictionBatchSize; index = GetEntry(index)->lruPrev)
+                    candidates[numCandidates++] = index;
+            }
+
+            if (numCandidates == 0)
+                return;
+
+            for (uint32_t i = 0; i < numCandidates && fResidentBytes.load(std::memory_order_relaxed) > budget; i++)
+            {
+                const uint32_t index = candidates[i];
+                Entry& entry = *GetEntry(index);
+                std::lock_guard lock(entry.mutex);
+                // Removed or spilled by another thread meanwhile.
+                if (entry.alive == false || entry.spilled || entry.image == nullptr)
+                    continue;
+
+                // Spilling an image held elsewhere wouldn't free its memory, sub images are kept with their parent.
+                if (entry.references > 0 || entry.image.use_count() > 1 || entry.children.empty() == false
+                    || ImageSpillStore::CanWrite(*entry.image) == false || spillStore->Write(index, *entry.image) == false)
+                {
+                    Touch(entry, index);
+                    continue;
+                }
+
+                entry.image.reset();
+                entry.spilled = true;
+                fResidentBytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+                fSpilledBytes.fetch_add(entry.bytes, std::memory_order_relaxed);
+
+                std::lock_guard lruLock(fLRUMutex);
+                Unlink(entry);
+            }
+        }
     }
 }
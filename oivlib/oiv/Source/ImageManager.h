@@ -1,39 +1,149 @@
 #pragma once
-#include <list>
-#include <map>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <filesystem>
 #include <defs.h>
 #include <Image.h>
+#include <Memory/ImageSpillStore.h>
 
 
 namespace OIV
 {
+    // Thread safe table of the images exposed through the API.
+    // Entries live in fixed size slabs which are never moved, so a lookup only locks the entry it resolves.
+    // A handle carries the entry's index and a generation which is advanced whenever the entry is recycled,
+    // a stale handle of a removed image never resolves to the image which took its place.
+    // Free entries are linked through their index, allocation and deallocation are O(1).
+    // Pixel bytes of live images are accounted against a memory budget, once exceeded the least recently used images
+    // nobody else holds are spilled to disk and read back transparently on their next access.
     class ImageManager
     {
     public:
-        const int16_t MAX_IMAGES = 100;
+        static constexpr uint32_t SlabSize = 256;
+        static constexpr uint32_t MaxSlabs = 255;
+        static constexpr uint32_t MaxImages = SlabSize * MaxSlabs;
         using VecImageHandles = std::vector<ImageHandle>;
-        typedef std::list<ImageHandle> ListImageHandles;
-        typedef std::map<ImageHandle,IMCodec::ImageSharedPtr> MapHandleToImage;
-        using MapHandleToChildren = std::map<ImageHandle, VecImageHandles>;
+
+    private:
+        static constexpr uint32_t NoEntry = UINT32_MAX;
+        static constexpr uint32_t IndexBits = 16;
+        static constexpr uint32_t GenerationMask = 0x7FFF;
+
+        struct Entry
+        {
+            std::mutex mutex;
+            uint16_t generation = 0;
+            bool alive = false;
+            // Outstanding references, the entry is recycled once it's removed and none are left.
+            uint32_t references = 0;
+            IMCodec::ImageSharedPtr image;
+            VecImageHandles children;
+            uint32_t nextFree = NoEntry;
+            // Size of the pixel buffer, resident or spilled.
+            uint64_t bytes = 0;
+            // The image is in the spill store, 'image' is null.
+            bool spilled = false;
+            // Usage order of resident images, guarded by fLRUMutex.
+            bool inLRU = false;
+            uint32_t lruPrev = NoEntry;
+            uint32_t lruNext = NoEntry;
+        };
+
+    public:
+        // Pins an entry, its handle stays valid and isn't reused for another image while referenced,
+        // even if the image is removed meanwhile.
+        class Reference
+        {
+        public:
+            Reference() = default;
+            Reference(const Reference&) = delete;
+            Reference& operator=(const Reference&) = delete;
+            Reference(Reference&& rhs) noexcept;
+            Reference& operator=(Reference&& rhs) noexcept;
+            ~Reference();
+
+            explicit operator bool() const { return fEntry != nullptr; }
+            const IMCodec::ImageSharedPtr& GetImage() const { return fImage; }
+
+        private:
+            friend class ImageManager;
+            Reference(ImageManager* manager, Entry* entry, uint32_t index, IMCodec::ImageSharedPtr image);
+            void Release();
+
+            ImageManager* fManager = nullptr;
+            Entry* fEntry = nullptr;
+            uint32_t fIndex = 0;
+            IMCodec::ImageSharedPtr fImage;
+        };
+
         ImageManager();
+        ~ImageManager();
         std::size_t GetNumLoadedImages() const;
         std::size_t GetNumImagesVacancy() const;
         ImageHandle AddImage(const IMCodec::ImageSharedPtr& image);
         ImageHandle AddChildImage(const IMCodec::ImageSharedPtr& image, ImageHandle parent);
         bool RemoveImage(ImageHandle handle);
         IMCodec::ImageSharedPtr GetImage(ImageHandle handle) const;
+        Reference Acquire(ImageHandle handle);
         void ReplaceImage(ImageHandle handle, IMCodec::ImageSharedPtr image);
         VecImageHandles GetChildrenOf(ImageHandle handle);
 
+        // 0 for no limit.
+        void SetMemoryBudget(uint64_t budgetBytes);
+        uint64_t GetMemoryBudget() const;
+        // Images are spilled only once a folder is set, later calls are ignored.
+        void SetSpillFolder(const std::filesystem::path& folder);
+        uint64_t GetResidentBytes() const;
+        uint64_t GetSpilledBytes() const;
+
     private: //methods
-        ImageHandle AllocateImageHandle();
-        void DeallocateHandle(ImageHandle handle);
-        bool RemoveChildren(ImageHandle handle);
-        
+        // The index is stored biased by one, a valid handle is never ImageHandleNull.
+        static ImageHandle MakeHandle(uint32_t index, uint16_t generation);
+        static bool ParseHandle(ImageHandle handle, uint32_t& index, uint16_t& generation);
+        Entry* GetEntry(uint32_t index) const;
+        // Returns the entry locked by 'lock' if 'handle' refers to a live image.
+        Entry* Resolve(ImageHandle handle, std::unique_lock<std::mutex>& lock, uint32_t& index) const;
+        uint32_t AllocateEntry();
+        // Called with the entry locked, once it's removed and unreferenced.
+        void RecycleEntry(Entry& entry, uint32_t index);
+        void RemoveChildren(VecImageHandles children);
+
+        // LRU maintenance, called with the entry locked.
+        void Touch(Entry& entry, uint32_t index) const;
+        void Unlink(Entry& entry) const;
+        void LinkFront(Entry& entry, uint32_t index) const;
+        // Takes the image into account, or out of it, called with the entry locked.
+        void Account(Entry& entry, uint32_t index) const;
+        void Forget(Entry& entry, uint32_t index) const;
+        // Reads a spilled image back, called with the entry locked.
+        const IMCodec::ImageSharedPtr& Restore(Entry& entry, uint32_t index) const;
+        ImageSpillStore* GetSpillStore() const;
+        // Spills least recently used images until the budget is met, called with no entry locked.
+        void Evict() const;
+
 
     private: // member fields
-        MapHandleToChildren fMapHandleToChildren;
-        MapHandleToImage fMapHandleToImage;
-        ListImageHandles fListFreeHandles;
+        using Slab = std::array<Entry, SlabSize>;
+        // Guards the free list and slab allocation.
+        std::mutex fFreeListMutex;
+        std::array<std::unique_ptr<Slab>, MaxSlabs> fSlabs;
+        // Slabs below this count are allocated and never change, lookups read them without locking.
+        std::atomic<uint32_t> fNumSlabs = 0;
+        uint32_t fFirstFree = NoEntry;
+        std::atomic<std::size_t> fNumLoadedImages = 0;
+
+        static constexpr uint32_t EvictionBatchSize = 16;
+        static constexpr uint32_t MaxEvictionBatches = 8;
+        // Guards the usage order and the spill store, taken after an entry's mutex.
+        mutable std::mutex fLRUMutex;
+        mutable uint32_t fLRUHead = NoEntry; // most recently used
+        mutable uint32_t fLRUTail = NoEntry;
+        std::unique_ptr<ImageSpillStore> fSpillStore;
+        std::atomic<uint64_t> fMemoryBudget = 0;
+        mutable std::atomic<uint64_t> fResidentBytes = 0;
+        mutable std::atomic<uint64_t> fSpilledBytes = 0;
     };
 }
@@ -0,0 +1,111 @@
+#include <Memory/ImageItemPool.h>
+#include <bit>
+
+namespace OIV
+{
+    ImageItemPool& ImageItemPool::GetSingleton()
+    {
+        static ImageItemPool sPool;
+        return sPool;
+    }
+
+    size_t ImageItemPool::GetClassSize(size_t size)
+    {
+        if (size <= MinPooledSize)
+            return size;
+
+        // Four classes between consecutive powers of two.
+        const size_t step = std::bit_ceil(size) / 8;
+        return (size + step - 1) / step * step;
+    }
+
+    IMCodec::ImageItemSharedPtr ImageItemPool::Acquire(size_t size)
+    {
+        using namespace IMCodec;
+        if (size < MinPooledSize)
+        {
+            ImageItemSharedPtr imageItem = std::make_shared<ImageItem>();
+            imageItem->data.Allocate(size);
+            return imageItem;
+        }
+
+        const size_t classSize = GetClassSize(size);
+        std::weak_ptr<ImageItemPool*> pool = fSelf;
+        ImageItemSharedPtr imageItem(new ImageItem(), [pool, classSize](ImageItem* item)
+            {
+                if (auto self = pool.lock())
+                    (*self)->Release(classSize, std::move(item->data));
+                delete item;
+            });
+
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            TrimExpired();
+            fStats.requests++;
+            for (auto it = fIdleBuffers.begin(); it != fIdleBuffers.end(); ++it)
+            {
+                if (it->classSize == classSize)
+                {
+                    imageItem->data = std::move(it->buffer);
+                    fIdleBuffers.erase(it);
+                    fStats.hits++;
+                    fStats.idleBytes -= classSize;
+                    return imageItem;
+                }
+            }
+            fStats.residentBytes += classSize;
+        }
+
+        imageItem->data.Allocate(classSize);
+        return imageItem;
+    }
+
+    void ImageItemPool::Release(size_t classSize, Buffer&& buffer)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fIdleBuffers.push_front({ classSize, Clock::now(), std::move(buffer) });
+        fStats.idleBytes += classSize;
+        TrimLocked(fMaxIdleBytes);
+    }
+
+    void ImageItemPool::SetMaxIdleBytes(uint64_t maxIdleBytes)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fMaxIdleBytes = maxIdleBytes;
+        TrimLocked(fMaxIdleBytes);
+    }
+
+    void ImageItemPool::Trim(uint64_t maxIdleBytes)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        TrimLocked(maxIdleBytes);
+    }
+
+    ImageItemPool::Stats ImageItemPool::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        return fStats;
+    }
+
+    void ImageItemPool::TrimExpired()
+    {
+        const Clock::time_point expiry = Clock::now() - IdleTimeout;
+        while (fIdleBuffers.empty() == false && fIdleBuffers.back().releaseTime < expiry)
+        {
+            fStats.idleBytes -= fIdleBuffers.back().classSize;
+            fStats.residentBytes -= fIdleBuffers.back().classSize;
+            fIdleBuffers.pop_back();
+        }
+    }
+
+    void ImageItemPool::TrimLocked(uint64_t maxIdleBytes)
+    {
+        TrimExpired();
+        while (fStats.idleBytes > maxIdleBytes)
+        {
+            fStats.idleBytes -= fIdleBuffers.back().classSize;
+            fStats.residentBytes -= fIdleBuffers.back().classSize;
+            fIdleBuffers.pop_back();
+        }
+    }
+}
@@ -0,0 +1,279 @@
+#include <Memory/ImageSpillStore.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <random>
+#include <set>
+#include <Memory/ImageItemPool.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace OIV
+{
+    namespace
+    {
+#pragma pack(push,1)
+        struct SpillFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t rowPitchInBytes;
+            uint16_t texelFormatStorage;
+            uint16_t texelFormatDecompressed;
+            uint64_t dataSize; // size of the image buffer, following the header
+        };
+#pragma pack(pop)
+
+        constexpr char SpillFileMagic[4] = { 'O', 'I', 'V', 'S' };
+        constexpr uint32_t SpillFileVersion = 2;
+        constexpr wchar_t SpillFileExtension[] = L".oivs";
+        constexpr wchar_t LockFileExtension[] = L".lock";
+        constexpr uint32_t MaxLockAttempts = 4;
+    }
+
+    // An exclusive lock on a file, released when the owning process exits, however it exits.
+    class ImageSpillStore::FolderLock
+    {
+    public:
+        FolderLock(const std::filesystem::path& lockPath) : fPath(lockPath)
+        {
+#ifdef _WIN32
+            // No sharing, the file can't be opened, or deleted, while it's held.
+            fHandle = CreateFileW(fPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+            fDescriptor = open(fPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+            if (fDescriptor == -1)
+                return;
+
+            // The file might have been removed by its previous holder before it was locked here.
+            struct stat opened;
+            struct stat current;
+            if (flock(fDescriptor, LOCK_EX | LOCK_NB) != 0
+                || fstat(fDescriptor, &opened) != 0 || stat(fPath.c_str(), &current) != 0
+                || opened.st_dev != current.st_dev || opened.st_ino != current.st_ino)
+            {
+                close(fDescriptor);
+                fDescriptor = -1;
+            }
+#endif
+        }
+
+        ~FolderLock()
+        {
+#ifdef _WIN32
+            if (fHandle != INVALID_HANDLE_VALUE)
+                CloseHandle(fHandle);
+#else
+            if (fDescriptor != -1)
+                close(fDescriptor);
+#endif
+        }
+
+        FolderLock(const FolderLock&) = delete;
+        FolderLock& operator=(const FolderLock&) = delete;
+
+        bool IsLocked() const
+        {
+#ifdef _WIN32
+            return fHandle != INVALID_HANDLE_VALUE;
+#else
+            return fDescriptor != -1;
+#endif
+        }
+
+        // Removes the lock file and releases the lock.
+        void Remove()
+        {
+            if (IsLocked() == false)
+                return;
+#ifdef _WIN32
+            // Fails harmlessly if another instance opened the file meanwhile.
+            CloseHandle(fHandle);
+            fHandle = INVALID_HANDLE_VALUE;
+            DeleteFileW(fPath.c_str());
+#else
+            // Removed while locked, whoever opened it meanwhile finds it gone once locking it.
+            unlink(fPath.c_str());
+            close(fDescriptor);
+            fDescriptor = -1;
+#endif
+        }
+
+    private:
+        std::filesystem::path fPath;
+#ifdef _WIN32
+        HANDLE fHandle = INVALID_HANDLE_VALUE;
+#else
+        int fDescriptor = -1;
+#endif
+    };
+
+    ImageSpillStore::ImageSpillStore(const std::filesystem::path& parentFolder)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(parentFolder, ec);
+        RemoveStaleFolders(parentFolder);
+
+        // A folder per store, concurrent instances never share spill files.
+        // Locked before the folder exists, another instance never finds the folder unlocked while it's in use.
+        std::random_device randomDevice;
+        for (uint32_t attempt = 0; attempt < MaxLockAttempts && fFolder.empty(); attempt++)
+        {
+            const uint64_t sessionId = (static_cast<uint64_t>(randomDevice()) << 32) | randomDevice();
+            std::wstringstream ss;
+            ss << std::hex << std::setw(16) << std::setfill(L'0') << sessionId;
+            const std::filesystem::path folder = parentFolder / ss.str();
+
+            fLock = std::make_unique<FolderLock>(GetLockPath(folder));
+            if (fLock->IsLocked() && std::filesystem::create_directories(folder, ec))
+                fFolder = folder;
+            else
+                fLock->Remove();
+        }
+    }
+
+    ImageSpillStore::~ImageSpillStore()
+    {
+        if (fFolder.empty())
+            return;
+
+        std::error_code ec;
+        std::filesystem::remove_all(fFolder, ec);
+        fLock->Remove();
+    }
+
+    std::filesystem::path ImageSpillStore::GetLockPath(const std::filesystem::path& folder)
+    {
+        return std::filesystem::path(folder).concat(LockFileExtension);
+    }
+
+    void ImageSpillStore::RemoveStaleFolders(const std::filesystem::path& parentFolder)
+    {
+        // Session folders, and lock files left without their folder.
+        std::set<std::filesystem::path> folders;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(parentFolder, ec))
+        {
+            const std::filesystem::path& path = entry.path();
+            if (entry.is_directory(ec))
+                folders.insert(path);
+            else if (path.extension() == LockFileExtension)
+                folders.insert(std::filesystem::path(path).replace_extension());
+        }
+
+        for (const std::filesystem::path& folder : folders)
+        {
+            // Only a store that's gone releases its lock.
+            FolderLock lock(GetLockPath(folder));
+            if (lock.IsLocked())
+            {
+                std::filesystem::remove_all(folder, ec);
+                lock.Remove();
+            }
+        }
+    }
+
+    std::filesystem::path ImageSpillStore::GetFilePath(uint64_t key) const
+    {
+        std::wstringstream ss;
+        ss << std::hex << std::setw(16) << std::setfill(L'0') << key << SpillFileExtension;
+        return fFolder / ss.str();
+    }
+
+    bool ImageSpillStore::CanWrite(const IMCodec::Image& image)
+    {
+        return image.GetNumSubImages() == 0 && image.GetBuffer() != nullptr;
+    }
+
+    bool ImageSpillStore::Write(uint64_t key, const IMCodec::Image& image)
+    {
+        if (fFolder.empty() || CanWrite(image) == false)
+            return false;
+
+        SpillFileHeader header{};
+        std::memcpy(header.magic, SpillFileMagic, sizeof(SpillFileMagic));
+        header.version = SpillFileVersion;
+        header.width = image.GetWidth();
+        header.height = image.GetHeight();
+        header.rowPitchInBytes = image.GetRowPitchInBytes();
+        header.texelFormatStorage = static_cast<uint16_t>(image.GetOriginalTexelFormat());
+        header.texelFormatDecompressed = static_cast<uint16_t>(image.GetTexelFormat());
+        header.dataSize = static_cast<uint64_t>(header.rowPitchInBytes) * header.height;
+
+        const std::filesystem::path filePath = GetFilePath(key);
+        const std::filesystem::path tempPath = std::filesystem::path(filePath).concat(L".tmp");
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (file.is_open() == false)
+                return false;
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(image.GetBuffer()), static_cast<std::streamsize>(header.dataSize));
+            if (file.good() == false)
+            {
+                file.close();
+                std::error_code ec;
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, filePath, ec);
+        if (ec.value() != 0)
+            return false;
+
+        std::lock_guard lock(fProcessDataMutex);
+        fProcessData.insert_or_assign(key, image.GetProcessData());
+        return true;
+    }
+
+    IMCodec::ImageSharedPtr ImageSpillStore::Read(uint64_t key) const
+    {
+        using namespace IMCodec;
+        std::ifstream file(GetFilePath(key), std::ios::binary);
+        SpillFileHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)).good() == false
+            || std::memcmp(header.magic, SpillFileMagic, sizeof(SpillFileMagic)) != 0
+            || header.version != SpillFileVersion
+            || header.dataSize != static_cast<uint64_t>(header.rowPitchInBytes) * header.height)
+            return nullptr;
+
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(header.dataSize);
+        imageItem->itemType = ImageItemType::Image;
+        ImageDescriptor& props = imageItem->descriptor;
+        props.width = header.width;
+        props.height = header.height;
+        props.rowPitchInBytes = header.rowPitchInBytes;
+        props.texelFormatStorage = static_cast<TexelFormat>(header.texelFormatStorage);
+        props.texelFormatDecompressed = static_cast<TexelFormat>(header.texelFormatDecompressed);
+
+        {
+            std::lock_guard lock(fProcessDataMutex);
+            auto itProcessData = fProcessData.find(key);
+            if (itProcessData != fProcessData.end())
+                imageItem->processData = itProcessData->second;
+        }
+
+        ImageSharedPtr image = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+        file.read(reinterpret_cast<char*>(const_cast<std::byte*>(image->GetBuffer())), static_cast<std::streamsize>(header.dataSize));
+        return file.good() ? image : nullptr;
+    }
+
+    void ImageSpillStore::Remove(uint64_t key)
+    {
+        std::error_code ec;
+        std::filesystem::remove(GetFilePath(key), ec);
+        std::lock_guard lock(fProcessDataMutex);
+        fProcessData.erase(key);
+    }
+}
@@ -1,21 +1,64 @@
 #pragma once
 #include "Interfaces/IRenderer.h"
+#include <map>
 
 namespace OIV
 {
+    // Renders nothing, overlays are still composed into the overlay atlas so upload statistics can be verified without a GPU.
     class NullRenderer : public IRenderer
     {
     public:
         // Inherited via IRenderer
         int Init([[maybe_unused]] const OIV_RendererInitializationParams& initParams) override { return 0; }
         int SetViewParams([[maybe_unused]] const ViewParameters& viewParams) override { return 0; }
-        int Redraw() override { return 0; }
+        int Redraw() override
+        {
+            std::vector<IRenderable*> overlays;
+            for (const auto& [id, renderable] : fRenderables)
+                if (renderable->GetImageRenderMode() == OIV_Image_Render_mode::IRM_Overlay)
+                    overlays.push_back(renderable);
+
+            std::vector<IRenderable*> unpacked;
+            fOverlayCompositor.Update(overlays, unpacked);
+            for (IRenderable* renderable : unpacked)
+            {
+                if (renderable->GetIsImageDirty())
+                {
+                    const IMCodec::ImageSharedPtr image = renderable->GetImage();
+                    fOverlayCompositor.AddUploadedBytes(static_cast<uint64_t>(image->GetRowPitchInBytes()) * image->GetHeight());
+                    renderable->ClearImageDirty();
+                }
+            }
+            fOverlayCompositor.OnUploaded();
+            return 0;
+        }
         int SetFilterLevel([[maybe_unused]] OIV_Filter_type filterLevel) override { return 0; }
         int SetExposure([[maybe_unused]] const OIV_CMD_ColorExposure_Request & exposure) override { return 0; }
         int SetSelectionRect([[maybe_unused]] VisualSelectionRect selectionRect) override { return 0; }
         int SetBackgroundColor(int index, LLUtils::Color backgroundColor) override {return 0;}
 
-        int AddRenderable([[maybe_unused]] IRenderable* renderable) override { return 0; }
-        int RemoveRenderable([[maybe_unused]] IRenderable* renderable) override { return 0; }
+        int AddRenderable(IRenderable* renderable) override
+        {
+            fRenderables.emplace(renderable->GetID(), renderable);
+            return 0;
+        }
+
+        int RemoveRenderable(IRenderable* renderable) override
+        {
+            fRenderables.erase(renderable->GetID());
+            fOverlayCompositor.Remove(renderable);
+            return 0;
+        }
+
+        int GetOverlayStats(OverlayCompositor::Stats& stats) const override
+        {
+            stats = fOverlayCompositor.GetStats();
+            return 0;
+        }
+
+    private:
+        // Ordered by ID, the draw order of the other renderers.
+        std::map<uint32_t, IRenderable*> fRenderables;
+        OverlayCompositor fOverlayCompositor;
     };
 }
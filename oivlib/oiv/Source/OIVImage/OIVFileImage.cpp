@@ -3,6 +3,13 @@
 #include <LLUtils/StringUtility.h>
 #include <defs.h>
 #include <ImageUtil/ImageUtil.h>
+#include <FileSignature/SignatureRegistry.h>
+#include <ImageCache/DecodedImageCache.h>
+#include <FileSignature/ImageHeaderProbe.h>
+#include <Transform/AxisAlignedTransformer.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
 
 namespace OIV
 {
@@ -61,11 +68,12 @@ namespace OIV
 		return transform;
 	}
 
-	IMCodec::ImageSharedPtr ApplyExifRotation(IMCodec::ImageSharedPtr image, int exitOrientation)
+	// Transforms in place when 'image' isn't shared, e.g. with the decoded image cache.
+	void ApplyExifRotation(IMCodec::ImageSharedPtr& image, int exitOrientation)
 	{
 		//IMUtil::AxisAlignedTransform transform = static_cast<IMUtil::AxisAlignedRotation>(ResolveExifRotation(exitOrientation));
 		//transform.flip = IMUtil::AxisAlignedFlip::None;
-		return IMUtil::ImageUtil::Transform(ResolveExifRotation(exitOrientation), image);
+		AxisAlignedTransformer::TransformInPlace(ResolveExifRotation(exitOrientation), image);
 	}
 
 
@@ -77,13 +85,93 @@ namespace OIV
 	{
 		return Load(imageCodec, loaderFlags, IMCodec::ImageLoadFlags::None, {});
 	}
-    ResultCode OIVFileImage::Load(IMCodec::ImageLoader* imageCodec, IMCodec::PluginTraverseMode loaderFlags, IMCodec::ImageLoadFlags imageLoadFlags, const IMCodec::Parameters& params)
+	bool OIVFileImage::SelectPluginBySignature(IMCodec::PluginTraverseMode loaderFlags)
+	{
+		using namespace IMCodec;
+		fCodecSelection = {};
+		if ((loaderFlags & PluginTraverseMode::AnyPlugin) != PluginTraverseMode::AnyPlugin)
+			return false;
+
+		// The header decides over the extension, a file with a wrong extension goes straight to the plugin of its format.
+		// An ambiguous header or one matching no known format (e.g. tga) is left to traversal.
+		const SignatureRegistry::MatchResult match = SignatureRegistry::GetBuiltIn().MatchFile(fFileName);
+		if (match.IsUnique() == false)
+			return false;
+
+		fCodecSelection.detectedFormat = match.formats.front();
+		fCodecSelection.traversalSkipped = true;
+		return true;
+	}
+
+	ResultCode OIVFileImage::LoadEmbeddedPreview(IMCodec::ImageLoader* imageCodec)
+	{
+		using namespace IMCodec;
+		ImageHeaderInfo info;
+		ResultCode result = ImageHeaderProbe::Probe(fFileName, info);
+		if (result != RC_Success)
+			return result;
+
+		if (info.exifThumbnailLength == 0)
+			return RC_FileNotSupported;
+
+		std::vector<std::byte> thumbnail(info.exifThumbnailLength);
+		std::ifstream file(std::filesystem::path(fFileName), std::ios::binary);
+		file.seekg(static_cast<std::streamoff>(info.exifThumbnailOffset));
+		if (file.read(reinterpret_cast<char*>(thumbnail.data()), static_cast<std::streamsize>(thumbnail.size())).good() == false)
+			return RC_FileNotFound;
+
+		// EXIF thumbnails are always JPEG compressed.
+		ImageSharedPtr image;
+		if (imageCodec->Decode(thumbnail.data(), thumbnail.size(), ImageLoadFlags::None, {}, L"jpg", PluginTraverseMode::NoTraverse, image) != ImageResult::Success
+			|| image == nullptr)
+			return RC_FileNotSupported;
+
+		if (info.exifOrientation > 1)
+			ApplyExifRotation(image, info.exifOrientation);
+
+		// Orientations 5 to 8 swap the axes.
+		const bool axesSwapped = info.exifOrientation >= 5 && info.exifOrientation <= 8;
+		fFullImageSize = axesSwapped ? LLUtils::PointI32(info.height, info.width) : LLUtils::PointI32(info.width, info.height);
+		fIsPreview = true;
+		SetUnderlyingImage(image);
+		return RC_Success;
+	}
+
+    ResultCode OIVFileImage::Load(IMCodec::ImageLoader* imageCodec, IMCodec::PluginTraverseMode loaderFlags, IMCodec::ImageLoadFlags imageLoadFlags, const IMCodec::Parameters& params
+		, DecodedImageCache* decodedImageCache)
     {
 		
 		ResultCode result = RC_FileNotSupported;
 		using namespace IMCodec;
-		ImageSharedPtr image;
-		ImageResult loadResult = imageCodec->Decode(fFileName, imageLoadFlags, params,loaderFlags, image);
+		ImageSharedPtr image = decodedImageCache != nullptr ? decodedImageCache->Find(fFileName) : nullptr;
+		ImageResult loadResult = ImageResult::Success;
+
+		if (image == nullptr)
+		{
+			if (SelectPluginBySignature(loaderFlags))
+			{
+				// The detected format is passed as the extension hint, only its plugin is tried.
+				LLUtils::FileMapping fileMapping(fFileName);
+				loadResult = imageCodec->Decode(static_cast<const std::byte*>(fileMapping.GetBuffer()), fileMapping.GetSize(), imageLoadFlags, params
+					, fCodecSelection.detectedFormat, PluginTraverseMode::NoTraverse, image);
+
+				// A header which merely looks like the format, let the other plugins try.
+				// A genuine decode error of the right plugin isn't retried.
+				if (loadResult == ImageResult::FileNotSupported)
+					fCodecSelection.traversalSkipped = false;
+			}
+
+			if (fCodecSelection.traversalSkipped == false)
+				loadResult = imageCodec->Decode(fFileName, imageLoadFlags, params, loaderFlags, image);
+
+			// The cache holds the image as decoded, exif rotation is applied on every load.
+			if (loadResult == ImageResult::Success && decodedImageCache != nullptr)
+				decodedImageCache->Add(fFileName, image);
+		}
+		else
+		{
+			fCodecSelection = {};
+		}
 
 		if (loadResult == ImageResult::Success)
 		{
@@ -97,15 +185,20 @@ namespace OIV
 					{
 						// I see no use of using the original image, discard source image and use the image with exif rotation applied. 
 						// If needed, responsibility for exif rotation can be transferred to the user by returning MetaData.exifOrientation.
-						image = ApplyExifRotation(image, exifOrientation);
+						ApplyExifRotation(image, exifOrientation);
 					}
 
 					for (uint16_t i = 0; i < image->GetNumSubImages(); i++)
-						image->SetSubImage(i, ApplyExifRotation(image->GetSubImage(i), exifOrientation));
+					{
+						ImageSharedPtr subImage = image->GetSubImage(i);
+						ApplyExifRotation(subImage, exifOrientation);
+						image->SetSubImage(i, subImage);
+					}
 				}
 
 				SetMetaData(metaData);
 				SetUnderlyingImage(image);
+				fIsPreview = false;
 				result = RC_Success;
 			}
 		}
@@ -1,13 +1,16 @@
 #include <OIVImage/OIVRawImage.h>
 #include <defs.h>
 #include <ImageUtil/ImageUtil.h>
+#include <Memory/ImageItemPool.h>
+#include <Transform/AxisAlignedTransformer.h>
 
 namespace OIV
 {
     ResultCode OIVRawImage::Load(const RawBufferParams& loadParams, const IMUtil::AxisAlignedTransform& transform)
     {
         using namespace IMCodec;
-        ImageItemSharedPtr imageItem = std::make_shared<ImageItem>();
+        const size_t bufferSize = static_cast<size_t>(loadParams.rowPitch) * loadParams.height;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(bufferSize);
         ImageDescriptor& props = imageItem->descriptor;
         
         imageItem->itemType = ImageItemType::Image;
@@ -16,12 +19,10 @@ namespace OIV
         props.texelFormatStorage = loadParams.texelFormat;
         props.texelFormatDecompressed = loadParams.texelFormat;
         props.rowPitchInBytes = loadParams.rowPitch;
-        const size_t bufferSize = props.rowPitchInBytes * props.height;
-        imageItem->data.Allocate(bufferSize);
         imageItem->data.Write(loadParams.buffer, 0, bufferSize);
 
         ImageSharedPtr image = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
-        image = IMUtil::ImageUtil::Transform(transform, image);
+        AxisAlignedTransformer::TransformInPlace(transform, image);
         SetUnderlyingImage(image);
         
         return RC_Success;
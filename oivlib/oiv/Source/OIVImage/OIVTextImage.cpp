@@ -68,7 +68,29 @@ namespace OIV
     {
 #if OIV_BUILD_FREETYPE == 1
 
-        IMCodec::ImageSharedPtr imageText = FreeType::FreeTypeHelper::CreateRGBAText(fFreeType, GetCreateParams(), &fCachedTextMetrics);
+        const FreeType::TextCreateParams createParams = GetCreateParams();
+        if (fGlyphAtlas != nullptr)
+        {
+            IMCodec::ImageSharedPtr currentText = GetImage();
+            if (fIncrementalCells && fIsComposed && currentText != nullptr && fGlyphAtlas->Update(createParams, fComposedParams, *currentText))
+            {
+                fComposedParams = createParams;
+                return currentText;
+            }
+
+            IMCodec::ImageSharedPtr composedText = fGlyphAtlas->Compose(createParams);
+            if (composedText != nullptr)
+            {
+                fIsComposed = true;
+                fComposedParams = createParams;
+                return composedText;
+            }
+        }
+
+        fIsComposed = false;
+
+        IMCodec::ImageSharedPtr imageText = FreeType::FreeTypeHelper::CreateRGBAText(fFreeType, createParams, &fCachedTextMetrics);
+        fDirtyFlags.clear(DirtyFlags::Metrics);
 
         if (imageText != nullptr)
         {
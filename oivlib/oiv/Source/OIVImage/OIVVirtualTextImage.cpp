@@ -0,0 +1,337 @@
+#include <OIVImage/OIVVirtualTextImage.h>
+#include "../FreeTypeHelper.h"
+#include <Memory/ImageItemPool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace OIV
+{
+    OIVVirtualTextImage::OIVVirtualTextImage(ImageSource imageSource, FreeType::FreeTypeConnector* freeType) : OIVBaseImage(imageSource)
+    {
+        fFreeType = freeType;
+    }
+
+    void OIVVirtualTextImage::SetText(std::wstring text)
+    {
+        fText = std::move(text);
+        fLineStarts.clear();
+        fLineStarts.push_back(0);
+        for (size_t i = 0; i < fText.size(); i++)
+            if (fText[i] == L'\n')
+                fLineStarts.push_back(i + 1);
+
+        fLineWidths.assign(fLineStarts.size(), 0);
+        InvalidateStrips();
+    }
+
+    void OIVVirtualTextImage::SetFontPath(const std::wstring& fontPath)
+    {
+        if (fFontPath != fontPath)
+        {
+            fFontPath = fontPath;
+            InvalidateStrips();
+        }
+    }
+
+    void OIVVirtualTextImage::SetFontSize(uint16_t fontSize)
+    {
+        if (fFontSize != fontSize)
+        {
+            fFontSize = fontSize;
+            InvalidateStrips();
+        }
+    }
+
+    void OIVVirtualTextImage::SetDPI(uint16_t dpix, uint16_t dpiy)
+    {
+        dpix = dpix == 0 ? 96 : dpix;
+        dpiy = dpiy == 0 ? 96 : dpiy;
+        if (fDPIx != dpix || fDPIy != dpiy)
+        {
+            fDPIx = dpix;
+            fDPIy = dpiy;
+            InvalidateStrips();
+        }
+    }
+
+    void OIVVirtualTextImage::SetTextColor(LLUtils::Color color)
+    {
+        if (fTextColor != color)
+        {
+            fTextColor = color;
+            InvalidateStrips();
+        }
+    }
+
+    void OIVVirtualTextImage::SetBackgroundColor(LLUtils::Color color)
+    {
+        if (fBackgroundColor != color)
+        {
+            fBackgroundColor = color;
+            InvalidateStrips();
+        }
+    }
+
+    void OIVVirtualTextImage::SetViewportSize(LLUtils::PointI32 size)
+    {
+        if (fViewportSize != size)
+        {
+            fViewportSize = size;
+            ClampViewportOffset();
+            fViewDirty = true;
+        }
+    }
+
+    void OIVVirtualTextImage::SetViewportOffset(LLUtils::PointF64 offset)
+    {
+        fViewportOffset = offset;
+        ClampViewportOffset();
+        fViewDirty = true;
+    }
+
+    void OIVVirtualTextImage::SetViewportScale(double scale)
+    {
+        if (fViewportScale != scale && scale > 0)
+        {
+            fViewportScale = scale;
+            ClampViewportOffset();
+            fViewDirty = true;
+        }
+    }
+
+    LLUtils::PointF64 OIVVirtualTextImage::GetDocumentSize()
+    {
+        UpdateFontMetrics();
+        return { fDocumentWidth, static_cast<double>(fLineStarts.size()) * fRowHeight };
+    }
+
+    void OIVVirtualTextImage::InvalidateStrips()
+    {
+        fStrips.clear();
+        fStripsMap.clear();
+        fStripsBytes = 0;
+        std::fill(fLineWidths.begin(), fLineWidths.end(), 0);
+        fFontMetricsValid = false;
+        fViewDirty = true;
+    }
+
+    void OIVVirtualTextImage::ClampViewportOffset()
+    {
+        const LLUtils::PointF64 documentSize = GetDocumentSize();
+        const LLUtils::PointF64 viewportSize = static_cast<LLUtils::PointF64>(fViewportSize) / fViewportScale;
+        fViewportOffset.x = std::clamp(fViewportOffset.x, 0.0, std::max(0.0, documentSize.x - viewportSize.x));
+        fViewportOffset.y = std::clamp(fViewportOffset.y, 0.0, std::max(0.0, documentSize.y - viewportSize.y));
+    }
+
+    std::wstring_view OIVVirtualTextImage::GetLine(size_t line) const
+    {
+        const size_t start = fLineStarts[line];
+        size_t end = line + 1 < fLineStarts.size() ? fLineStarts[line + 1] - 1 : fText.size();
+        if (end > start && fText[end - 1] == L'\r')
+            end--;
+
+        return std::wstring_view(fText).substr(start, std::min(end - start, MaxLineLength));
+    }
+
+    void OIVVirtualTextImage::UpdateFontMetrics()
+    {
+        if (fFontMetricsValid == true)
+            return;
+
+        fFontMetricsValid = true;
+        fRowHeight = fFontSize;
+        fCharAdvance = fFontSize / 2.0;
+
+#if OIV_BUILD_FREETYPE == 1
+        if (fFreeType != nullptr)
+        {
+            FreeType::TextCreateParams createParams{};
+            createParams.fontPath = fFontPath;
+            createParams.fontSize = fFontSize;
+            createParams.DPIx = fDPIx;
+            createParams.DPIy = fDPIy;
+            createParams.renderMode = FreeType::RenderMode::Antialiased;
+
+            createParams.text = L"0";
+            FreeType::TextMetrics metrics;
+            fFreeType->MeasureText(createParams, metrics);
+            if (metrics.rowHeight > 0)
+                fRowHeight = metrics.rowHeight;
+
+            // The advance of a glyph, without its bearings, estimates the width of lines not rasterized yet.
+            FreeType::FreeTypeConnector::Bitmap single;
+            FreeType::FreeTypeConnector::Bitmap sequence;
+            fFreeType->CreateBitmap(createParams, single, nullptr);
+            createParams.text = L"0000000000";
+            fFreeType->CreateBitmap(createParams, sequence, nullptr);
+            if (sequence.width > single.width)
+                fCharAdvance = (sequence.width - single.width) / 9.0;
+        }
+#endif
+
+        size_t longestLine = 0;
+        for (size_t line = 0; line < fLineStarts.size(); line++)
+            longestLine = std::max(longestLine, GetLine(line).size());
+
+        fDocumentWidth = longestLine * fCharAdvance;
+    }
+
+    IMCodec::ImageSharedPtr OIVVirtualTextImage::GetStrip(size_t line, uint16_t fontSize)
+    {
+        const uint64_t key = GetStripKey(line, fontSize);
+        auto it = fStripsMap.find(key);
+        if (it != fStripsMap.end())
+        {
+            fStrips.splice(fStrips.begin(), fStrips, it->second);
+            return it->second->image;
+        }
+
+        IMCodec::ImageSharedPtr image;
+#if OIV_BUILD_FREETYPE == 1
+        const std::wstring_view text = GetLine(line);
+        if (text.empty() == false && fFreeType != nullptr)
+        {
+            FreeType::TextCreateParams createParams{};
+            createParams.fontPath = fFontPath;
+            createParams.fontSize = fontSize;
+            createParams.DPIx = fDPIx;
+            createParams.DPIy = fDPIy;
+            createParams.renderMode = FreeType::RenderMode::Antialiased;
+            createParams.outlineColor = { 0,0,0,255 };
+            createParams.textColor = fTextColor;
+            createParams.backgroundColor = fBackgroundColor;
+            createParams.flags |= FreeType::TextCreateFlags::Bidirectional;
+            createParams.text = std::wstring(text);
+            image = FreeType::FreeTypeHelper::CreateRGBAText(fFreeType, createParams, nullptr);
+        }
+#endif
+
+        if (image != nullptr && fontSize == fFontSize)
+        {
+            fLineWidths[line] = image->GetWidth();
+            fDocumentWidth = std::max(fDocumentWidth, static_cast<double>(image->GetWidth()));
+        }
+
+        // Empty lines are cached as well, accounted for their bookkeeping.
+        const size_t stripBytes = image != nullptr ? image->GetTotalSizeOfImageTexels() : sizeof(Strip);
+        fStrips.push_front({ key, image });
+        fStripsMap.emplace(key, fStrips.begin());
+        fStripsBytes += stripBytes;
+
+        while (fStripsBytes > MaxStripCacheBytes && fStrips.size() > 1)
+        {
+            const Strip& leastRecent = fStrips.back();
+            fStripsBytes -= leastRecent.image != nullptr ? leastRecent.image->GetTotalSizeOfImageTexels() : sizeof(Strip);
+            fStripsMap.erase(leastRecent.key);
+            fStrips.pop_back();
+        }
+
+        return image;
+    }
+
+    void OIVVirtualTextImage::Compose()
+    {
+        using namespace IMCodec;
+        UpdateFontMetrics();
+
+        const uint32_t width = static_cast<uint32_t>(std::max(fViewportSize.x, 1));
+        const uint32_t height = static_cast<uint32_t>(std::max(fViewportSize.y, 1));
+        const size_t rowPitch = width * 4;
+
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(rowPitch * height);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = width;
+        desc.height = height;
+        desc.rowPitchInBytes = static_cast<uint32_t>(rowPitch);
+        desc.texelFormatDecompressed = TexelFormat::I_R8_G8_B8_A8;
+        desc.texelFormatStorage = TexelFormat::I_R8_G8_B8_A8;
+        imageItem->itemType = ImageItemType::Image;
+
+        std::byte* target = reinterpret_cast<std::byte*>(imageItem->data.data());
+        auto fillRow = [&](uint32_t y, uint32_t end, LLUtils::Color color)
+        {
+            const std::byte texel[4] = { std::byte{ color.R }, std::byte{ color.G }, std::byte{ color.B }, std::byte{ color.A } };
+            std::byte* row = target + y * rowPitch;
+            for (uint32_t x = 0; x < end; x++)
+                std::memcpy(row + x * 4, texel, 4);
+        };
+
+        for (uint32_t y = 0; y < height; y++)
+            fillRow(y, width, fBackgroundColor);
+
+        const double scale = fViewportScale;
+        const double rowPitchPx = fRowHeight * scale;
+        const size_t numLines = fLineStarts.size();
+
+        if (rowPitchPx >= MinRowPitch)
+        {
+            const uint16_t fontSize = static_cast<uint16_t>(std::clamp<long>(std::lround(fFontSize * scale), 1, MaxFontSize));
+            const size_t firstLine = static_cast<size_t>(fViewportOffset.y / fRowHeight);
+            const size_t endLine = std::min(numLines, static_cast<size_t>(std::ceil((fViewportOffset.y + height / scale) / fRowHeight)));
+            const int64_t left = std::lround(-fViewportOffset.x * scale);
+
+            for (size_t line = firstLine; line < endLine; line++)
+            {
+                const ImageSharedPtr strip = GetStrip(line, fontSize);
+                if (strip == nullptr)
+                    continue;
+
+                const int64_t top = std::lround(line * rowPitchPx - fViewportOffset.y * scale);
+                const int64_t firstX = std::max<int64_t>(left, 0);
+                const int64_t endX = std::min<int64_t>(left + strip->GetWidth(), width);
+                const int64_t firstY = std::max<int64_t>(top, 0);
+                const int64_t endY = std::min<int64_t>(top + strip->GetHeight(), height);
+                if (firstX >= endX)
+                    continue;
+
+                for (int64_t y = firstY; y < endY; y++)
+                    std::memcpy(target + y * rowPitch + firstX * 4, strip->GetBufferAt(static_cast<uint32_t>(firstX - left), static_cast<uint32_t>(y - top)), (endX - firstX) * 4);
+            }
+        }
+        else
+        {
+            // Text is too small to read, draw each line as a bar of its width, the widest line wins when lines share a row.
+            const LLUtils::Color ink{
+                  static_cast<uint8_t>((fTextColor.R + fBackgroundColor.R) / 2)
+                , static_cast<uint8_t>((fTextColor.G + fBackgroundColor.G) / 2)
+                , static_cast<uint8_t>((fTextColor.B + fBackgroundColor.B) / 2)
+                , fBackgroundColor.A };
+
+            for (uint32_t y = 0; y < height; y++)
+            {
+                const double documentTop = fViewportOffset.y + y / scale;
+                const double documentBottom = fViewportOffset.y + (y + 1) / scale;
+                const size_t firstLine = static_cast<size_t>(documentTop / fRowHeight);
+                if (firstLine >= numLines)
+                    break;
+
+                const size_t endLine = std::clamp(static_cast<size_t>(std::ceil(documentBottom / fRowHeight)), firstLine + 1, numLines);
+                // Leave a gap between lines spanning several rows.
+                if (endLine == firstLine + 1 && std::fmod(documentTop, fRowHeight) > fRowHeight * 0.6)
+                    continue;
+
+                double widest = 0;
+                for (size_t line = firstLine; line < endLine; line++)
+                    widest = std::max(widest, fLineWidths[line] != 0 ? fLineWidths[line] : GetLine(line).size() * fCharAdvance);
+
+                fillRow(y, static_cast<uint32_t>(std::clamp((widest - fViewportOffset.x) * scale, 0.0, static_cast<double>(width))), ink);
+            }
+        }
+
+        SetUnderlyingImage(std::make_shared<Image>(imageItem, ImageItemType::Unknown));
+        fViewDirty = false;
+    }
+
+    void OIVVirtualTextImage::PerformPreRender()
+    {
+        OIVBaseImage::PerformPreRender();
+        if (fViewDirty)
+            Compose();
+    }
+
+    bool OIVVirtualTextImage::PerformIsDirty() const
+    {
+        return fViewDirty || OIVBaseImage::PerformIsDirty();
+    }
+}
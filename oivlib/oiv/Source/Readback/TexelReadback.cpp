@@ -0,0 +1,219 @@
+#include <Readback/TexelReadback.h>
+#include <System.h>
+#include <LLUtils/Exception.h>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OIV_READBACK_SSE2 1
+#else
+#define OIV_READBACK_SSE2 0
+#endif
+
+namespace OIV
+{
+    namespace
+    {
+        struct Layout
+        {
+            uint32_t bytesPerChannel;
+            uint32_t bytesPerTexel;
+            // Channel positions of red, green, blue and opacity in a texel, -1 if missing.
+            std::array<int32_t, 4> channels;
+        };
+
+        bool GetLayout(OIV_TexelFormat format, Layout& layout)
+        {
+            switch (format)
+            {
+            case TF_I_R8_G8_B8:         layout = { 1, 3, { 0, 1, 2, -1 } }; return true;
+            case TF_I_R16_G16_B16:      layout = { 2, 6, { 0, 1, 2, -1 } }; return true;
+            case TF_I_R8_G8_B8_A8:      layout = { 1, 4, { 0, 1, 2, 3 } }; return true;
+            case TF_I_R16_G16_B16_A16:  layout = { 2, 8, { 0, 1, 2, 3 } }; return true;
+            case TF_I_B8_G8_R8:         layout = { 1, 3, { 2, 1, 0, -1 } }; return true;
+            case TF_I_B16_G16_R16:      layout = { 2, 6, { 2, 1, 0, -1 } }; return true;
+            case TF_I_B8_G8_R8_A8:      layout = { 1, 4, { 2, 1, 0, 3 } }; return true;
+            case TF_I_B16_G16_R16_A16:  layout = { 2, 8, { 2, 1, 0, 3 } }; return true;
+            case TF_I_A8_R8_G8_B8:      layout = { 1, 4, { 1, 2, 3, 0 } }; return true;
+            case TF_I_A16_R16_G16_B16:  layout = { 2, 8, { 1, 2, 3, 0 } }; return true;
+            case TF_I_A8_B8_G8_R8:      layout = { 1, 4, { 3, 2, 1, 0 } }; return true;
+            case TF_I_A16_B16_G16_R16:  layout = { 2, 8, { 3, 2, 1, 0 } }; return true;
+            case TF_I_A8:               layout = { 1, 1, { -1, -1, -1, 0 } }; return true;
+            default:
+                return false;
+            }
+        }
+
+        // Texels of the same format are copied as they are, whatever the format.
+        bool GetLayouts(OIV_TexelFormat sourceFormat, OIV_TexelFormat targetFormat, Layout& sourceLayout, Layout& targetLayout)
+        {
+            if (sourceFormat == targetFormat)
+            {
+                const uint32_t bytesPerTexel = TexelReadback::GetBytesPerTexel(sourceFormat);
+                sourceLayout = { 0, bytesPerTexel, { -1, -1, -1, -1 } };
+                targetLayout = sourceLayout;
+                return bytesPerTexel != 0;
+            }
+
+            return GetLayout(sourceFormat, sourceLayout) && GetLayout(targetFormat, targetLayout);
+        }
+
+        bool IsRedBlueSwap(const Layout& source, const Layout& target)
+        {
+            return source.bytesPerChannel == 1 && target.bytesPerChannel == 1 && source.bytesPerTexel == 4 && target.bytesPerTexel == 4
+                && source.channels[0] == target.channels[2] && source.channels[2] == target.channels[0]
+                && source.channels[1] == 1 && target.channels[1] == 1 && source.channels[3] == 3 && target.channels[3] == 3;
+        }
+
+        void SwapRedBlue(const std::byte* source, std::byte* target, uint32_t width)
+        {
+            uint32_t x = 0;
+#if OIV_READBACK_SSE2
+            const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            const __m128i low = _mm_set1_epi32(0x000000FF);
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+                const __m128i swapped = _mm_or_si128(_mm_and_si128(texels, greenAlpha)
+                    , _mm_or_si128(_mm_and_si128(_mm_srli_epi32(texels, 16), low), _mm_slli_epi32(_mm_and_si128(texels, low), 16)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + x * 4), swapped);
+            }
+#endif
+            for (; x < width; x++)
+            {
+                const std::byte* s = source + x * 4;
+                std::byte* t = target + x * 4;
+                t[0] = s[2];
+                t[1] = s[1];
+                t[2] = s[0];
+                t[3] = s[3];
+            }
+        }
+
+        template <typename Channel>
+        constexpr uint32_t MaxValue() { return (1u << (sizeof(Channel) * 8)) - 1; }
+
+        template <typename SourceChannel, typename TargetChannel>
+        void ConvertRow(const std::byte* source, std::byte* target, uint32_t width, const Layout& sourceLayout, const Layout& targetLayout)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                SourceChannel sourceTexel[4];
+                TargetChannel targetTexel[4];
+                std::memcpy(sourceTexel, source + x * sourceLayout.bytesPerTexel, sourceLayout.bytesPerTexel);
+                for (size_t c = 0; c < 4; c++)
+                {
+                    const int32_t targetChannel = targetLayout.channels[c];
+                    if (targetChannel < 0)
+                        continue;
+
+                    const int32_t sourceChannel = sourceLayout.channels[c];
+                    // Missing color channels read as 0, a missing opacity as opaque.
+                    uint32_t value = sourceChannel >= 0 ? static_cast<uint32_t>(sourceTexel[sourceChannel]) : (c == 3 ? MaxValue<SourceChannel>() : 0);
+                    if constexpr (sizeof(SourceChannel) == 1 && sizeof(TargetChannel) == 2)
+                        value *= 257;
+                    else if constexpr (sizeof(SourceChannel) == 2 && sizeof(TargetChannel) == 1)
+                        value = (value * 255 + 32767) / 65535;
+
+                    targetTexel[targetChannel] = static_cast<TargetChannel>(value);
+                }
+                std::memcpy(target + x * targetLayout.bytesPerTexel, targetTexel, targetLayout.bytesPerTexel);
+            }
+        }
+
+        void CopyRow(const std::byte* source, std::byte* target, uint32_t width, const Layout& sourceLayout, const Layout& targetLayout)
+        {
+            if (sourceLayout.bytesPerTexel == targetLayout.bytesPerTexel && sourceLayout.bytesPerChannel == targetLayout.bytesPerChannel
+                && sourceLayout.channels == targetLayout.channels)
+                std::memcpy(target, source, static_cast<size_t>(width) * sourceLayout.bytesPerTexel);
+            else if (IsRedBlueSwap(sourceLayout, targetLayout))
+                SwapRedBlue(source, target, width);
+            else if (sourceLayout.bytesPerChannel == 1 && targetLayout.bytesPerChannel == 1)
+                ConvertRow<uint8_t, uint8_t>(source, target, width, sourceLayout, targetLayout);
+            else if (sourceLayout.bytesPerChannel == 1)
+                ConvertRow<uint8_t, uint16_t>(source, target, width, sourceLayout, targetLayout);
+            else if (targetLayout.bytesPerChannel == 1)
+                ConvertRow<uint16_t, uint8_t>(source, target, width, sourceLayout, targetLayout);
+            else
+                ConvertRow<uint16_t, uint16_t>(source, target, width, sourceLayout, targetLayout);
+        }
+
+        // Below this size a region is copied on the calling thread.
+        constexpr size_t MinParallelBytes = 1024 * 1024;
+    }
+
+    bool TexelReadback::IsSupported(OIV_TexelFormat sourceFormat, OIV_TexelFormat targetFormat)
+    {
+        Layout sourceLayout;
+        Layout targetLayout;
+        return GetLayouts(sourceFormat, targetFormat, sourceLayout, targetLayout);
+    }
+
+    uint32_t TexelReadback::GetBytesPerTexel(OIV_TexelFormat format)
+    {
+        const uint32_t bitsPerTexel = IMCodec::GetTexelFormatSize(static_cast<IMCodec::TexelFormat>(format));
+        return bitsPerTexel % CHAR_BIT == 0 ? bitsPerTexel / CHAR_BIT : 0;
+    }
+
+    void TexelReadback::CopyRegion(const IMCodec::Image& image, uint32_t x, uint32_t y, uint32_t width, uint32_t height
+        , OIV_TexelFormat targetFormat, std::byte* target, std::size_t targetRowPitch)
+    {
+        Layout sourceLayout;
+        Layout targetLayout;
+        if (GetLayouts(static_cast<OIV_TexelFormat>(image.GetTexelFormat()), targetFormat, sourceLayout, targetLayout) == false)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::BadParameters, "Unsupported texel format");
+
+        auto copyRows = [&](uint32_t firstRow, uint32_t endRow)
+        {
+            for (uint32_t row = firstRow; row < endRow; row++)
+                CopyRow(image.GetBufferAt(x, y + row), target + row * targetRowPitch, width, sourceLayout, targetLayout);
+        };
+
+        static const uint32_t sNumThreads = std::max(System::GetIdealNumThreadsForMemoryOperations(), 1u);
+        const size_t totalBytes = static_cast<size_t>(width) * height * targetLayout.bytesPerTexel;
+        const uint32_t numThreads = totalBytes < MinParallelBytes ? 1 : std::min(sNumThreads, height);
+        if (numThreads == 1)
+        {
+            copyRows(0, height);
+            return;
+        }
+
+        // Each thread copies a band of consecutive rows.
+        std::vector<std::thread> threads;
+        const uint32_t rowsPerThread = (height + numThreads - 1) / numThreads;
+        for (uint32_t firstRow = rowsPerThread; firstRow < height; firstRow += rowsPerThread)
+            threads.emplace_back(copyRows, firstRow, std::min(firstRow + rowsPerThread, height));
+
+        copyRows(0, std::min(rowsPerThread, height));
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void TexelReadback::CopyPoints(const IMCodec::Image& image, const OIV_POINT_I* points, std::size_t numPoints
+        , OIV_TexelFormat targetFormat, std::byte* target)
+    {
+        Layout sourceLayout;
+        Layout targetLayout;
+        if (GetLayouts(static_cast<OIV_TexelFormat>(image.GetTexelFormat()), targetFormat, sourceLayout, targetLayout) == false)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::BadParameters, "Unsupported texel format");
+
+        const int64_t width = image.GetWidth();
+        const int64_t height = image.GetHeight();
+        for (size_t i = 0; i < numPoints; i++)
+        {
+            const int64_t x = points[i].x;
+            const int64_t y = points[i].y;
+            std::byte* texel = target + i * targetLayout.bytesPerTexel;
+            if (x >= 0 && x < width && y >= 0 && y < height)
+                CopyRow(image.GetBufferAt(static_cast<uint32_t>(x), static_cast<uint32_t>(y)), texel, 1, sourceLayout, targetLayout);
+            else
+                std::memset(texel, 0, targetLayout.bytesPerTexel);
+        }
+    }
+}
@@ -0,0 +1,287 @@
+#include <Render/OverlayCompositor.h>
+#include <Memory/ImageItemPool.h>
+#include <algorithm>
+#include <cstring>
+
+namespace OIV
+{
+    void OverlayCompositor::GetSlotSize(uint32_t width, uint32_t height, uint32_t& slotWidth, uint32_t& slotHeight)
+    {
+        slotWidth = (width + SlotWidthGranularity - 1) / SlotWidthGranularity * SlotWidthGranularity + SlotPadding;
+        slotHeight = (height + SlotHeightGranularity - 1) / SlotHeightGranularity * SlotHeightGranularity + SlotPadding;
+    }
+
+    bool OverlayCompositor::IsPackable(const IMCodec::Image& image)
+    {
+        const IMCodec::TexelFormat format = image.GetTexelFormat();
+        uint32_t slotWidth;
+        uint32_t slotHeight;
+        GetSlotSize(image.GetWidth(), image.GetHeight(), slotWidth, slotHeight);
+        return (format == IMCodec::TexelFormat::I_R8_G8_B8_A8 || format == IMCodec::TexelFormat::I_B8_G8_R8_A8)
+            && slotWidth <= MaxAtlasSize
+            && slotHeight <= MaxAtlasSize;
+    }
+
+    bool OverlayCompositor::Allocate(uint32_t width, uint32_t height, Rect& slot)
+    {
+        uint32_t slotWidth;
+        uint32_t slotHeight;
+        GetSlotSize(width, height, slotWidth, slotHeight);
+        if (slotWidth > fAtlasWidth || slotHeight > fAtlasHeight)
+            return false;
+
+        // Use the lowest shelf that fits and doesn't waste more than half the slot's height, otherwise open a new shelf.
+        Shelf* best = nullptr;
+        for (Shelf& shelf : fShelves)
+        {
+            if (shelf.height >= slotHeight && shelf.height * 2 <= slotHeight * 3 && fAtlasWidth - shelf.usedWidth >= slotWidth
+                && (best == nullptr || shelf.height < best->height))
+                best = &shelf;
+        }
+
+        if (best == nullptr)
+        {
+            if (fAtlasHeight - fShelvesBottom < slotHeight)
+                return false;
+
+            best = &fShelves.emplace_back(Shelf{ fShelvesBottom, slotHeight, 0 });
+            fShelvesBottom += slotHeight;
+        }
+
+        slot = { best->usedWidth, best->y, slotWidth - SlotPadding, slotHeight - SlotPadding };
+        best->usedWidth += slotWidth;
+        return true;
+    }
+
+    void OverlayCompositor::CreateAtlas()
+    {
+        using namespace IMCodec;
+        const size_t rowPitch = static_cast<size_t>(fAtlasWidth) * 4;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(rowPitch * fAtlasHeight);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = fAtlasWidth;
+        desc.height = fAtlasHeight;
+        desc.rowPitchInBytes = static_cast<uint32_t>(rowPitch);
+        desc.texelFormatDecompressed = TexelFormat::I_R8_G8_B8_A8;
+        desc.texelFormatStorage = TexelFormat::I_R8_G8_B8_A8;
+        imageItem->itemType = ImageItemType::Image;
+        // Unused texels are transparent.
+        std::memset(imageItem->data.data(), 0, rowPitch * fAtlasHeight);
+        fAtlasData = reinterpret_cast<std::byte*>(imageItem->data.data());
+        fAtlas = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+        fAtlasRecreated = true;
+        fDirtyRects.clear();
+    }
+
+    void OverlayCompositor::Copy(const Entry& entry)
+    {
+        const IMCodec::Image& image = *entry.image;
+        const uint32_t width = image.GetWidth();
+        const uint32_t height = image.GetHeight();
+        const bool swapRedBlue = image.GetTexelFormat() == IMCodec::TexelFormat::I_B8_G8_R8_A8;
+        const size_t atlasRowPitch = fAtlas->GetRowPitchInBytes();
+        std::byte* target = fAtlasData + entry.slot.y * atlasRowPitch + entry.slot.x * 4;
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const std::byte* sourceRow = image.GetBufferAt(0, y);
+            std::byte* targetRow = target + y * atlasRowPitch;
+            if (swapRedBlue == false)
+            {
+                std::memcpy(targetRow, sourceRow, width * 4);
+            }
+            else
+            {
+                for (uint32_t x = 0; x < width * 4; x += 4)
+                {
+                    targetRow[x + 0] = sourceRow[x + 2];
+                    targetRow[x + 1] = sourceRow[x + 1];
+                    targetRow[x + 2] = sourceRow[x + 0];
+                    targetRow[x + 3] = sourceRow[x + 3];
+                }
+            }
+        }
+
+        if (fAtlasRecreated == false)
+            fDirtyRects.push_back({ entry.slot.x, entry.slot.y, width, height });
+    }
+
+    void OverlayCompositor::Repack()
+    {
+        fStats.repacks++;
+
+        // Pack taller images first, shelves are then filled with images of similar height.
+        std::vector<Entry*> entries;
+        for (auto& [renderable, entry] : fEntries)
+            if (entry.image != nullptr)
+                entries.push_back(&entry);
+
+        std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) { return a->image->GetHeight() > b->image->GetHeight(); });
+
+        // Grow the atlas until everything fits, or it reaches its maximum size and the rest is drawn unpacked.
+        for (;;)
+        {
+            fShelves.clear();
+            fShelvesBottom = 0;
+            bool allPacked = true;
+            for (Entry* entry : entries)
+            {
+                entry->packed = Allocate(entry->image->GetWidth(), entry->image->GetHeight(), entry->slot);
+                allPacked &= entry->packed;
+            }
+
+            if (allPacked || (fAtlasWidth == MaxAtlasSize && fAtlasHeight == MaxAtlasSize))
+            {
+                // Whatever doesn't fit now won't until overlays are removed, retrying every frame would repack every frame.
+                for (Entry* entry : entries)
+                    entry->overflowed = entry->packed == false;
+                break;
+            }
+
+            if (fAtlasWidth <= fAtlasHeight)
+                fAtlasWidth = std::min(fAtlasWidth * 2, MaxAtlasSize);
+            else
+                fAtlasHeight = std::min(fAtlasHeight * 2, MaxAtlasSize);
+        }
+
+        CreateAtlas();
+        for (Entry* entry : entries)
+            if (entry->packed)
+                Copy(*entry);
+    }
+
+    void OverlayCompositor::Update(const std::vector<IRenderable*>& overlays, std::vector<IRenderable*>& unpacked)
+    {
+        fStats.frames++;
+        fStats.frameUploadedBytes = 0;
+        fInstances.clear();
+        unpacked.clear();
+
+        if (fAtlas == nullptr)
+            CreateAtlas();
+
+        std::vector<IRenderable*> visible;
+        std::vector<Entry*> changed;
+        for (IRenderable* renderable : overlays)
+        {
+            if (renderable->GetOpacity() == 0.0 || renderable->GetVisible() == false)
+                continue;
+
+            renderable->PreRender();
+            const IMCodec::ImageSharedPtr& image = renderable->GetImage();
+            if (image == nullptr)
+                continue;
+
+            if (IsPackable(*image) == false)
+            {
+                if (fEntries.erase(renderable) > 0)
+                    fOverlaySetChanged = true;
+
+                unpacked.push_back(renderable);
+                continue;
+            }
+
+            auto [it, inserted] = fEntries.try_emplace(renderable);
+            Entry& entry = it->second;
+            fOverlaySetChanged |= inserted;
+            if (renderable->GetIsImageDirty() || entry.image != image || (entry.packed == false && entry.overflowed == false))
+            {
+                entry.image = image;
+                changed.push_back(&entry);
+            }
+            visible.push_back(renderable);
+        }
+
+        if (fOverlaySetChanged)
+        {
+            // Space may have been freed, overflowed entries get another chance.
+            fOverlaySetChanged = false;
+            for (auto& [renderable, entry] : fEntries)
+            {
+                if (entry.overflowed)
+                {
+                    entry.overflowed = false;
+                    if (std::find(changed.begin(), changed.end(), &entry) == changed.end())
+                        changed.push_back(&entry);
+                }
+            }
+        }
+
+        bool repack = false;
+        for (Entry* entry : changed)
+        {
+            // Drawn unpacked, see Entry::overflowed.
+            if (entry->overflowed)
+                continue;
+
+            const uint32_t width = entry->image->GetWidth();
+            const uint32_t height = entry->image->GetHeight();
+            if (entry->packed == false || width > entry->slot.width || height > entry->slot.height)
+            {
+                // The previous slot is abandoned until the next repack.
+                entry->packed = Allocate(width, height, entry->slot);
+                if (entry->packed == false)
+                {
+                    repack = true;
+                    break;
+                }
+            }
+            Copy(*entry);
+        }
+
+        if (repack)
+            Repack();
+
+        for (IRenderable* renderable : visible)
+        {
+            const Entry& entry = fEntries.at(renderable);
+            if (entry.packed)
+            {
+                // The image is consumed through the atlas, images left unpacked stay dirty for the renderer to upload on their own.
+                renderable->ClearImageDirty();
+                fInstances.push_back({ renderable, { entry.slot.x, entry.slot.y, entry.image->GetWidth(), entry.image->GetHeight() }
+                    , renderable->GetPosition(), renderable->GetScale(), renderable->GetOpacity() });
+            }
+            else
+            {
+                unpacked.push_back(renderable);
+            }
+        }
+
+        fStats.packedOverlays = static_cast<uint32_t>(fInstances.size());
+        fStats.unpackedOverlays = static_cast<uint32_t>(unpacked.size());
+        fStats.atlasWidth = fAtlasWidth;
+        fStats.atlasHeight = fAtlasHeight;
+    }
+
+    void OverlayCompositor::Remove(IRenderable* renderable)
+    {
+        // Its slot is reclaimed on the next repack.
+        if (fEntries.erase(renderable) > 0)
+            fOverlaySetChanged = true;
+    }
+
+    void OverlayCompositor::OnUploaded()
+    {
+        uint64_t bytes = 0;
+        if (fAtlasRecreated)
+        {
+            bytes = static_cast<uint64_t>(fAtlas->GetRowPitchInBytes()) * fAtlas->GetHeight();
+        }
+        else
+        {
+            for (const Rect& rect : fDirtyRects)
+                bytes += static_cast<uint64_t>(rect.width) * rect.height * 4;
+        }
+
+        AddUploadedBytes(bytes);
+        fAtlasRecreated = false;
+        fDirtyRects.clear();
+    }
+
+    void OverlayCompositor::AddUploadedBytes(uint64_t bytes)
+    {
+        fStats.frameUploadedBytes += bytes;
+        fStats.totalUploadedBytes += bytes;
+    }
+}
@@ -1,6 +1,9 @@
 #include "Resampler.h"
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <cstring>
+#include <climits>
 #include <LLUtils/PlatformUtility.h>
 #include <LLUtils/Exception.h>
 #include <System.h>
@@ -10,16 +13,13 @@ namespace OIV
 	void Resampler::Init()
 	{
 		//Lazy initialize.
-		if (fInitialized == false)
-		{
-			fNumOfIdealThreadsForResampling = System::GetIdealNumThreadsForMemoryOperations();
-			fTasks.resize(fNumOfIdealThreadsForResampling);
-			fThreads.resize(fNumOfIdealThreadsForResampling);
-			fInitialized = true;
-		}
+		std::call_once(fInitialized, [this]()
+			{
+				fNumOfIdealThreadsForResampling = System::GetIdealNumThreadsForMemoryOperations();
+			});
 	}
 
-	void Resampler::Resample(const ResamplerParams& params)
+	bool Resampler::Resample(const ResamplerParams& params)
 	{
 		Init();
 
@@ -128,15 +128,20 @@ namespace OIV
 		//cv.notify_all();
 #endif
 
+		// Tasks are per call so resampling can run concurrently, e.g. a preview and a background refinement.
+		std::vector<ResampleTask> tasks(totalThreads);
+		std::vector<std::thread> threads(totalThreads);
 		for (int i = 0; i < totalThreads; i++)
 		{
-			fTasks[i] = templateTask;;
-			fTasks[i].TaskID = i;
-			fThreads[i] = std::thread(std::bind(&Resampler::ResampleThreadEntryPoint, this, std::placeholders::_1), &fTasks[i]);
+			tasks[i] = templateTask;;
+			tasks[i].TaskID = i;
+			threads[i] = std::thread(std::bind(&Resampler::ResampleThreadEntryPoint, this, std::placeholders::_1), &tasks[i]);
 		}
 
 		for (int i = 0; i < totalThreads; i++)
-			fThreads[i].join();
+			threads[i].join();
+
+		const bool isCancelled = params.cancelled != nullptr && *params.cancelled == true;
 
 #if 0
 		for (int i = 0; i < totalThreads; i++)
@@ -168,6 +173,7 @@ namespace OIV
 			).detach();
 		}
 #endif
+		return isCancelled == false;
 	}
 
 
@@ -360,20 +366,44 @@ namespace OIV
 				const size_t endY = task->TaskID == totalThreads - 1 ? targetHeight : (task->TaskID + 1) * (targetHeight / totalThreads);
 
 
-				for (size_t targetY = startY; targetY < endY; targetY++)
-					for (size_t targetX = 0; targetX < targetWidth; targetX++)
-						//while (currentTargetPixel < totalTargetTexels)
-					{
-						//				const size_t targetY = currentTargetPixel / targetWidth;
-										//const size_t targetX = currentTargetPixel - targetY * targetWidth;
-
-						params1.ImageX = static_cast<size_t>((targetX + 0.5) * ratiox + 0.5); // adding 0.5 before casting instead of rounding
-						params1.ImageY = static_cast<size_t>((targetY + 0.5) * ratioy + 0.5); // much faster solution.
+				const std::atomic_bool* cancelled = task->resampleParams.cancelled;
 
-						targetBuffer[targetY * targetWidth + targetX] = GetAverageAt(params1);
-						//targetBuffer[currentTargetPixel] = GetAverageAt(params1);
-						//currentTargetPixel += totalThreads;
+				if (task->resampleParams.filter == ResampleFilter::Nearest)
+				{
+					for (size_t targetY = startY; targetY < endY; targetY++)
+					{
+						if (cancelled != nullptr && *cancelled == true)
+							break;
+
+						const size_t sourceY = std::min(static_cast<size_t>((targetY + 0.5) * ratioy), sourceHeight - 1);
+						const uint32_t* sourceLine = sourceBuffer + sourceY * sourceWidth;
+						uint32_t* targetLine = targetBuffer + targetY * targetWidth;
+						for (size_t targetX = 0; targetX < targetWidth; targetX++)
+							targetLine[targetX] = sourceLine[std::min(static_cast<size_t>((targetX + 0.5) * ratiox), sourceWidth - 1)];
 					}
+				}
+				else
+				{
+					for (size_t targetY = startY; targetY < endY; targetY++)
+					{
+						if (cancelled != nullptr && *cancelled == true)
+							break;
+
+						for (size_t targetX = 0; targetX < targetWidth; targetX++)
+							//while (currentTargetPixel < totalTargetTexels)
+						{
+							//				const size_t targetY = currentTargetPixel / targetWidth;
+											//const size_t targetX = currentTargetPixel - targetY * targetWidth;
+
+							params1.ImageX = static_cast<size_t>((targetX + 0.5) * ratiox + 0.5); // adding 0.5 before casting instead of rounding
+							params1.ImageY = static_cast<size_t>((targetY + 0.5) * ratioy + 0.5); // much faster solution.
+
+							targetBuffer[targetY * targetWidth + targetX] = GetAverageAt(params1);
+							//targetBuffer[currentTargetPixel] = GetAverageAt(params1);
+							//currentTargetPixel += totalThreads;
+						}
+					}
+				}
 
 #if RESAMPLE_THREAD_POOL
 			}
@@ -385,4 +415,223 @@ namespace OIV
 		}
 #endif
 	}
-}
\ No newline at end of file
+
+	namespace
+	{
+		bool IsAxesSwapped(const IMUtil::AxisAlignedTransform& transform)
+		{
+			return transform.rotation == IMUtil::AxisAlignedRotation::Rotate90CW || transform.rotation == IMUtil::AxisAlignedRotation::Rotate90CCW;
+		}
+
+		// Maps a texel of the transformed image to the source image, undoing the flip first as it's applied after rotation.
+		LLUTILS_FORCE_INLINE void TransformedToSource(const ResamplerSource& source, int64_t transformedWidth, int64_t transformedHeight, int64_t& x, int64_t& y)
+		{
+			if ((source.transform.flip & IMUtil::AxisAlignedFlip::Horizontal) == IMUtil::AxisAlignedFlip::Horizontal)
+				x = transformedWidth - 1 - x;
+			if ((source.transform.flip & IMUtil::AxisAlignedFlip::Vertical) == IMUtil::AxisAlignedFlip::Vertical)
+				y = transformedHeight - 1 - y;
+
+			const int64_t tx = x;
+			const int64_t ty = y;
+			switch (source.transform.rotation)
+			{
+			case IMUtil::AxisAlignedRotation::Rotate90CW:
+				x = ty;
+				y = source.height - 1 - tx;
+				break;
+			case IMUtil::AxisAlignedRotation::Rotate90CCW:
+				x = source.width - 1 - ty;
+				y = tx;
+				break;
+			case IMUtil::AxisAlignedRotation::Rotate180:
+				x = source.width - 1 - tx;
+				y = source.height - 1 - ty;
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Channel value scaled to 8 bits.
+		LLUTILS_FORCE_INLINE uint32_t ReadChannel(const std::byte* texel, int32_t offset, uint32_t bytesPerChannel)
+		{
+			if (offset < 0)
+				return 255;
+
+			if (bytesPerChannel == 1)
+				return static_cast<uint32_t>(texel[offset]);
+
+			uint16_t value;
+			std::memcpy(&value, texel + offset, sizeof(value));
+			return value >> 8;
+		}
+	}
+
+	bool Resampler::GetResamplerSource(const IMCodec::Image& image, ResamplerSource& source)
+	{
+		using namespace IMCodec;
+		const TexelInfo& info = image.GetTexelInfo();
+		if (info.texelSize % CHAR_BIT != 0)
+			return false;
+
+		source.channelOffsets = { -1, -1, -1, -1 };
+		source.bytesPerChannel = 0;
+		uint32_t currentPos = 0;
+		for (size_t i = 0; i < info.numChannles; i++)
+		{
+			const auto& channel = info.channles.at(i);
+			const uint32_t position = currentPos;
+			currentPos += channel.width;
+
+			// Padding.
+			if (channel.semantic == ChannelSemantic::None)
+				continue;
+
+			// Monochrome and floating point images are normalized when converted, keep these on the regular path.
+			if (channel.channelDataType != ChannelDataType::UnsignedInt
+				|| (channel.width != 8 && channel.width != 16)
+				|| position % CHAR_BIT != 0
+				|| (source.bytesPerChannel != 0 && source.bytesPerChannel != channel.width / CHAR_BIT))
+				return false;
+
+			int channelIndex;
+			switch (channel.semantic)
+			{
+			case ChannelSemantic::Red:
+				channelIndex = 0;
+				break;
+			case ChannelSemantic::Green:
+				channelIndex = 1;
+				break;
+			case ChannelSemantic::Blue:
+				channelIndex = 2;
+				break;
+			case ChannelSemantic::Opacity:
+				channelIndex = 3;
+				break;
+			default:
+				return false;
+			}
+
+			source.bytesPerChannel = channel.width / CHAR_BIT;
+			source.channelOffsets[channelIndex] = static_cast<int32_t>(position / CHAR_BIT);
+		}
+
+		if (source.channelOffsets[0] < 0 || source.channelOffsets[1] < 0 || source.channelOffsets[2] < 0)
+			return false;
+
+		source.buffer = reinterpret_cast<const std::byte*>(image.GetBuffer());
+		source.width = image.GetWidth();
+		source.height = image.GetHeight();
+		source.rowPitch = image.GetRowPitchInBytes();
+		source.bytesPerTexel = info.texelSize / CHAR_BIT;
+		return true;
+	}
+
+	bool Resampler::ResampleTransformed(const TransformedResamplerParams& params)
+	{
+		Init();
+
+		const ResamplerSource& source = params.source;
+		const bool swapAxes = IsAxesSwapped(source.transform);
+		const uint32_t transformedWidth = swapAxes ? source.height : source.width;
+		const uint32_t transformedHeight = swapAxes ? source.width : source.height;
+
+		const double ratiox = static_cast<double>(transformedWidth) / params.targetWidth;
+		const double ratioy = static_cast<double>(transformedHeight) / params.targetHeight;
+
+		// Same box as the regular resample so both paths produce the same image.
+		const int32_t diffHor = static_cast<int32_t>(std::round(ratiox) / 2.0);
+		const int32_t diffVert = static_cast<int32_t>(std::round(ratioy) / 2.0);
+		ResamplerBox box{ -diffHor,-diffVert, diffHor,diffVert };
+		if (box.right == 0)
+			box.right = 1;
+		if (box.bottom == 0)
+			box.bottom = 1;
+
+		const uint32_t tilesX = (params.targetWidth + TransformedTileSize - 1) / TransformedTileSize;
+		const uint32_t tilesY = (params.targetHeight + TransformedTileSize - 1) / TransformedTileSize;
+		const uint32_t totalTiles = tilesX * tilesY;
+		std::atomic_uint32_t nextTile = 0;
+
+		auto resampleTiles = [&]()
+		{
+			uint32_t tile;
+			while ((params.cancelled == nullptr || *params.cancelled == false) && (tile = nextTile++) < totalTiles)
+				ResampleTransformedTile(params, box, ratiox, ratioy, tile % tilesX, tile / tilesX);
+		};
+
+		const uint32_t totalThreads = std::max(1u, std::min(fNumOfIdealThreadsForResampling, totalTiles));
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < totalThreads; i++)
+			threads.emplace_back(resampleTiles);
+
+		resampleTiles();
+
+		for (auto& thread : threads)
+			thread.join();
+
+		return params.cancelled == nullptr || *params.cancelled == false;
+	}
+
+	void Resampler::ResampleTransformedTile(const TransformedResamplerParams& params, const ResamplerBox& box, double ratioX, double ratioY, uint32_t tileX, uint32_t tileY)
+	{
+		const ResamplerSource& source = params.source;
+		const bool swapAxes = IsAxesSwapped(source.transform);
+		const int64_t transformedWidth = swapAxes ? source.height : source.width;
+		const int64_t transformedHeight = swapAxes ? source.width : source.height;
+
+		const uint32_t startX = tileX * TransformedTileSize;
+		const uint32_t startY = tileY * TransformedTileSize;
+		const uint32_t endX = std::min(startX + TransformedTileSize, params.targetWidth);
+		const uint32_t endY = std::min(startY + TransformedTileSize, params.targetHeight);
+
+		for (uint32_t targetY = startY; targetY < endY; targetY++)
+		{
+			uint8_t* targetLine = reinterpret_cast<uint8_t*>(params.targetBuffer + static_cast<size_t>(targetY) * params.targetWidth);
+			for (uint32_t targetX = startX; targetX < endX; targetX++)
+			{
+				uint8_t* target = targetLine + targetX * 4;
+				if (params.filter == ResampleFilter::Nearest)
+				{
+					int64_t x = std::min(static_cast<int64_t>((targetX + 0.5) * ratioX), transformedWidth - 1);
+					int64_t y = std::min(static_cast<int64_t>((targetY + 0.5) * ratioY), transformedHeight - 1);
+					TransformedToSource(source, transformedWidth, transformedHeight, x, y);
+					const std::byte* texel = source.buffer + y * source.rowPitch + x * source.bytesPerTexel;
+					for (int c = 0; c < 4; c++)
+						target[c] = static_cast<uint8_t>(ReadChannel(texel, source.channelOffsets[c], source.bytesPerChannel));
+					continue;
+				}
+
+				// Box in transformed space, an axis aligned transform maps it to a box in source space
+				// which is then read row by row regardless of rotation.
+				const int64_t centerX = static_cast<int64_t>((targetX + 0.5) * ratioX + 0.5);
+				const int64_t centerY = static_cast<int64_t>((targetY + 0.5) * ratioY + 0.5);
+				int64_t x0 = std::clamp<int64_t>(centerX + box.left, 0, transformedWidth - 1);
+				int64_t y0 = std::clamp<int64_t>(centerY + box.top, 0, transformedHeight - 1);
+				int64_t x1 = std::clamp<int64_t>(centerX + box.right - 1, x0, transformedWidth - 1);
+				int64_t y1 = std::clamp<int64_t>(centerY + box.bottom - 1, y0, transformedHeight - 1);
+				TransformedToSource(source, transformedWidth, transformedHeight, x0, y0);
+				TransformedToSource(source, transformedWidth, transformedHeight, x1, y1);
+
+				const int64_t sourceXStart = std::min(x0, x1);
+				const int64_t sourceXEnd = std::max(x0, x1) + 1;
+				const int64_t sourceYStart = std::min(y0, y1);
+				const int64_t sourceYEnd = std::max(y0, y1) + 1;
+
+				uint64_t accum[4]{};
+				for (int64_t sourceY = sourceYStart; sourceY < sourceYEnd; sourceY++)
+				{
+					const std::byte* texel = source.buffer + sourceY * source.rowPitch + sourceXStart * source.bytesPerTexel;
+					for (int64_t sourceX = sourceXStart; sourceX < sourceXEnd; sourceX++, texel += source.bytesPerTexel)
+						for (int c = 0; c < 4; c++)
+							accum[c] += ReadChannel(texel, source.channelOffsets[c], source.bytesPerChannel);
+				}
+
+				const uint64_t totalTexels = static_cast<uint64_t>(sourceXEnd - sourceXStart) * static_cast<uint64_t>(sourceYEnd - sourceYStart);
+				for (int c = 0; c < 4; c++)
+					target[c] = static_cast<uint8_t>(accum[c] / totalTexels);
+			}
+		}
+	}
+}
@@ -2,6 +2,12 @@
 #include <cstdint>
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <cstddef>
+#include <Image.h>
+#include <ImageUtil/AxisAlignedTransform.h>
 namespace std
 {
 	class thread;
@@ -19,6 +25,12 @@ namespace OIV
 		int32_t right;
 	};
 
+	enum class ResampleFilter
+	{
+		  Box		// average of the source texels covered by a target texel
+		, Nearest	// nearest source texel, cheap enough for interactive previews
+	};
+
 	struct ResamplerParams
 	{
 		uint32_t* targetBuffer;
@@ -27,6 +39,35 @@ namespace OIV
 		const uint32_t* sourceBuffer;
 		uint32_t sourceWidth;
 		uint32_t sourceHeight;
+		ResampleFilter filter = ResampleFilter::Box;
+		// When set, resampling stops once the flag is raised.
+		const std::atomic_bool* cancelled = nullptr;
+	};
+
+	// Unsigned integer source image read directly by a transformed resample, channels are 8 or 16 bits wide and byte aligned.
+	struct ResamplerSource
+	{
+		const std::byte* buffer;
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;
+		uint32_t bytesPerTexel;
+		uint32_t bytesPerChannel;
+		// Byte offsets of the red, green, blue and opacity channels in a texel, -1 if missing.
+		std::array<int32_t, 4> channelOffsets;
+		// Applied to the source before resampling, flip is applied after rotation.
+		IMUtil::AxisAlignedTransform transform;
+	};
+
+	struct TransformedResamplerParams
+	{
+		// R8G8B8A8 texels.
+		uint32_t* targetBuffer;
+		uint32_t targetWidth;
+		uint32_t targetHeight;
+		ResamplerSource source;
+		ResampleFilter filter = ResampleFilter::Box;
+		const std::atomic_bool* cancelled = nullptr;
 	};
 
 	struct AverageParams
@@ -63,18 +104,25 @@ namespace OIV
 	{
 
 	public:
-		void Resample(const ResamplerParams& params);
+		// Safe to call from multiple threads, returns false if resampling has been cancelled.
+		bool Resample(const ResamplerParams& params);
+		// Reads the source through its transform, converts and resamples in a single pass, no intermediate image is created.
+		bool ResampleTransformed(const TransformedResamplerParams& params);
+		// Returns false if the texel format of 'image' can't be read by ResampleTransformed.
+		static bool GetResamplerSource(const IMCodec::Image& image, ResamplerSource& source);
 	private: // memeber functions
 		void Init();
 		uint32_t GetAverageAt(const AverageParams& params);
 		void ResampleThreadEntryPoint(ResampleTask* task);
+		void ResampleTransformedTile(const TransformedResamplerParams& params, const ResamplerBox& box, double ratioX, double ratioY, uint32_t tileX, uint32_t tileY);
+
+		// Target texels are resampled in square tiles so the source region read by a thread stays small.
+		static constexpr uint32_t TransformedTileSize = 64;
 
 
 
 	private: // memeber fields
-		std::vector<std::thread> fThreads;
-		std::vector<ResampleTask> fTasks;
 		uint32_t fNumOfIdealThreadsForResampling = 1;
-		bool fInitialized = false;
+		std::once_flag fInitialized;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <Text/GlyphAtlasCache.h>
+#include <Memory/ImageItemPool.h>
+#include <cstring>
+#include <string_view>
+
+namespace OIV
+{
+    GlyphAtlasCache::GlyphAtlasCache(FreeType::FreeTypeConnector* freeType) : fFreeType(freeType)
+    {
+
+    }
+
+    void GlyphAtlasCache::Clear()
+    {
+        fAtlases.clear();
+    }
+
+    bool GlyphAtlasCache::IsSameConfiguration(const FreeType::TextCreateParams& a, const FreeType::TextCreateParams& b)
+    {
+        return !(a.fontPath != b.fontPath
+            || a.fontSize != b.fontSize
+            || a.DPIx != b.DPIx
+            || a.DPIy != b.DPIy
+            || a.renderMode != b.renderMode
+            || a.flags != b.flags
+            || a.outlineWidth != b.outlineWidth
+            || a.outlineColor != b.outlineColor
+            || a.textColor != b.textColor
+            || a.backgroundColor != b.backgroundColor);
+    }
+
+    bool GlyphAtlasCache::SplitGlyphs(const std::wstring& text, bool useMetaText, std::vector<std::wstring>& glyphs)
+    {
+        static constexpr std::wstring_view ColorTag = L"<textcolor=";
+        std::wstring currentTag;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const wchar_t ch = text[i];
+            if (ch == L'<' && useMetaText)
+            {
+                // Only color tags are carried per glyph, any other tag affects the layout.
+                const size_t tagEnd = text.find(L'>', i);
+                if (tagEnd == std::wstring::npos || std::wstring_view(text).substr(i).starts_with(ColorTag) == false)
+                    return false;
+
+                currentTag = text.substr(i, tagEnd - i + 1);
+                i = tagEnd;
+                continue;
+            }
+
+            // Control characters and scripts which may need shaping or bidirectional layout.
+            if (ch < 0x20 || ch > 0xFF)
+                return false;
+
+            glyphs.push_back(currentTag + ch);
+        }
+        return glyphs.empty() == false;
+    }
+
+    GlyphAtlasCache::Atlas& GlyphAtlasCache::GetAtlas(const FreeType::TextCreateParams& createParams)
+    {
+        for (auto it = fAtlases.begin(); it != fAtlases.end(); ++it)
+        {
+            if (IsSameConfiguration(it->params, createParams))
+            {
+                fAtlases.splice(fAtlases.end(), fAtlases, it);
+                return fAtlases.back();
+            }
+        }
+
+        if (fAtlases.size() >= MaxAtlases)
+            fAtlases.pop_front();
+
+        Atlas& atlas = fAtlases.emplace_back();
+        atlas.params = createParams;
+        atlas.params.text.clear();
+        atlas.params.maxWidthPx = 0;
+        return atlas;
+    }
+
+    int32_t GlyphAtlasCache::GetGlyph(Atlas& atlas, const std::wstring& glyphText)
+    {
+        auto it = atlas.glyphs.find(glyphText);
+        if (it != atlas.glyphs.end())
+            return it->second;
+
+        if (atlas.glyphs.size() >= MaxGlyphsPerAtlas)
+            return -1;
+
+        const size_t cellRowSize = atlas.cellWidth * 4;
+        const size_t cellSize = cellRowSize * atlas.cellHeight;
+        const int32_t cellIndex = static_cast<int32_t>(atlas.cells.size() / cellSize);
+
+        FreeType::TextCreateParams params = atlas.params;
+        params.text = glyphText;
+        FreeType::FreeTypeConnector::Bitmap bitmap;
+        fFreeType->CreateBitmap(params, bitmap, nullptr);
+
+        if (bitmap.width == atlas.cellWidth && bitmap.height == atlas.cellHeight)
+        {
+            atlas.cells.resize(atlas.cells.size() + cellSize);
+            std::byte* cell = atlas.cells.data() + cellIndex * cellSize;
+            const std::byte* source = reinterpret_cast<const std::byte*>(bitmap.buffer.data());
+            for (uint32_t y = 0; y < atlas.cellHeight; y++)
+                std::memcpy(cell + y * cellRowSize, source + y * bitmap.rowPitch, cellRowSize);
+        }
+        else if (glyphText.back() == L' ')
+        {
+            // A lone space may be trimmed by the rasterizer, its cell is background only.
+            const LLUtils::Color& color = atlas.params.backgroundColor;
+            const std::byte texel[4] = { std::byte{ color.R }, std::byte{ color.G }, std::byte{ color.B }, std::byte{ color.A } };
+            atlas.cells.resize(atlas.cells.size() + cellSize);
+            std::byte* cell = atlas.cells.data() + cellIndex * cellSize;
+            for (size_t i = 0; i < cellSize; i += 4)
+                std::memcpy(cell + i, texel, 4);
+        }
+        else
+        {
+            atlas.glyphs.emplace(glyphText, -1);
+            return -1;
+        }
+
+        atlas.glyphs.emplace(glyphText, cellIndex);
+        return cellIndex;
+    }
+
+    void GlyphAtlasCache::Calibrate(Atlas& atlas)
+    {
+        atlas.order = CompositionOrder::Disabled;
+
+        FreeType::TextCreateParams params = atlas.params;
+        auto rasterize = [&](const wchar_t* text, FreeType::FreeTypeConnector::Bitmap& bitmap)
+        {
+            params.text = text;
+            fFreeType->CreateBitmap(params, bitmap, nullptr);
+            return bitmap.width != 0 && bitmap.height != 0;
+        };
+
+        // The cell is the bounds of a single glyph, the advance is what a second glyph adds to it.
+        FreeType::FreeTypeConnector::Bitmap single;
+        FreeType::FreeTypeConnector::Bitmap pair;
+        if (rasterize(L"0", single) == false || rasterize(L"00", pair) == false
+            || pair.height != single.height || pair.width <= single.width || pair.width - single.width > single.width)
+            return;
+
+        atlas.advance = pair.width - single.width;
+        atlas.cellWidth = single.width;
+        atlas.cellHeight = single.height;
+
+        FreeType::FreeTypeConnector::Bitmap reference;
+        if (rasterize(CalibrationText, reference) == false || reference.height != atlas.cellHeight)
+            return;
+
+        std::vector<std::wstring> glyphTexts;
+        SplitGlyphs(CalibrationText, false, glyphTexts);
+        std::vector<int32_t> cells;
+        if (GetGlyphs(atlas, glyphTexts, cells) == false)
+            return;
+
+        // Use the composition order which reproduces the fully rasterized text exactly, if any.
+        for (CompositionOrder order : { CompositionOrder::Forward, CompositionOrder::Backward })
+        {
+            IMCodec::ImageSharedPtr composed = Compose(atlas, cells, order);
+            if (composed->GetWidth() != reference.width)
+                return;
+
+            const size_t rowSize = reference.width * 4;
+            bool identical = true;
+            const std::byte* referenceBuffer = reinterpret_cast<const std::byte*>(reference.buffer.data());
+            for (uint32_t y = 0; y < reference.height && identical; y++)
+                identical = std::memcmp(composed->GetBufferAt(0, y), referenceBuffer + y * reference.rowPitch, rowSize) == 0;
+
+            if (identical)
+            {
+                atlas.order = order;
+                return;
+            }
+        }
+    }
+
+    bool GlyphAtlasCache::GetGlyphs(Atlas& atlas, const std::vector<std::wstring>& glyphTexts, std::vector<int32_t>& cells)
+    {
+        cells.reserve(glyphTexts.size());
+        for (const std::wstring& glyphText : glyphTexts)
+        {
+            const int32_t cell = GetGlyph(atlas, glyphText);
+            if (cell < 0)
+                return false;
+            cells.push_back(cell);
+        }
+        return true;
+    }
+
+    void GlyphAtlasCache::BlitCell(const Atlas& atlas, int32_t cell, size_t position, uint32_t firstColumn, uint32_t endColumn, std::byte* target, size_t rowPitch)
+    {
+        const size_t cellRowSize = atlas.cellWidth * 4;
+        const std::byte* source = atlas.cells.data() + cell * cellRowSize * atlas.cellHeight + firstColumn * 4;
+        std::byte* cellTarget = target + (position * atlas.advance + firstColumn) * 4;
+        const size_t size = (endColumn - firstColumn) * 4;
+        for (uint32_t y = 0; y < atlas.cellHeight; y++)
+            std::memcpy(cellTarget + y * rowPitch, source + y * cellRowSize, size);
+    }
+
+    void GlyphAtlasCache::BlitCells(const Atlas& atlas, const std::vector<int32_t>& cells, CompositionOrder order, std::byte* target, size_t rowPitch)
+    {
+        const size_t numCells = cells.size();
+        for (size_t n = 0; n < numCells; n++)
+        {
+            const size_t i = order == CompositionOrder::Forward ? n : numCells - 1 - n;
+            BlitCell(atlas, cells[i], i, 0, atlas.cellWidth, target, rowPitch);
+        }
+    }
+
+    IMCodec::ImageSharedPtr GlyphAtlasCache::Compose(const Atlas& atlas, const std::vector<int32_t>& cells, CompositionOrder order) const
+    {
+        using namespace IMCodec;
+        const uint32_t width = static_cast<uint32_t>(cells.size()) * atlas.advance + (atlas.cellWidth - atlas.advance);
+        const uint32_t height = atlas.cellHeight;
+        const size_t rowPitch = width * 4;
+
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(rowPitch * height);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = width;
+        desc.height = height;
+        desc.rowPitchInBytes = static_cast<uint32_t>(rowPitch);
+        desc.texelFormatDecompressed = TexelFormat::I_R8_G8_B8_A8;
+        desc.texelFormatStorage = TexelFormat::I_R8_G8_B8_A8;
+        imageItem->itemType = ImageItemType::Image;
+
+        BlitCells(atlas, cells, order, reinterpret_cast<std::byte*>(imageItem->data.data()), rowPitch);
+        return std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+    }
+
+    bool GlyphAtlasCache::Update(const FreeType::TextCreateParams& createParams, const FreeType::TextCreateParams& previousParams, IMCodec::Image& image)
+    {
+        using namespace FreeType;
+        if (fFreeType == nullptr || IsSameConfiguration(createParams, previousParams) == false)
+            return false;
+
+        const bool useMetaText = (createParams.flags & TextCreateFlags::UseMetaText) == TextCreateFlags::UseMetaText;
+        std::vector<std::wstring> glyphTexts;
+        std::vector<std::wstring> previousGlyphTexts;
+        if (SplitGlyphs(createParams.text, useMetaText, glyphTexts) == false
+            || SplitGlyphs(previousParams.text, useMetaText, previousGlyphTexts) == false
+            || glyphTexts.size() != previousGlyphTexts.size())
+            return false;
+
+        Atlas& atlas = GetAtlas(createParams);
+        if (atlas.order == CompositionOrder::Unknown)
+            Calibrate(atlas);
+
+        if (atlas.order == CompositionOrder::Disabled
+            || image.GetWidth() != glyphTexts.size() * atlas.advance + (atlas.cellWidth - atlas.advance)
+            || image.GetHeight() != atlas.cellHeight
+            || (createParams.maxWidthPx > 0 && image.GetWidth() > static_cast<uint32_t>(createParams.maxWidthPx)))
+            return false;
+
+        std::vector<int32_t> cells;
+        if (GetGlyphs(atlas, glyphTexts, cells) == false)
+            return false;
+
+        // Cells overlap their neighbours, blit only the columns of a changed cell which are not covered by a neighbour in the composition order.
+        std::byte* target = const_cast<std::byte*>(image.GetBufferAt(0, 0));
+        const size_t numCells = cells.size();
+        for (size_t i = 0; i < numCells; i++)
+        {
+            if (glyphTexts[i] == previousGlyphTexts[i])
+                continue;
+
+            uint32_t firstColumn = 0;
+            uint32_t endColumn = atlas.cellWidth;
+            if (atlas.order == CompositionOrder::Forward && i + 1 < numCells)
+                endColumn = atlas.advance;
+            else if (atlas.order == CompositionOrder::Backward && i > 0)
+                firstColumn = atlas.cellWidth - atlas.advance;
+
+            BlitCell(atlas, cells[i], i, firstColumn, endColumn, target, image.GetRowPitchInBytes());
+        }
+
+        return true;
+    }
+
+    IMCodec::ImageSharedPtr GlyphAtlasCache::Compose(const FreeType::TextCreateParams& createParams)
+    {
+        using namespace FreeType;
+        if (fFreeType == nullptr)
+            return nullptr;
+
+        const bool useMetaText = (createParams.flags & TextCreateFlags::UseMetaText) == TextCreateFlags::UseMetaText;
+        std::vector<std::wstring> glyphTexts;
+        if (SplitGlyphs(createParams.text, useMetaText, glyphTexts) == false)
+            return nullptr;
+
+        Atlas& atlas = GetAtlas(createParams);
+        if (atlas.order == CompositionOrder::Unknown)
+            Calibrate(atlas);
+
+        if (atlas.order == CompositionOrder::Disabled)
+            return nullptr;
+
+        // Text wider than the maximum width would be wrapped.
+        const uint64_t width = glyphTexts.size() * atlas.advance + (atlas.cellWidth - atlas.advance);
+        if (createParams.maxWidthPx > 0 && width > static_cast<uint64_t>(createParams.maxWidthPx))
+            return nullptr;
+
+        std::vector<int32_t> cells;
+        if (GetGlyphs(atlas, glyphTexts, cells) == false)
+            return nullptr;
+
+        return Compose(atlas, cells, atlas.order);
+    }
+}
@@ -0,0 +1,395 @@
+#include <Transform/AxisAlignedTransformer.h>
+#include <Memory/ImageItemPool.h>
+#include <ImageUtil/ImageUtil.h>
+#include <System.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OIV_TRANSFORM_SSE2 1
+#else
+#define OIV_TRANSFORM_SSE2 0
+#endif
+
+namespace OIV
+{
+    namespace
+    {
+        struct Texel24
+        {
+            uint8_t channels[3];
+        };
+
+        struct Texel128
+        {
+            uint64_t channels[2];
+        };
+
+        // Every axis aligned transform reads target texel (x, y) from source texel (SourceX(y), SourceY(x)) when the axes are swapped,
+        // and from (SourceX(x), SourceY(y)) otherwise, where each source coordinate may run backwards.
+        struct Mapping
+        {
+            bool swapAxes;
+            bool reverseX;
+            bool reverseY;
+        };
+
+        struct Surface
+        {
+            std::byte* buffer;
+            size_t width;
+            size_t height;
+            size_t rowPitch;
+        };
+
+        constexpr size_t TileSize = 32;
+        // Below this size spawning threads costs more than it saves.
+        constexpr size_t MinParallelBytes = 4 * 1024 * 1024;
+
+        Mapping GetMapping(const IMUtil::AxisAlignedTransform& transform)
+        {
+            Mapping mapping{};
+            switch (transform.rotation)
+            {
+            case IMUtil::AxisAlignedRotation::Rotate90CW:
+                mapping.swapAxes = true;
+                mapping.reverseY = true;
+                break;
+            case IMUtil::AxisAlignedRotation::Rotate90CCW:
+                mapping.swapAxes = true;
+                mapping.reverseX = true;
+                break;
+            case IMUtil::AxisAlignedRotation::Rotate180:
+                mapping.reverseX = true;
+                mapping.reverseY = true;
+                break;
+            default:
+                break;
+            }
+
+            // Flip is applied after rotation, with swapped axes the target x axis runs along the source y axis.
+            const bool horizontal = (transform.flip & IMUtil::AxisAlignedFlip::Horizontal) == IMUtil::AxisAlignedFlip::Horizontal;
+            const bool vertical = (transform.flip & IMUtil::AxisAlignedFlip::Vertical) == IMUtil::AxisAlignedFlip::Vertical;
+            if (mapping.swapAxes)
+            {
+                mapping.reverseY ^= horizontal;
+                mapping.reverseX ^= vertical;
+            }
+            else
+            {
+                mapping.reverseX ^= horizontal;
+                mapping.reverseY ^= vertical;
+            }
+            return mapping;
+        }
+
+        uint32_t GetNumThreads(size_t totalBytes, size_t tasks)
+        {
+            static const uint32_t sNumThreads = std::max(System::GetIdealNumThreadsForMemoryOperations(), 1u);
+            return totalBytes < MinParallelBytes ? 1 : static_cast<uint32_t>(std::min<size_t>(sNumThreads, tasks));
+        }
+
+        // Calls 'task(index)' for every index in [0, numTasks) over the memory operation threads.
+        template <typename Task>
+        void ParallelFor(size_t numTasks, size_t totalBytes, Task task)
+        {
+            std::atomic_size_t nextTask = 0;
+            auto worker = [&]()
+            {
+                size_t index;
+                while ((index = nextTask++) < numTasks)
+                    task(index);
+            };
+
+            std::vector<std::thread> threads;
+            const uint32_t numThreads = GetNumThreads(totalBytes, numTasks);
+            for (uint32_t i = 1; i < numThreads; i++)
+                threads.emplace_back(worker);
+
+            worker();
+
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        template <typename Texel>
+        constexpr size_t GetBlockSize()
+        {
+#if OIV_TRANSFORM_SSE2
+            if constexpr (sizeof(Texel) == 4)
+                return 4;
+            else if constexpr (sizeof(Texel) == 8)
+                return 2;
+#endif
+            return 1;
+        }
+
+        template <typename Texel>
+        class SwappedAxesTransform
+        {
+        public:
+            SwappedAxesTransform(const Surface& source, const Surface& target, const Mapping& mapping)
+                : fSource(source), fTarget(target), fMapping(mapping) {}
+
+            void TransformTile(size_t x0, size_t y0, size_t x1, size_t y1) const
+            {
+                constexpr size_t blockSize = GetBlockSize<Texel>();
+                size_t y = y0;
+                if constexpr (blockSize > 1)
+                {
+                    for (; y + blockSize <= y1; y += blockSize)
+                    {
+                        size_t x = x0;
+                        for (; x + blockSize <= x1; x += blockSize)
+                            TransposeBlock(x, y);
+
+                        TransformRect(x, y, x1, y + blockSize);
+                    }
+                }
+                TransformRect(x0, y, x1, y1);
+            }
+
+        private:
+            size_t SourceX(size_t targetY) const { return fMapping.reverseX ? fSource.width - 1 - targetY : targetY; }
+            size_t SourceY(size_t targetX) const { return fMapping.reverseY ? fSource.height - 1 - targetX : targetX; }
+            const Texel* SourceRow(size_t targetX) const { return reinterpret_cast<const Texel*>(fSource.buffer + SourceY(targetX) * fSource.rowPitch); }
+            Texel* TargetRow(size_t targetY) const { return reinterpret_cast<Texel*>(fTarget.buffer + targetY * fTarget.rowPitch); }
+
+            void TransformRect(size_t x0, size_t y0, size_t x1, size_t y1) const
+            {
+                // Each source row fills a column of the target, the target rows of a tile stay in cache meanwhile.
+                for (size_t x = x0; x < x1; x++)
+                {
+                    const Texel* sourceRow = SourceRow(x);
+                    for (size_t y = y0; y < y1; y++)
+                        TargetRow(y)[x] = sourceRow[SourceX(y)];
+                }
+            }
+
+            void TransposeBlock([[maybe_unused]] size_t x, [[maybe_unused]] size_t y) const
+            {
+#if OIV_TRANSFORM_SSE2
+                // Target texels (x .. x + n, y .. y + n) are read from n consecutive texels of n source rows.
+                const size_t sourceX = fMapping.reverseX ? SourceX(y + GetBlockSize<Texel>() - 1) : SourceX(y);
+                if constexpr (sizeof(Texel) == 4)
+                {
+                    __m128i rows[4];
+                    for (size_t i = 0; i < 4; i++)
+                    {
+                        rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SourceRow(x + i) + sourceX));
+                        if (fMapping.reverseX)
+                            rows[i] = _mm_shuffle_epi32(rows[i], _MM_SHUFFLE(0, 1, 2, 3));
+                    }
+
+                    const __m128i t0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+                    const __m128i t1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+                    const __m128i t2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+                    const __m128i t3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 0) + x), _mm_unpacklo_epi64(t0, t1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 1) + x), _mm_unpackhi_epi64(t0, t1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 2) + x), _mm_unpacklo_epi64(t2, t3));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 3) + x), _mm_unpackhi_epi64(t2, t3));
+                }
+                else if constexpr (sizeof(Texel) == 8)
+                {
+                    __m128i rows[2];
+                    for (size_t i = 0; i < 2; i++)
+                    {
+                        rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SourceRow(x + i) + sourceX));
+                        if (fMapping.reverseX)
+                            rows[i] = _mm_shuffle_epi32(rows[i], _MM_SHUFFLE(1, 0, 3, 2));
+                    }
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 0) + x), _mm_unpacklo_epi64(rows[0], rows[1]));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(TargetRow(y + 1) + x), _mm_unpackhi_epi64(rows[0], rows[1]));
+                }
+#endif
+            }
+
+            const Surface& fSource;
+            const Surface& fTarget;
+            const Mapping& fMapping;
+        };
+
+        template <typename Texel>
+        void TransformSwappedAxes(const Surface& source, const Surface& target, const Mapping& mapping)
+        {
+            const SwappedAxesTransform<Texel> transform(source, target, mapping);
+            const size_t tilesX = (target.width + TileSize - 1) / TileSize;
+            const size_t tilesY = (target.height + TileSize - 1) / TileSize;
+            ParallelFor(tilesX * tilesY, target.height * target.rowPitch, [&](size_t tile)
+                {
+                    const size_t x0 = (tile % tilesX) * TileSize;
+                    const size_t y0 = (tile / tilesX) * TileSize;
+                    transform.TransformTile(x0, y0, std::min(x0 + TileSize, target.width), std::min(y0 + TileSize, target.height));
+                });
+        }
+
+        template <typename Texel>
+        void CopyRow(const Texel* source, Texel* target, size_t width, bool reverse)
+        {
+            if (reverse == false)
+                std::memcpy(target, source, width * sizeof(Texel));
+            else
+                for (size_t x = 0; x < width; x++)
+                    target[x] = source[width - 1 - x];
+        }
+
+        template <typename Texel>
+        void TransformKeptAxes(const Surface& source, const Surface& target, const Mapping& mapping)
+        {
+            ParallelFor(target.height, target.height * target.rowPitch, [&](size_t y)
+                {
+                    const size_t sourceY = mapping.reverseY ? source.height - 1 - y : y;
+                    CopyRow(reinterpret_cast<const Texel*>(source.buffer + sourceY * source.rowPitch)
+                        , reinterpret_cast<Texel*>(target.buffer + y * target.rowPitch), target.width, mapping.reverseX);
+                });
+        }
+
+        template <typename Texel>
+        void TransformKeptAxesInPlace(const Surface& surface, const Mapping& mapping)
+        {
+            const size_t width = surface.width;
+            auto row = [&](size_t y) { return reinterpret_cast<Texel*>(surface.buffer + y * surface.rowPitch); };
+
+            if (mapping.reverseY)
+            {
+                // Swap the rows of each pair, reversing them on the way if needed, an odd middle row is only reversed.
+                const size_t pairs = (surface.height + 1) / 2;
+                ParallelFor(pairs, surface.height * surface.rowPitch, [&](size_t y)
+                    {
+                        Texel* top = row(y);
+                        Texel* bottom = row(surface.height - 1 - y);
+                        if (top == bottom)
+                        {
+                            if (mapping.reverseX)
+                                std::reverse(top, top + width);
+                        }
+                        else if (mapping.reverseX)
+                        {
+                            for (size_t x = 0; x < width; x++)
+                                std::swap(top[x], bottom[width - 1 - x]);
+                        }
+                        else
+                        {
+                            std::swap_ranges(top, top + width, bottom);
+                        }
+                    });
+            }
+            else if (mapping.reverseX)
+            {
+                ParallelFor(surface.height, surface.height * surface.rowPitch, [&](size_t y)
+                    {
+                        std::reverse(row(y), row(y) + width);
+                    });
+            }
+        }
+
+        // Calls 'func.template operator()<Texel>()' with a texel type of 'bytesPerTexel' bytes, returns false if there's none.
+        template <typename Func>
+        bool DispatchTexelSize(size_t bytesPerTexel, Func&& func)
+        {
+            switch (bytesPerTexel)
+            {
+            case 1:
+                func.template operator()<uint8_t>();
+                return true;
+            case 2:
+                func.template operator()<uint16_t>();
+                return true;
+            case 3:
+                func.template operator()<Texel24>();
+                return true;
+            case 4:
+                func.template operator()<uint32_t>();
+                return true;
+            case 8:
+                func.template operator()<uint64_t>();
+                return true;
+            case 16:
+                func.template operator()<Texel128>();
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool IsSupported(const IMCodec::Image& image)
+        {
+            if (image.GetItemType() == IMCodec::ImageItemType::Container || image.GetNumSubImages() > 0)
+                return false;
+
+            const size_t bitsPerTexel = image.GetBitsPerTexel();
+            return bitsPerTexel % CHAR_BIT == 0 && DispatchTexelSize(bitsPerTexel / CHAR_BIT, []<typename Texel>() {});
+        }
+
+        Surface GetSurface(const IMCodec::Image& image)
+        {
+            return { const_cast<std::byte*>(image.GetBuffer()), image.GetWidth(), image.GetHeight(), image.GetRowPitchInBytes() };
+        }
+
+        bool IsIdentity(const IMUtil::AxisAlignedTransform& transform)
+        {
+            return transform.rotation == IMUtil::AxisAlignedRotation::None && transform.flip == IMUtil::AxisAlignedFlip::None;
+        }
+    }
+
+    IMCodec::ImageSharedPtr AxisAlignedTransformer::Transform(const IMUtil::AxisAlignedTransform& transform, IMCodec::ImageSharedPtr image)
+    {
+        using namespace IMCodec;
+        if (IsIdentity(transform))
+            return image;
+
+        if (IsSupported(*image) == false)
+            return IMUtil::ImageUtil::Transform(transform, image);
+
+        const Mapping mapping = GetMapping(transform);
+        const size_t bytesPerTexel = image->GetBitsPerTexel() / CHAR_BIT;
+        const uint32_t width = mapping.swapAxes ? image->GetHeight() : image->GetWidth();
+        const uint32_t height = mapping.swapAxes ? image->GetWidth() : image->GetHeight();
+
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(static_cast<size_t>(width) * height * bytesPerTexel);
+        imageItem->itemType = ImageItemType::Image;
+        imageItem->processData = image->GetProcessData();
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.width = width;
+        desc.height = height;
+        desc.rowPitchInBytes = static_cast<uint32_t>(width * bytesPerTexel);
+        desc.texelFormatDecompressed = image->GetTexelFormat();
+        desc.texelFormatStorage = image->GetOriginalTexelFormat();
+        ImageSharedPtr transformed = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
+
+        const Surface source = GetSurface(*image);
+        const Surface target = GetSurface(*transformed);
+        DispatchTexelSize(bytesPerTexel, [&]<typename Texel>()
+            {
+                if (mapping.swapAxes)
+                    TransformSwappedAxes<Texel>(source, target, mapping);
+                else
+                    TransformKeptAxes<Texel>(source, target, mapping);
+            });
+
+        return transformed;
+    }
+
+    void AxisAlignedTransformer::TransformInPlace(const IMUtil::AxisAlignedTransform& transform, IMCodec::ImageSharedPtr& image)
+    {
+        const Mapping mapping = GetMapping(transform);
+        if (mapping.swapAxes || image.use_count() > 1 || IsSupported(*image) == false)
+        {
+            image = Transform(transform, image);
+            return;
+        }
+
+        const Surface surface = GetSurface(*image);
+        DispatchTexelSize(image->GetBitsPerTexel() / CHAR_BIT, [&]<typename Texel>()
+            {
+                TransformKeptAxesInPlace<Texel>(surface, mapping);
+            });
+    }
+}
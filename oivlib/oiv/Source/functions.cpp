@@ -7,6 +7,18 @@ ResultCode OIV_Execute(int command, std::size_t requestSize, void* requestData,
     return OIV::Execute_impl(static_cast<CommandExecute>(command), requestSize, requestData, responseSize, responseData);
 }
 
+ResultCode OIV_ExecuteAsync(int command, std::size_t requestSize, const void* requestData, std::size_t responseSize, OIV_AsyncTicket* ticket)
+{
+    //Call the c++ implementation
+    return OIV::ExecuteAsync_impl(command, requestSize, requestData, responseSize, ticket);
+}
+
+ResultCode OIV_CancelAsync(OIV_AsyncTicket ticket)
+{
+    //Call the c++ implementation
+    return OIV::CancelAsync_impl(ticket);
+}
+
 ResultCode OIV_Util_GetBPPFromTexelFormat(OIV_TexelFormat in_texelFormat, uint8_t* out_bpp)
 {
     //Call the c++ implementation
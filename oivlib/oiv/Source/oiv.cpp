@@ -9,6 +9,10 @@
 #include <functions.h>
 #include <Version.h>
 #include "Interfaces/IRendererDefs.h"
+#include <FileSignature/ImageHeaderProbe.h>
+#include <Memory/ImageItemPool.h>
+#include <Transform/AxisAlignedTransformer.h>
+#include <Readback/TexelReadback.h>
 
 #if OIV_BUILD_RENDERER_D3D11 == 1
 #include <OIVD3D11RendererFactory.h>
@@ -96,7 +100,7 @@ namespace OIV
         LL_EXCEPTION(LLUtils::Exception::ErrorCode::BadParameters, "Bad build configuration");
     }
 
-    IMCodec::ImageSharedPtr OIV::Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize)
+    IMCodec::ImageSharedPtr OIV::Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize, ResampleFilter filter, const std::atomic_bool* cancelled)
     {
 
         const uint32_t width = targetSize.x;
@@ -104,15 +108,14 @@ namespace OIV
 
 
         using namespace IMCodec;
-        //Create target downscaled image.
-        ImageItemSharedPtr imageItem = std::make_shared<ImageItem>();
+        //Create target downscaled image, successive resamples of similar size reuse the same buffers.
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(width * height * sourceImage->GetBytesPerTexel());
         ImageDescriptor& desc = imageItem->descriptor;
         desc.height = height;
         desc.width = width;
         desc.rowPitchInBytes = width * sourceImage->GetBytesPerTexel();
         desc.texelFormatDecompressed = sourceImage->GetTexelFormat();
         desc.texelFormatStorage = sourceImage->GetOriginalTexelFormat();
-        imageItem->data.Allocate(width * height * sourceImage->GetBytesPerTexel());
         
         ImageSharedPtr resampled = std::make_shared<IMCodec::Image>(imageItem,ImageItemType::Unknown);
         ResamplerParams params;
@@ -122,10 +125,41 @@ namespace OIV
         params.targetBuffer = const_cast<uint32_t*>(reinterpret_cast<const uint32_t*>(resampled->GetBufferAt(0, 0)));
         params.targetWidth = width;
         params.targetHeight = height;
+        params.filter = filter;
+        params.cancelled = cancelled;
 
-        fResampler.Resample(params);
+        return fResampler.Resample(params) ? resampled : nullptr;
+    }
+
+    IMCodec::ImageSharedPtr OIV::ResampleTransformed(IMCodec::ImageSharedPtr sourceImage, const IMUtil::AxisAlignedTransform& transform
+        , LLUtils::PointI32 targetSize, ResampleFilter filter, const std::atomic_bool* cancelled)
+    {
+        using namespace IMCodec;
+        TransformedResamplerParams params;
+        if (Resampler::GetResamplerSource(*sourceImage, params.source) == false)
+            return nullptr;
+
+        const uint32_t width = targetSize.x;
+        const uint32_t height = targetSize.y;
+        constexpr uint32_t targetBytesPerTexel = 4;
 
-        return resampled;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(width * height * targetBytesPerTexel);
+        ImageDescriptor& desc = imageItem->descriptor;
+        desc.height = height;
+        desc.width = width;
+        desc.rowPitchInBytes = width * targetBytesPerTexel;
+        desc.texelFormatDecompressed = TexelFormat::I_R8_G8_B8_A8;
+        desc.texelFormatStorage = sourceImage->GetOriginalTexelFormat();
+
+        ImageSharedPtr resampled = std::make_shared<IMCodec::Image>(imageItem, ImageItemType::Unknown);
+        params.source.transform = transform;
+        params.targetBuffer = const_cast<uint32_t*>(reinterpret_cast<const uint32_t*>(resampled->GetBufferAt(0, 0)));
+        params.targetWidth = width;
+        params.targetHeight = height;
+        params.filter = filter;
+        params.cancelled = cancelled;
+
+        return fResampler.ResampleTransformed(params) ? resampled : nullptr;
     }
 
 
@@ -182,18 +216,17 @@ namespace OIV
 		//return result;
     }
 
-    ResultCode OIV::LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, int16_t& handle) 
+    ResultCode OIV::LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, ImageHandle& handle) 
     {
         using namespace IMCodec;
-        ImageItemSharedPtr imageItem = std::make_shared<ImageItem>();
+        const size_t bufferSize = static_cast<size_t>(loadRawRequest.rowPitch) * loadRawRequest.height;
+        ImageItemSharedPtr imageItem = ImageItemPool::GetSingleton().Acquire(bufferSize);
         ImageDescriptor& props = imageItem->descriptor;
         props.height = loadRawRequest.height;
         props.width = loadRawRequest.width;
         props.texelFormatStorage = static_cast<IMCodec::TexelFormat>(loadRawRequest.texelFormat);
         props.texelFormatDecompressed = static_cast<IMCodec::TexelFormat>(loadRawRequest.texelFormat);
         props.rowPitchInBytes = loadRawRequest.rowPitch;
-        const size_t bufferSize = props.rowPitchInBytes * props.height;
-        imageItem->data.Allocate(bufferSize);
         imageItem->data.Write(loadRawRequest.buffer, 0, bufferSize);
 
         IMUtil::AxisAlignedTransform transform{};
@@ -201,7 +234,7 @@ namespace OIV
         transform.flip = static_cast<IMUtil::AxisAlignedFlip>(loadRawRequest.transformation);
 
         ImageSharedPtr image = std::make_shared<Image>(imageItem, ImageItemType::Unknown);
-        image = IMUtil::ImageUtil::Transform(transform, image);
+        AxisAlignedTransformer::TransformInPlace(transform, image);
 
         handle = fImageManager.AddImage(image);
         return RC_Success;
@@ -282,7 +315,8 @@ namespace OIV
         ResultCode result = RC_Success;
         if (req.handle > 0 )
         {
-            ImageSharedPtr original = fImageManager.GetImage(req.handle);
+            ImageManager::Reference source = fImageManager.Acquire(req.handle);
+            const ImageSharedPtr& original = source.GetImage();
             if (original != nullptr)
             {
                 bool rainbow = (req.flags & OIV_CF_RAINBOW_NORMALIZE) != 0;
@@ -347,7 +381,8 @@ namespace OIV
     ResultCode OIV::CropImage(const OIV_CMD_CropImage_Request& request, OIV_CMD_CropImage_Response& response)
     {
         ResultCode result = RC_Success;
-        IMCodec::ImageSharedPtr imageToCrop = GetImage(request.imageHandle);
+        ImageManager::Reference source = fImageManager.Acquire(request.imageHandle);
+        const IMCodec::ImageSharedPtr& imageToCrop = source.GetImage();
         if (imageToCrop == nullptr)
         {
             result = RC_ImageNotFound;
@@ -454,13 +489,8 @@ namespace OIV
 
     ResultCode OIV::UnloadFile(const ImageHandle handle)
     {
-        return ResultCode::RC_NotImplemented;
-
-        /*ResultCode result = RC_Success;
-        RemoveImageFromRenderer(handle);
-        fImageManager.RemoveImage(handle);
-
-        return result;*/
+        // Images on display are held by the renderer, they're released once replaced there.
+        return fImageManager.RemoveImage(handle) ? RC_Success : RC_InvalidImageHandle;
     }
 
     int OIV::Init()
@@ -504,6 +534,7 @@ namespace OIV
         //TODO: add renderer properties to get a unique renderer name instead of hard coded "D3D11"
 		OIVString appDataPath = LLUtils::StringUtility::ConvertString<OIVString>(LLUtils::PlatformUtility::GetAppDataFolder()) + 
 			+ OIV_TEXT("/OIV/") + GetVersionAsString() + OIV_TEXT("/Renderer/D3D11/.");
+
         params.container = fParent;
         
         params.dataPath = appDataPath.c_str();
@@ -512,6 +543,15 @@ namespace OIV
     }
 
 
+    int OIV::SetImageSpilling(const OIVCHAR* spillFolder, uint64_t budgetBytes)
+    {
+        // Spilling is opt in, without a folder images stay in memory whatever the budget.
+        if (spillFolder != nullptr)
+            fImageManager.SetSpillFolder(spillFolder);
+        fImageManager.SetMemoryBudget(budgetBytes);
+        return 0;
+    }
+
     int OIV::SetParent(std::size_t handle)
     {
         fParent = handle;
@@ -563,13 +603,14 @@ namespace OIV
 
     ResultCode OIV::AxisAlignTrasnform(const OIV_CMD_AxisAlignedTransform_Request& request, OIV_CMD_AxisAlignedTransform_Response& response)
     {
-        IMCodec::ImageSharedPtr image = fImageManager.GetImage(request.handle);
+        ImageManager::Reference source = fImageManager.Acquire(request.handle);
+        IMCodec::ImageSharedPtr image = source.GetImage();
         if (image != nullptr)
         {
             IMUtil::AxisAlignedTransform transform;
             transform.rotation = static_cast<IMUtil::AxisAlignedRotation>(request.transform.rotation);
             transform.flip = static_cast<IMUtil::AxisAlignedFlip>(request.transform.flip);
-            image = IMUtil::ImageUtil::Transform(transform,  image);
+            image = AxisAlignedTransformer::Transform(transform, image);
             response.handle = fImageManager.AddImage(image);
             return RC_Success;
         }
@@ -581,12 +622,176 @@ namespace OIV
     {
         using namespace IMCodec;
         //resample the displayed image.
-        ImageSharedPtr original = fImageManager.GetImage(resampleRequest.imageHandle);
-        ImageSharedPtr resmapled = Resample(original, resampleRequest.size);
+        ImageManager::Reference source = fImageManager.Acquire(resampleRequest.imageHandle);
+        if (!source)
+            return RC_ImageNotFound;
+
+        ImageSharedPtr resmapled = Resample(source.GetImage(), resampleRequest.size);
         handle = fImageManager.AddImage(resmapled);
         return RC_Success;
     }
 
+    ResultCode OIV::ProbeFile(const OIV_CMD_ProbeFile_Request& request, OIV_CMD_ProbeFile_Response& response)
+    {
+        if (request.filePath == nullptr)
+            return RC_InvalidParameters;
+
+        ImageHeaderInfo info;
+        const ResultCode result = ImageHeaderProbe::Probe(request.filePath, info);
+
+        response = {};
+        response.width = info.width;
+        response.height = info.height;
+        response.bitsPerPixel = info.bitsPerPixel;
+        response.NumSubImages = info.numSubImages;
+        response.texelFormat = info.texelFormat;
+        response.exifOrientation = info.exifOrientation;
+        info.exifDateTime.copy(response.exifDateTime, OIV_CMD_ProbeFile_DateTime_Size - 1);
+        response.exifThumbnailOffset = info.exifThumbnailOffset;
+        response.exifThumbnailLength = info.exifThumbnailLength;
+        info.format.copy(response.format, OIV_CMD_ProbeFile_Format_Size - 1);
+        return result;
+    }
+
+    namespace
+    {
+        // Points whose texels are converted with ImageUtil are grouped by the tile holding them, only those tiles are converted.
+        constexpr int32_t ConvertedPointsTileSize = 16;
+
+        bool CopyConvertedPoints(const IMCodec::ImageSharedPtr& image, const OIV_POINT_I* points, std::size_t numPoints
+            , OIV_TexelFormat format, uint32_t bytesPerTexel, std::byte* target)
+        {
+            using namespace IMCodec;
+            const int32_t imageWidth = static_cast<int32_t>(image->GetWidth());
+            const int32_t imageHeight = static_cast<int32_t>(image->GetHeight());
+            auto getTile = [](const OIV_POINT_I& point) { return std::make_pair(point.y / ConvertedPointsTileSize, point.x / ConvertedPointsTileSize); };
+
+            std::vector<std::size_t> inside;
+            for (std::size_t i = 0; i < numPoints; i++)
+            {
+                const OIV_POINT_I& point = points[i];
+                if (point.x >= 0 && point.x < imageWidth && point.y >= 0 && point.y < imageHeight)
+                    inside.push_back(i);
+                else
+                    std::memset(target + i * bytesPerTexel, 0, bytesPerTexel);
+            }
+
+            std::sort(inside.begin(), inside.end(), [&](std::size_t a, std::size_t b) { return getTile(points[a]) < getTile(points[b]); });
+
+            for (std::size_t begin = 0, end = 0; begin < inside.size(); begin = end)
+            {
+                const auto tile = getTile(points[inside[begin]]);
+                while (end < inside.size() && getTile(points[inside[end]]) == tile)
+                    end++;
+
+                const int32_t x0 = tile.second * ConvertedPointsTileSize;
+                const int32_t y0 = tile.first * ConvertedPointsTileSize;
+                const int32_t x1 = std::min(x0 + ConvertedPointsTileSize, imageWidth);
+                const int32_t y1 = std::min(y0 + ConvertedPointsTileSize, imageHeight);
+                ImageSharedPtr subImage = IMUtil::ImageUtil::GetSubImage(image, { { x0, y0 }, { x1, y1 } });
+                ImageSharedPtr converted = subImage != nullptr ? IMUtil::ImageUtil::ConvertImageWithNormalization(subImage, static_cast<TexelFormat>(format), false) : nullptr;
+                if (converted == nullptr)
+                    return false;
+
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    const OIV_POINT_I& point = points[inside[i]];
+                    const OIV_POINT_I tilePoint = { point.x - x0, point.y - y0 };
+                    TexelReadback::CopyPoints(*converted, &tilePoint, 1, format, target + inside[i] * bytesPerTexel);
+                }
+            }
+            return true;
+        }
+    }
+
+    ResultCode OIV::ReadTexels(const OIV_CMD_ReadTexels_Request& request, OIV_CMD_ReadTexels_Response& response)
+    {
+        using namespace IMCodec;
+        ImageManager::Reference source = fImageManager.Acquire(request.handle);
+        ImageSharedPtr image = source.GetImage();
+        if (image == nullptr)
+            return RC_ImageNotFound;
+
+        const OIV_TexelFormat imageFormat = static_cast<OIV_TexelFormat>(image->GetTexelFormat());
+        const OIV_TexelFormat format = request.format == TF_UNKNOWN ? imageFormat : request.format;
+        const uint32_t bytesPerTexel = TexelReadback::GetBytesPerTexel(format);
+        if (bytesPerTexel == 0)
+            return RC_UnsupportedFormat;
+
+        const int32_t imageWidth = static_cast<int32_t>(image->GetWidth());
+        const int32_t imageHeight = static_cast<int32_t>(image->GetHeight());
+
+        // The region of the image read.
+        int32_t x0 = 0;
+        int32_t y0 = 0;
+        int32_t x1 = 0;
+        int32_t y1 = 0;
+        if (request.points == nullptr)
+        {
+            x0 = std::clamp(request.rect.x0, 0, imageWidth);
+            y0 = std::clamp(request.rect.y0, 0, imageHeight);
+            x1 = std::clamp(request.rect.x1, x0, imageWidth);
+            y1 = std::clamp(request.rect.y1, y0, imageHeight);
+            response.width = static_cast<uint32_t>(x1 - x0);
+            response.height = static_cast<uint32_t>(y1 - y0);
+        }
+        else
+        {
+            response.width = request.numPoints;
+            response.height = 1;
+        }
+
+        const size_t rowSize = static_cast<size_t>(response.width) * bytesPerTexel;
+        if (request.rowPitch != 0 && request.rowPitch < rowSize)
+            return RC_InvalidParameters;
+
+        response.rowPitch = request.rowPitch != 0 ? request.rowPitch : static_cast<uint32_t>(rowSize);
+        response.bitsPerTexel = bytesPerTexel * CHAR_BIT;
+        response.format = format;
+        response.requiredSize = response.height == 0 ? 0 : static_cast<size_t>(response.height - 1) * response.rowPitch + rowSize;
+
+        if (request.buffer == nullptr || response.requiredSize == 0)
+            return RC_Success;
+
+        if (request.bufferSize < response.requiredSize)
+            return RC_WrongDataSize;
+
+        std::byte* target = static_cast<std::byte*>(request.buffer);
+        if (TexelReadback::IsSupported(imageFormat, format))
+        {
+            if (request.points == nullptr)
+                TexelReadback::CopyRegion(*image, x0, y0, response.width, response.height, format, target, response.rowPitch);
+            else
+                TexelReadback::CopyPoints(*image, request.points, request.numPoints, format, target);
+
+            return RC_Success;
+        }
+
+        // Convert what's read with ImageUtil, then copy it as it is.
+        if (request.points != nullptr)
+            return CopyConvertedPoints(image, request.points, request.numPoints, format, bytesPerTexel, target) ? RC_Success : RC_BadConversion;
+
+        if (x1 > x0 && y1 > y0)
+        {
+            ImageSharedPtr subImage = IMUtil::ImageUtil::GetSubImage(image, { { x0, y0 }, { x1, y1 } });
+            ImageSharedPtr converted = subImage != nullptr ? IMUtil::ImageUtil::ConvertImageWithNormalization(subImage, static_cast<TexelFormat>(format), false) : nullptr;
+            if (converted == nullptr)
+                return RC_BadConversion;
+
+            TexelReadback::CopyRegion(*converted, 0, 0, response.width, response.height, format, target, response.rowPitch);
+        }
+
+        return RC_Success;
+    }
+
+    ResultCode OIV::SetImageMemoryBudget(const OIV_CMD_SetImageMemoryBudget_Request& request, OIV_CMD_SetImageMemoryBudget_Response& response)
+    {
+        fImageManager.SetMemoryBudget(request.budgetBytes);
+        response.residentBytes = fImageManager.GetResidentBytes();
+        response.spilledBytes = fImageManager.GetSpilledBytes();
+        return RC_Success;
+    }
+
   
 #pragma endregion
 
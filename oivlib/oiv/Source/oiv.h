@@ -17,7 +17,7 @@ namespace OIV
 #pragma region //-------------IPictureListener implementation------------------
         ResultCode UnloadFile(const ImageHandle handle) override;
         ResultCode LoadFile(void* buffer, std::size_t size, char* extension , OIV_CMD_LoadFile_Flags flags, ImageHandle& handle) override;
-        ResultCode LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, int16_t& handle) override;
+        ResultCode LoadRaw(const OIV_CMD_LoadRaw_Request& loadRawRequest, ImageHandle& handle) override;
         //ResultCode DisplayFile(const OIV_CMD_DisplayImage_Request& display_flags) override;
         ResultCode CreateText(const OIV_CMD_CreateText_Request&, OIV_CMD_CreateText_Response&) override;
         ResultCode SetSelectionRect(const OIV_CMD_SetSelectionRect_Request& selectionRect) override;
@@ -30,6 +30,9 @@ namespace OIV
         ResultCode GetTexelInfo(const OIV_CMD_TexelInfo_Request& texel_request, OIV_CMD_TexelInfo_Response& texelresponse) override;
         ResultCode GetKnownFileTypes(OIV_CMD_GetKnownFileTypes_Response& res) override;
         ResultCode ResampleImage(const OIV_CMD_Resample_Request& resampleRequest, ImageHandle& handle) override;
+        ResultCode ProbeFile(const OIV_CMD_ProbeFile_Request& request, OIV_CMD_ProbeFile_Response& response) override;
+        ResultCode ReadTexels(const OIV_CMD_ReadTexels_Request& request, OIV_CMD_ReadTexels_Response& response) override;
+        ResultCode SetImageMemoryBudget(const OIV_CMD_SetImageMemoryBudget_Request& request, OIV_CMD_SetImageMemoryBudget_Response& response) override;
         ResultCode RegisterCallbacks(const OIV_CMD_RegisterCallbacks_Request& callbacks) override;
         ResultCode GetSubImages(const OIV_CMD_GetSubImages_Request& request, OIV_CMD_GetSubImages_Response& res) override;
         IRenderer* GetRenderer() override;
@@ -37,6 +40,7 @@ namespace OIV
         
         int Init() override;
         int SetParent(std::size_t handle) override;
+        int SetImageSpilling(const OIVCHAR* spillFolder, uint64_t budgetBytes) override;
         int Refresh() override;
         
         IMCodec::ImageSharedPtr GetImage(ImageHandle handle) const override;
@@ -44,7 +48,10 @@ namespace OIV
         int SetTexelGrid(const CmdRequestTexelGrid& viewParams) override;
         int SetClientSize(uint16_t width, uint16_t height) override;
         ResultCode AxisAlignTrasnform(const OIV_CMD_AxisAlignedTransform_Request& request, OIV_CMD_AxisAlignedTransform_Response& response) override;
-        IMCodec::ImageSharedPtr Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize) override;
+        IMCodec::ImageSharedPtr Resample(IMCodec::ImageSharedPtr sourceImage, LLUtils::PointI32 targetSize
+            , ResampleFilter filter = ResampleFilter::Box, const std::atomic_bool* cancelled = nullptr) override;
+        IMCodec::ImageSharedPtr ResampleTransformed(IMCodec::ImageSharedPtr sourceImage, const IMUtil::AxisAlignedTransform& transform
+            , LLUtils::PointI32 targetSize, ResampleFilter filter = ResampleFilter::Box, const std::atomic_bool* cancelled = nullptr) override;
 #pragma endregion
 
 #pragma region //-------------Private methods------------------
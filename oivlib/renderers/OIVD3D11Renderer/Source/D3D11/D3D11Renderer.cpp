@@ -1,4 +1,5 @@
 #include <filesystem>
+#include <algorithm>
 #include <d3dcommon.h>
 #include <d3d11.h>
 #include <LLUtils/PlatformUtility.h>
@@ -191,6 +192,19 @@ LLUTILS_DISABLE_WARNING_POP
         fBufferImageCommon = std::make_unique<D3D11BufferBound<CONSTANT_BUFFER_IMAGE_COMMON>>(fDevice, cbDesc, nullptr);
        
     }
+
+    //Create constant buffer for overlays batch.
+    {
+        D3D11_BUFFER_DESC cbDesc;
+        cbDesc.ByteWidth = LLUtils::Utility::Align<UINT>(sizeof(CONSTANT_BUFFER_OVERLAYS), 16);
+        cbDesc.Usage = D3D11_USAGE_DYNAMIC;
+        cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        cbDesc.MiscFlags = 0;
+        cbDesc.StructureByteStride = 0;
+
+        fBufferOverlays = std::make_unique<D3D11BufferBound<CONSTANT_BUFFER_OVERLAYS>>(fDevice, cbDesc, nullptr);
+    }
         
 
         D3D11_SAMPLER_DESC sampler;
@@ -230,6 +244,10 @@ LLUTILS_DISABLE_WARNING_POP
         fSelectionFragmentShaer->SetSourceFileName(programsPath / L"quad_selection_fp.shader");
         fImageSimpleFragmentShader = std::make_unique<D3D11FragmentShader>(fDevice);
         fImageSimpleFragmentShader->SetSourceFileName(programsPath / L"quad_simple_fp.shader");
+        fOverlaysVertexShader = std::make_unique<D3D11VertexShader>(fDevice);
+        fOverlaysVertexShader->SetSourceFileName(programsPath / L"quad_overlays_vp.shader");
+        fOverlaysFragmentShader = std::make_unique<D3D11FragmentShader>(fDevice);
+        fOverlaysFragmentShader->SetSourceFileName(programsPath / L"quad_overlays_fp.shader");
 
         std::filesystem::path shaderCachePath = std::filesystem::path(fDataPath) / L"ShaderCache/.";
         
@@ -239,6 +257,8 @@ LLUTILS_DISABLE_WARNING_POP
         D3D11Utility::LoadShader(fImageFragmentShader, shaderCachePath);
         D3D11Utility::LoadShader(fSelectionFragmentShaer , shaderCachePath);
         D3D11Utility::LoadShader(fImageSimpleFragmentShader , shaderCachePath);
+        D3D11Utility::LoadShader(fOverlaysVertexShader, shaderCachePath);
+        D3D11Utility::LoadShader(fOverlaysFragmentShader, shaderCachePath);
 
     }
 
@@ -307,13 +327,18 @@ LLUTILS_DISABLE_WARNING_POP
 
         renderable->PreRender();
 
-        if (renderable->GetIsImageDirty() )
+        // An overlay drawn from the atlas until now may have no texture of its own.
+        if (renderable->GetIsImageDirty() || entry.texture == nullptr)
         {
-            const_cast<ImageEntry&>(entry).texture = OIVD3DHelper::CreateTexture(fDevice, renderable->GetImage(), false);
+            const IMCodec::ImageSharedPtr image = renderable->GetImage();
+            const_cast<ImageEntry&>(entry).texture = OIVD3DHelper::CreateTexture(fDevice, image, false);
             renderable->ClearImageDirty();
             
             if (entry.texture == nullptr)
                 LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "can not create texture");
+
+            if (renderable->GetImageRenderMode() == OIV_Image_Render_mode::IRM_Overlay)
+                fOverlayCompositor.AddUploadedBytes(static_cast<uint64_t>(image->GetRowPitchInBytes()) * image->GetHeight());
         }
     
         CONSTANT_BUFFER_IMAGE_COMMON& gpuBuffer = fBufferImageCommon->GetBuffer();
@@ -351,6 +376,105 @@ LLUTILS_DISABLE_WARNING_POP
     }
 
 
+    void D3D11Renderer::UploadOverlayAtlas()
+    {
+        const IMCodec::ImageSharedPtr& atlas = fOverlayCompositor.GetAtlas();
+        if (fOverlayCompositor.IsAtlasRecreated() || fOverlayAtlasTexture == nullptr)
+        {
+            fOverlayAtlasTexture = OIVD3DHelper::CreateTexture(fDevice, atlas, false, true);
+        }
+        else
+        {
+            for (const OverlayCompositor::Rect& rect : fOverlayCompositor.GetDirtyRects())
+                fOverlayAtlasTexture->Update(rect.x, rect.y, rect.width, rect.height, atlas->GetBufferAt(rect.x, rect.y), atlas->GetRowPitchInBytes());
+        }
+
+        fOverlayCompositor.OnUploaded();
+    }
+
+    void D3D11Renderer::DrawOverlayBatch(const std::vector<const OverlayCompositor::Instance*>& batch)
+    {
+        if (batch.empty())
+            return;
+
+        SetFilterLevel(batch.front()->renderable->GetFilterType());
+        fOverlaysVertexShader->Use();
+        fOverlaysFragmentShader->Use();
+        fOverlayAtlasTexture->Use();
+
+        const float atlasWidth = static_cast<float>(fOverlayAtlasTexture->GetCreateParams().width);
+        const float atlasHeight = static_cast<float>(fOverlayAtlasTexture->GetCreateParams().height);
+        CONSTANT_BUFFER_OVERLAYS& gpuBuffer = fBufferOverlays->GetBuffer();
+        gpuBuffer.uvViewportSize[0] = static_cast<float>(fViewport.Width);
+        gpuBuffer.uvViewportSize[1] = static_cast<float>(fViewport.Height);
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            const OverlayCompositor::Instance& instance = *batch[i];
+            CONSTANT_BUFFER_OVERLAYS::OverlayInstance& gpuInstance = gpuBuffer.uOverlays[i];
+            gpuInstance.screenRect[0] = static_cast<float>(instance.position.x);
+            gpuInstance.screenRect[1] = static_cast<float>(instance.position.y);
+            gpuInstance.screenRect[2] = static_cast<float>(instance.atlasRect.width * instance.scale.x);
+            gpuInstance.screenRect[3] = static_cast<float>(instance.atlasRect.height * instance.scale.y);
+            gpuInstance.atlasRect[0] = instance.atlasRect.x / atlasWidth;
+            gpuInstance.atlasRect[1] = instance.atlasRect.y / atlasHeight;
+            gpuInstance.atlasRect[2] = instance.atlasRect.width / atlasWidth;
+            gpuInstance.atlasRect[3] = instance.atlasRect.height / atlasHeight;
+            gpuInstance.opacity[0] = static_cast<float>(instance.opacity);
+        }
+
+        fBufferOverlays->Update();
+        fBufferOverlays->Use(ShaderStage::VertexShader, 0);
+        // One quad per overlay, blended in instance order.
+        fDevice->GetContext()->DrawInstanced(4, static_cast<UINT>(batch.size()), 0, 0);
+        fImageVertexShader->Use();
+    }
+
+    void D3D11Renderer::DrawOverlays()
+    {
+        std::vector<IRenderable*> overlays;
+        for (const MapImageEntry::value_type& idEntryPair : fImageEntries)
+            if (idEntryPair.first->GetImageRenderMode() == OIV_Image_Render_mode::IRM_Overlay)
+                overlays.push_back(idEntryPair.first);
+
+        std::vector<IRenderable*> unpacked;
+        fOverlayCompositor.Update(overlays, unpacked);
+        UploadOverlayAtlas();
+
+        const std::vector<OverlayCompositor::Instance>& instances = fOverlayCompositor.GetInstances();
+        // Packed overlays don't need textures of their own, they are recreated if an overlay is ever drawn unpacked.
+        for (const OverlayCompositor::Instance& instance : instances)
+            fImageEntries.at(instance.renderable).texture.reset();
+
+        // Both lists are in draw order, consecutive packed overlays sharing a filter are drawn in one call
+        // and an unpacked overlay is drawn between the batches around it.
+        std::vector<const OverlayCompositor::Instance*> batch;
+        auto itInstance = instances.begin();
+        auto itUnpacked = unpacked.begin();
+        for (IRenderable* renderable : overlays)
+        {
+            if (itInstance != instances.end() && itInstance->renderable == renderable)
+            {
+                if (batch.size() == MaxOverlaysPerDraw
+                    || (batch.empty() == false && batch.front()->renderable->GetFilterType() != renderable->GetFilterType()))
+                {
+                    DrawOverlayBatch(batch);
+                    batch.clear();
+                }
+                batch.push_back(&*itInstance++);
+            }
+            else if (itUnpacked != unpacked.end() && *itUnpacked == renderable)
+            {
+                DrawOverlayBatch(batch);
+                batch.clear();
+                DrawImage(fImageEntries.at(renderable));
+                itUnpacked++;
+            }
+        }
+
+        DrawOverlayBatch(batch);
+    }
+
     int D3D11Renderer::Redraw()
     {
         UpdateGpuParameters();
@@ -382,13 +506,7 @@ LLUTILS_DISABLE_WARNING_POP
             context->Draw(4, 0);
         }
 
-        //Draw Overlays
-        for (const MapImageEntry::value_type& idEntryPair : fImageEntries)
-        {
-            const ImageEntry& entry = idEntryPair.second;
-            if (entry.renderable->GetImageRenderMode() == OIV_Image_Render_mode::IRM_Overlay)
-                DrawImage(entry);
-        }
+        DrawOverlays();
 
         fDevice->GetSwapChain()->Present(0, 0);
         return 0;
@@ -465,6 +583,8 @@ LLUTILS_DISABLE_WARNING_POP
         if (fImageEntries.erase(renderable) == 0)
             LL_EXCEPTION(LLUtils::Exception::ErrorCode::DuplicateItem, "can not remove image");
 
+        fOverlayCompositor.Remove(renderable);
+
         return 0;
     }
 
@@ -479,4 +599,10 @@ LLUTILS_DISABLE_WARNING_POP
 
         return 0;
     }
+
+    int D3D11Renderer::GetOverlayStats(OverlayCompositor::Stats& stats) const
+    {
+        stats = fOverlayCompositor.GetStats();
+        return 0;
+    }
 }
\ No newline at end of file
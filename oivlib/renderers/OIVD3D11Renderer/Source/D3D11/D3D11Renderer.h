@@ -8,8 +8,10 @@
 #include <defs.h>
 #include <Interfaces/IRendererDefs.h>
 #include <Interfaces/IRenderable.h>
+#include <Render/OverlayCompositor.h>
 #include <LLUtils/Color.h>
 #include <map>
+#include <vector>
 
 namespace OIV
 {
@@ -53,6 +55,21 @@ namespace OIV
         //------------------------
         
     };
+
+    constexpr size_t MaxOverlaysPerDraw = 256; // must match MAX_OVERLAYS in quad_overlays_vp.shader
+
+    struct CONSTANT_BUFFER_OVERLAYS
+    {
+        struct OverlayInstance
+        {
+            float screenRect[4];
+            float atlasRect[4];
+            float opacity[4];
+        };
+
+        float uvViewportSize[4];
+        OverlayInstance uOverlays[MaxOverlaysPerDraw];
+    };
 #pragma pack()
 
 
@@ -86,6 +103,7 @@ namespace OIV
         int AddRenderable(IRenderable* renderable);
         int RemoveRenderable(IRenderable* renderable);
         int SetBackgroundColor(int index, LLUtils::Color backgroundColor);
+        int GetOverlayStats(OverlayCompositor::Stats& stats) const;
 
 #pragma region //**** Private methods*****/
     private: 
@@ -95,6 +113,9 @@ namespace OIV
         void UpdateViewportSize(int x, int y);
         void SetDevicestate();
         void DrawImage(const ImageEntry& entry);
+        void UploadOverlayAtlas();
+        void DrawOverlays();
+        void DrawOverlayBatch(const std::vector<const OverlayCompositor::Instance*>& batch);
 #pragma endregion
     private:
         D3D11DeviceSharedPtr fDevice;
@@ -102,6 +123,8 @@ namespace OIV
         D3D11ShaderUniquePtr fImageFragmentShader;
         D3D11ShaderUniquePtr fSelectionFragmentShaer;
         D3D11ShaderUniquePtr fImageSimpleFragmentShader;
+        D3D11ShaderUniquePtr fOverlaysVertexShader;
+        D3D11ShaderUniquePtr fOverlaysFragmentShader;
         bool fIsParamsDirty = true;
         bool fGlobalsDirty = true;
         VisualSelectionRect fSelectionRect;
@@ -125,6 +148,7 @@ namespace OIV
 
         using MapImageEntry = std::map<IRenderable*, ImageEntry, MapLess>;
         MapImageEntry fImageEntries;
+        OverlayCompositor fOverlayCompositor;
         OIVString fDataPath;
         LLUtils::ColorF32 fBackgroundColor = { static_cast<uint8_t>(45),static_cast < uint8_t>(45),static_cast < uint8_t>(48),static_cast < uint8_t>(255) };
 
@@ -134,6 +158,8 @@ namespace OIV
         D3D11BufferBoundUniquePtr<CONSTANT_BUFFER_GLOBALS> fBufferGlobals;
         D3D11BufferBoundUniquePtr<CONSTANT_BUFFER_IMAGE_COMMON> fBufferImageCommon;
         D3D11BufferBoundUniquePtr<CONSTANT_BUFFER_IMAGE_MAIN> fBufferImageMain;
+        D3D11BufferBoundUniquePtr<CONSTANT_BUFFER_OVERLAYS> fBufferOverlays;
+        D3D11TextureSharedPtr fOverlayAtlasTexture;
         
         ComPtr<ID3D11SamplerState>  fSamplerState;
         ComPtr<ID3D11BlendState> fBlendState;
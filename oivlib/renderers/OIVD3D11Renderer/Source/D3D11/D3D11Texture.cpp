@@ -53,7 +53,7 @@ namespace OIV
         desc.ArraySize = 1;
         desc.Format = fCreateparams.format;
         desc.SampleDesc.Count = 1;
-        desc.Usage = generateMips ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE ;
+        desc.Usage = generateMips || fCreateparams.updatable ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE ;
         desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (generateMips ? D3D11_BIND_RENDER_TARGET : 0);
         desc.CPUAccessFlags = static_cast<UINT>(0);
 
@@ -96,6 +96,21 @@ namespace OIV
         OIV_D3D_SET_OBJECT_NAME(fTexture, "Texture2D");
     }
 
+    void D3D11Texture::Update(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const std::byte* buffer, uint32_t rowPitchInBytes)
+    {
+        if (fCreateparams.updatable == false)
+            LL_EXCEPTION(LLUtils::Exception::ErrorCode::InvalidState, "Texture is not updatable");
+
+        D3D11_BOX box;
+        box.front = 0;
+        box.back = 1;
+        box.left = x;
+        box.top = y;
+        box.right = x + width;
+        box.bottom = y + height;
+        fDevice->GetContext()->UpdateSubresource(fTexture.Get(), 0, &box, buffer, rowPitchInBytes, rowPitchInBytes * height);
+    }
+
     void D3D11Texture::Use() const
     {
         fDevice->GetContext()->PSSetShaderResources(static_cast<UINT>(0), static_cast<UINT>(1), fTextureShaderResourceView.GetAddressOf());
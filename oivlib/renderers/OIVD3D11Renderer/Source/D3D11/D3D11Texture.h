@@ -14,6 +14,8 @@ namespace OIV
             uint32_t height;
             DXGI_FORMAT format;
             int32_t mips;
+            // Allows updating sub rectangles of the texture after creation.
+            bool updatable = false;
         };
 
         struct InitialBuffer
@@ -26,6 +28,7 @@ namespace OIV
         D3D11Texture(D3D11DeviceSharedPtr device, const CreateParams& createParams, const InitialBuffer* initialBuffer);
         const CreateParams& GetCreateParams() const;
         void Use() const;
+        void Update(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const std::byte* buffer, uint32_t rowPitchInBytes);
 
 
     private: // methods
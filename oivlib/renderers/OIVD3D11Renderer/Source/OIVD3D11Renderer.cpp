@@ -51,6 +51,11 @@ namespace OIV
         return fD3D11Renderer->RemoveRenderable(renderable);
     }
 
+    int OIVD3D11Renderer::GetOverlayStats(OverlayCompositor::Stats& stats) const
+    {
+        return fD3D11Renderer->GetOverlayStats(stats);
+    }
+
     int OIVD3D11Renderer::SetBackgroundColor(int index, LLUtils::Color backgroundColor)
     {
         return fD3D11Renderer->SetBackgroundColor(index, backgroundColor);
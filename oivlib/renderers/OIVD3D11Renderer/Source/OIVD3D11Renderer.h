@@ -23,6 +23,7 @@ namespace OIV
         int SetBackgroundColor(int index, LLUtils::Color backgroundColor) override;
         int AddRenderable(IRenderable* renderable) override;
         int RemoveRenderable(IRenderable* renderable) override;
+        int GetOverlayStats(OverlayCompositor::Stats& stats) const override;
 
 #pragma endregion
 
@@ -4,7 +4,7 @@
 
 namespace OIV
 {
-        D3D11TextureSharedPtr OIVD3DHelper::CreateTexture(D3D11DeviceSharedPtr device, const IMCodec::ImageSharedPtr image, bool createMipMaps)
+        D3D11TextureSharedPtr OIVD3DHelper::CreateTexture(D3D11DeviceSharedPtr device, const IMCodec::ImageSharedPtr image, bool createMipMaps, bool updatable)
         {
 
             DXGI_FORMAT textureFormat = DXGI_FORMAT_UNKNOWN;
@@ -30,6 +30,7 @@ namespace OIV
             params.width = image->GetWidth();
             params.height = image->GetHeight();
             params.mips = createMipMaps ? -1 : -2;
+            params.updatable = updatable;
 
 
             D3D11Texture::InitialBuffer buffer;
@@ -7,7 +7,7 @@ namespace OIV
     class OIVD3DHelper
     {
     public:
-        static D3D11TextureSharedPtr CreateTexture(D3D11DeviceSharedPtr device, const IMCodec::ImageSharedPtr image, bool createMipMaps);
+        static D3D11TextureSharedPtr CreateTexture(D3D11DeviceSharedPtr device, const IMCodec::ImageSharedPtr image, bool createMipMaps, bool updatable = false);
     };
 
 